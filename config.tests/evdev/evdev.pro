@@ -1,7 +0,0 @@
-TEMPLATE = app
-
-CONFIG += link_pkgconfig
-PKGCONFIG += libevdev
-TARGET = evdev
-
-SOURCES += main.cpp
@@ -4,7 +4,6 @@ load(configure)
 qtCompileTest(gconf)
 qtCompileTest(bluez)
 qtCompileTest(udev)
-qtCompileTest(evdev)
 qtCompileTest(x11)
 qtCompileTest(mir)
 
@@ -335,7 +335,7 @@ void QDeclarativeServiceLoader::IPCFault(QService::UnrecoverableIPCError errorVa
     \instantiates QDeclarativeServiceFilter
 
     \brief The ServiceFilter element holds a list of \l ServiceDescriptor objects.
-    \inherits QObject
+    \inherits QAbstractListModel
 
     \ingroup qml-serviceframework
 
@@ -360,20 +360,25 @@ void QDeclarativeServiceLoader::IPCFault(QService::UnrecoverableIPCError errorVa
             serviceDescriptor: serviceFilter.serviceDescriptions[0] //To get the first matching service
         }
         Repeater{ //To instantiate an object for all matching services.
-            model: serviceFilter.serviceDescriptions
+            model: serviceFilter
             Item {
                 ServiceLoader {
-                    serviceDescriptor: modelData
+                    serviceDescriptor: model.serviceDescriptor
                 }
             }
         }
     }
     \endcode
 
+    The ServiceFilter is a list model itself, with the roles \c serviceDescriptor,
+    \c serviceName, \c interfaceName, \c majorVersion and \c minorVersion.
+    When services are registered or unregistered only the rows of those services
+    are inserted or removed, so views keep the delegates of the other rows.
+
     \sa ServiceLoader ServiceDescriptor
 */
 QDeclarativeServiceFilter::QDeclarativeServiceFilter(QObject* parent)
-    : QObject(parent),
+    : QAbstractListModel(parent),
       m_majorVersion(1), // ### Is '1' the correct unset number?
       m_minorVersion(0),
       m_exactVersionMatching(false),
@@ -386,6 +391,44 @@ QDeclarativeServiceFilter::QDeclarativeServiceFilter(QObject* parent)
 QDeclarativeServiceFilter::~QDeclarativeServiceFilter()
 {
 }
+
+int QDeclarativeServiceFilter::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_services.count();
+}
+
+QVariant QDeclarativeServiceFilter::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_services.count())
+        return QVariant();
+
+    QDeclarativeServiceDescriptor *descriptor = m_services.at(index.row());
+    switch (role) {
+    case ServiceDescriptorRole:
+        return QVariant::fromValue(descriptor);
+    case Qt::DisplayRole:
+    case ServiceNameRole:
+        return descriptor->serviceName();
+    case InterfaceNameRole:
+        return descriptor->interfaceName();
+    case MajorVersionRole:
+        return descriptor->majorVersion();
+    case MinorVersionRole:
+        return descriptor->minorVersion();
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> QDeclarativeServiceFilter::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(ServiceDescriptorRole, "serviceDescriptor");
+    roles.insert(ServiceNameRole, "serviceName");
+    roles.insert(InterfaceNameRole, "interfaceName");
+    roles.insert(MajorVersionRole, "majorVersion");
+    roles.insert(MinorVersionRole, "minorVersion");
+    return roles;
+}
 /*!
     \qmlproperty QString ServiceFilter::serviceName
 
@@ -444,7 +487,7 @@ void QDeclarativeServiceFilter::setMonitorServiceRegistrations(bool updates)
         return;
 
     if (updates == false) {
-        disconnect(this, SLOT(servicesAddedRemoved()));
+        disconnect(this, SLOT(servicesAddedRemoved(QString)));
         if (m_serviceManager)
             delete m_serviceManager;
         m_serviceManager = 0;
@@ -452,54 +495,110 @@ void QDeclarativeServiceFilter::setMonitorServiceRegistrations(bool updates)
         if (!m_serviceManager)
             m_serviceManager = new QServiceManager(this);
         connect(m_serviceManager, SIGNAL(serviceAdded(QString,QService::Scope)),
-                this, SLOT(servicesAddedRemoved()));
+                this, SLOT(servicesAddedRemoved(QString)));
         connect(m_serviceManager, SIGNAL(serviceRemoved(QString,QService::Scope)),
-                this, SLOT(servicesAddedRemoved()));
+                this, SLOT(servicesAddedRemoved(QString)));
     }
 
     emit monitorServiceRegistrationsChanged(updates);
     m_monitorServiceRegistrations = updates;
 }
 
-void QDeclarativeServiceFilter::servicesAddedRemoved()
+void QDeclarativeServiceFilter::servicesAddedRemoved(const QString &serviceName)
 {
     // invoke in another event loop run ### Why?
-    QMetaObject::invokeMethod(this, "updateServiceList", Qt::QueuedConnection);
+    QMetaObject::invokeMethod(this, "updateService", Qt::QueuedConnection,
+                              Q_ARG(QString, serviceName));
 }
 
-QList<QDeclarativeServiceDescriptor> makeDeclarative(QList<QServiceInterfaceDescriptor> in)
+QServiceFilter QDeclarativeServiceFilter::currentFilter(const QString &serviceName) const
 {
-    QList<QDeclarativeServiceDescriptor> out;
-    foreach (const QServiceInterfaceDescriptor &d, in)
-        out << QDeclarativeServiceDescriptor(d);
-    return out;
-}
-
-void QDeclarativeServiceFilter::updateServiceList()
-{
-    if (!m_componentComplete)
-        return;
-
-    if (!m_serviceManager)
-        m_serviceManager = new QServiceManager(this);
     const QString version = QString::number(m_majorVersion) + "." + QString::number(m_minorVersion);
 
     QServiceFilter filter;
 
-    if (!m_serviceName.isEmpty())
-        filter.setServiceName(m_serviceName);
+    if (!serviceName.isEmpty())
+        filter.setServiceName(serviceName);
 
     if (!m_interfaceName.isEmpty())
         filter.setInterface(m_interfaceName, version, m_exactVersionMatching ?
                 QServiceFilter::ExactVersionMatch : QServiceFilter::MinimumVersionMatch);
 
-    QList<QDeclarativeServiceDescriptor> list = makeDeclarative(m_serviceManager->findInterfaces(filter));
+    return filter;
+}
 
-    if (list != m_services) {
-        m_services = list;
-        emit serviceDescriptionsChanged();
+/*
+    Brings the rows of \a serviceName, or all rows if it is empty, in line
+    with \a services. Rows that are still wanted keep their descriptor
+    objects, the others are removed and new ones appended.
+*/
+void QDeclarativeServiceFilter::applyServices(const QList<QServiceInterfaceDescriptor> &services, const QString &serviceName)
+{
+    bool changed = false;
+
+    for (int row = m_services.count() - 1; row >= 0; --row) {
+        QDeclarativeServiceDescriptor *descriptor = m_services.at(row);
+        if (!serviceName.isEmpty() && descriptor->serviceName() != serviceName)
+            continue;
+        if (services.contains(*descriptor))
+            continue;
+
+        // remove the whole run of unwanted rows ending here at once
+        int first = row;
+        while (first > 0) {
+            QDeclarativeServiceDescriptor *previous = m_services.at(first - 1);
+            if ((!serviceName.isEmpty() && previous->serviceName() != serviceName)
+                    || services.contains(*previous))
+                break;
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, row);
+        for (int i = row; i >= first; --i)
+            m_services.takeAt(i)->deleteLater();
+        endRemoveRows();
+        changed = true;
+        row = first;
     }
 
+    QList<QServiceInterfaceDescriptor> added;
+    foreach (const QServiceInterfaceDescriptor &service, services) {
+        bool found = false;
+        foreach (QDeclarativeServiceDescriptor *descriptor, m_services) {
+            if (*descriptor == service) {
+                found = true;
+                break;
+            }
+        }
+        if (!found && !added.contains(service))
+            added.append(service);
+    }
+
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_services.count(), m_services.count() + added.count() - 1);
+        foreach (const QServiceInterfaceDescriptor &service, added) {
+            QDeclarativeServiceDescriptor *descriptor = new QDeclarativeServiceDescriptor(service);
+            descriptor->setParent(this);
+            m_services.append(descriptor);
+        }
+        endInsertRows();
+        changed = true;
+    }
+
+    if (changed)
+        emit serviceDescriptionsChanged();
+}
+
+void QDeclarativeServiceFilter::updateServiceList()
+{
+    if (!m_componentComplete)
+        return;
+
+    if (!m_serviceManager)
+        m_serviceManager = new QServiceManager(this);
+
+    applyServices(m_serviceManager->findInterfaces(currentFilter(m_serviceName)), QString());
+
     if (!m_monitorServiceRegistrations) {
         delete m_serviceManager;
         m_serviceManager = 0;
@@ -507,6 +606,21 @@ void QDeclarativeServiceFilter::updateServiceList()
 
 }
 
+/*
+    Only \a serviceName was added or removed, so only its interfaces are
+    looked up again.
+*/
+void QDeclarativeServiceFilter::updateService(const QString &serviceName)
+{
+    if (!m_componentComplete || !m_serviceManager)
+        return;
+
+    if (!m_serviceName.isEmpty() && m_serviceName != serviceName)
+        return;
+
+    applyServices(m_serviceManager->findInterfaces(currentFilter(serviceName)), serviceName);
+}
+
 /*!
     \qmlproperty QQmlListProperty ServiceFilter::serviceDescriptions
 
@@ -523,7 +637,11 @@ void QDeclarativeServiceFilter::componentComplete()
 void QDeclarativeServiceFilter::s_append(QQmlListProperty<QDeclarativeServiceDescriptor> *prop, QDeclarativeServiceDescriptor *service)
 {
     QDeclarativeServiceFilter* list = static_cast<QDeclarativeServiceFilter*>(prop->object);
-    list->m_services.append(*service);//### This does not maintain the reference
+    QDeclarativeServiceDescriptor *descriptor = new QDeclarativeServiceDescriptor(*service);//### This does not maintain the reference
+    descriptor->setParent(list);
+    list->beginInsertRows(QModelIndex(), list->m_services.count(), list->m_services.count());
+    list->m_services.append(descriptor);
+    list->endInsertRows();
     list->serviceDescriptionsChanged();
 }
 int QDeclarativeServiceFilter::s_count(QQmlListProperty<QDeclarativeServiceDescriptor> *prop)
@@ -533,13 +651,17 @@ int QDeclarativeServiceFilter::s_count(QQmlListProperty<QDeclarativeServiceDescr
 
 QDeclarativeServiceDescriptor* QDeclarativeServiceFilter::s_at(QQmlListProperty<QDeclarativeServiceDescriptor> *prop, int index)
 {
-    return &(static_cast<QDeclarativeServiceFilter*>(prop->object)->m_services[index]);
+    return static_cast<QDeclarativeServiceFilter*>(prop->object)->m_services.at(index);
 }
 
 void QDeclarativeServiceFilter::s_clear(QQmlListProperty<QDeclarativeServiceDescriptor> *prop)
 {
     QDeclarativeServiceFilter* list = static_cast<QDeclarativeServiceFilter*>(prop->object);
+    list->beginResetModel();
+    foreach (QDeclarativeServiceDescriptor *descriptor, list->m_services)
+        descriptor->deleteLater();
     list->m_services.clear();
+    list->endResetModel();
     list->serviceDescriptionsChanged();
 }
 #include "moc_qdeclarativeservice_p.cpp"
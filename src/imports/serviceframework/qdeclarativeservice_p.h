@@ -219,7 +219,7 @@ private:
     QServiceReply* m_serviceReply;
 };
 
-class QDeclarativeServiceFilter : public QObject, public QQmlParserStatus {
+class QDeclarativeServiceFilter : public QAbstractListModel, public QQmlParserStatus {
     Q_OBJECT
     Q_INTERFACES(QQmlParserStatus)
     Q_PROPERTY(QString serviceName READ serviceName WRITE setServiceName NOTIFY serviceNameChanged)
@@ -232,8 +232,21 @@ class QDeclarativeServiceFilter : public QObject, public QQmlParserStatus {
     // ### Rename services ?
     Q_PROPERTY(QQmlListProperty<QDeclarativeServiceDescriptor> serviceDescriptions READ serviceDescriptions NOTIFY serviceDescriptionsChanged)
 public:
+    enum Roles {
+        ServiceDescriptorRole = Qt::UserRole + 1,
+        ServiceNameRole,
+        InterfaceNameRole,
+        MajorVersionRole,
+        MinorVersionRole
+    };
+
     QDeclarativeServiceFilter(QObject* parent = 0);
     ~QDeclarativeServiceFilter();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QHash<int, QByteArray> roleNames() const;
+
     QString serviceName() const
     {
         return m_serviceName;
@@ -337,16 +350,19 @@ signals:
 
 private slots:
     void updateServiceList();
-    void servicesAddedRemoved();
+    void updateService(const QString &serviceName);
+    void servicesAddedRemoved(const QString &serviceName);
 private:
+    QServiceFilter currentFilter(const QString &serviceName) const;
+    void applyServices(const QList<QServiceInterfaceDescriptor> &services, const QString &serviceName);
+
     QString m_serviceName;
     QString m_interfaceName;
     int m_majorVersion;
     int m_minorVersion;
     bool m_exactVersionMatching;
     bool m_monitorServiceRegistrations;
-    QQmlListProperty<QDeclarativeServiceDescriptor*> m_serviceDescriptions;
-    QList<QDeclarativeServiceDescriptor> m_services;
+    QList<QDeclarativeServiceDescriptor *> m_services;
 
     QServiceManager* m_serviceManager;
     bool m_componentComplete;
@@ -41,12 +41,16 @@
 #include "qdeclarativeinputdevicemodel_p.h"
 #include "qinputinfo.h"
 
+#include <QtCore/qtimer.h>
+
 QT_BEGIN_NAMESPACE
 
 QDeclarativeInputDeviceModel::QDeclarativeInputDeviceModel(QObject *parent) :
     QAbstractListModel(parent),
     deviceInfoManager(new QInputInfoManager),
-    currentFilter(QInputDevice::UnknownType)
+    currentFilter(QInputDevice::UnknownType),
+    m_lastAddedDevice(0),
+    updatePending(false)
 {
     connect(deviceInfoManager,SIGNAL(ready()),this,SLOT(updateDeviceList()));
     connect(deviceInfoManager,SIGNAL(filterChanged(QInputDevice::InputTypeFlags)),
@@ -56,8 +60,6 @@ QDeclarativeInputDeviceModel::QDeclarativeInputDeviceModel(QObject *parent) :
             this,&QDeclarativeInputDeviceModel::addedDevice);
     connect(deviceInfoManager, &QInputInfoManager::deviceRemoved,
             this,&QDeclarativeInputDeviceModel::removedDevice);
-    connect(deviceInfoManager, &QInputInfoManager::countChanged,
-            this,&QDeclarativeInputDeviceModel::countChanged);
 }
 
 QDeclarativeInputDeviceModel::~QDeclarativeInputDeviceModel()
@@ -82,16 +84,16 @@ QVariant QDeclarativeInputDeviceModel::data(const QModelIndex &index, int role)
         return QVariant::fromValue(static_cast<QString>(device->identifier()));
         break;
     case ButtonsRole:
-        return QVariant::fromValue(static_cast<QList <int> >(device->buttons()));
+        return cachedRoles(device).buttons;
         break;
     case SwitchesRole:
-        return QVariant::fromValue(static_cast<QList <int> >(device->switches()));
+        return cachedRoles(device).switches;
         break;
     case RelativeAxesRole:
-        return QVariant::fromValue(static_cast<QList <int> >(device->relativeAxes()));
+        return cachedRoles(device).relativeAxes;
         break;
     case AbsoluteAxesRole:
-        return QVariant::fromValue(static_cast<QList <int> >(device->absoluteAxes()));
+        return cachedRoles(device).absoluteAxes;
         break;
     case TypesRole:
         return QVariant::fromValue(static_cast<int>(device->types()));
@@ -101,6 +103,24 @@ QVariant QDeclarativeInputDeviceModel::data(const QModelIndex &index, int role)
     return QVariant();
 }
 
+/*
+ * The list roles are converted once per device instead of on every data() call,
+ * delegates ask for them each time they are created.
+ * */
+const QDeclarativeInputDeviceModel::DeviceRoles &QDeclarativeInputDeviceModel::cachedRoles(QInputDevice *device) const
+{
+    QHash<QString, DeviceRoles>::iterator it = roleCache.find(device->identifier());
+    if (it == roleCache.end()) {
+        DeviceRoles roles;
+        roles.buttons = QVariant::fromValue(device->buttons());
+        roles.switches = QVariant::fromValue(device->switches());
+        roles.relativeAxes = QVariant::fromValue(device->relativeAxes());
+        roles.absoluteAxes = QVariant::fromValue(device->absoluteAxes());
+        it = roleCache.insert(device->identifier(), roles);
+    }
+    return it.value();
+}
+
 int QDeclarativeInputDeviceModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
@@ -126,51 +146,122 @@ QInputDevice *QDeclarativeInputDeviceModel::get(int index) const
     return inputDevices.value(index);
 }
 
+/*
+ * Brings the rows in line with the device map of the manager. Rows are keyed by
+ * device identifier and kept in the order of the map, so only the rows of devices
+ * that went away are removed and only new devices are inserted, each run of
+ * adjacent rows in one go.
+ * */
 void QDeclarativeInputDeviceModel::updateDeviceList()
 {
-    QList <QInputDevice *> newDevices = deviceInfoManager->deviceMap().values();
-    int numNew = newDevices.count();
-
-    for (int i = 0; i < numNew; i++) {
-        int j = inputDevices.indexOf(newDevices.value(i));
-
-        if (j == -1) {
-            beginInsertRows(QModelIndex(), i, i);
-            inputDevices.insert(i, newDevices.value(i));
-            endInsertRows();
-        } else if (i != j) {
-            // changed its position -> move it
-            QInputDevice* device = inputDevices.value(j);
-            beginMoveRows(QModelIndex(), j, j, QModelIndex(), i);
-            inputDevices.remove(j);
-            if (i >= inputDevices.size())
-                inputDevices.resize(i + 1);
-            inputDevices.insert(i, device);
-            endMoveRows();
-        } //else {
-        QModelIndex changedIndex(this->index(j, 0, QModelIndex()));
-        Q_EMIT dataChanged(changedIndex, changedIndex);
-    }
+    const QMap <QString, QInputDevice *> newDevices = deviceInfoManager->deviceMap();
+    const int oldCount = inputDevices.count();
 
-    int numOld = inputDevices.count();
-    if (numOld > numNew) {
-        beginRemoveRows(QModelIndex(), numNew, numOld - 1);
-        inputDevices.remove(numNew, numOld - numNew);
+    int row = inputDevices.count() - 1;
+    while (row >= 0) {
+        if (newDevices.value(deviceIdentifiers.at(row)) == inputDevices.at(row)) {
+            row--;
+            continue;
+        }
+
+        int first = row;
+        while (first > 0 && newDevices.value(deviceIdentifiers.at(first - 1)) != inputDevices.at(first - 1))
+            first--;
+
+        beginRemoveRows(QModelIndex(), first, row);
+        for (int i = first; i <= row; i++)
+            roleCache.remove(deviceIdentifiers.at(i));
+        inputDevices.remove(first, row - first + 1);
+        deviceIdentifiers.remove(first, row - first + 1);
         endRemoveRows();
+
+        row = first - 1;
+    }
+
+    // every remaining row is in the map and in map order, anything else is new
+    row = 0;
+    QMap <QString, QInputDevice *>::const_iterator it = newDevices.constBegin();
+    while (it != newDevices.constEnd()) {
+        if (row < inputDevices.count() && inputDevices.at(row) == it.value()) {
+            row++;
+            ++it;
+            continue;
+        }
+
+        QMap <QString, QInputDevice *>::const_iterator last = it;
+        int added = 0;
+        while (last != newDevices.constEnd()
+               && !(row < inputDevices.count() && inputDevices.at(row) == last.value())) {
+            ++last;
+            added++;
+        }
+
+        beginInsertRows(QModelIndex(), row, row + added - 1);
+        for (; it != last; ++it) {
+            inputDevices.insert(row, it.value());
+            deviceIdentifiers.insert(row, it.key());
+            row++;
+        }
+        endInsertRows();
     }
+
+    if (inputDevices.count() != oldCount)
+        Q_EMIT countChanged(inputDevices.count());
 }
 
-void QDeclarativeInputDeviceModel::addedDevice(QInputDevice *device)
+/*
+ * Hotplug events tend to come in bursts, a dock brings several devices at once.
+ * New devices are collected and inserted together on the next event loop run.
+ * */
+void QDeclarativeInputDeviceModel::scheduleUpdate()
 {
+    if (updatePending)
+        return;
+    updatePending = true;
+    QTimer::singleShot(0, this, SLOT(flushPendingChanges()));
+}
+
+void QDeclarativeInputDeviceModel::flushPendingChanges()
+{
+    updatePending = false;
     updateDeviceList();
-    setFilter(currentFilter);
-    Q_EMIT added(device);
+
+    const QList<QPointer<QInputDevice> > addedDevices = pendingAdded;
+    pendingAdded.clear();
+
+    Q_FOREACH (const QPointer<QInputDevice> &device, addedDevices) {
+        if (device)
+            Q_EMIT added(device);
+    }
 }
 
+void QDeclarativeInputDeviceModel::addedDevice(QInputDevice *device)
+{
+    pendingAdded.append(device);
+    scheduleUpdate();
+}
+
+/*
+ * Removals are not batched, the manager deletes the device right after
+ * announcing it, so its row has to go before control returns to the event loop.
+ * */
 void QDeclarativeInputDeviceModel::removedDevice(const QString &devicePath)
 {
-    updateDeviceList();
-    setFilter(currentFilter);
+    for (int i = pendingAdded.count() - 1; i >= 0; i--) {
+        if (!pendingAdded.at(i) || pendingAdded.at(i)->identifier() == devicePath)
+            pendingAdded.removeAt(i);
+    }
+
+    const int row = deviceIdentifiers.indexOf(devicePath);
+    if (row >= 0) {
+        beginRemoveRows(QModelIndex(), row, row);
+        roleCache.remove(devicePath);
+        inputDevices.remove(row);
+        deviceIdentifiers.remove(row);
+        endRemoveRows();
+        Q_EMIT countChanged(inputDevices.count());
+    }
+
     Q_EMIT removed(devicePath);
 }
 
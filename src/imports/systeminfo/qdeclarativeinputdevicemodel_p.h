@@ -42,6 +42,8 @@
 
 #include <QObject>
 #include <QAbstractListModel>
+#include <QHash>
+#include <QPointer>
 #include "qinputinfo.h"
 
 QT_BEGIN_NAMESPACE
@@ -89,14 +91,29 @@ Q_SIGNALS:
 public Q_SLOTS:
     void updateDeviceList();
 private:
+    struct DeviceRoles {
+        QVariant buttons;
+        QVariant switches;
+        QVariant relativeAxes;
+        QVariant absoluteAxes;
+    };
+
+    const DeviceRoles &cachedRoles(QInputDevice *device) const;
+    void scheduleUpdate();
+
     QInputInfoManager *deviceInfoManager;
     QVector<QInputDevice *> inputDevices;
+    QVector<QString> deviceIdentifiers;
     QInputDevice::InputTypeFlags currentFilter;
     QInputDevice *m_lastAddedDevice;
+    mutable QHash<QString, DeviceRoles> roleCache;
+    QList<QPointer<QInputDevice> > pendingAdded;
+    bool updatePending;
 
 private slots:
     void addedDevice(QInputDevice *device);
     void removedDevice(const QString &path);
+    void flushPendingChanges();
 
 };
 
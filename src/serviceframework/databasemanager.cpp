@@ -39,6 +39,7 @@
 
 #include "databasemanager_p.h"
 #include "qserviceinterfacedescriptor_p.h"
+#include "serviceregistryindex_p.h"
 #include <QFileSystemWatcher>
 #include <QHash>
 
@@ -120,12 +121,27 @@ void DatabaseFileWatcher::setEnabled(ServiceDatabase *database, bool enabled)
             SLOT(databaseDirectoryChanged(QString)));
     }
 
+    //system services answered from the registry index change only when the
+    //index is recompiled, so watch the index rather than opening the database
+    if (database == m_manager->m_systemDb && systemIndex()) {
+        const QString indexPath = m_manager->m_systemIndex->indexPath();
+        if (enabled) {
+            m_knownServices[indexPath] = m_manager->m_systemIndex->getServiceNames(QString());
+            m_watcher->addPath(indexPath);
+        } else {
+            m_watcher->removePath(indexPath);
+            m_knownServices.remove(indexPath);
+        }
+        return;
+    }
+
     QString path = database->databasePath();
     if (enabled) {
         if (QFile::exists(path)) {
             if (!database->isOpen())
                 database->open();
             m_knownServices[path] = database->getServiceNames(QString());
+            m_knownVersions[path] = database->changeVersion(&m_knownEpochs[path]);
             m_watcher->addPath(path);
         } else {
             restartDirMonitoring(path, QString());
@@ -133,6 +149,8 @@ void DatabaseFileWatcher::setEnabled(ServiceDatabase *database, bool enabled)
     } else {
         m_watcher->removePath(path);
         m_knownServices.remove(path);
+        m_knownVersions.remove(path);
+        m_knownEpochs.remove(path);
     }
 }
 
@@ -144,12 +162,25 @@ void DatabaseFileWatcher::databaseDirectoryChanged(const QString &path)
     }
 }
 
+/*
+    Returns the registry index that answers system scope queries, opening
+    it if the system database has not been opened instead.
+*/
+ServiceRegistryIndex *DatabaseFileWatcher::systemIndex()
+{
+    if (!m_manager->m_systemIndex && !m_manager->m_systemDb->isOpen())
+        m_manager->openSystemIndex();
+    return m_manager->m_systemIndex;
+}
+
 void DatabaseFileWatcher::databaseChanged(const QString &path)
 {
     if (m_manager->m_userDb && path == m_manager->m_userDb->databasePath())
         notifyChanges(m_manager->m_userDb, DatabaseManager::UserScope);
     else if (path == m_manager->m_systemDb->databasePath())
         notifyChanges(m_manager->m_systemDb, DatabaseManager::SystemScope);
+    else if (m_manager->m_systemIndex && path == m_manager->m_systemIndex->indexPath())
+        notifyIndexChanges();
 
     // if database was deleted, the path may have been dropped
     if (!m_watcher->files().contains(path) && QFile::exists(path))
@@ -161,17 +192,102 @@ void DatabaseFileWatcher::notifyChanges(ServiceDatabase *database, DatabaseManag
     QString dbPath = database->databasePath();
     if (!QFile::exists(dbPath)) {
         m_knownServices.remove(dbPath);
+        m_knownVersions.remove(dbPath);
+        m_knownEpochs.remove(dbPath);
         restartDirMonitoring(dbPath, QString());
         return;
     }
 
+    //try to apply only the changes logged since the last notification
+    //before falling back to comparing the complete list of services
+    qint64 version = m_knownVersions.value(dbPath, -1);
+    const QList<QPair<QString, ServiceDatabase::ChangeType> > changes
+            = database->serviceChanges(&version, m_knownEpochs.value(dbPath));
+    if (database->lastError().code() == DBError::NoError) {
+        QStringList &knownServices = m_knownServices[dbPath];
+        QList<QPair<QString, ServiceDatabase::ChangeType> > notifications;
+        for (int i=0; i<changes.count(); i++) {
+            const QString &serviceName = changes[i].first;
+            if (changes[i].second == ServiceDatabase::ServiceAddedChange) {
+                if (!knownServices.contains(serviceName, Qt::CaseInsensitive)) {
+                    knownServices << serviceName;
+                    notifications << changes[i];
+                }
+            } else if (knownServices.contains(serviceName, Qt::CaseInsensitive)) {
+                QMutableListIterator<QString> it(knownServices);
+                while (it.hasNext()) {
+                    if (it.next().compare(serviceName, Qt::CaseInsensitive) == 0)
+                        it.remove();
+                }
+                notifications << changes[i];
+            }
+        }
+
+        m_knownVersions[dbPath] = version;
+        for (int i=0; i<notifications.count(); i++) {
+            if (notifications[i].second == ServiceDatabase::ServiceAddedChange)
+                emit m_manager->serviceAdded(notifications[i].first, scope);
+            else
+                emit m_manager->serviceRemoved(notifications[i].first, scope);
+        }
+        return;
+    }
+
+    m_knownVersions[dbPath] = database->changeVersion(&m_knownEpochs[dbPath]);
     QStringList currentServices = database->getServiceNames(QString());
     if (database->lastError().code() !=DBError::NoError) {
         qWarning("QServiceManager: failed to get current service names for serviceAdded() and serviceRemoved() signals");
         return;
     }
 
-    const QStringList &knownServicesRef = m_knownServices[dbPath];
+    notifyServiceNames(dbPath, currentServices, scope);
+}
+
+/*
+    Emits the changes of the system services after the registry index
+    has been recompiled or removed.
+*/
+void DatabaseFileWatcher::notifyIndexChanges()
+{
+    ServiceRegistryIndex *index = m_manager->m_systemIndex;
+    const QString indexPath = index->indexPath();
+
+    //a recompiled index replaces the file, so the new one must be mapped
+    if (QFile::exists(indexPath) && index->open(indexPath)) {
+        notifyServiceNames(indexPath, index->getServiceNames(QString()), DatabaseManager::SystemScope);
+        return;
+    }
+
+    //without the index system scope queries resort to the system database
+    m_watcher->removePath(indexPath);
+    const QStringList knownServices = m_knownServices.take(indexPath);
+    delete m_manager->m_systemIndex;
+    m_manager->m_systemIndex = 0;
+
+    ServiceDatabase *database = m_manager->m_systemDb;
+    const QString dbPath = database->databasePath();
+    m_knownServices[dbPath] = knownServices;
+    if (!QFile::exists(dbPath)) {
+        notifyServiceNames(dbPath, QStringList(), DatabaseManager::SystemScope);
+        restartDirMonitoring(dbPath, QString());
+        return;
+    }
+
+    if (!database->isOpen())
+        database->open();
+    m_knownVersions[dbPath] = database->changeVersion(&m_knownEpochs[dbPath]);
+    m_watcher->addPath(dbPath);
+    notifyServiceNames(dbPath, database->getServiceNames(QString()), DatabaseManager::SystemScope);
+}
+
+/*
+    Emits serviceAdded() and serviceRemoved() for the differences between
+    the services last seen at \a path and \a currentServices.
+*/
+void DatabaseFileWatcher::notifyServiceNames(const QString &path, const QStringList &currentServices,
+                                             DatabaseManager::DbScope scope)
+{
+    const QStringList &knownServicesRef = m_knownServices[path];
 
     QSet<QString> currentServicesSet = currentServices.toSet();
     QSet<QString> knownServicesSet = knownServicesRef.toSet();
@@ -190,7 +306,7 @@ void DatabaseFileWatcher::notifyChanges(ServiceDatabase *database, DatabaseManag
             removedServices << knownServicesRef[i];
     }
 
-    m_knownServices[dbPath] = currentServices;
+    m_knownServices[path] = currentServices;
     for (int i=0; i<newServices.count(); i++)
         emit m_manager->serviceAdded(newServices[i], scope);
     for (int i=0; i<removedServices.count(); i++)
@@ -244,6 +360,7 @@ bool lessThan(const QServiceInterfaceDescriptor &d1,
 DatabaseManager::DatabaseManager()
     : m_userDb(NULL),
       m_systemDb(new ServiceDatabase),
+      m_systemIndex(0),
       m_fileWatcher(0),
       m_hasAccessedUserDb(false),
       m_alreadyWarnedOpenError(false)
@@ -274,6 +391,9 @@ DatabaseManager::~DatabaseManager()
         delete m_systemDb;
     }
     m_systemDb = 0;
+
+    delete m_systemIndex;
+    m_systemIndex = 0;
 }
 
 
@@ -321,7 +441,7 @@ void DatabaseManager::initDbPath(DbScope scope)
 bool DatabaseManager::registerService(ServiceMetaDataResults &service, DbScope scope)
 {
     if (scope == DatabaseManager::SystemScope) {
-        if (!openDb(DatabaseManager::SystemScope)) {
+        if (!openDb(DatabaseManager::SystemScope) || !isSystemDbWritable()) {
             return false;
         }  else {
             if (!m_systemDb->registerService(service)) {
@@ -347,6 +467,32 @@ bool DatabaseManager::registerService(ServiceMetaDataResults &service, DbScope s
     }
 }
 
+/*
+    Adds the details of all \a services into the service database corresponding
+    to \a scope using a single transaction.  Either all of the services are
+    registered or none of them are.
+
+    Returns true if the operation succeeded and false otherwise.
+    The last error is set when this function is called.
+*/
+bool DatabaseManager::registerServices(const QList<ServiceMetaDataResults> &services, DbScope scope)
+{
+    if (!openDb(scope == DatabaseManager::SystemScope ? DatabaseManager::SystemScope : DatabaseManager::UserScope))
+        return false;
+    if (scope == DatabaseManager::SystemScope && !isSystemDbWritable())
+        return false;
+
+    //openDb() may have recreated the database object
+    ServiceDatabase *db = (scope == DatabaseManager::SystemScope) ? m_systemDb : m_userDb;
+    if (!db->registerServices(services)) {
+        m_lastError = db->lastError();
+        return false;
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return true;
+}
+
 /*
     Removes the details of \serviceName from the database corresponding to \a
     scope.
@@ -357,7 +503,7 @@ bool DatabaseManager::registerService(ServiceMetaDataResults &service, DbScope s
 bool DatabaseManager::unregisterService(const QString &serviceName, DbScope scope)
 {
     if (scope == DatabaseManager::SystemScope) {
-        if (!openDb(DatabaseManager::SystemScope))
+        if (!openDb(DatabaseManager::SystemScope) || !isSystemDbWritable())
             return false;
    else {
             if (!m_systemDb->unregisterService(serviceName)) {
@@ -394,7 +540,7 @@ bool DatabaseManager::serviceInitialized(const QString &serviceName, DbScope sco
 {
     ServiceDatabase *db = (scope == DatabaseManager::SystemScope) ? m_systemDb : m_userDb;
 
-    if (!openDb(scope)) {
+    if (!openDb(scope) || (scope == SystemScope && !isSystemDbWritable())) {
         return false;
     } else {
         if (!db->serviceInitialized(serviceName)) {
@@ -436,10 +582,11 @@ QList<QServiceInterfaceDescriptor>  DatabaseManager::getInterfaces(const QServic
     }
 
     if (openDb(SystemScope)) {
-        descriptors.append(m_systemDb->getInterfaces(filter));
-        if (m_systemDb->lastError().code() != DBError::NoError) {
+        descriptors.append(m_systemIndex ? m_systemIndex->getInterfaces(filter)
+                                         : m_systemDb->getInterfaces(filter));
+        if (systemDbLastError().code() != DBError::NoError) {
             descriptors.clear();
-            m_lastError = m_systemDb->lastError();
+            m_lastError = systemDbLastError();
             return descriptors;
         }
 
@@ -484,10 +631,11 @@ QStringList DatabaseManager::getServiceNames(const QString &interfaceName, Datab
 
     if (openDb(DatabaseManager::SystemScope)) {
         QStringList systemServiceNames;
-        systemServiceNames = m_systemDb->getServiceNames(interfaceName);
-        if (m_systemDb->lastError().code() != DBError::NoError) {
+        systemServiceNames = m_systemIndex ? m_systemIndex->getServiceNames(interfaceName)
+                                           : m_systemDb->getServiceNames(interfaceName);
+        if (systemDbLastError().code() != DBError::NoError) {
             serviceNames.clear();
-            m_lastError = m_systemDb->lastError();
+            m_lastError = systemDbLastError();
             return serviceNames;
         }
         foreach (const QString &systemServiceName, systemServiceNames) {
@@ -534,13 +682,14 @@ QServiceInterfaceDescriptor DatabaseManager::interfaceDefault(const QString &int
                 return QServiceInterfaceDescriptor();
             }
 
-            descriptor = m_systemDb->getInterface(interfaceID);
+            descriptor = m_systemIndex ? m_systemIndex->getInterface(interfaceID)
+                                       : m_systemDb->getInterface(interfaceID);
             //found the service from the system database
-            if (m_systemDb->lastError().code() == DBError::NoError) {
+            if (systemDbLastError().code() == DBError::NoError) {
                 m_lastError.setError(DBError::NoError);
                 descriptor.d->scope = QService::SystemScope;
                 return descriptor;
-            } else if (m_systemDb->lastError().code() == DBError::NotFound) {
+            } else if (systemDbLastError().code() == DBError::NotFound) {
                 //service implementing interface doesn't exist in the system db
                 //so the user db must contain a stale entry so remove it
                 m_userDb->removeExternalDefaultServiceInterface(interfaceID);
@@ -584,15 +733,16 @@ QServiceInterfaceDescriptor DatabaseManager::interfaceDefault(const QString &int
             return QServiceInterfaceDescriptor();
         }
     } else {
-        descriptor = m_systemDb->interfaceDefault(interfaceName);
-        if (m_systemDb->lastError().code() == DBError::NoError) {
+        descriptor = m_systemIndex ? m_systemIndex->interfaceDefault(interfaceName)
+                                   : m_systemDb->interfaceDefault(interfaceName);
+        if (systemDbLastError().code() == DBError::NoError) {
             descriptor.d->scope = QService::SystemScope;
             return descriptor;
-        } else if (m_systemDb->lastError().code() == DBError::NotFound) {
-            m_lastError = m_systemDb->lastError();
+        } else if (systemDbLastError().code() == DBError::NotFound) {
+            m_lastError = systemDbLastError();
             return QServiceInterfaceDescriptor();
         } else {
-            m_lastError = m_systemDb->lastError();
+            m_lastError = systemDbLastError();
             return QServiceInterfaceDescriptor();
         }
     }
@@ -668,8 +818,9 @@ bool DatabaseManager::setInterfaceDefault(const QServiceInterfaceDescriptor &des
             if (!openDb(SystemScope))
                 return false;
 
-            QString interfaceDescriptorID = m_systemDb->getInterfaceID(descriptor);
-            if (m_systemDb->lastError().code() == DBError::NoError) {
+            QString interfaceDescriptorID = m_systemIndex ? m_systemIndex->getInterfaceID(descriptor)
+                                                          : m_systemDb->getInterfaceID(descriptor);
+            if (systemDbLastError().code() == DBError::NoError) {
                 if (m_userDb->setInterfaceDefault(descriptor, interfaceDescriptorID)) {
                     m_lastError.setError(DBError::NoError);
                     return true;
@@ -678,7 +829,7 @@ bool DatabaseManager::setInterfaceDefault(const QServiceInterfaceDescriptor &des
                     return false;
                 }
             } else {
-                m_lastError = m_systemDb->lastError();
+                m_lastError = systemDbLastError();
                 return false;
             }
         }
@@ -689,7 +840,7 @@ bool DatabaseManager::setInterfaceDefault(const QServiceInterfaceDescriptor &des
             m_lastError.setError(DBError::InvalidDescriptorScope, errorText);
             return false;
         } else {
-            if (!openDb(SystemScope)) {
+            if (!openDb(SystemScope) || !isSystemDbWritable()) {
                 return false;
             } else {
                 if (m_systemDb->setInterfaceDefault(descriptor)) {
@@ -711,6 +862,14 @@ bool DatabaseManager::setInterfaceDefault(const QServiceInterfaceDescriptor &des
 */
 bool DatabaseManager::openDb(DbScope scope)
 {
+    if (scope == SystemScope && m_systemIndex) {
+        if (QFile::exists(m_systemIndex->indexPath()))
+            return true;
+        //the index has been removed, resort to the system database
+        delete m_systemIndex;
+        m_systemIndex = 0;
+    }
+
     if (scope == SystemScope && m_systemDb->isOpen() && !QFile::exists(m_systemDb->databasePath())) {
         delete m_systemDb;
         m_systemDb = new ServiceDatabase;
@@ -735,7 +894,7 @@ bool DatabaseManager::openDb(DbScope scope)
     if (db->isOpen())
         return true;
 
-    bool isOpen = db->open();
+    bool isOpen = (scope == SystemScope && openSystemIndex()) || db->open();
     if (!isOpen) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
         qWarning() << "DatabaseManger::openDb():-"
@@ -800,6 +959,55 @@ bool DatabaseManager::openDb(DbScope scope)
     return true;
 }
 
+/*
+    Opens the precompiled registry index that accompanies the system
+    database, if there is one.  System scope queries are then answered
+    from the index and the system database is never opened.
+
+    Returns true if the index was opened, false otherwise.
+*/
+bool DatabaseManager::openSystemIndex()
+{
+    const QString indexPath = ServiceRegistryIndex::indexPath(m_systemDb->databasePath());
+    if (!QFile::exists(indexPath))
+        return false;
+
+    ServiceRegistryIndex *index = new ServiceRegistryIndex;
+    if (!index->open(indexPath)) {
+        qWarning() << "Service Framework:- Ignoring service registry index:"
+                   << qPrintable(index->lastError().text());
+        delete index;
+        return false;
+    }
+
+    m_systemIndex = index;
+    return true;
+}
+
+/*
+    Returns true if the system database can be modified.  If system scope
+    queries are answered from a precompiled registry index, the last error
+    is set and false is returned; the index has to be recompiled instead.
+*/
+bool DatabaseManager::isSystemDbWritable()
+{
+    if (!m_systemIndex)
+        return true;
+
+    QString errorText(QLatin1String("System services are provided by a read-only registry index: %1"));
+    m_lastError.setError(DBError::NoWritePermissions, errorText.arg(m_systemIndex->indexPath()));
+    return false;
+}
+
+/*
+    Returns the last error of whichever of the system database or the
+    registry index answers system scope queries.
+*/
+DBError DatabaseManager::systemDbLastError() const
+{
+    return m_systemIndex ? m_systemIndex->lastError() : m_systemDb->lastError();
+}
+
 /*
     Returns the interface descriptor with the highest version from the
     list of interface \a descriptors
@@ -63,6 +63,7 @@
 QT_BEGIN_NAMESPACE
 
 class DatabaseFileWatcher;
+class ServiceRegistryIndex;
 class Q_AUTOTEST_EXPORT DatabaseManager : public QObject
 {
     Q_OBJECT
@@ -73,6 +74,7 @@ class Q_AUTOTEST_EXPORT DatabaseManager : public QObject
         virtual ~DatabaseManager();
 
         bool registerService(ServiceMetaDataResults &service, DbScope scope);
+        bool registerServices(const QList<ServiceMetaDataResults> &services, DbScope scope);
         bool unregisterService(const QString &serviceName, DbScope scope);
         bool serviceInitialized(const QString &serviceName, DbScope scope);
 
@@ -94,9 +96,13 @@ class Q_AUTOTEST_EXPORT DatabaseManager : public QObject
     private:
         void initDbPath(DbScope scope);
         bool openDb(DbScope scope);
+        bool openSystemIndex();
+        bool isSystemDbWritable();
+        DBError systemDbLastError() const;
 
         ServiceDatabase *m_userDb;
         ServiceDatabase *m_systemDb;
+        ServiceRegistryIndex *m_systemIndex;
         DBError m_lastError;
 
         friend class DatabaseFileWatcher;
@@ -122,12 +128,18 @@ private Q_SLOTS:
 
 private:
     void notifyChanges(ServiceDatabase *database, DatabaseManager::DbScope scope);
+    void notifyIndexChanges();
+    void notifyServiceNames(const QString &path, const QStringList &currentServices,
+                            DatabaseManager::DbScope scope);
+    ServiceRegistryIndex *systemIndex();
     QString closestExistingParent(const QString &path);
     void restartDirMonitoring(const QString &dbPath, const QString &previousDirPath);
 
     DatabaseManager *m_manager;
     QFileSystemWatcher *m_watcher;
     QHash<QString, QStringList> m_knownServices;
+    QHash<QString, qint64> m_knownVersions;
+    QHash<QString, QString> m_knownEpochs;
     QStringList m_monitoredDbPaths;
 };
 
@@ -54,9 +54,12 @@
 #include "qserviceframeworkglobal.h"
 #include <QString>
 
+// exported so that the servicefw tool can link against the database classes
+#define SERVICEDATABASE_EXPORT Q_SERVICEFW_EXPORT
+
 QT_BEGIN_NAMESPACE
 
-class Q_AUTOTEST_EXPORT DBError
+class SERVICEDATABASE_EXPORT DBError
 {
     public:
         enum ErrorCode {
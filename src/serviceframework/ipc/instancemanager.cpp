@@ -116,6 +116,24 @@ const QMetaObject* InstanceManager::metaObject(const QRemoteServiceRegister::Ent
     }
 }
 
+/*!
+    \internal
+
+    Returns the execution policy of a registered service identified by its \a entry.
+    Global instances are shared between clients and always use
+    QRemoteServiceRegister::SharedThreadExecution.
+*/
+QRemoteServiceRegister::ExecutionPolicy InstanceManager::executionPolicy(const QRemoteServiceRegister::Entry& entry) const
+{
+    QMutexLocker ml(&lock);
+    if (metaMap.contains(entry)) {
+        const QRemoteServiceRegisterEntryPrivate *entryData = metaMap[entry].entryData.data();
+        if (entryData->instanceType == QRemoteServiceRegister::PrivateInstance)
+            return entryData->executionPolicy;
+    }
+    return QRemoteServiceRegister::SharedThreadExecution;
+}
+
 /*!
    \internal
 
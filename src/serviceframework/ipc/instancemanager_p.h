@@ -88,6 +88,7 @@ public:
     bool addType(const QRemoteServiceRegister::Entry& entry);
 
     const QMetaObject* metaObject(const QRemoteServiceRegister::Entry& ident) const;
+    QRemoteServiceRegister::ExecutionPolicy executionPolicy(const QRemoteServiceRegister::Entry& ident) const;
     QList<QRemoteServiceRegister::Entry> allEntries() const;
 
     int totalInstances() const;
@@ -44,6 +44,9 @@ equals(SFW_BACKEND,unix) {
     error("Unkown SFW_BACKEND $$SFW_BACKEND")
 }
 
+# users of the module, e.g. the IPC tests, check the backend that was built
+MODULE_CONFIG += sfw_$${SFW_BACKEND}_backend
+
 PRIVATE_HEADERS += ipc/qslotinvoker_p.h \
     ipc/qsignalintercepter_p.h \
     ipc/instancemanager_p.h \
@@ -51,7 +54,9 @@ PRIVATE_HEADERS += ipc/qslotinvoker_p.h \
     ipc/proxyobject_p.h \
     ipc/ipcendpoint_p.h \
     ipc/qremoteserviceregister_p.h \
-    ipc/qremoteserviceregisterentry_p.h
+    ipc/qremoteserviceregisterentry_p.h \
+    ipc/qserviceipcstatistics_p.h \
+    ipc/qservicesupervisor_p.h
 
 SOURCES += ipc/qslotinvoker.cpp \
     ipc/qsignalintercepter.cpp \
@@ -59,7 +64,9 @@ SOURCES += ipc/qslotinvoker.cpp \
     ipc/qservicepackage.cpp \
     ipc/proxyobject.cpp \
     ipc/ipcendpoint.cpp \
-    ipc/qremoteserviceregister_p.cpp
+    ipc/qremoteserviceregister_p.cpp \
+    ipc/qserviceipcstatistics.cpp \
+    ipc/qservicesupervisor.cpp
 
 OTHER_FILES += \
     ipc/json-schema.txt
@@ -87,7 +87,11 @@ void QServiceIpcEndPoint::terminateConnection()
     qWarning() << "SFW Terminate connection called on base class, should be reimplemented to do something";
 }
 
-int QServiceIpcEndPoint::waitForData()
+/*
+    Waits for at most \a msecs milliseconds, or 30 seconds if \a msecs is
+    negative, until a response arrives or the wait is interrupted.
+*/
+int QServiceIpcEndPoint::waitForData(int msecs)
 {
     QEventLoop loop;
     QTimer timer;
@@ -95,7 +99,7 @@ int QServiceIpcEndPoint::waitForData()
     connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
     connect(this, SIGNAL(packageReceived()), &loop, SLOT(quit()));
 
-    timer.start(30000);
+    timer.start(msecs < 0 ? 30000 : msecs);
     loop.exec();
     return 0;
 }
@@ -105,5 +109,14 @@ void QServiceIpcEndPoint::waitingDone()
     emit packageReceived();
 }
 
+/*
+    Makes a waitForData() call return early. Unlike the other functions
+    this may be called from any thread.
+*/
+void QServiceIpcEndPoint::interruptWait()
+{
+    emit packageReceived();
+}
+
 #include "moc_ipcendpoint_p.cpp"
 QT_END_NAMESPACE
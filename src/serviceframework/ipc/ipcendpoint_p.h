@@ -73,8 +73,9 @@ public:
 
     void writePackage(QServicePackage newPackage);
 
-    virtual int waitForData();
+    virtual int waitForData(int msecs = -1);
     virtual void waitingDone();
+    virtual void interruptWait();
 
     virtual void getSecurityCredentials(QServiceClientCredentials& creds);
 
@@ -44,13 +44,22 @@
 #include "qsignalintercepter_p.h"
 #include "qserviceclientcredentials.h"
 #include "qserviceclientcredentials_p.h"
+#include "qserviceipcstatistics_p.h"
 #include <QTimer>
 #include <QEvent>
 #include <QVarLengthArray>
+#include <QVector>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QJsonDocument>
 #include <QCoreApplication>
 #include <QFile>
 #include <QStringList>
+#include <QDataStream>
 
 #include "qservicedebuglog_p.h"
 
@@ -63,7 +72,7 @@ QT_BEGIN_NAMESPACE
 class Response
 {
 public:
-    Response() : isFinished(false), result(0)
+    Response() : isFinished(false), result(0), bytes(0)
     { }
 
     ~Response()
@@ -72,6 +81,7 @@ public:
     bool isFinished;
     void* result;
     QString error;
+    quint32 bytes;
 };
 
 class ServiceSignalIntercepter : public QSignalIntercepter
@@ -92,15 +102,20 @@ public:
 
 protected:
     void activated( const QList<QVariant>& args )
+    {
+        endPoint->invokeRemote(metaIndex, args, QMetaType::Void);
+    }
+
+    void rawActivated( void **a )
     {
         qServiceLog() << "class" << "servicesignalinter"
                       << "event" << "signal"
                       << "endpoint" << endPoint->objectName()
                       << "metaidx" << metaIndex
                       << "signal" << QString::fromLatin1(signal)
-                      << "args" << args.count();
+                      << "args" << parameterTypesCount();
 
-        endPoint->invokeRemote(metaIndex, args, QMetaType::Void);
+        endPoint->invokeRemoteSignal(metaIndex, parameterTypes(), parameterTypesCount(), a);
     }
 private:
     ObjectEndPoint* endPoint;
@@ -109,6 +124,50 @@ private:
 
 };
 
+/*
+    Blocking calls fail after SFW_CALL_TIMEOUT milliseconds, 15 seconds by
+    default. A negative value waits forever.
+*/
+static int qt_sfw_default_call_timeout()
+{
+    static const int timeout = qEnvironmentVariableIsSet("SFW_CALL_TIMEOUT")
+            ? qEnvironmentVariableIntValue("SFW_CALL_TIMEOUT") : 15000;
+    return timeout;
+}
+
+/*
+    Replies of calls which gave up waiting are remembered to drop them
+    quietly. A service that never replies must not make the set grow
+    forever, so it is emptied once it holds this many ids.
+*/
+#define SFW_MAX_ABANDONED_REQUESTS 64
+
+/*
+    The client end points by the proxy they serve. The watchdog functions of
+    QServiceManager look end points up here from any thread, an end point
+    leaves the registry before it is destroyed.
+*/
+struct ObjectEndPointRegistry
+{
+    QMutex lock;
+    QHash<QObject *, ObjectEndPoint *> endPoints;
+};
+
+Q_GLOBAL_STATIC(ObjectEndPointRegistry, _q_objectEndPoints)
+
+/*
+    Precomputed invocation data for one method of the service object.
+    Built once per service object so that a call only needs a table
+    lookup and the argument pointer setup.
+*/
+struct ServiceMethodThunk
+{
+    ServiceMethodThunk() : returnType(QMetaType::Void) {}
+
+    int returnType;
+    QVector<int> parameterTypes;
+};
+
 class ObjectEndPointPrivate
 {
 public:
@@ -119,17 +178,38 @@ public:
     //used on service side
     QRemoteServiceRegister::Entry entry;
     QUuid serviceInstanceId;
+    QHash<int, ServiceSignalIntercepter*> signalIntercepters;
+    QVector<ServiceMethodThunk> methodThunks;
+    QByteArray argumentBuffer;
+    QPointer<QThread> instanceThread;
 
     // user on the client side
     bool functionReturned;
     QUuid waitingOnReturnUuid;
+    bool peerClosed;
+    // calls which gave up waiting, their replies are dropped
+    QSet<QUuid> abandonedRequests;
+    // may be changed from any thread
+    QAtomicInt callTimeout;
+    QAtomicInt cancelGeneration;
+    // key of this end point in the registry
+    QObject *registeredProxy;
+
+    //call counters by meta index, properties use -(index + 1)
+    QHash<int, QServiceMethodStatistics *> callStatistics;
 
     ObjectEndPointPrivate() :
         endPointType(ObjectEndPoint::Service),
         parent(0),
-        functionReturned(false)
+        functionReturned(false),
+        peerClosed(false),
+        callTimeout(qt_sfw_default_call_timeout()),
+        cancelGeneration(0),
+        registeredProxy(0)
     {
         waitingOnReturnUuid = QUuid();
+        //keep the capacity when the buffer is reset for the next message
+        argumentBuffer.reserve(256);
     }
 
     ~ObjectEndPointPrivate()
@@ -137,28 +217,100 @@ public:
     }
 
     //service side
-    void setupSignalIntercepters(QObject * service)
+    /*
+        Signals are only intercepted and forwarded while the client has
+        something connected to them. The client reports its interest per
+        signal with a SignalSubscription package.
+    */
+    void setSignalIntercepted(QObject * service, int metaIndex, bool intercepted)
     {
         Q_ASSERT(endPointType == ObjectEndPoint::Service);
 
-        //create a signal intercepter for each signal
-        //offered by service
+        if (!intercepted) {
+            delete signalIntercepters.take(metaIndex);
+            return;
+        }
+
+        if (signalIntercepters.contains(metaIndex))
+            return;
+
         //exclude QObject signals
-        const QMetaObject* mo = service->metaObject();
-        while (mo && strcmp(mo->className(), "QObject"))
-        {
-            for (int i = mo->methodOffset(); i < mo->methodCount(); ++i) {
-                const QMetaMethod method = mo->method(i);
-                if (method.methodType() == QMetaMethod::Signal) {
-                    QByteArray signal = method.methodSignature();
-                    //add '2' for signal - see QSIGNAL_CODE
-                    ServiceSignalIntercepter* intercept =
-                        new ServiceSignalIntercepter(service, "2"+signal, parent );
-                    intercept->setMetaIndex(i);
-                }
+        const QMetaMethod method = service->metaObject()->method(metaIndex);
+        if (method.methodType() != QMetaMethod::Signal
+                || metaIndex < QObject::staticMetaObject.methodCount()) {
+            qWarning() << "SFW client subscribed to invalid signal index" << metaIndex << "of" << service->metaObject()->className();
+            return;
+        }
+
+        //add '2' for signal - see QSIGNAL_CODE
+        ServiceSignalIntercepter* intercept =
+            new ServiceSignalIntercepter(service, "2" + method.methodSignature(), parent);
+        intercept->setMetaIndex(metaIndex);
+        signalIntercepters.insert(metaIndex, intercept);
+    }
+
+    //service side
+    void setupMethodThunks(const QMetaObject *meta)
+    {
+        Q_ASSERT(endPointType == ObjectEndPoint::Service);
+
+        methodThunks.resize(meta->methodCount());
+        for (int i = 0; i < meta->methodCount(); ++i) {
+            const QMetaMethod method = meta->method(i);
+            ServiceMethodThunk &thunk = methodThunks[i];
+            thunk.returnType = method.returnType();
+            thunk.parameterTypes.resize(method.parameterCount());
+            for (int arg = 0; arg < method.parameterCount(); ++arg)
+                thunk.parameterTypes[arg] = method.parameterType(arg);
+        }
+    }
+
+    const ServiceMethodThunk *methodThunk(int metaIndex) const
+    {
+        if (metaIndex < 0 || metaIndex >= methodThunks.count())
+            return 0;
+        return &methodThunks.at(metaIndex);
+    }
+
+    /*
+        Calls the method at \a metaIndex through the meta call of \a service.
+        Arguments which do not match the parameter type are converted, and
+        the call fails if that is not possible or arguments are missing.
+    */
+    bool invokeMethod(QObject *service, int metaIndex, const ServiceMethodThunk &thunk,
+                      QVariant *args, int argCount, QVariant *returnValue)
+    {
+        const int numArgs = thunk.parameterTypes.count();
+        if (argCount < numArgs)
+            return false;
+
+        QVarLengthArray<void *, 16> a(numArgs + 1);
+        if (thunk.returnType == QMetaType::Void || thunk.returnType == QMetaType::UnknownType) {
+            a[0] = 0;
+        } else if (thunk.returnType == QMetaType::QVariant) {
+            //ignore whether QVariant is a declared meta type or not
+            a[0] = returnValue;
+        } else {
+            *returnValue = QVariant(thunk.returnType, (const void*) 0);
+            a[0] = returnValue->data();
+        }
+
+        for (int arg = 0; arg < numArgs; ++arg) {
+            const int type = thunk.parameterTypes.at(arg);
+            QVariant &value = args[arg];
+            if (type == QMetaType::QVariant) {
+                a[arg + 1] = &value;
+                continue;
             }
-            mo = mo->superClass();
+            if (type != QMetaType::UnknownType && value.userType() != type
+                    && !value.convert(type))
+                return false;
+            if (!value.isValid())
+                return false;
+            a[arg + 1] = value.data();
         }
+
+        return QMetaObject::metacall(service, QMetaObject::InvokeMetaMethod, metaIndex, a.data()) < 0;
     }
 
     /*!
@@ -212,6 +364,12 @@ ObjectEndPoint::ObjectEndPoint(Type type, QServiceIpcEndPoint* comm, QObject* pa
 
 ObjectEndPoint::~ObjectEndPoint()
 {
+    if (d->registeredProxy) {
+        //service is already cleared when the proxy deletes its children
+        ObjectEndPointRegistry *registry = _q_objectEndPoints();
+        QMutexLocker locker(&registry->lock);
+        registry->endPoints.remove(d->registeredProxy);
+    }
     qServiceLog() << "class" << "objectendpoint"
                   << "event" << "delete"
                   << "name" << objectName();
@@ -223,6 +381,8 @@ void ObjectEndPoint::disconnected()
     qServiceLog() << "class" << "objectendpoint"
                   << "event" << "disconnected"
                   << "name" << objectName();
+    d->peerClosed = true;
+    d->abandonedRequests.clear();
     if (d->endPointType == Service) {
         InstanceManager::instance()->removeObjectInstance(d->entry, d->serviceInstanceId);
         deleteLater();
@@ -247,6 +407,8 @@ QObject* ObjectEndPoint::constructProxy(const QRemoteServiceRegister::Entry & en
     //ask for serialized meta object
     //get proxy based on meta object
     //return meta object
+    d->entry = entry;
+
     QServicePackage p;
     p.d = new QServicePackagePrivate();
     p.d->messageId = QUuid::createUuid();
@@ -270,6 +432,12 @@ QObject* ObjectEndPoint::constructProxy(const QRemoteServiceRegister::Entry & en
             qWarning() << "Request for remote service failed";
         else
             service = reinterpret_cast<QServiceProxy* >(response->result);
+        if (service) {
+            ObjectEndPointRegistry *registry = _q_objectEndPoints();
+            QMutexLocker locker(&registry->lock);
+            registry->endPoints.insert(service, this);
+            d->registeredProxy = service;
+        }
     } else {
         qDebug() << Q_FUNC_INFO << "response passed but not finished";
         return 0;
@@ -285,7 +453,9 @@ void ObjectEndPoint::newPackageReady()
 {
     //client and service side
 
-    while (dispatch->packageAvailable() && !d->functionReturned)
+    //stop as soon as the end point has been moved to its instance thread
+    while (dispatch->packageAvailable() && !d->functionReturned
+           && thread() == QThread::currentThread())
     {
         QServicePackage p = dispatch->nextPackage();
         if (!p.isValid())
@@ -301,6 +471,12 @@ void ObjectEndPoint::newPackageReady()
             case QServicePackage::PropertyCall:
                 propertyCall(p);
                 break;
+            case QServicePackage::SignalSubscription:
+                signalSubscription(p);
+                break;
+            case QServicePackage::StatisticsRequest:
+                statisticsRequest(p);
+                break;
             default:
                 qWarning() << "Unknown package type received.";
         }
@@ -328,6 +504,9 @@ void ObjectEndPoint::propertyCall(const QServicePackage& p)
         stream >> callType;
         const QMetaObject::Call c = (QMetaObject::Call) callType;
 
+        QElapsedTimer timer;
+        timer.start();
+
         QVariant result;
         QMetaProperty property = service->metaObject()->property(metaIndex);
         if (property.isValid()) {
@@ -345,6 +524,10 @@ void ObjectEndPoint::propertyCall(const QServicePackage& p)
                     break;
 
             }
+
+            QServiceMethodStatistics *stats = callStatistics(metaIndex, true);
+            stats->addCall(0, data.size());
+            stats->latency.record(timer.nsecsElapsed() / 1000);
         }
 
         if (c == QMetaObject::ReadProperty) {
@@ -362,6 +545,8 @@ void ObjectEndPoint::propertyCall(const QServicePackage& p)
         Q_ASSERT(d->endPointType == ObjectEndPoint::Client);
         static QQueue<QUuid> lastId;
         Response* response = openRequests.value(p.d->messageId);
+        if (!response && d->abandonedRequests.remove(p.d->messageId))
+            return;
         if (response) {
             lastId.enqueue(p.d->messageId);
             while (lastId.count() > 10)
@@ -377,6 +562,7 @@ void ObjectEndPoint::propertyCall(const QServicePackage& p)
             }
             QVariant* variant = new QVariant(p.d->payload);
             response->result = reinterpret_cast<void *>(variant);
+            response->bytes = p.d->wireSize;
 
             dispatch->waitingDone();
         }
@@ -390,6 +576,32 @@ void ObjectEndPoint::propertyCall(const QServicePackage& p)
     }
 }
 
+void ObjectEndPoint::signalSubscription(const QServicePackage& p)
+{
+    //service side
+    Q_ASSERT(d->endPointType == ObjectEndPoint::Service);
+
+    if (!service) { // ingore everything until the service is created
+        qWarning() << Q_FUNC_INFO << "dropping a signal subscription since the object hasn't completed construction";
+        return;
+    }
+
+    QByteArray data = p.d->payload.toByteArray();
+    QDataStream stream(&data, QIODevice::ReadOnly);
+    int metaIndex = -1;
+    bool subscribed = false;
+    stream >> metaIndex;
+    stream >> subscribed;
+
+    qServiceLog() << "class" << "objectendpoint"
+                  << "event" << "signalSubscription"
+                  << "name" << objectName()
+                  << "metaidx" << metaIndex
+                  << "subscribed" << subscribed;
+
+    d->setSignalIntercepted(service, metaIndex, subscribed);
+}
+
 void ObjectEndPoint::objectRequest(const QServicePackage& p)
 {
     if (p.d->responseType != QServicePackage::NotAResponse ) {
@@ -468,7 +680,7 @@ void ObjectEndPoint::objectRequest(const QServicePackage& p)
             return;
         }
 
-        d->setupSignalIntercepters(service);
+        d->setupMethodThunks(service->metaObject());
 
         //send meta object
         d->entry = p.d->entry;
@@ -476,7 +688,67 @@ void ObjectEndPoint::objectRequest(const QServicePackage& p)
         response.d->responseType = QServicePackage::Success;
         response.d->payload = QVariant(data);
         dispatch->writePackage(response);
+
+        if (m->executionPolicy(p.d->entry) == QRemoteServiceRegister::InstanceThreadExecution)
+            moveToInstanceThread();
+    }
+}
+
+/*
+    Service side: moves the end point, its connection and the service
+    instance to a thread of their own. Further requests of this client
+    are decoded and executed there and the replies are written back on
+    the same connection.
+*/
+void ObjectEndPoint::moveToInstanceThread()
+{
+    Q_ASSERT(d->endPointType == ObjectEndPoint::Service);
+
+    if (service->parent()) {
+        qWarning() << "SFW cannot move service instance with a parent to its own thread" << objectName();
+        return;
+    }
+
+    QThread *instanceThread = new QThread;
+    instanceThread->setObjectName(objectName());
+    connect(this, SIGNAL(destroyed()), instanceThread, SLOT(quit()), Qt::DirectConnection);
+    connect(instanceThread, SIGNAL(finished()), instanceThread, SLOT(deleteLater()));
+    d->instanceThread = instanceThread;
+
+    //the service register can no longer own an end point in another thread
+    if (parent()) {
+        connect(parent(), SIGNAL(destroyed()), this, SLOT(joinInstanceThread()),
+                Qt::DirectConnection);
+        setParent(0);
     }
+
+    qServiceLog() << "class" << "objectendpoint"
+                  << "event" << "instance thread"
+                  << "name" << objectName();
+
+    service->moveToThread(instanceThread);
+    moveToThread(instanceThread);
+    instanceThread->start();
+
+    //pick up requests which already arrived
+    QMetaObject::invokeMethod(this, "newPackageReady", Qt::QueuedConnection);
+}
+
+/*
+    Service side: called in the register's thread when the register is
+    destroyed. The end point is deleted in its instance thread, which is
+    then joined so that it does not outlive the register.
+*/
+void ObjectEndPoint::joinInstanceThread()
+{
+    QThread *instanceThread = d->instanceThread;
+    deleteLater();
+    if (!instanceThread || instanceThread == QThread::currentThread())
+        return;
+
+    //deferred deletions are still processed once the event loop has quit
+    instanceThread->quit();
+    instanceThread->wait();
 }
 
 void ObjectEndPoint::methodCall(const QServicePackage& p)
@@ -494,42 +766,50 @@ void ObjectEndPoint::methodCall(const QServicePackage& p)
         QByteArray data = p.d->payload.toByteArray();
         QDataStream stream(&data, QIODevice::ReadOnly);
         int metaIndex = -1;
-        QVariantList args;
+        quint32 argCount = 0;
         stream >> metaIndex;
-        stream >> args;
+        stream >> argCount;
+
+        //decode the QVariantList straight into stack storage,
+        //every serialized QVariant takes at least five bytes
+        if (argCount > quint32(data.size() / 5)) {
+            qWarning() << Q_FUNC_INFO << "dropping a method call or signal with a malformed argument list";
+            return;
+        }
+        QVarLengthArray<QVariant, 8> args(argCount);
+        for (quint32 arg = 0; arg < argCount; ++arg)
+            stream >> args[arg];
 
         if (remoteToLocal)
             metaIndex = remoteToLocal[metaIndex];
 
-        QMetaMethod method = service->metaObject()->method(metaIndex);
-        const bool isSignal = (method.methodType() == QMetaMethod::Signal);
-        const int returnType = method.returnType();
-
-        if (isSignal) {
-            Q_ASSERT(d->endPointType == ObjectEndPoint::Client);
-            // Construct the raw argument list.
-            /*  we ignore a possible return type of the signal. The value is
-                not deterministic and it can actually create memory leaks
-                in moc generated code.
-            */
-            const int numArgs = args.size();
-            QVarLengthArray<void *, 32> a( numArgs+1 );
-            a[0] = 0;
+        if (d->endPointType == ObjectEndPoint::Client) {
+            QMetaMethod method = service->metaObject()->method(metaIndex);
+            if (method.methodType() == QMetaMethod::Signal) {
+                // Construct the raw argument list.
+                /*  we ignore a possible return type of the signal. The value is
+                    not deterministic and it can actually create memory leaks
+                    in moc generated code.
+                */
+                const int numArgs = method.parameterCount();
+                if (args.size() < numArgs) {
+                    qWarning() << Q_FUNC_INFO << "dropping signal" << method.methodSignature() << "with missing arguments";
+                    return;
+                }
+                QVarLengthArray<void *, 32> a( numArgs+1 );
+                a[0] = 0;
+
+                for ( int arg = 0; arg < numArgs; ++arg ) {
+                    if (method.parameterType(arg) == QMetaType::QVariant)
+                        a[arg+1] = (void *)&( args[arg] );
+                    else
+                        a[arg+1] = (void *)( args[arg].data() );
+                }
 
-            const QList<QByteArray> pTypes = method.parameterTypes();
-            for ( int arg = 0; arg < numArgs; ++arg ) {
-                if (pTypes.at(arg) == "QVariant")
-                    a[arg+1] = (void *)&( args[arg] );
-                else
-                    a[arg+1] = (void *)( args[arg].data() );
+                d->triggerConnectedSlots(service, service->metaObject(), metaIndex, a.data());
+                return;
             }
 
-            d->triggerConnectedSlots(service, service->metaObject(), metaIndex, a.data());
-            return;
-        }
-        //service side
-        if (d->endPointType != ObjectEndPoint::Service) {
-
             qWarning() << "SFW FATAL ERROR. Client got a method call that wasn't a signal" << objectName();
 
             qServiceLog() << "error" << "non-signal method call on client"
@@ -549,54 +829,22 @@ void ObjectEndPoint::methodCall(const QServicePackage& p)
             return;
         }
 
-        const char* typenames[] = {0,0,0,0,0,0,0,0,0,0};
-        const void* param[] = {0,0,0,0,0,0,0,0,0,0};
-
-        for (int i=0; i<args.size(); i++) {
-            if (args[i].isValid()) {
-                typenames[i] = args[i].typeName();
-            } else {
-                if (method.parameterTypes().at(i) == "QVariant")
-                    typenames[i] = "QVariant";
-            }
-            param[i] = args[i].constData();
-        }
-
-
-        bool result = false;
-        if (returnType == QMetaType::Void) {
-            result = method.invoke(service,
-                   QGenericArgument(typenames[0], param[0]),
-                   QGenericArgument(typenames[1], param[1]),
-                   QGenericArgument(typenames[2], param[2]),
-                   QGenericArgument(typenames[3], param[3]),
-                   QGenericArgument(typenames[4], param[4]),
-                   QGenericArgument(typenames[5], param[5]),
-                   QGenericArgument(typenames[6], param[6]),
-                   QGenericArgument(typenames[7], param[7]),
-                   QGenericArgument(typenames[8], param[8]),
-                   QGenericArgument(typenames[9], param[9]));
-        } else {
-            //result buffer
-            QVariant returnValue;
-            //ignore whether QVariant is a declared meta type or not
-            if (returnType != QMetaType::QVariant) {
-                returnValue = QVariant(returnType, (const void*) 0);
-            }
-
-            QGenericReturnArgument ret(method.typeName(), returnValue.data());
-            result = method.invoke(service, ret,
-                   QGenericArgument(typenames[0], param[0]),
-                   QGenericArgument(typenames[1], param[1]),
-                   QGenericArgument(typenames[2], param[2]),
-                   QGenericArgument(typenames[3], param[3]),
-                   QGenericArgument(typenames[4], param[4]),
-                   QGenericArgument(typenames[5], param[5]),
-                   QGenericArgument(typenames[6], param[6]),
-                   QGenericArgument(typenames[7], param[7]),
-                   QGenericArgument(typenames[8], param[8]),
-                   QGenericArgument(typenames[9], param[9]));
+        //service side
+        QElapsedTimer timer;
+        timer.start();
+
+        const ServiceMethodThunk *thunk = d->methodThunk(metaIndex);
+        QVariant returnValue;
+        const bool result = thunk && d->invokeMethod(service, metaIndex, *thunk,
+                                                     args.data(), args.size(), &returnValue);
+
+        if (thunk) {
+            QServiceMethodStatistics *stats = callStatistics(metaIndex, false);
+            stats->addCall(0, data.size());
+            stats->latency.record(timer.nsecsElapsed() / 1000);
+        }
 
+        if (!thunk || thunk->returnType != QMetaType::Void) {
             QServicePackage response = p.createResponse();
 
             if (result) {
@@ -606,14 +854,17 @@ void ObjectEndPoint::methodCall(const QServicePackage& p)
                 response.d->responseType = QServicePackage::Failed;
             }
             dispatch->writePackage(response);
-
         }
         if (!result)
-            qWarning( "%s::%s cannot be called.", service->metaObject()->className(), method.methodSignature().constData());
+            qWarning( "%s::%s cannot be called.", service->metaObject()->className(),
+                      service->metaObject()->method(metaIndex).methodSignature().constData());
     } else {
         //client side
         Q_ASSERT(d->endPointType == ObjectEndPoint::Client);
 
+        if (d->abandonedRequests.remove(p.d->messageId))
+            return;
+
         if (d->waitingOnReturnUuid == p.d->messageId) {
             d->functionReturned = true;
         }
@@ -630,6 +881,7 @@ void ObjectEndPoint::methodCall(const QServicePackage& p)
             }
             QVariant* variant = new QVariant(p.d->payload);
             response->result = reinterpret_cast<void *>(variant);
+            response->bytes = p.d->wireSize;
 
             dispatch->waitingDone();
         }
@@ -656,17 +908,25 @@ QVariant ObjectEndPoint::invokeRemoteProperty(int metaIndex, const QVariant& arg
     stream << metaIndex << arg << c;
     p.d->payload = data;
 
+    QServiceMethodStatistics *stats = callStatistics(metaIndex, true);
+
     if (c == QMetaObject::ReadProperty) {
         //create response and block for answer
         Response* response = new Response();
         openRequests.insert(p.d->messageId, response);
 
+        QElapsedTimer timer;
+        timer.start();
+
         dispatch->writePackage(p);
         qServiceLog() << "class" << "objectendpoint"
                       << "event" << "invokeRemoteProperty"
                       << "progress" << "wait for result";
         waitForResponse(p.d->messageId);
 
+        stats->addCall(data.size(), response->bytes);
+        stats->latency.record(timer.nsecsElapsed() / 1000);
+
         QVariant result;
         if (response->isFinished) {
             if (response->result == 0) {
@@ -685,12 +945,70 @@ QVariant ObjectEndPoint::invokeRemoteProperty(int metaIndex, const QVariant& arg
 
         return result;
     } else {
+        stats->addCall(data.size(), 0);
         dispatch->writePackage(p);
     }
 
     return QVariant();
 }
 
+/*
+    Tells the service whether the client has anything connected to the
+    signal with the remote \a metaIndex. Does not block.
+*/
+void ObjectEndPoint::setRemoteSignalSubscribed(int metaIndex, bool subscribed)
+{
+    //client side
+    Q_ASSERT(d->endPointType == ObjectEndPoint::Client);
+
+    QServicePackage p;
+    p.d = new QServicePackagePrivate();
+    p.d->packageType = QServicePackage::SignalSubscription;
+    p.d->messageId = QUuid::createUuid();
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly|QIODevice::Append);
+    stream << metaIndex << subscribed;
+    p.d->payload = data;
+
+    dispatch->writePackage(p);
+}
+
+/*
+    Sends the signal at \a metaIndex to the client. The \a numArgs arguments
+    are written from the signal's argument array \a a straight into the
+    message, in the same format invokeRemote() uses for a QVariantList.
+*/
+void ObjectEndPoint::invokeRemoteSignal(int metaIndex, const int *types, int numArgs, void **a)
+{
+    //service side
+    Q_ASSERT(d->endPointType == ObjectEndPoint::Service);
+
+    QServicePackage p;
+    p.d = new QServicePackagePrivate();
+    p.d->packageType = QServicePackage::MethodCall;
+    p.d->messageId = QUuid::createUuid();
+
+    //reuse the marshalling buffer unless the signal is emitted from another thread
+    QByteArray threadBuffer;
+    QByteArray &data = (QThread::currentThread() == thread()) ? d->argumentBuffer : threadBuffer;
+    data.resize(0);
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << metaIndex << quint32(numArgs);
+        for (int arg = 0; arg < numArgs; ++arg) {
+            if (types[arg] == QSignalIntercepter::QVariantId)
+                stream << *reinterpret_cast<const QVariant *>(a[arg + 1]);
+            else
+                stream << QVariant(types[arg], a[arg + 1]);
+        }
+    }
+    p.d->payload = data;
+
+    callStatistics(metaIndex, false)->addCall(data.size(), 0);
+    dispatch->writePackage(p);
+}
+
 /*
     Will block if return value expected
     Handles signal/slots
@@ -710,22 +1028,33 @@ QVariant ObjectEndPoint::invokeRemote(int metaIndex, const QVariantList& args, i
     stream << metaIndex << args;
     p.d->payload = data;
 
+    QServiceMethodStatistics *stats = callStatistics(metaIndex, false);
+
     if (returnType == QMetaType::Void) {
+        stats->addCall(data.size(), 0);
         dispatch->writePackage(p);
     } else {
         //create response and block for answer
         Response* response = new Response();
         openRequests.insert(p.d->messageId, response);
 
+        //a nested call must not lose the reply of the call it is nested in
+        const QUuid outerCall = d->waitingOnReturnUuid;
         d->waitingOnReturnUuid = p.d->messageId;
 
+        QElapsedTimer timer;
+        timer.start();
+
         dispatch->writePackage(p);
         qServiceLog() << "class" << "objectendpoint"
                       << "event" << "invokeRemote"
                       << "progress" << "wait for result";
         waitForResponse(p.d->messageId);
 
-        d->waitingOnReturnUuid = QUuid();
+        d->waitingOnReturnUuid = outerCall;
+
+        stats->addCall(data.size(), response->bytes);
+        stats->latency.record(timer.nsecsElapsed() / 1000);
 
         QVariant result;
         if (response->isFinished) {
@@ -750,39 +1079,167 @@ QVariant ObjectEndPoint::invokeRemote(int metaIndex, const QVariantList& args, i
     return QVariant();
 }
 
+/*
+    Blocks until the response to \a requestId arrived, the call timed out
+    or was cancelled, or the connection closed. The timeout is read when the
+    call starts, changing it only affects later calls.
+*/
 void ObjectEndPoint::waitForResponse(const QUuid& requestId)
 {
     Q_ASSERT(d->endPointType == ObjectEndPoint::Client);
-    if (openRequests.contains(requestId) ) {
-        Response *r = openRequests.value(requestId);
-        QTime elapsed;
-        elapsed.start();
-        while (r->isFinished == false && (elapsed.elapsed() < 15000)) {
-            qServiceLog() << "class" << "objectendpoint"
-                          << "event" << "waiting"
-                          << "elapsed" << elapsed.elapsed()
-                          << "name" << objectName()
-                          << "uuid" << requestId.toString();
-            int ret = dispatch->waitForData();
-            if (ret != 0) {
-                qWarning() << this << "SFW ipc error" << r->error;
+    Response *r = openRequests.value(requestId);
+    if (!r)
+        return;
+
+    const int timeout = d->callTimeout.load();
+    const int generation = d->cancelGeneration.load();
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    while (!r->isFinished) {
+        if (d->peerClosed) {
+            r->error = QLatin1Literal("end point disconnected");
+            break;
+        }
+        if (d->cancelGeneration.load() != generation) {
+            r->error = QLatin1Literal("call cancelled");
+            break;
+        }
+        int wait = -1;
+        if (timeout >= 0) {
+            wait = timeout - int(elapsed.elapsed());
+            if (wait <= 0) {
+                r->error = QLatin1Literal("call timed out");
                 break;
             }
         }
+        if (dispatch->waitForData(wait) != 0) {
+            r->error = QLatin1Literal("end point disconnected");
+            break;
+        }
+    }
 
-        qServiceLog() << "class" << "objectendpoint"
-                      << "event" << "waiting done"
-                      << "elapsed" << elapsed.elapsed()
-                      << "name" << objectName();
-
-        if (r->isFinished == false) {
-            qWarning() << "SFW IPC failure, remote end failed to respond to blocking IPC call in" << elapsed.elapsed()/1000 << "seconds." << objectName();
+    qServiceLog() << "class" << "objectendpoint"
+                  << "event" << "waiting done"
+                  << "elapsed" << (qint32)elapsed.elapsed()
+                  << "name" << objectName()
+                  << "uuid" << requestId.toString()
+                  << "error" << r->error;
+
+    if (r->isFinished == false) {
+        qWarning() << "SFW IPC failure, blocking call to" << objectName()
+                   << "failed after" << elapsed.elapsed() << "ms:" << r->error;
+        if (!d->peerClosed) {
+            if (d->abandonedRequests.count() >= SFW_MAX_ABANDONED_REQUESTS)
+                d->abandonedRequests.clear();
+            d->abandonedRequests.insert(requestId);
         }
-        if (d->functionReturned) {
-            d->functionReturned = false;
+    }
+    if (d->functionReturned) {
+        d->functionReturned = false;
+        //deliver what arrived after the reply once the caller got it
+        if (dispatch->packageAvailable())
             QMetaObject::invokeMethod(this, "newPackageReady", Qt::QueuedConnection);
+    }
+}
+
+/*
+    Sets the time blocking calls through the end point of \a proxy wait for
+    their reply to \a msecs milliseconds, a negative value waits forever.
+    Returns false if \a proxy is not an inter-process proxy object.
+*/
+bool ObjectEndPoint::setCallTimeout(QObject *proxy, int msecs)
+{
+    ObjectEndPointRegistry *registry = _q_objectEndPoints();
+    QMutexLocker locker(&registry->lock);
+    ObjectEndPoint *endPoint = registry->endPoints.value(proxy);
+    if (!endPoint)
+        return false;
+    endPoint->d->callTimeout.store(msecs);
+    return true;
+}
+
+int ObjectEndPoint::callTimeout(QObject *proxy)
+{
+    ObjectEndPointRegistry *registry = _q_objectEndPoints();
+    QMutexLocker locker(&registry->lock);
+    ObjectEndPoint *endPoint = registry->endPoints.value(proxy);
+    return endPoint ? endPoint->d->callTimeout.load() : 0;
+}
+
+/*
+    Makes the blocking calls currently waiting for a reply from the end
+    point of \a proxy fail. May be called from any thread, the registry
+    lock keeps the end point alive until the wait was interrupted.
+*/
+void ObjectEndPoint::cancelPendingCalls(QObject *proxy)
+{
+    ObjectEndPointRegistry *registry = _q_objectEndPoints();
+    QMutexLocker locker(&registry->lock);
+    if (ObjectEndPoint *endPoint = registry->endPoints.value(proxy)) {
+        endPoint->d->cancelGeneration.ref();
+        endPoint->dispatch->interruptWait();
+    }
+}
+
+/*
+    Returns the counters of the method or property at \a metaIndex. On the
+    client side a method index refers to the remote meta object and is
+    mapped back to the proxy's method to find its signature.
+*/
+QServiceMethodStatistics *ObjectEndPoint::callStatistics(int metaIndex, bool property)
+{
+    //signals may be emitted from other threads than the end point's one
+    const bool cached = QThread::currentThread() == thread();
+    const int key = property ? -(metaIndex + 1) : metaIndex;
+    if (cached) {
+        if (QServiceMethodStatistics *stats = d->callStatistics.value(key))
+            return stats;
+    }
+
+    QByteArray name;
+    const QMetaObject *meta = service ? service->metaObject() : 0;
+    if (meta && property) {
+        name = meta->property(metaIndex).name();
+    } else if (meta) {
+        int localIndex = metaIndex;
+        if (d->endPointType == Client && localToRemote) {
+            localIndex = -1;
+            for (int i = 0; i < meta->methodCount(); ++i) {
+                if (localToRemote[i] == metaIndex) {
+                    localIndex = i;
+                    break;
+                }
+            }
         }
+        name = meta->method(localIndex).methodSignature();
     }
+    if (name.isEmpty())
+        name = QByteArray::number(metaIndex);
+
+    QServiceMethodStatistics *stats = QServiceIpcStatistics::method(
+                d->endPointType == Client ? QServiceIpcStatistics::Client : QServiceIpcStatistics::Service,
+                d->entry.interfaceName(), name);
+    if (cached)
+        d->callStatistics.insert(key, stats);
+    return stats;
+}
+
+/*
+    Answers a request for the statistics of this process. The request may
+    arrive before any object was created on the connection.
+*/
+void ObjectEndPoint::statisticsRequest(const QServicePackage& p)
+{
+    //service side
+    if (d->endPointType != ObjectEndPoint::Service
+            || p.d->responseType != QServicePackage::NotAResponse)
+        return;
+
+    QServicePackage response = p.createResponse();
+    response.d->responseType = QServicePackage::Success;
+    response.d->payload = QJsonDocument(QServiceIpcStatistics::snapshot()).toJson(QJsonDocument::Compact);
+    dispatch->writePackage(response);
 }
 
 void ObjectEndPoint::setLookupTable(int *local, int *remote)
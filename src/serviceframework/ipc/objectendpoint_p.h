@@ -61,6 +61,7 @@
 QT_BEGIN_NAMESPACE
 
 class ObjectEndPointPrivate;
+class QServiceMethodStatistics;
 class Response;
 class ObjectEndPoint : public QObject
 {
@@ -78,12 +79,20 @@ public:
     void objectRequest(const QServicePackage& p);
     void methodCall(const QServicePackage& p);
     void propertyCall(const QServicePackage& p);
+    void signalSubscription(const QServicePackage& p);
+    void statisticsRequest(const QServicePackage& p);
 
     QVariant invokeRemote(int metaIndex, const QVariantList& args, int returnType);
+    void invokeRemoteSignal(int metaIndex, const int *types, int numArgs, void **a);
     QVariant invokeRemoteProperty(int metaIndex, const QVariant& arg, int returnType, QMetaObject::Call c);
+    void setRemoteSignalSubscribed(int metaIndex, bool subscribed);
 
     void setLookupTable(int *local, int *remote);
 
+    static bool setCallTimeout(QObject *proxy, int msecs);
+    static int callTimeout(QObject *proxy);
+    static void cancelPendingCalls(QObject *proxy);
+
 Q_SIGNALS:
     // deprecated, only left for dbus backend internal use
     void pendingRequestFinished();
@@ -92,8 +101,13 @@ public Q_SLOTS:
     void newPackageReady();
     void disconnected();
 
+private Q_SLOTS:
+    void joinInstanceThread();
+
 private:
     void waitForResponse(const QUuid& requestId);
+    void moveToInstanceThread();
+    QServiceMethodStatistics *callStatistics(int metaIndex, bool property);
 
     QServiceIpcEndPoint* dispatch;
     QPointer<QObject> service;
@@ -48,6 +48,8 @@
 
 #include <QDebug>
 #include <QCoreApplication>
+#include <QSet>
+#include <QDataStream>
 
 #include <stdlib.h>
 
@@ -61,7 +63,7 @@ public:
     ObjectEndPoint* endPoint;
     int *localToRemote;
     int *remoteToLocal;
-
+    QSet<int> subscribedSignals;
 };
 
 QServiceProxy::QServiceProxy(const QByteArray& metadata, ObjectEndPoint* endPoint, QObject* parent)
@@ -154,10 +156,6 @@ int QServiceProxy::qt_metacall(QMetaObject::Call c, int id, void **a)
         const QList<QByteArray> pTypes = method.parameterTypes();
         const int pTypesCount = pTypes.count();
         QVariantList args ;
-        if (pTypesCount > 10) {
-            qWarning() << "Cannot call" << method.methodSignature() << ". More than 10 parameter.";
-            return id;
-        }
         for (int i=0; i < pTypesCount; i++) {
             const QByteArray& t = pTypes[i];
 
@@ -237,6 +235,9 @@ int QServiceProxy::qt_metacall(QMetaObject::Call c, int id, void **a)
                 result = d->endPoint->invokeRemoteProperty(metaIndex, arg, pType, c);
                 //wrap result for client
                 if (pType != 0) {
+                    //a failed call returns the default value
+                    if (!result.isValid())
+                        result = QVariant(pType, (const void *) 0);
                     QByteArray buffer;
                     QDataStream stream(&buffer, QIODevice::ReadWrite);
                     QMetaType::save(stream, pType, result.constData());
@@ -272,6 +273,59 @@ void *QServiceProxy::qt_metacast(const char* className)
     return QServiceProxyBase::qt_metacast(className);
 }
 
+void QServiceProxy::connectNotify(const QMetaMethod &signal)
+{
+    QServiceProxyBase::connectNotify(signal);
+    updateSignalSubscription(signal);
+}
+
+void QServiceProxy::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal.isValid()) {
+        updateSignalSubscription(signal);
+    } else if (d->meta) {
+        //all signals were disconnected
+        foreach (int metaIndex, d->subscribedSignals)
+            updateSignalSubscription(d->meta->method(metaIndex));
+    }
+}
+
+/*
+    The service only forwards signals the client subscribed to. Subscribe
+    when the first connection to \a signal is made and unsubscribe when
+    the last one goes away.
+*/
+void QServiceProxy::updateSignalSubscription(const QMetaMethod &signal)
+{
+#ifdef SFW_USE_DBUS_BACKEND
+    Q_UNUSED(signal);
+#else
+    if (!d->meta || signal.methodType() != QMetaMethod::Signal)
+        return;
+
+    //QObject and QServiceProxyBase signals are local to the proxy
+    const int metaIndex = signal.methodIndex();
+    if (metaIndex < d->meta->methodOffset() || d->localToRemote[metaIndex] < 0)
+        return;
+
+    const bool connected = isSignalConnected(signal);
+    if (connected == d->subscribedSignals.contains(metaIndex))
+        return;
+
+    if (connected)
+        d->subscribedSignals.insert(metaIndex);
+    else
+        d->subscribedSignals.remove(metaIndex);
+
+    qServiceLog() << "event" << "signal subscription"
+                  << "signal" << QString::fromLatin1(signal.methodSignature())
+                  << "subscribed" << connected
+                  << "endpoint" << d->endPoint->objectName();
+
+    d->endPoint->setRemoteSignalSubscribed(d->localToRemote[metaIndex], connected);
+#endif
+}
+
 class QServiceProxyBasePrivate
 {
 public:
@@ -99,7 +99,13 @@ public:
     int qt_metacall(QMetaObject::Call c, int id, void **a);
     void *qt_metacast(const char* className);
 
+protected:
+    void connectNotify(const QMetaMethod &signal);
+    void disconnectNotify(const QMetaMethod &signal);
+
 private:
+    void updateSignalSubscription(const QMetaMethod &signal);
+
     QServiceProxyPrivate* d;
     Q_DISABLE_COPY(QServiceProxy);
 };
@@ -405,6 +405,17 @@ bool QRemoteServiceRegisterPrivate::isServiceRunning(const QRemoteServiceRegiste
     return reply.value();
 }
 
+/*
+    The D-Bus backend doesn't go through ObjectEndPoint, so there are no
+    statistics to ask for.
+*/
+QByteArray QRemoteServiceRegisterPrivate::statisticsForService(const QString &location, int timeout)
+{
+    Q_UNUSED(timeout);
+    qWarning() << "SFW IPC statistics are not available with the D-Bus backend" << location;
+    return QByteArray();
+}
+
 #include "moc_qremoteserviceregister_dbus_p.cpp"
 #include "qremoteserviceregister_dbus_p.moc"
 QT_END_NAMESPACE
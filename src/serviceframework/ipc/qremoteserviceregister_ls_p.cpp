@@ -43,6 +43,7 @@
 #include "objectendpoint_p.h"
 #include "qserviceclientcredentials_p.h"
 #include "qserviceclientcredentials.h"
+#include "qserviceipcstatistics_p.h"
 
 #include <QLocalServer>
 #include <QEventLoop>
@@ -62,6 +63,7 @@
 #include <sys/un.h>
 #include <sys/socket.h>
 #include <errno.h>
+#include <unistd.h>
 #else
 // Needed for ::Sleep, while we wait for a better solution
 #include <windows.h>
@@ -176,6 +178,9 @@ protected:
             socket->close();
             return;
         }
+
+        QServiceIpcStatistics::transport()->addWritten(sizeblock.length() + block.length());
+        QServiceIpcStatistics::transport()->addPackageWritten();
     }
 
 protected Q_SLOTS:
@@ -205,6 +210,9 @@ protected Q_SLOTS:
             }
 
             if (pending_bytes == 0 && !pending_buf.isEmpty()) {
+                QServiceIpcStatistics::transport()->addRead(sizeof(quint32) + pending_buf.length());
+                QServiceIpcStatistics::transport()->addPackageRead();
+
                 QDataStream in(pending_buf);
                 in.setVersion(QDataStream::Qt_4_6);
                 QServicePackage package;
@@ -279,6 +287,20 @@ bool QRemoteServiceRegisterLocalSocketPrivate::createServiceEndPoint(const QStri
     localServer = new QLocalServer(this);
     connect(localServer, SIGNAL(newConnection()), this, SLOT(processIncoming()));
 
+#if defined(Q_OS_UNIX) && QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    // started by a client that already listens on our address for us
+    int listenfd = takeListenSocket(ident);
+    if (listenfd != -1) {
+        if (localServer->listen(listenfd)) {
+            if (localServer->hasPendingConnections())
+                QMetaObject::invokeMethod(this, "processIncoming", Qt::QueuedConnection);
+            return true;
+        }
+        qWarning() << "Cannot adopt inherited local socket endpoint" << localServer->errorString();
+        ::close(listenfd);
+    }
+#endif
+
     //other IPC mechanisms such as dbus may have to publish the
     //meta object definition for all registered service types
     QLocalServer::removeServer(ident);
@@ -299,6 +321,35 @@ QRemoteServiceRegisterPrivate* QRemoteServiceRegisterPrivate::constructPrivateOb
   return new QRemoteServiceRegisterLocalSocketPrivate(parent);
 }
 
+#if defined(Q_OS_UNIX) && QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+/*
+    Starts the service at \a location with its listening socket already
+    created, see QRemoteServiceRegisterPrivate::createListenSocket().
+    Returns false if the service has to be started the old way.
+*/
+static bool qt_sfw_activate_service(const QString &location)
+{
+    const QString fullPath = QDir::cleanPath(QDir::tempPath()) + QLatin1Char('/') + location;
+    int listenfd = QRemoteServiceRegisterPrivate::createListenSocket(fullPath);
+    if (listenfd == -1)
+        return errno == EADDRINUSE;
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QProcess process;
+    process.setProgram(location);
+    bool started = QRemoteServiceRegisterPrivate::passListenSocket(listenfd, location, &env);
+    if (started) {
+        process.setProcessEnvironment(env);
+        started = process.startDetached();
+    }
+    ::close(listenfd);
+
+    if (!started)
+        QLocalServer::removeServer(location);
+    return started;
+}
+#endif
+
 /*
     Creates endpoint on client side.
 */
@@ -315,9 +366,20 @@ QObject* QRemoteServiceRegisterPrivate::proxyForService(const QRemoteServiceRegi
             QString path = location;
             qWarning() << "Cannot connect to remote service, trying to start service " << path;
 
+            bool activated = false;
+#if defined(Q_OS_UNIX) && QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+            activated = qt_sfw_activate_service(location);
+            if (activated) {
+                // queued by the kernel until the service accepts it
+                socket->connectToServer(location);
+                if (!socket->waitForConnected())
+                    qWarning() << "Cannot connect to started service" << socket->errorString();
+            }
+#endif
+
             qint64 pid = 0;
             // Start the service as a detached process
-            if (QProcess::startDetached(path, QStringList(), QString(), &pid)){
+            if (!activated && QProcess::startDetached(path, QStringList(), QString(), &pid)){
                 int i;
                 socket->connectToServer(location);
                 for (i = 0; !socket->isValid() && i < 1000; i++){
@@ -338,7 +400,7 @@ QObject* QRemoteServiceRegisterPrivate::proxyForService(const QRemoteServiceRegi
                     return false;
                 }
             }
-            else {
+            else if (!activated) {
                 qWarning() << "Server could not be started";
             }
         }
@@ -375,6 +437,25 @@ bool QRemoteServiceRegisterPrivate::isServiceRunning(const QRemoteServiceRegiste
     return socket->waitForConnected(1000);
 }
 
+/*
+    Connects to the service at \a location without starting it and asks
+    it for its statistics.
+*/
+QByteArray QRemoteServiceRegisterPrivate::statisticsForService(const QString &location, int timeout)
+{
+    QLocalSocket* socket = new QLocalSocket();
+    socket->connectToServer(location);
+    if (!socket->waitForConnected(qMin(timeout, 1000))) {
+        qWarning() << "SFW service is not running at" << location;
+        delete socket;
+        return QByteArray();
+    }
+
+    LocalSocketEndPoint connection(socket);
+    connection.setObjectName(location + QStringLiteral(" statistics"));
+    return QServiceIpcStatistics::requestSnapshot(&connection, timeout);
+}
+
 #include "moc_qremoteserviceregister_ls_p.cpp"
 #include "qremoteserviceregister_ls_p.moc"
 QT_END_NAMESPACE
@@ -42,15 +42,33 @@
 #include "instancemanager_p.h"
 
 #include <QCoreApplication>
+#include <QTimer>
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#endif
 
 QT_BEGIN_NAMESPACE
 
 QRemoteServiceRegisterPrivate::QRemoteServiceRegisterPrivate(QObject* parent)
-    : QObject(parent), iFilter(0),
+    : QObject(parent), m_idleTimeout(0), m_idleTimer(0), iFilter(0),
       securityOptions(QRemoteServiceRegister::NoOptions),
       userIdentifier(0), userIdentifierSet(false),
       groupIdentifier(0), groupIdentifierSet(false)
 {
+    // set by QServiceSupervisor for the services it starts
+    if (qEnvironmentVariableIsSet("SFW_IDLE_TIMEOUT"))
+        m_idleTimeout = qEnvironmentVariableIntValue("SFW_IDLE_TIMEOUT");
     setQuitOnLastInstanceClosed(true);
 }
 
@@ -77,11 +95,54 @@ void QRemoteServiceRegisterPrivate::setQuitOnLastInstanceClosed(bool quit)
 {
     m_quit = quit;
     if (m_quit) {
-        connect(InstanceManager::instance(), SIGNAL(allInstancesClosed()), QCoreApplication::instance(), SLOT(quit()));
+        connect(InstanceManager::instance(), SIGNAL(allInstancesClosed()),
+                this, SLOT(lastInstanceClosed()), Qt::UniqueConnection);
     }
     else {
-        disconnect(InstanceManager::instance(), SIGNAL(allInstancesClosed()), QCoreApplication::instance(), SLOT(quit()));
+        disconnect(InstanceManager::instance(), SIGNAL(allInstancesClosed()), this, SLOT(lastInstanceClosed()));
+        if (m_idleTimer)
+            m_idleTimer->stop();
+    }
+}
+
+int QRemoteServiceRegisterPrivate::idleTimeout() const
+{
+    return m_idleTimeout;
+}
+
+void QRemoteServiceRegisterPrivate::setIdleTimeout(int msecs)
+{
+    m_idleTimeout = msecs;
+    if (m_idleTimer && m_idleTimer->isActive()) {
+        if (msecs > 0)
+            m_idleTimer->start(msecs);
+        else
+            m_idleTimer->stop();
+    }
+}
+
+void QRemoteServiceRegisterPrivate::lastInstanceClosed()
+{
+    if (m_idleTimeout == 0) {
+        QCoreApplication::quit();
+        return;
+    }
+    if (m_idleTimeout < 0)
+        return;
+
+    if (!m_idleTimer) {
+        m_idleTimer = new QTimer(this);
+        m_idleTimer->setSingleShot(true);
+        connect(m_idleTimer, SIGNAL(timeout()), this, SLOT(idleTimeoutExpired()));
     }
+    m_idleTimer->start(m_idleTimeout);
+}
+
+void QRemoteServiceRegisterPrivate::idleTimeoutExpired()
+{
+    // a client may have come back in the meantime
+    if (m_quit && InstanceManager::instance()->totalInstances() < 1)
+        QCoreApplication::quit();
 }
 
 QRemoteServiceRegister::SecurityFilter QRemoteServiceRegisterPrivate::setSecurityFilter(QRemoteServiceRegister::SecurityFilter filter)
@@ -152,5 +213,160 @@ QRemoteServiceRegisterPrivate *QRemoteServiceRegisterPrivate::constructPrivateOb
     return d;
 }
 
+#ifdef Q_OS_UNIX
+/*
+    Socket activation: when a client has to start a service it creates the
+    listening socket at the service address itself and passes it to the
+    service process, which adopts it in publishServices(). The client can
+    connect right away, the kernel queues the connection until the service
+    gets around to accepting it, so nobody has to poll for the service to
+    come up.
+
+    The socket is passed by number in SFW_LISTEN_FD, SFW_LISTEN_ADDRESS
+    names the address it was created for.
+*/
+
+static bool qt_sfw_bind_listen(int fd, const QByteArray &path)
+{
+    struct sockaddr_un name;
+    if (path.size() >= int(sizeof(name.sun_path))) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    ::memset(&name, 0, sizeof(name));
+    name.sun_family = PF_UNIX;
+    ::memcpy(name.sun_path, path.constData(), path.size() + 1);
+
+    if (::bind(fd, (const sockaddr *)&name, sizeof(name)) == -1)
+        return false;
+    if (::listen(fd, 50) == -1) {
+        int error = errno;
+        ::unlink(path.constData());
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+static bool qt_sfw_is_stale_socket(const QByteArray &path)
+{
+    struct sockaddr_un name;
+    ::memset(&name, 0, sizeof(name));
+    name.sun_family = PF_UNIX;
+    ::memcpy(name.sun_path, path.constData(), path.size() + 1);
+
+    int fd = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return false;
+    bool stale = ::connect(fd, (struct sockaddr *)&name, sizeof(name)) == -1
+            && errno == ECONNREFUSED;
+    ::close(fd);
+    return stale;
+}
+
+/*
+    Creates a listening socket at \a path for a service that is about to
+    be started. The socket is bound under a temporary name and linked into
+    place once it listens, so clients never see an address nobody listens
+    on. Returns -1 with errno set to EADDRINUSE if another client already
+    got there first, the caller should then simply connect.
+*/
+int QRemoteServiceRegisterPrivate::createListenSocket(const QString &path)
+{
+    static QBasicAtomicInt serial = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+    const QByteArray location = QFile::encodeName(path);
+    const QByteArray tempLocation = location + '.' + QByteArray::number(::getpid())
+            + '.' + QByteArray::number(serial.fetchAndAddRelaxed(1)) + ".activate";
+
+    int fd = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    ::unlink(tempLocation.constData());
+    if (!qt_sfw_bind_listen(fd, tempLocation)) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    ::chmod(tempLocation.constData(),
+            S_IWUSR|S_IRUSR|S_IWGRP|S_IRGRP|S_IWOTH|S_IROTH);
+
+    int ret = ::link(tempLocation.constData(), location.constData());
+    if (ret == -1 && errno == EEXIST && qt_sfw_is_stale_socket(location)) {
+        // left behind by a service that did not shut down cleanly
+        ::unlink(location.constData());
+        ret = ::link(tempLocation.constData(), location.constData());
+    }
+    int error = errno;
+    ::unlink(tempLocation.constData());
+
+    if (ret == -1) {
+        ::close(fd);
+        errno = (error == EEXIST) ? EADDRINUSE : error;
+        return -1;
+    }
+    return fd;
+}
+
+/*
+    Makes \a fd survive the exec of the service and tells the service about
+    it, either in \a env or, when called in the forked child, in the
+    process environment.
+*/
+bool QRemoteServiceRegisterPrivate::passListenSocket(int fd, const QString &ident, QProcessEnvironment *env)
+{
+    if (::fcntl(fd, F_SETFD, 0) == -1)
+        return false;
+    if (env) {
+        env->insert(QStringLiteral("SFW_LISTEN_FD"), QString::number(fd));
+        env->insert(QStringLiteral("SFW_LISTEN_ADDRESS"), ident);
+        return true;
+    }
+    return qputenv("SFW_LISTEN_FD", QByteArray::number(fd))
+            && qputenv("SFW_LISTEN_ADDRESS", ident.toLocal8Bit());
+}
+
+/*
+    Returns the listening socket passed by the client that started this
+    process if it was created for \a ident, or -1.
+*/
+int QRemoteServiceRegisterPrivate::takeListenSocket(const QString &ident)
+{
+    const QByteArray fdString = qgetenv("SFW_LISTEN_FD");
+    if (fdString.isEmpty() || QString::fromLocal8Bit(qgetenv("SFW_LISTEN_ADDRESS")) != ident)
+        return -1;
+
+    // not for our own children
+    qunsetenv("SFW_LISTEN_FD");
+    qunsetenv("SFW_LISTEN_ADDRESS");
+
+    bool ok = false;
+    const int fd = fdString.toInt(&ok);
+    if (!ok || fd < 0)
+        return -1;
+
+    int value = 0;
+    socklen_t len = sizeof(value);
+    if (::getsockopt(fd, SOL_SOCKET, SO_TYPE, &value, &len) == -1 || value != SOCK_STREAM) {
+        qWarning() << "SFW ignoring inherited listen socket" << fd << "for" << ident;
+        return -1;
+    }
+#ifdef SO_ACCEPTCONN
+    value = 0;
+    len = sizeof(value);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &value, &len) == -1 || !value) {
+        qWarning() << "SFW inherited socket" << fd << "for" << ident << "is not listening";
+        return -1;
+    }
+#endif
+
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+#endif
+
 #include "moc_qremoteserviceregister_p.cpp"
 QT_END_NAMESPACE
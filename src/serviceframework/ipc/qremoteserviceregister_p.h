@@ -57,6 +57,9 @@
 
 QT_BEGIN_NAMESPACE
 
+class QProcessEnvironment;
+class QTimer;
+
 class ObjectEndPoint;
 class QRemoteServiceRegisterPrivate: public QObject
 {
@@ -71,6 +74,9 @@ public:
     virtual bool quitOnLastInstanceClosed() const;
     virtual void setQuitOnLastInstanceClosed(const bool quit);
 
+    int idleTimeout() const;
+    void setIdleTimeout(int msecs);
+
     virtual QRemoteServiceRegister::SecurityFilter setSecurityFilter(QRemoteServiceRegister::SecurityFilter filter);
 
     void setBaseUserIdentifier(qintptr uid);
@@ -88,12 +94,18 @@ public Q_SLOTS:
     // Must be implemented in the subclass
     //void processIncoming();
 
+private Q_SLOTS:
+    void lastInstanceClosed();
+    void idleTimeoutExpired();
+
 protected:
     virtual QRemoteServiceRegister::SecurityFilter getSecurityFilter();
     QRemoteServiceRegister::SecurityAccessOptions getSecurityOptions() const;
 
 private:
     bool m_quit;
+    int m_idleTimeout;
+    QTimer *m_idleTimer;
     QRemoteServiceRegister::SecurityFilter iFilter;
     QRemoteServiceRegister::SecurityAccessOptions securityOptions;
     qintptr userIdentifier;
@@ -106,6 +118,14 @@ public:
     static QObject* proxyForService(const QRemoteServiceRegister::Entry& entry, const QString& location);
     static QRemoteServiceRegisterPrivate* constructPrivateObject(QObject *parent);
     static bool isServiceRunning(const QRemoteServiceRegister::Entry&, const QString& location);
+    // Asks a running service for its IPC statistics, see QServiceIpcStatistics
+    static QByteArray statisticsForService(const QString& location, int timeout);
+#ifdef Q_OS_UNIX
+    // Socket activation, a launching client hands the listening socket to the service
+    static int createListenSocket(const QString &path);
+    static bool passListenSocket(int fd, const QString &ident, QProcessEnvironment *env = 0);
+    static int takeListenSocket(const QString &ident);
+#endif
     // Create a private object based on the service type
     static QRemoteServiceRegisterPrivate* constructPrivateObject(QService::Type serviceType, QObject *parent);
 };
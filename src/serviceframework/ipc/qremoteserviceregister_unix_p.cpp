@@ -44,6 +44,7 @@
 #include "qserviceclientcredentials_p.h"
 #include "qserviceclientcredentials.h"
 #include "qservicedebuglog_p.h"
+#include "qserviceipcstatistics_p.h"
 
 #include <QDataStream>
 #include <QTimer>
@@ -54,6 +55,9 @@
 #include <QDir>
 #include <QEvent>
 #include <QThreadStorage>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
 #include <QStandardPaths>
 #include <QString>
 
@@ -76,9 +80,15 @@
 #include <stdio.h>
 #ifndef Q_OS_MAC
 #include <sys/inotify.h>
+#include <sys/eventfd.h>
 #endif
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+#include <string.h>
 
 
 #ifdef LOCAL_PEERCRED /* from sys/un.h */
@@ -90,6 +100,7 @@ QT_BEGIN_NAMESPACE
 //IPC based on unix domain sockets
 
 class UnixEndPoint;
+class UnixChannelEndPoint;
 class Waiter;
 
 static void qt_ignore_sigpipe()
@@ -111,9 +122,74 @@ static void qt_ignore_sigpipe()
 #endif
 }
 
+/*
+    Packages of at least SFW_SHM_PAYLOAD_THRESHOLD bytes are not pushed
+    through the socket. They are written to a sealed memfd segment and only
+    the descriptor is passed with SCM_RIGHTS, preceded by an eight byte frame
+    of SFW_SHM_PAYLOAD_MARKER and the size of the package.
+*/
+#define SFW_SHM_PAYLOAD_THRESHOLD (256 * 1024)
+#define SFW_SHM_PAYLOAD_MARKER 0xffffffffu
+#define SFW_MAX_PASSED_FDS 16
+
+#if defined(Q_OS_LINUX) && defined(SYS_memfd_create)
+#define SFW_USE_SHM_PAYLOAD
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+
+#define SFW_SHM_PAYLOAD_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE)
+
+/*
+    Copies \a data into a new memfd segment and seals it, so the receiver
+    can map it without the sender changing it underneath. Returns -1 on
+    failure, in which case the package is sent inline.
+*/
+static int qt_create_payload_segment(const QByteArray &data)
+{
+    int fd = ::syscall(SYS_memfd_create, "sfw-payload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return -1;
+
+    if (::ftruncate(fd, data.size()) == -1) {
+        ::close(fd);
+        return -1;
+    }
+
+    void *segment = ::mmap(0, data.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+    if (segment == MAP_FAILED) {
+        ::close(fd);
+        return -1;
+    }
+    memcpy(segment, data.constData(), data.size());
+    ::munmap(segment, data.size());
+
+    if (::fcntl(fd, F_ADD_SEALS, SFW_SHM_PAYLOAD_SEALS | F_SEAL_SEAL) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
 Q_GLOBAL_STATIC(QThreadStorage<QList<UnixEndPoint *> >, _q_unixendpoints);
 Q_GLOBAL_STATIC(QThreadStorage<QList<QRemoteServiceRegisterUnixPrivate *> >, _q_remoteservice);
 Q_GLOBAL_STATIC(QThreadStorage<QList<Waiter *> >, _q_connectionfds);
+Q_GLOBAL_STATIC(QThreadStorage<QHash<QString, QPointer<UnixEndPoint> > >, _q_unixconnectionpool);
 
 class Waiter
 {
@@ -183,12 +259,17 @@ public:
     bool event(QEvent *e);
     void terminateConnection(bool error);
 
-    int waitForData();
+    int waitForData(int msecs = -1);
+    void interruptWait();
     static int last_packet_size;
     static int operation_sequence;
     static QStringList op_log;
 
     static int runLocalEventLoop(int msec = 5000);
+
+    UnixChannelEndPoint *openChannel(quint32 channelId = 0);
+    void setPooled(bool pooled);
+    bool isReusable();
 Q_SIGNALS:
     void errorUnrecoverableIPCFault(QService::UnrecoverableIPCError);
 
@@ -198,6 +279,7 @@ protected:
 protected Q_SLOTS:
     void readIncoming();
     void flushWriteBuffer();
+    void flushChannelPackages();
 
     void registerWithThreadData();
     void socketError(const QString &error);
@@ -206,25 +288,92 @@ protected Q_SLOTS:
 
 private:
 
-    int write(const char *data, int len);
+    int write(const char *data, int len, int passFd = -1);
+    void readPackage(const QByteArray &data);
+    bool readPayloadSegment(quint32 size);
+    void closePassedFds();
+    void routePackage(const QServicePackage &package);
+    void writeChannelPackage(const QServicePackage &package);
+    void closeChannel(UnixChannelEndPoint *channel);
 
     int client_fd;
     bool connection_open;
     QSocketNotifier *readNotifier;
     QSocketNotifier *writeNotifier;
     QByteArray pending_write;
+    // descriptors to pass with the byte at the given offset of pending_write
+    QList<QPair<int, int> > pending_write_fds;
 
-    QRemoteServiceRegisterUnixPrivate *serviceRegPriv;
+    QPointer<QRemoteServiceRegisterUnixPrivate> serviceRegPriv;
     QByteArray pending_header;
     QByteArray pending_buf;
     quint32 pending_bytes;
+    bool pending_segment;
+    QList<int> received_fds;
+
+    // wakes a blocking wait up from other threads, created by the first wait
+    QAtomicInt wake_fd;
+    QAtomicInt wake_pending;
+
+    // logical channels multiplexed over this connection, the channels
+    // may live in other threads than the connection itself
+    QMutex channelLock;
+    QHash<quint32, UnixChannelEndPoint *> channels;
+    QList<QServicePackage> channelWrites;
+    quint32 lastChannelId;
+    bool pooled;
+    bool released;
+
+    friend class UnixChannelEndPoint;
+    friend class QRemoteServiceRegisterUnixPrivate;
+};
+
+/*
+    One proxy's view of a connection shared by all proxies to the same
+    service location. Packages are tagged with the channel id on the way
+    out and handed over by the connection on the way in.
+*/
+class UnixChannelEndPoint : public QServiceIpcEndPoint
+{
+    Q_OBJECT
+public:
+    UnixChannelEndPoint(UnixEndPoint *connection, quint32 channelId);
+    ~UnixChannelEndPoint();
+
+    quint32 channelId() const { return id; }
+
+    void getSecurityCredentials(QServiceClientCredentials &creds);
+    int waitForData(int msecs = -1);
+    void interruptWait();
+
+    void deliverPackage(const QServicePackage &package);
+    void connectionClosed();
+
+protected:
+    void flushPackage(const QServicePackage& package);
+
+protected Q_SLOTS:
+    void deliverPending();
+
+private:
+    QPointer<UnixEndPoint> connection;
+    quint32 id;
+    QMutex pendingLock;
+    QList<QServicePackage> pending;
 };
 
 UnixEndPoint::UnixEndPoint(int client_fd, QObject* parent)
     : QServiceIpcEndPoint(parent),
       client_fd(client_fd),
       connection_open(true),
-      pending_bytes(0)
+      pending_bytes(0),
+      pending_segment(false),
+      wake_fd(-1),
+      wake_pending(0),
+      channelLock(QMutex::Recursive),
+      lastChannelId(0),
+      pooled(false),
+      released(false)
 
 {
     qt_ignore_sigpipe();
@@ -255,6 +404,10 @@ UnixEndPoint::~UnixEndPoint()
                   << "was_open" << (connection_open ? 1 : 0);
     if (connection_open)
         terminateConnection(false);
+    if (!pending_write.isEmpty())
+        QServiceIpcStatistics::transport()->addPendingWrite(-pending_write.size());
+    if (wake_fd.load() != -1)
+        ::close(wake_fd.load());
 }
 
 void UnixEndPoint::getSecurityCredentials(QServiceClientCredentials &creds)
@@ -328,7 +481,23 @@ void UnixEndPoint::terminateConnection(bool error)
         ::close(client_fd);
         client_fd = -1;
         connection_open = false;
+        closePassedFds();
         emit disconnected();
+
+        QMutexLocker locker(&channelLock);
+        QHash<quint32, UnixChannelEndPoint *> closed;
+        closed.swap(channels);
+        foreach (UnixChannelEndPoint *channel, closed)
+            channel->connectionClosed();
+
+        // a dead pooled connection is of no further use, the pool only
+        // keeps a guarded pointer and opens a new connection next time
+        if (pooled && !released) {
+            released = true;
+            deleteLater();
+        }
+        locker.unlock();
+
         if (error)
             ipcfault();
     } else {
@@ -338,13 +507,36 @@ void UnixEndPoint::terminateConnection(bool error)
     }
 }
 
-int UnixEndPoint::waitForData()
+int UnixEndPoint::waitForData(int msecs)
 {
     /* no point waiting around for a dead client */
     if (client_fd == -1)
         return -1;
 
-    return UnixEndPoint::runLocalEventLoop();
+#ifndef Q_OS_MAC
+    if (wake_fd.load() == -1)
+        wake_fd.fetchAndStoreOrdered(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+#endif
+    // an interruption before the descriptor existed
+    if (wake_pending.fetchAndStoreOrdered(0))
+        return 0;
+
+    return UnixEndPoint::runLocalEventLoop(msecs < 0 ? 5000 : msecs);
+}
+
+/*
+    Wakes up the thread waiting in waitForData(), may be called from any
+    thread.
+*/
+void UnixEndPoint::interruptWait()
+{
+    wake_pending.fetchAndStoreOrdered(1);
+    const int fd = wake_fd.loadAcquire();
+    if (fd != -1) {
+        const quint64 one = 1;
+        if (::write(fd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN)
+            qWarning() << "SFW failed to interrupt wait" << qt_error_string(errno);
+    }
 }
 
 int UnixEndPoint::runLocalEventLoop(int msec) {
@@ -375,6 +567,12 @@ int UnixEndPoint::runLocalEventLoop(int msec) {
         if (n <= e->client_fd) {
             n = e->client_fd+1;
         }
+        const int wake = e->wake_fd.load();
+        if (wake != -1) {
+            FD_SET(wake, &reader);
+            if (n <= wake)
+                n = wake+1;
+        }
     }
 
     QList<QRemoteServiceRegisterUnixPrivate *> &endpu = _q_remoteservice()->localData();
@@ -403,10 +601,9 @@ int UnixEndPoint::runLocalEventLoop(int msec) {
         }
     }
 
-    tv.tv_usec = msec*1000;
     // OSX does not support usec > 1 million
-    tv.tv_sec = tv.tv_usec%1000000;
-    tv.tv_usec /= 1000000;
+    tv.tv_sec = msec / 1000;
+    tv.tv_usec = (msec % 1000) * 1000;
 
 //    QServiceDebugLog::instance()->appendToLog(QStringLiteral("<!> select"));
 
@@ -456,6 +653,13 @@ int UnixEndPoint::runLocalEventLoop(int msec) {
     }
 
     foreach (UnixEndPoint *e, endp) {
+        const int wake = e->wake_fd.load();
+        if (wake != -1 && FD_ISSET(wake, &reader)) {
+            quint64 count;
+            while (::read(wake, &count, sizeof(count)) == sizeof(count))
+                ;
+            e->wake_pending.store(0);
+        }
         if (FD_ISSET(e->client_fd, &reader)) {
             e->readIncoming();
         }
@@ -479,7 +683,7 @@ int UnixEndPoint::runLocalEventLoop(int msec) {
     }
 
 #ifdef QT_SFW_IPC_DEBUG
-    const char *times_str = ::getenv("SFW_BLOCKING_TIMES");
+    const char *times_str = QServiceDebugLog::isEnabled() ? ::getenv("SFW_BLOCKING_TIMES") : 0;
     if (times_str) {
         int times = QString::fromLatin1(times_str).toInt();
         if (total_time.elapsed() > times) {
@@ -509,28 +713,52 @@ void UnixEndPoint::flushPackage(const QServicePackage& package)
     outsize << size;
 
 #ifdef QT_SFW_IPC_DEBUG
-    const QMetaObject *mo = &QServicePackage::staticMetaObject;
+    if (QServiceDebugLog::isEnabled()) {
+        const QMetaObject *mo = &QServicePackage::staticMetaObject;
 
-    const QMetaEnum typeEnum = mo->enumerator(
-                mo->indexOfEnumerator("Type"));
-    const char *type = typeEnum.valueToKey(package.d->packageType);
+        const QMetaEnum typeEnum = mo->enumerator(
+                    mo->indexOfEnumerator("Type"));
+        const char *type = typeEnum.valueToKey(package.d->packageType);
 
-    const QMetaEnum rtypeEnum = mo->enumerator(
-                mo->indexOfEnumerator("ResponseType"));
-    const char *rtype = rtypeEnum.valueToKey(package.d->responseType);
+        const QMetaEnum rtypeEnum = mo->enumerator(
+                    mo->indexOfEnumerator("ResponseType"));
+        const char *rtype = rtypeEnum.valueToKey(package.d->responseType);
 
-    qServiceLog() << "class" << "unixep"
-                  << "event" << "write"
-                  << "fd" << client_fd
-                  << "size" << (qint32)size
-                  << "name" << objectName()
-                  << "packageType" << type
-                  << "respType" << rtype;
+        qServiceLog() << "class" << "unixep"
+                      << "event" << "write"
+                      << "fd" << client_fd
+                      << "size" << (qint32)size
+                      << "name" << objectName()
+                      << "packageType" << type
+                      << "respType" << rtype;
+    }
 #endif
 
     if (!connection_open)
         return;
 
+    QServiceIpcStatistics::transport()->addPackageWritten();
+
+#ifdef SFW_USE_SHM_PAYLOAD
+    if (size >= SFW_SHM_PAYLOAD_THRESHOLD) {
+        const int segment = qt_create_payload_segment(block);
+        if (segment != -1) {
+            QByteArray frame;
+            QDataStream outframe(&frame, QIODevice::WriteOnly);
+            outframe.setVersion(QDataStream::Qt_4_6);
+            outframe << quint32(SFW_SHM_PAYLOAD_MARKER) << size;
+
+            qServiceLog() << "class" << "unixep"
+                          << "event" << "write segment"
+                          << "fd" << client_fd
+                          << "size" << (qint32)size;
+
+            write(frame.constData(), frame.length(), segment);
+            return;
+        }
+    }
+#endif
+
     int bytes = write(sizeblock.constData(), sizeblock.length());
     if (bytes != sizeof(quint32)) {
         qWarning() << "SFW Failed to write length" << client_fd << bytes;
@@ -559,7 +787,39 @@ void UnixEndPoint::readIncoming()
 
     QByteArray raw_data;
     raw_data.resize(4096);
-    int bytes = ::read(client_fd, raw_data.data(), 4096);
+
+    // payload segments arrive as descriptors attached to their frame
+    char control[CMSG_SPACE(sizeof(int) * SFW_MAX_PASSED_FDS)];
+    struct iovec iov;
+    iov.iov_base = raw_data.data();
+    iov.iov_len = raw_data.size();
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+#ifdef MSG_CMSG_CLOEXEC
+    int bytes = ::recvmsg(client_fd, &msg, MSG_CMSG_CLOEXEC);
+#else
+    int bytes = ::recvmsg(client_fd, &msg, 0);
+#endif
+    if (bytes > 0) {
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            const int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *fds = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            for (int i = 0; i < count; ++i)
+                received_fds.append(fds[i]);
+        }
+        if (msg.msg_flags & MSG_CTRUNC) {
+            qWarning() << "SFW dropped passed descriptors, closing connection" << objectName();
+            terminateConnection(true);
+            return;
+        }
+    }
     if (bytes <= 0) {
         /* Linux can give us a spurious EAGAIN, only check on error */
         /* No Comment */
@@ -578,6 +838,7 @@ void UnixEndPoint::readIncoming()
     }
     readNotifier->setEnabled(true);
     raw_data.resize(bytes);
+    QServiceIpcStatistics::transport()->addRead(bytes);
 
     while (!raw_data.isEmpty()) {
 
@@ -591,6 +852,10 @@ void UnixEndPoint::readIncoming()
                 in_size >> pending_bytes;
                 pending_buf.clear();
                 pending_header.clear();
+                // the size of a payload segment follows its marker
+                pending_segment = (pending_bytes == SFW_SHM_PAYLOAD_MARKER);
+                if (pending_segment)
+                    pending_bytes = sizeof(quint32);
             }
         }
 
@@ -605,39 +870,265 @@ void UnixEndPoint::readIncoming()
         }
 
         if (pending_bytes == 0 && !pending_buf.isEmpty()) {
-            QDataStream in(pending_buf);
-            in.setVersion(QDataStream::Qt_4_6);
-            QServicePackage package;
-            in >> package;
+            if (pending_segment) {
+                QDataStream in_size(pending_buf);
+                in_size.setVersion(QDataStream::Qt_4_6);
+                quint32 size = 0;
+                in_size >> size;
+                pending_buf.clear();
+                pending_segment = false;
+                if (!readPayloadSegment(size)) {
+                    terminateConnection(true);
+                    return;
+                }
+            } else {
+                const QByteArray data = pending_buf;
+                pending_buf.clear();
+                readPackage(data);
+            }
+        }
+    }
+
+    Q_ASSERT(raw_data.isEmpty());
+}
+
+void UnixEndPoint::readPackage(const QByteArray &data)
+{
+    QServiceIpcStatistics::transport()->addPackageRead();
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_4_6);
+    QServicePackage package;
+    in >> package;
 
 #ifdef QT_SFW_IPC_DEBUG
-            int size = pending_buf.length();
-            const QMetaObject *mo = &QServicePackage::staticMetaObject;
+    if (QServiceDebugLog::isEnabled()) {
+        int size = data.length();
+        const QMetaObject *mo = &QServicePackage::staticMetaObject;
 
-            const QMetaEnum typeEnum = mo->enumerator(
-                        mo->indexOfEnumerator("Type"));
-            const char *type = typeEnum.valueToKey(package.d->packageType);
+        const QMetaEnum typeEnum = mo->enumerator(
+                    mo->indexOfEnumerator("Type"));
+        const char *type = typeEnum.valueToKey(package.d->packageType);
 
-            const QMetaEnum rtypeEnum = mo->enumerator(
-                        mo->indexOfEnumerator("ResponseType"));
-            const char *rtype = rtypeEnum.valueToKey(package.d->responseType);
+        const QMetaEnum rtypeEnum = mo->enumerator(
+                    mo->indexOfEnumerator("ResponseType"));
+        const char *rtype = rtypeEnum.valueToKey(package.d->responseType);
 
-            qServiceLog() << "class" << "unixep"
-                          << "event" << "read"
-                          << "fd" << client_fd
-                          << "size" << (qint32)size
-                          << "name" << objectName()
-                          << "packageType" << type
-                          << "respType" << rtype;
+        qServiceLog() << "class" << "unixep"
+                      << "event" << "read"
+                      << "fd" << client_fd
+                      << "size" << (qint32)size
+                      << "name" << objectName()
+                      << "packageType" << type
+                      << "respType" << rtype;
+    }
 #endif
 
-            incoming.enqueue(package);
-            pending_buf.clear();
-            emit readyRead();
+    if (package.isValid() && package.d->channelId) {
+        routePackage(package);
+        return;
+    }
+
+    incoming.enqueue(package);
+    emit readyRead();
+}
+
+/*
+    Hands a package received on a shared connection to its channel. On the
+    service side the first package of an unknown channel creates the end
+    point serving it, like accepting a new connection would.
+*/
+void UnixEndPoint::routePackage(const QServicePackage &package)
+{
+    const quint32 channelId = package.d->channelId;
+
+    QMutexLocker locker(&channelLock);
+    UnixChannelEndPoint *channel = channels.value(channelId);
+
+    if (package.d->packageType == QServicePackage::ChannelClosed) {
+        if (channel) {
+            qServiceLog() << "class" << "unixep"
+                          << "event" << "channel closed"
+                          << "client_fd" << client_fd
+                          << "channel" << (qint32)channelId;
+            channels.remove(channelId);
+            channel->connectionClosed();
         }
+        return;
     }
 
-    Q_ASSERT(raw_data.isEmpty());
+    if (!channel) {
+        if (!serviceRegPriv || serviceRegPriv->thread() != thread()
+                || package.d->packageType != QServicePackage::ObjectCreation
+                || package.d->responseType != QServicePackage::NotAResponse) {
+            qServiceLog() << "class" << "unixep"
+                          << "event" << "drop unknown channel"
+                          << "client_fd" << client_fd
+                          << "channel" << (qint32)channelId;
+            return;
+        }
+
+        channel = openChannel(channelId);
+        ObjectEndPoint *endpoint = new ObjectEndPoint(ObjectEndPoint::Service, channel, serviceRegPriv);
+        endpoint->setObjectName(channel->objectName());
+    }
+
+    // a channel in another thread only queues the package, holding the
+    // lock keeps it from being destroyed meanwhile
+    if (channel->thread() != QThread::currentThread()) {
+        channel->deliverPackage(package);
+        return;
+    }
+
+    locker.unlock();
+    channel->deliverPackage(package);
+}
+
+/*
+    Opens the logical channel \a channelId on this connection, or the next
+    free one if \a channelId is 0.
+*/
+UnixChannelEndPoint *UnixEndPoint::openChannel(quint32 channelId)
+{
+    QMutexLocker locker(&channelLock);
+    if (!channelId) {
+        do {
+            channelId = ++lastChannelId;
+        } while (!channelId || channels.contains(channelId));
+    }
+
+    UnixChannelEndPoint *channel = new UnixChannelEndPoint(this, channelId);
+    channel->setObjectName(objectName() + QString(QLatin1String(" channel %1")).arg(channelId));
+    channels.insert(channelId, channel);
+
+    qServiceLog() << "class" << "unixep"
+                  << "event" << "channel open"
+                  << "client_fd" << client_fd
+                  << "channel" << (qint32)channelId
+                  << "channels" << channels.count();
+    return channel;
+}
+
+void UnixEndPoint::closeChannel(UnixChannelEndPoint *channel)
+{
+    QMutexLocker locker(&channelLock);
+    if (channels.value(channel->channelId()) != channel)
+        return;
+    channels.remove(channel->channelId());
+
+    if (!connection_open)
+        return;
+
+    // the service notices the last proxy going away by the connection closing
+    if (pooled && channels.isEmpty()) {
+        released = true;
+        deleteLater();
+        return;
+    }
+
+    QServicePackage p;
+    p.d = new QServicePackagePrivate();
+    p.d->packageType = QServicePackage::ChannelClosed;
+    p.d->channelId = channel->channelId();
+    locker.unlock();
+
+    writeChannelPackage(p);
+}
+
+void UnixEndPoint::setPooled(bool pooled)
+{
+    QMutexLocker locker(&channelLock);
+    this->pooled = pooled;
+}
+
+/*
+    Returns true if new proxies may open channels on this connection.
+*/
+bool UnixEndPoint::isReusable()
+{
+    QMutexLocker locker(&channelLock);
+    return pooled && connection_open && !released;
+}
+
+/*
+    Writes a package on behalf of a channel, channels living in other
+    threads have it written from the connection's thread.
+*/
+void UnixEndPoint::writeChannelPackage(const QServicePackage &package)
+{
+    if (thread() == QThread::currentThread()) {
+        flushPackage(package);
+        return;
+    }
+
+    QMutexLocker locker(&channelLock);
+    channelWrites.append(package);
+    if (channelWrites.count() == 1)
+        QMetaObject::invokeMethod(this, "flushChannelPackages", Qt::QueuedConnection);
+}
+
+void UnixEndPoint::flushChannelPackages()
+{
+    channelLock.lock();
+    QList<QServicePackage> packages;
+    packages.swap(channelWrites);
+    channelLock.unlock();
+
+    foreach (const QServicePackage &package, packages)
+        flushPackage(package);
+}
+
+/*
+    Maps the payload segment passed along with the current frame and reads
+    the package of \a size bytes straight from the mapping. Returns false if
+    there is no segment or it is not sealed against modification.
+*/
+bool UnixEndPoint::readPayloadSegment(quint32 size)
+{
+#ifdef SFW_USE_SHM_PAYLOAD
+    if (received_fds.isEmpty()) {
+        qWarning() << "SFW payload segment frame without descriptor" << objectName();
+        return false;
+    }
+    const int fd = received_fds.takeFirst();
+
+    struct stat info;
+    const int seals = ::fcntl(fd, F_GET_SEALS);
+    if (seals == -1 || (seals & SFW_SHM_PAYLOAD_SEALS) != SFW_SHM_PAYLOAD_SEALS
+            || ::fstat(fd, &info) == -1 || info.st_size < (off_t)size || size == 0) {
+        qWarning() << "SFW rejected unsealed or truncated payload segment" << objectName();
+        ::close(fd);
+        return false;
+    }
+
+    void *segment = ::mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        qWarning() << "SFW failed to map payload segment" << qt_error_string(errno);
+        return false;
+    }
+
+    qServiceLog() << "class" << "unixep"
+                  << "event" << "read segment"
+                  << "fd" << client_fd
+                  << "size" << (qint32)size;
+
+    readPackage(QByteArray::fromRawData(static_cast<const char *>(segment), size));
+    ::munmap(segment, size);
+    return true;
+#else
+    Q_UNUSED(size);
+    qWarning() << "SFW payload segments are not supported on this platform" << objectName();
+    return false;
+#endif
+}
+
+void UnixEndPoint::closePassedFds()
+{
+    while (!received_fds.isEmpty())
+        ::close(received_fds.takeFirst());
+    while (!pending_write_fds.isEmpty())
+        ::close(pending_write_fds.takeFirst().second);
 }
 
 void UnixEndPoint::registerWithThreadData()
@@ -663,9 +1154,12 @@ void UnixEndPoint::ipcfault()
 //    QMetaObject::invokeMethod(this, "errorUnrecoverableIPCFault", Qt::QueuedConnection, Q_ARG(QService::UnrecoverableIPCError, QService::ErrorServiceNoLongerAvailable));
 }
 
-int UnixEndPoint::write(const char *data, int len)
+int UnixEndPoint::write(const char *data, int len, int passFd)
 {
+    if (passFd != -1)
+        pending_write_fds.append(qMakePair(pending_write.length(), passFd));
     pending_write.append(data, len);
+    QServiceIpcStatistics::transport()->addPendingWrite(len);
     flushWriteBuffer();
     return len;
 }
@@ -675,10 +1169,53 @@ void UnixEndPoint::flushWriteBuffer()
     writeNotifier->setEnabled(false);
 
     if (!pending_write.isEmpty()) {
-        int ret = ::write(client_fd, pending_write.constData(), pending_write.length());
+        // a passed descriptor travels with the first byte of its frame, so
+        // never write past the next frame which carries one
+        int len = pending_write.length();
+        int passFd = -1;
+        if (!pending_write_fds.isEmpty()) {
+            if (pending_write_fds.first().first == 0) {
+                passFd = pending_write_fds.first().second;
+                if (pending_write_fds.count() > 1)
+                    len = pending_write_fds.at(1).first;
+            } else {
+                len = pending_write_fds.first().first;
+            }
+        }
+
+        int ret;
+        if (passFd != -1) {
+            char control[CMSG_SPACE(sizeof(int))];
+            memset(control, 0, sizeof(control));
+            struct iovec iov;
+            iov.iov_base = const_cast<char *>(pending_write.constData());
+            iov.iov_len = len;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+            ret = ::sendmsg(client_fd, &msg, 0);
+        } else {
+            ret = ::write(client_fd, pending_write.constData(), len);
+        }
 
         if (ret > 0) {
+            if (passFd != -1) {
+                ::close(passFd);
+                pending_write_fds.removeFirst();
+            }
+            for (int i = 0; i < pending_write_fds.count(); ++i)
+                pending_write_fds[i].first -= ret;
             pending_write.remove(0, ret);
+            QServiceIpcStatistics::transport()->addWritten(ret);
+            QServiceIpcStatistics::transport()->addPendingWrite(-ret);
             if (!pending_write.isEmpty()) {
                 writeNotifier->setEnabled(true);
             }
@@ -709,6 +1246,103 @@ void UnixEndPoint::flushWriteBuffer()
     }
 }
 
+UnixChannelEndPoint::UnixChannelEndPoint(UnixEndPoint *connection, quint32 channelId)
+    : QServiceIpcEndPoint(),
+      connection(connection),
+      id(channelId)
+{
+}
+
+UnixChannelEndPoint::~UnixChannelEndPoint()
+{
+    qServiceLog() << "class" << "unixchannel"
+                  << "event" << "delete"
+                  << "channel" << (qint32)id
+                  << "name" << objectName();
+    if (connection)
+        connection->closeChannel(this);
+}
+
+void UnixChannelEndPoint::getSecurityCredentials(QServiceClientCredentials &creds)
+{
+    if (connection)
+        connection->getSecurityCredentials(creds);
+}
+
+/*
+    Waits for data on the shared connection. The wait reads every package
+    arriving on the connection, not only those of this channel, so the
+    packages of other proxies in this thread, e.g. their signals, are
+    dispatched re-entrantly while a blocking call waits for its reply. This
+    is the same as the local event loop does for separate connections.
+*/
+int UnixChannelEndPoint::waitForData(int msecs)
+{
+    if (!connection)
+        return -1;
+
+    if (connection->thread() == QThread::currentThread())
+        return connection->waitForData(msecs);
+
+    return QServiceIpcEndPoint::waitForData(msecs);
+}
+
+void UnixChannelEndPoint::interruptWait()
+{
+    QServiceIpcEndPoint::interruptWait();
+    if (UnixEndPoint *shared = connection.data())
+        shared->interruptWait();
+}
+
+void UnixChannelEndPoint::flushPackage(const QServicePackage& package)
+{
+    if (!connection || !package.isValid())
+        return;
+
+    QServicePackage out(package);
+    out.d.detach();
+    out.d->channelId = id;
+    connection->writeChannelPackage(out);
+}
+
+/*
+    Called by the connection for each package of this channel. The package
+    is queued to the channel's thread if that isn't the connection's.
+*/
+void UnixChannelEndPoint::deliverPackage(const QServicePackage &package)
+{
+    if (thread() == QThread::currentThread()) {
+        incoming.enqueue(package);
+        emit readyRead();
+        return;
+    }
+
+    QMutexLocker locker(&pendingLock);
+    pending.append(package);
+    if (pending.count() == 1)
+        QMetaObject::invokeMethod(this, "deliverPending", Qt::QueuedConnection);
+}
+
+void UnixChannelEndPoint::deliverPending()
+{
+    pendingLock.lock();
+    QList<QServicePackage> packages;
+    packages.swap(pending);
+    pendingLock.unlock();
+
+    foreach (const QServicePackage &package, packages)
+        incoming.enqueue(package);
+    emit readyRead();
+}
+
+void UnixChannelEndPoint::connectionClosed()
+{
+    if (thread() == QThread::currentThread())
+        emit disconnected();
+    else
+        QMetaObject::invokeMethod(this, "disconnected", Qt::QueuedConnection);
+}
+
 QRemoteServiceRegisterUnixPrivate::QRemoteServiceRegisterUnixPrivate(QObject* parent)
     : QRemoteServiceRegisterPrivate(parent), server_fd(-1), server_notifier(0)
 {
@@ -755,6 +1389,7 @@ void QRemoteServiceRegisterUnixPrivate::processIncoming()
     if (client_fd != -1) {
         //LocalSocketEndPoint owns socket
         UnixEndPoint* ipcEndPoint = new UnixEndPoint(client_fd, this);
+        ipcEndPoint->serviceRegPriv = this;
 
         ipcEndPoint->setObjectName(objectName() + QString(QLatin1String(" instance on fd %1")).arg(client_fd));
 
@@ -775,14 +1410,13 @@ void QRemoteServiceRegisterUnixPrivate::processIncoming()
 }
 
 /*
-    Creates endpoint on service side.
+    Creates, binds and listens on the service socket at \a location.
 */
-bool QRemoteServiceRegisterUnixPrivate::createServiceEndPoint(const QString& ident)
+bool QRemoteServiceRegisterUnixPrivate::bindServiceSocket(const QString &location)
 {
-    setObjectName(ident);
     server_fd = ::socket(PF_UNIX, SOCK_STREAM, 0);
     if (server_fd == -1) {
-        qWarning() << "SFW Failed to create server socket" << ident << qt_error_string(errno);
+        qWarning() << "SFW Failed to create server socket" << location << qt_error_string(errno);
         return false;
     }
 
@@ -790,10 +1424,6 @@ bool QRemoteServiceRegisterUnixPrivate::createServiceEndPoint(const QString& ide
     fcntl(server_fd, F_SETFL, flags|O_NONBLOCK);
     fcntl(server_fd, F_SETFD, FD_CLOEXEC);
 
-    QString location = ident;
-    location = QDir::cleanPath(QDir::tempPath());
-    location += QLatin1Char('/') + ident;
-
     qServiceLog() << "class" << "qrsrup"
                   << "event" << "createservice start"
                   << "server_fd" << server_fd
@@ -823,6 +1453,24 @@ bool QRemoteServiceRegisterUnixPrivate::createServiceEndPoint(const QString& ide
         qWarning("SFW failed to chmod %s: %s", qPrintable(tempLocation),
                  ::strerror(errno));
     }
+    if (!setSocketOwner(tempLocation))
+        return false;
+
+    if (-1 == ::listen(server_fd, 50)) {
+        qWarning() << "Failed to listen on server socket" << tempLocation << qt_error_string(errno);
+        return false;
+    }
+
+    if (-1 == ::rename(tempLocation.toLatin1(), location.toLatin1())) {
+        qWarning("Failed to rename %s to %s", qPrintable(tempLocation),
+                 qPrintable(location));
+    }
+
+    return true;
+}
+
+bool QRemoteServiceRegisterUnixPrivate::setSocketOwner(const QString &path)
+{
     int uid = getuid();
     int gid = getgid();
     bool doChown = false;
@@ -834,19 +1482,40 @@ bool QRemoteServiceRegisterUnixPrivate::createServiceEndPoint(const QString& ide
         gid = getBaseGroupIdentifier();
         doChown = true;
     }
-    if (doChown && (-1 == ::chown(tempLocation.toLatin1(), uid, gid))) {
+    if (doChown && (-1 == ::chown(path.toLatin1(), uid, gid))) {
         qWarning() << "Failed to chown socket to request uid/gid" << uid << gid << qt_error_string(errno);
         return false;
     }
+    return true;
+}
 
-    if (-1 == ::listen(server_fd, 50)) {
-        qWarning() << "Failed to listen on server socket" << tempLocation << qt_error_string(errno);
-        return false;
-    }
+/*
+    Creates endpoint on service side.
+*/
+bool QRemoteServiceRegisterUnixPrivate::createServiceEndPoint(const QString& ident)
+{
+    setObjectName(ident);
 
-    if (-1 == ::rename(tempLocation.toLatin1(), location.toLatin1())) {
-        qWarning("Failed to rename %s to %s", qPrintable(tempLocation),
-                 qPrintable(location));
+    QString location = QDir::cleanPath(QDir::tempPath());
+    location += QLatin1Char('/') + ident;
+    QString pidLocation = location + QStringLiteral(".pid");
+
+    // started by a client that already listens on our address for us
+    server_fd = takeListenSocket(ident);
+    if (server_fd != -1) {
+        qServiceLog() << "class" << "qrsrup"
+                      << "event" << "createservice adopt"
+                      << "server_fd" << server_fd
+                      << "name" << objectName();
+
+        int flags = fcntl(server_fd, F_GETFL, 0);
+        fcntl(server_fd, F_SETFL, flags|O_NONBLOCK);
+
+        ::unlink(pidLocation.toLatin1());
+        if (!setSocketOwner(location))
+            return false;
+    } else if (!bindServiceSocket(location)) {
+        return false;
     }
 
     server_notifier = new QSocketNotifier(server_fd, QSocketNotifier::Read, this);
@@ -896,6 +1565,82 @@ QRemoteServiceRegisterPrivate* QRemoteServiceRegisterPrivate::constructPrivateOb
 
 #define SFW_PROCESS_TIMEOUT 10000
 
+/*
+    Starts the service executable \a path as a detached process, handing it
+    \a listenfd for \a location if that is not -1. Returns false if the
+    process could not be started.
+*/
+static bool startServiceProcess(const QString &path, const QString &location, int listenfd)
+{
+    int pipefd[2];
+
+    if (-1 == (pipe(pipefd))) {
+        qWarning("pipe2 failed: %s", ::strerror(errno));
+        return false;
+    }
+
+    fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+
+    qint64 pid = 0;
+
+    // Start the service as a detached process
+    if (!(pid = fork())) {
+        char buffer[] = "FAIL";
+        close(pipefd[0]);
+
+        qServiceLog() << "class" << "doStart"
+                      << "event" << "client starting"
+                      << "location" << path;
+
+        // child, move it away from the parent
+        if (-1 == (setsid())) {
+            qWarning("setsit failed: %s", ::strerror(errno));
+            write(pipefd[1], buffer, 5);
+            exit(-1);
+        }
+
+        setpgid(getpid(), getpid());
+
+        if (listenfd != -1 && !QRemoteServiceRegisterPrivate::passListenSocket(listenfd, location)) {
+            qWarning("passing the listen socket failed: %s", ::strerror(errno));
+            write(pipefd[1], buffer, 5);
+            exit(-1);
+        }
+
+        execlp(path.toLatin1(), path.toLatin1(), NULL);
+
+        qWarning() << "exec of process" << path.toLatin1() << ::strerror(errno);
+
+        qServiceLog() << "class" << "doStart"
+                      << "event" << "failed start"
+                      << "error" << ::strerror(errno);
+
+        write(pipefd[1], buffer, 5);
+        exit(-1);
+    }
+
+    if (pid == -1) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        qWarning("process start failed %s", ::strerror(errno));
+        return false;
+    }
+
+    close(pipefd[1]);
+
+    char buffer[5];
+    const bool failed = read(pipefd[0], buffer, 5) > 0;
+    close(pipefd[0]);
+    if (failed) {
+        qServiceLog() << "class" << "doStart"
+                      << "event" << "ddeamon error reported";
+        qWarning("process start failed");
+        return false;
+    }
+    return true;
+}
+
 int doStart(const QString &location) {
 
     QLatin1String fmt("hh:mm:ss.zzz");
@@ -987,93 +1732,68 @@ int doStart(const QString &location) {
 
     QString path = location;
 
-    int pipefd[2];
-
-    if (-1 == (pipe(pipefd))) {
-        qWarning("pipe2 failed: %s", ::strerror(errno));
+    // Listen on the service address ourselves and hand the socket to the
+    // service, then our connect is queued by the kernel right away
+    bool activated = false;
+    int listenfd = QRemoteServiceRegisterPrivate::createListenSocket(fullPath);
+    if (listenfd == -1 && errno == EADDRINUSE) {
+        // another client just did the same, the service is on its way
+        qServiceLog() << "class" << "doStart"
+                      << "event" << "already activated"
+                      << "location" << location;
+        ret = ::connect(socketfd, (struct sockaddr *)&name, sizeof(name));
+        if (ret == 0) {
 #ifndef Q_OS_MAC
-        ::inotify_rm_watch(fd, wd);
-        ::close(fd);
+            ::inotify_rm_watch(fd, wd);
+            ::close(fd);
 #endif
-        delete w;
-        delete w_inotify;
-        return socketfd;
-    }
-
-    fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
-    fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
-
-    qint64 pid = 0;
-
-    // Start the service as a detached process
-    if (!(pid = fork())) {
-        char buffer[] = "FAIL";
-        close(pipefd[0]);
-
-        qServiceLog() << "class" << "doStart"
-                      << "event" << "client starting"
-                      << "location" << path;
-
-        // child, move it away from the parent
-        if (-1 == (setsid())) {
-            qWarning("setsit failed: %s", ::strerror(errno));
-            write(pipefd[1], buffer, 5);
-            exit(-1);
+            delete w;
+            delete w_inotify;
+            return socketfd;
         }
+        // e.g. a full backlog, wait below instead of starting it twice
+        activated = true;
+    } else if (listenfd == -1) {
+        qWarning() << "SFW unable to create socket for" << location
+                   << "waiting for the service to create it" << qt_error_string(errno);
+    }
 
-        setpgid(getpid(), getpid());
-
-        execlp(path.toLatin1(), path.toLatin1(), NULL);
-
-        qWarning() << "exec of process" << path.toLatin1() << ::strerror(errno);
+    if (!activated) {
+        const bool started = startServiceProcess(path, location, listenfd);
 
-        qServiceLog() << "class" << "doStart"
-                      << "event" << "failed start"
-                      << "error" << ::strerror(errno);
-
-        write(pipefd[1], buffer, 5);
-        exit(-1);
-    }
+        // the service owns the listening socket now
+        if (listenfd != -1)
+            ::close(listenfd);
 
-    if (pid == -1) {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        qWarning("process start failed %s", ::strerror(errno));
+        if (!started) {
+            if (listenfd != -1)
+                ::unlink(fullPath.toLatin1());
 #ifndef Q_OS_MAC
-        ::inotify_rm_watch(fd, wd);
-        ::close(fd);
+            ::inotify_rm_watch(fd, wd);
+            ::close(fd);
 #endif
-        delete w;
-        delete w_inotify;
-        return socketfd;
-    }
-
-    close(pipefd[1]);
+            delete w;
+            delete w_inotify;
+            return socketfd;
+        }
 
-    char buffer[5];
-    if (read(pipefd[0], buffer, 5) > 0) {
         qServiceLog() << "class" << "doStart"
-                      << "event" << "ddeamon error reported";
-        qWarning("process start failed");
-#ifndef Q_OS_MAC
-        ::inotify_rm_watch(fd, wd);
-        ::close(fd);
-#endif
-        delete w;
-        delete w_inotify;
-        return socketfd;
+                      << "event" << "deamon started";
     }
-    close(pipefd[0]);
-
-    qServiceLog() << "class" << "doStart"
-                  << "event" << "deamon started";
 
-    QFileInfo file(QStringLiteral("/tmp/") + location);
-    qWarning() << QTime::currentTime().toString(fmt)
-               << "SFW checking in" << file.path() << "for the socket to come into existance" << file.filePath();
+    QFileInfo file(fullPath);
+    if (listenfd == -1 && !activated) {
+        qWarning() << QTime::currentTime().toString(fmt)
+                   << "SFW checking in" << file.path() << "for the socket to come into existance" << file.filePath();
+    }
 
     ret = ::connect(socketfd, (struct sockaddr *)&name, sizeof(name));
-    if (ret == -1 && errno == EINPROGRESS) {
+    bool success = (ret == 0);
+    if (success) {
+        qServiceLog() << "class" << "doStart"
+                      << "event" << "connect queued"
+                      << "location" << location;
+    } else if (ret == -1 && errno == EINPROGRESS) {
         qWarning() << "SFW got conect in progress";
         w->setEnabled(true);
     } else {
@@ -1082,10 +1802,11 @@ int doStart(const QString &location) {
         w->setEnabled(false);
     }
 
-    bool success = false;
-
-    while (total_time.elapsed() < SFW_PROCESS_TIMEOUT) {
-        UnixEndPoint::runLocalEventLoop(SFW_PROCESS_TIMEOUT-total_time.elapsed());
+    while (!success && total_time.elapsed() < SFW_PROCESS_TIMEOUT) {
+        // nothing signals the backlog of an existing socket draining, so
+        // retry the connect periodically then
+        const int remaining = SFW_PROCESS_TIMEOUT - total_time.elapsed();
+        UnixEndPoint::runLocalEventLoop(activated ? qMin(remaining, 100) : remaining);
 
 #ifndef Q_OS_MAC
 #define INOTIFY_SIZE (sizeof(struct inotify_event)+1024)
@@ -1155,38 +1876,54 @@ QObject* QRemoteServiceRegisterPrivate::proxyForService(const QRemoteServiceRegi
                   << "name" << location;
 #endif
 
-    int socketfd = doStart(location);
-
-    if (socketfd >= 0){
-        UnixEndPoint* ipcEndPoint = new UnixEndPoint(socketfd);
-        ObjectEndPoint* endPoint = new ObjectEndPoint(ObjectEndPoint::Client, ipcEndPoint);
-
-        ipcEndPoint->setObjectName(entry.interfaceName() + QString(QStringLiteral(" client end %1")).arg(socketfd));
-        endPoint->setObjectName(entry.interfaceName() + QString(QStringLiteral(" client end %1")).arg(socketfd));
-
-        QObject *proxy = endPoint->constructProxy(entry);
-        if (proxy){
-            QObject::connect(proxy, SIGNAL(destroyed()), endPoint, SLOT(deleteLater()));
-            QObject::connect(ipcEndPoint, SIGNAL(errorUnrecoverableIPCFault(QService::UnrecoverableIPCError)),
-                             proxy, SIGNAL(errorUnrecoverableIPCFault(QService::UnrecoverableIPCError)));
-            qServiceLog() << "class" << "qrsrp"
-                          << "event" << "create object"
-                          << "iface" << entry.interfaceName()
-                          << "name" << proxy->objectName();
-            ipcEndPoint->setParent(proxy);
-            endPoint->setParent(proxy);
-            qWarning() << "SFW created object for" << entry.interfaceName();
-        }
-        else {
-            qWarning() << "SFW failed to create object for" << entry.interfaceName();
-            qServiceLog() << "class" << "qrsrp"
-                          << "event" << "create object FAIL"
-                          << "iface" << entry.interfaceName();
-            delete endPoint;
+    //all proxies of this thread to the same location share one connection
+    QHash<QString, QPointer<UnixEndPoint> > &pool = _q_unixconnectionpool()->localData();
+    UnixEndPoint *connection = pool.value(location);
+    if (!connection || !connection->isReusable()) {
+        int socketfd = doStart(location);
+        if (socketfd < 0) {
+            pool.remove(location);
+            return 0;
         }
-        return proxy;
+
+        connection = new UnixEndPoint(socketfd);
+        connection->setObjectName(location + QString(QStringLiteral(" client end %1")).arg(socketfd));
+        connection->setPooled(true);
+        pool.insert(location, connection);
+    } else {
+        qServiceLog() << "class" << "qrsrp"
+                      << "event" << "reuse connection"
+                      << "iface" << entry.interfaceName()
+                      << "name" << connection->objectName();
     }
-    return 0;
+
+    UnixChannelEndPoint* ipcEndPoint = connection->openChannel();
+    ObjectEndPoint* endPoint = new ObjectEndPoint(ObjectEndPoint::Client, ipcEndPoint);
+
+    ipcEndPoint->setObjectName(entry.interfaceName() + QLatin1Char(' ') + ipcEndPoint->objectName());
+    endPoint->setObjectName(ipcEndPoint->objectName());
+
+    QObject *proxy = endPoint->constructProxy(entry);
+    if (proxy){
+        QObject::connect(proxy, SIGNAL(destroyed()), endPoint, SLOT(deleteLater()));
+        QObject::connect(connection, SIGNAL(errorUnrecoverableIPCFault(QService::UnrecoverableIPCError)),
+                         proxy, SIGNAL(errorUnrecoverableIPCFault(QService::UnrecoverableIPCError)));
+        qServiceLog() << "class" << "qrsrp"
+                      << "event" << "create object"
+                      << "iface" << entry.interfaceName()
+                      << "name" << proxy->objectName();
+        ipcEndPoint->setParent(proxy);
+        endPoint->setParent(proxy);
+        qWarning() << "SFW created object for" << entry.interfaceName();
+    }
+    else {
+        qWarning() << "SFW failed to create object for" << entry.interfaceName();
+        qServiceLog() << "class" << "qrsrp"
+                      << "event" << "create object FAIL"
+                      << "iface" << entry.interfaceName();
+        delete endPoint;
+    }
+    return proxy;
 }
 
 bool QRemoteServiceRegisterPrivate::isServiceRunning(const QRemoteServiceRegister::Entry &, const QString &location)
@@ -1208,6 +1945,40 @@ bool QRemoteServiceRegisterPrivate::isServiceRunning(const QRemoteServiceRegiste
     return false;
 }
 
+/*
+    Connects to the service at \a location without starting it and asks
+    it for its statistics.
+*/
+QByteArray QRemoteServiceRegisterPrivate::statisticsForService(const QString &location, int timeout)
+{
+    QString fullPath = QDir::cleanPath(QDir::tempPath());
+    fullPath += QLatin1Char('/') + location;
+    const QByteArray path = fullPath.toLatin1();
+
+    struct sockaddr_un name;
+    if (path.size() >= int(sizeof(name.sun_path))) {
+        qWarning() << "SFW service address too long" << fullPath;
+        return QByteArray();
+    }
+    name.sun_family = PF_UNIX;
+    ::memcpy(name.sun_path, path.constData(), path.size() + 1);
+
+    int socketfd = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    if (socketfd < 0) {
+        qWarning("socket(2) failed: %s", ::strerror(errno));
+        return QByteArray();
+    }
+    if (::connect(socketfd, (struct sockaddr *) &name, sizeof(struct sockaddr_un)) != 0) {
+        qWarning() << "SFW service is not running at" << location << qt_error_string(errno);
+        ::close(socketfd);
+        return QByteArray();
+    }
+
+    UnixEndPoint connection(socketfd);
+    connection.setObjectName(location + QStringLiteral(" statistics"));
+    return QServiceIpcStatistics::requestSnapshot(&connection, timeout);
+}
+
 #include "moc_qremoteserviceregister_unix_p.cpp"
 #include "qremoteserviceregister_unix_p.moc"
 QT_END_NAMESPACE
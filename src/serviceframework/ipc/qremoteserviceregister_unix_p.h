@@ -84,6 +84,8 @@ protected Q_SLOTS:
 
 private:
     bool createServiceEndPoint(const QString& ident);
+    bool bindServiceSocket(const QString &location);
+    bool setSocketOwner(const QString &path);
 
     int server_fd;
     QSocketNotifier *server_notifier;
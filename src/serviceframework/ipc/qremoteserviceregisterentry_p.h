@@ -62,14 +62,16 @@ class QRemoteServiceRegisterEntryPrivate : public QSharedData
 {
 public:
     QRemoteServiceRegisterEntryPrivate()
-            : meta(0), cptr(0), instanceType(QRemoteServiceRegister::PrivateInstance)
+            : meta(0), cptr(0), instanceType(QRemoteServiceRegister::PrivateInstance),
+              executionPolicy(QRemoteServiceRegister::SharedThreadExecution)
     {
     }
 
     QRemoteServiceRegisterEntryPrivate(QRemoteServiceRegisterEntryPrivate &other)
         : QSharedData(other), iface(other.iface),
           service(other.service), ifaceVersion(other.ifaceVersion),
-          meta(other.meta), cptr(other.cptr), instanceType(other.instanceType)
+          meta(other.meta), cptr(other.cptr), instanceType(other.instanceType),
+          executionPolicy(other.executionPolicy)
     {
     }
 
@@ -80,6 +82,7 @@ public:
     const QMetaObject* meta;
     QRemoteServiceRegister::CreateServiceFunc cptr;
     QRemoteServiceRegister::InstanceType instanceType;
+    QRemoteServiceRegister::ExecutionPolicy executionPolicy;
 };
 
 QT_END_NAMESPACE
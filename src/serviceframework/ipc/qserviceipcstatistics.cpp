@@ -0,0 +1,354 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qserviceipcstatistics_p.h"
+#include "qremoteserviceregister_p.h"
+#include "ipcendpoint_p.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEventLoop>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QTimer>
+#include <QUuid>
+
+QT_BEGIN_NAMESPACE
+
+QServiceLatencyHistogram::QServiceLatencyHistogram()
+{
+    reset();
+}
+
+int QServiceLatencyHistogram::bucketIndex(quint64 value)
+{
+    if (value < quint64(SubBuckets))
+        return int(value);
+
+    const int magnitude = 63 - qCountLeadingZeroBits(value);
+    const int index = (magnitude - SubBucketBits + 1) * SubBuckets
+            + int((value >> (magnitude - SubBucketBits)) & (SubBuckets - 1));
+    return qMin(index, int(BucketCount) - 1);
+}
+
+/*
+    Returns the smallest value recorded into the bucket at \a index.
+*/
+quint64 QServiceLatencyHistogram::bucketValue(int index)
+{
+    if (index < SubBuckets)
+        return quint64(index);
+
+    const int magnitude = index / SubBuckets + SubBucketBits - 1;
+    return quint64(SubBuckets + index % SubBuckets) << (magnitude - SubBucketBits);
+}
+
+void QServiceLatencyHistogram::record(quint64 usec)
+{
+    buckets[bucketIndex(usec)].fetchAndAddRelaxed(1);
+    total.fetchAndAddRelaxed(1);
+    sum.fetchAndAddRelaxed(usec);
+
+    quint64 current = max.load();
+    while (usec > current && !max.testAndSetRelaxed(current, usec, current))
+        ;
+}
+
+void QServiceLatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; ++i)
+        buckets[i].store(0);
+    total.store(0);
+    sum.store(0);
+    max.store(0);
+}
+
+quint64 QServiceLatencyHistogram::count() const
+{
+    return total.load();
+}
+
+quint64 QServiceLatencyHistogram::maximum() const
+{
+    return max.load();
+}
+
+/*
+    Returns the value below which \a percent percent of the recorded values
+    fall, as the upper end of the bucket holding that value.
+*/
+quint64 QServiceLatencyHistogram::percentile(double percent) const
+{
+    quint64 recorded = 0;
+    for (int i = 0; i < BucketCount; ++i)
+        recorded += buckets[i].load();
+    if (recorded == 0)
+        return 0;
+
+    const quint64 target = qMax<quint64>(1, quint64(recorded * qBound(0.0, percent, 100.0) / 100.0 + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i].load();
+        if (seen >= target) {
+            if (i == BucketCount - 1)
+                return maximum();
+            return qMin(bucketValue(i + 1) - 1, maximum());
+        }
+    }
+    return maximum();
+}
+
+QJsonObject QServiceLatencyHistogram::toJson() const
+{
+    QJsonObject object;
+    const quint64 calls = count();
+    object.insert(QStringLiteral("count"), double(calls));
+    if (calls == 0)
+        return object;
+
+    object.insert(QStringLiteral("mean"), double(sum.load()) / calls);
+    object.insert(QStringLiteral("p50"), double(percentile(50)));
+    object.insert(QStringLiteral("p90"), double(percentile(90)));
+    object.insert(QStringLiteral("p99"), double(percentile(99)));
+    object.insert(QStringLiteral("p999"), double(percentile(99.9)));
+    object.insert(QStringLiteral("max"), double(maximum()));
+    return object;
+}
+
+void QServiceMethodStatistics::reset()
+{
+    calls.store(0);
+    bytesOut.store(0);
+    bytesIn.store(0);
+    latency.reset();
+}
+
+QJsonObject QServiceMethodStatistics::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("calls"), double(calls.load()));
+    object.insert(QStringLiteral("bytesOut"), double(bytesOut.load()));
+    object.insert(QStringLiteral("bytesIn"), double(bytesIn.load()));
+    object.insert(QStringLiteral("latency"), latency.toJson());
+    return object;
+}
+
+void QServiceTransportStatistics::addPendingWrite(qint64 delta)
+{
+    const qint64 pending = pendingWrite.fetchAndAddRelaxed(delta) + delta;
+    qint64 current = pendingWriteMax.load();
+    while (pending > current && !pendingWriteMax.testAndSetRelaxed(current, pending, current))
+        ;
+}
+
+void QServiceTransportStatistics::reset()
+{
+    bytesRead.store(0);
+    bytesWritten.store(0);
+    packagesRead.store(0);
+    packagesWritten.store(0);
+    // bytes still queued stay accounted for
+    pendingWriteMax.store(pendingWrite.load());
+}
+
+QJsonObject QServiceTransportStatistics::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("bytesRead"), double(bytesRead.load()));
+    object.insert(QStringLiteral("bytesWritten"), double(bytesWritten.load()));
+    object.insert(QStringLiteral("packagesRead"), double(packagesRead.load()));
+    object.insert(QStringLiteral("packagesWritten"), double(packagesWritten.load()));
+    object.insert(QStringLiteral("pendingWrite"), double(pendingWrite.load()));
+    object.insert(QStringLiteral("pendingWriteMax"), double(pendingWriteMax.load()));
+    return object;
+}
+
+struct QServiceMethodStatisticsEntry
+{
+    QServiceIpcStatistics::Side side;
+    QString interfaceName;
+    QByteArray signature;
+    QServiceMethodStatistics *stats;
+};
+
+/*
+    Entries are never removed, the end points keep pointers to them for
+    their whole lifetime. The lock is only taken the first time an end
+    point uses a method.
+*/
+class QServiceIpcStatisticsRegistry
+{
+public:
+    ~QServiceIpcStatisticsRegistry()
+    {
+        foreach (const QServiceMethodStatisticsEntry &entry, methods)
+            delete entry.stats;
+    }
+
+    QMutex lock;
+    QHash<QString, QServiceMethodStatisticsEntry> methods;
+    QServiceTransportStatistics transport;
+};
+
+Q_GLOBAL_STATIC(QServiceIpcStatisticsRegistry, _q_ipcstatistics);
+
+QServiceMethodStatistics *QServiceIpcStatistics::method(Side side, const QString &interfaceName,
+                                                        const QByteArray &signature)
+{
+    QServiceIpcStatisticsRegistry *registry = _q_ipcstatistics();
+    const QString key = QString::number(side) + QLatin1Char('/') + interfaceName
+            + QLatin1Char('/') + QString::fromLatin1(signature);
+
+    QMutexLocker locker(&registry->lock);
+    QHash<QString, QServiceMethodStatisticsEntry>::const_iterator it = registry->methods.constFind(key);
+    if (it != registry->methods.constEnd())
+        return it->stats;
+
+    QServiceMethodStatisticsEntry entry = { side, interfaceName, signature, new QServiceMethodStatistics };
+    registry->methods.insert(key, entry);
+    return entry.stats;
+}
+
+QServiceTransportStatistics *QServiceIpcStatistics::transport()
+{
+    return &_q_ipcstatistics()->transport;
+}
+
+/*
+    Returns the counters of this process. Counters keep changing while the
+    snapshot is taken, so related values may be off by the calls made in
+    the meantime.
+*/
+QJsonObject QServiceIpcStatistics::snapshot()
+{
+    QServiceIpcStatisticsRegistry *registry = _q_ipcstatistics();
+
+    QJsonArray methods;
+    {
+        QMutexLocker locker(&registry->lock);
+        foreach (const QServiceMethodStatisticsEntry &entry, registry->methods) {
+            if (entry.stats->calls.load() == 0)
+                continue;
+
+            QJsonObject method = entry.stats->toJson();
+            method.insert(QStringLiteral("side"), entry.side == Client ? QStringLiteral("client")
+                                                                       : QStringLiteral("service"));
+            method.insert(QStringLiteral("interface"), entry.interfaceName);
+            method.insert(QStringLiteral("method"), QString::fromLatin1(entry.signature));
+            methods.append(method);
+        }
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("pid"), double(QCoreApplication::applicationPid()));
+    object.insert(QStringLiteral("application"), QCoreApplication::applicationName());
+    object.insert(QStringLiteral("transport"), registry->transport.toJson());
+    object.insert(QStringLiteral("methods"), methods);
+    return object;
+}
+
+void QServiceIpcStatistics::reset()
+{
+    QServiceIpcStatisticsRegistry *registry = _q_ipcstatistics();
+
+    QMutexLocker locker(&registry->lock);
+    foreach (const QServiceMethodStatisticsEntry &entry, registry->methods)
+        entry.stats->reset();
+    registry->transport.reset();
+}
+
+/*
+    Asks the service running at \a location for its snapshot. The service
+    is not started if it isn't running. Returns an empty object if the
+    service can't be reached or doesn't answer within \a timeout
+    milliseconds.
+*/
+QJsonObject QServiceIpcStatistics::query(const QString &location, int timeout)
+{
+    const QByteArray data = QRemoteServiceRegisterPrivate::statisticsForService(location, timeout);
+    if (data.isEmpty())
+        return QJsonObject();
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "SFW invalid statistics received from" << location << error.errorString();
+        return QJsonObject();
+    }
+    return document.object();
+}
+
+QByteArray QServiceIpcStatistics::requestSnapshot(QServiceIpcEndPoint *endPoint, int timeout)
+{
+    QServicePackage request;
+    request.d = new QServicePackagePrivate();
+    request.d->packageType = QServicePackage::StatisticsRequest;
+    request.d->messageId = QUuid::createUuid();
+
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    QObject::connect(endPoint, SIGNAL(readyRead()), &loop, SLOT(quit()));
+    QObject::connect(endPoint, SIGNAL(disconnected()), &loop, SLOT(quit()));
+
+    endPoint->writePackage(request);
+    timer.start(timeout);
+
+    while (timer.isActive()) {
+        while (endPoint->packageAvailable()) {
+            const QServicePackage response = endPoint->nextPackage();
+            if (response.isValid() && response.d->messageId == request.d->messageId) {
+                if (response.d->responseType != QServicePackage::Success)
+                    return QByteArray();
+                return response.d->payload.toByteArray();
+            }
+        }
+        loop.exec();
+        if (!endPoint->packageAvailable())
+            break;
+    }
+
+    qWarning() << "SFW no statistics received from" << endPoint->objectName();
+    return QByteArray();
+}
+
+QT_END_NAMESPACE
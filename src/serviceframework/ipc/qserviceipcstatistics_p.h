@@ -0,0 +1,204 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSERVICEIPCSTATISTICS_P_H
+#define QSERVICEIPCSTATISTICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserviceframeworkglobal.h"
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QString>
+#include <QJsonObject>
+
+QT_BEGIN_NAMESPACE
+
+class QServiceIpcEndPoint;
+
+/*
+    Latency histogram with a fixed relative error. Values below 8 have a
+    bucket each, every power of two above is split into 8 linear sub
+    buckets, which keeps the error below 12.5% up to about 12 days in
+    microseconds. Recording is a handful of relaxed atomic operations, so
+    any thread may record while another one takes a snapshot.
+*/
+class Q_SERVICEFW_EXPORT QServiceLatencyHistogram
+{
+public:
+    enum {
+        SubBucketBits = 3,
+        SubBuckets = 1 << SubBucketBits,
+        Magnitudes = 38,
+        BucketCount = SubBuckets * Magnitudes
+    };
+
+    QServiceLatencyHistogram();
+
+    void record(quint64 usec);
+    void reset();
+
+    quint64 count() const;
+    quint64 maximum() const;
+    quint64 percentile(double percent) const;
+
+    QJsonObject toJson() const;
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketValue(int index);
+
+private:
+    QAtomicInteger<quint32> buckets[BucketCount];
+    QAtomicInteger<quint64> total;
+    QAtomicInteger<quint64> sum;
+    QAtomicInteger<quint64> max;
+
+    Q_DISABLE_COPY(QServiceLatencyHistogram)
+};
+
+/*
+    Counters of one method or property of one interface, seen from either
+    the client or the service side. The client counts the marshalled
+    arguments it sends and the response it receives, and records the round
+    trip time. The service counts the arguments it receives and records
+    the time the call took to execute.
+*/
+class Q_SERVICEFW_EXPORT QServiceMethodStatistics
+{
+public:
+    QServiceMethodStatistics() {}
+
+    void addCall(quint32 sent, quint32 received)
+    {
+        calls.fetchAndAddRelaxed(1);
+        bytesOut.fetchAndAddRelaxed(sent);
+        bytesIn.fetchAndAddRelaxed(received);
+    }
+
+    void reset();
+    QJsonObject toJson() const;
+
+    QAtomicInteger<quint64> calls;
+    QAtomicInteger<quint64> bytesOut;
+    QAtomicInteger<quint64> bytesIn;
+    QServiceLatencyHistogram latency;
+
+private:
+    Q_DISABLE_COPY(QServiceMethodStatistics)
+};
+
+/*
+    Byte and package counters of the socket transport, summed over all
+    connections of the process. pendingWrite is the number of bytes queued
+    for sockets which couldn't take them yet.
+*/
+class Q_SERVICEFW_EXPORT QServiceTransportStatistics
+{
+public:
+    QServiceTransportStatistics() {}
+
+    void addRead(quint32 bytes)
+    {
+        bytesRead.fetchAndAddRelaxed(bytes);
+    }
+
+    void addPackageRead()
+    {
+        packagesRead.fetchAndAddRelaxed(1);
+    }
+
+    void addWritten(quint32 bytes)
+    {
+        bytesWritten.fetchAndAddRelaxed(bytes);
+    }
+
+    void addPackageWritten()
+    {
+        packagesWritten.fetchAndAddRelaxed(1);
+    }
+
+    void addPendingWrite(qint64 delta);
+
+    void reset();
+    QJsonObject toJson() const;
+
+    QAtomicInteger<quint64> bytesRead;
+    QAtomicInteger<quint64> bytesWritten;
+    QAtomicInteger<quint64> packagesRead;
+    QAtomicInteger<quint64> packagesWritten;
+    QAtomicInteger<qint64> pendingWrite;
+    QAtomicInteger<qint64> pendingWriteMax;
+
+private:
+    Q_DISABLE_COPY(QServiceTransportStatistics)
+};
+
+class Q_SERVICEFW_EXPORT QServiceIpcStatistics
+{
+public:
+    enum Side {
+        Client = 0,
+        Service
+    };
+
+    static QServiceMethodStatistics *method(Side side, const QString &interfaceName,
+                                            const QByteArray &signature);
+    static QServiceTransportStatistics *transport();
+
+    static QJsonObject snapshot();
+    static void reset();
+
+    static QJsonObject query(const QString &location, int timeout = 5000);
+
+    // used by the backends to ask a connected service for its snapshot
+    static QByteArray requestSnapshot(QServiceIpcEndPoint *endPoint, int timeout);
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERVICEIPCSTATISTICS_P_H
@@ -40,6 +40,7 @@
 #include "qservicepackage_p.h"
 #include <QDataStream>
 #include <QDebug>
+#include <QIODevice>
 
 QT_BEGIN_NAMESPACE
 
@@ -77,19 +78,33 @@ QServicePackage QServicePackage::createResponse() const
     response.d->packageType = d->packageType;
     response.d->messageId = d->messageId;
     response.d->instanceId = d->instanceId;
+    response.d->channelId = d->channelId;
     response.d->responseType = QServicePackage::Failed;
 
     return response;
 }
 
 #ifndef QT_NO_DATASTREAM
+/*
+    Packages which belong to a channel of a shared connection carry a
+    different magic number followed by the channel id, all other packages
+    keep the original layout.
+*/
+static const quint32 packageMagicNumber = 0x78AFAFB;
+static const quint32 channelPackageMagicNumber = 0x78AFAFC;
+
 QDataStream &operator<<(QDataStream &out, const QServicePackage& package)
 {
-    const quint32 magicNumber = 0x78AFAFB;
     out.setVersion(QDataStream::Qt_4_6);
-    out << magicNumber;
 
     const qint8 valid = package.d ? 1 : 0;
+    if (valid && package.d->channelId) {
+        out << channelPackageMagicNumber;
+        out << package.d->channelId;
+    } else {
+        out << packageMagicNumber;
+    }
+
     out << (qint8) valid;
     if (valid) {
         out << (qint8) package.d->packageType;
@@ -105,12 +120,15 @@ QDataStream &operator<<(QDataStream &out, const QServicePackage& package)
 
 QDataStream &operator>>(QDataStream &in, QServicePackage& package)
 {
-    const quint32 magicNumber = 0x78AFAFB;
     in.setVersion(QDataStream::Qt_4_6);
+    const qint64 start = in.device() ? in.device()->pos() : 0;
 
     quint32 storedMagicNumber;
+    quint32 channelId = 0;
     in >> storedMagicNumber;
-    if (storedMagicNumber != magicNumber) {
+    if (storedMagicNumber == channelPackageMagicNumber) {
+        in >> channelId;
+    } else if (storedMagicNumber != packageMagicNumber) {
         qWarning() << Q_FUNC_INFO << "Datastream doesn't provide serialized QServiceFilter";
         return in;
     }
@@ -134,6 +152,9 @@ QDataStream &operator>>(QDataStream &in, QServicePackage& package)
         in >> package.d->instanceId;
         in >> package.d->entry;
         in >> package.d->payload;
+        package.d->channelId = channelId;
+        if (in.device())
+            package.d->wireSize = quint32(in.device()->pos() - start);
     } else {
         if (package.d)
             package.d.reset();
@@ -159,12 +180,24 @@ QDebug operator<<(QDebug dbg, const QServicePackage& p)
             case QServicePackage::PropertyCall:
                 type = QLatin1String("PropertyCall");
                 break;
+            case QServicePackage::SignalSubscription:
+                type = QLatin1String("SignalSubscription");
+                break;
+            case QServicePackage::ChannelClosed:
+                type = QLatin1String("ChannelClosed");
+                break;
+            case QServicePackage::StatisticsRequest:
+                type = QLatin1String("StatisticsRequest");
+                break;
             default:
                 break;
         }
         dbg.nospace() << "QServicePackage ";
         dbg.nospace() << type << ' ' << p.d->responseType ; dbg.space();
         dbg.nospace() << p.d->messageId.toString(); dbg.space();
+        if (p.d->channelId) {
+            dbg.nospace() << "channel" << ' ' << p.d->channelId; dbg.space();
+        }
         dbg.nospace() << p.d->entry;dbg.space();
     } else {
         dbg.nospace() << "QServicePackage(invalid)";
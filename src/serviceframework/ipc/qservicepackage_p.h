@@ -77,7 +77,10 @@ public:
     enum Type {
         ObjectCreation = 0,
         MethodCall,
-        PropertyCall
+        PropertyCall,
+        SignalSubscription,
+        ChannelClosed,
+        StatisticsRequest
     };
     Q_ENUMS(Type)
 
@@ -115,7 +118,8 @@ public:
     QServicePackagePrivate()
         :   packageType(QServicePackage::ObjectCreation),
             entry(QRemoteServiceRegister::Entry()), payload(QVariant()),
-            messageId(QUuid()), instanceId(QUuid()), responseType(QServicePackage::NotAResponse)
+            messageId(QUuid()), instanceId(QUuid()), responseType(QServicePackage::NotAResponse),
+            channelId(0), wireSize(0)
     {
     }
 
@@ -125,6 +129,10 @@ public:
     QUuid messageId;
     QUuid instanceId;
     QServicePackage::ResponseType responseType;
+    // logical channel on a shared connection, 0 if the connection isn't shared
+    quint32 channelId;
+    // serialized size of a received package
+    quint32 wireSize;
 
     void clean()
     {
@@ -134,6 +142,8 @@ public:
         payload = QVariant();
         entry = QRemoteServiceRegister::Entry();
         responseType = QServicePackage::NotAResponse;
+        channelId = 0;
+        wireSize = 0;
     }
 };
 
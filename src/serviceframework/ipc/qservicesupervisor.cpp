@@ -0,0 +1,310 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qservicesupervisor_p.h"
+#include "qremoteserviceregister_p.h"
+#include "qservicedebuglog_p.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+struct QSupervisedService
+{
+    QSupervisedService()
+        : listenfd(-1), notifier(0), process(0), restartTimer(0), restartDelay(0) {}
+
+    QString address;
+    QString program;
+    QString path;
+    int listenfd;
+    QSocketNotifier *notifier;
+    QProcess *process;
+    QTimer *restartTimer;
+    QElapsedTimer uptime;
+    int restartDelay;
+};
+
+QServiceSupervisor::QServiceSupervisor(QObject *parent)
+    : QObject(parent), policy(StartImmediately), idleMsecs(-1)
+{
+}
+
+QServiceSupervisor::~QServiceSupervisor()
+{
+    foreach (QSupervisedService *service, services) {
+        if (service->process) {
+            service->process->disconnect(this);
+            service->process->terminate();
+            if (!service->process->waitForFinished(3000))
+                service->process->kill();
+        }
+#ifdef Q_OS_UNIX
+        if (service->listenfd != -1) {
+            ::unlink(QFile::encodeName(service->path).constData());
+            ::close(service->listenfd);
+        }
+#endif
+        delete service;
+    }
+}
+
+void QServiceSupervisor::setStartPolicy(StartPolicy startPolicy)
+{
+    policy = startPolicy;
+}
+
+QServiceSupervisor::StartPolicy QServiceSupervisor::startPolicy() const
+{
+    return policy;
+}
+
+/*
+    Passed on to the services as SFW_IDLE_TIMEOUT, see
+    QRemoteServiceRegister::idleTimeout. Negative keeps them running.
+*/
+void QServiceSupervisor::setIdleTimeout(int msecs)
+{
+    idleMsecs = msecs;
+}
+
+int QServiceSupervisor::idleTimeout() const
+{
+    return idleMsecs;
+}
+
+/*
+    Supervises the service at the IPC \a address, started by running
+    \a program, which defaults to the address like for clients starting
+    a service. Fails if the service is already running.
+*/
+bool QServiceSupervisor::addService(const QString &address, const QString &program)
+{
+    if (addresses().contains(address))
+        return true;
+
+    QSupervisedService *service = new QSupervisedService;
+    service->address = address;
+    service->program = program.isEmpty() ? address : program;
+    service->path = QDir::cleanPath(QDir::tempPath()) + QLatin1Char('/') + address;
+
+#ifdef Q_OS_UNIX
+    service->listenfd = QRemoteServiceRegisterPrivate::createListenSocket(service->path);
+    if (service->listenfd == -1) {
+        if (errno == EADDRINUSE)
+            qWarning() << "SFW service" << address << "is already running";
+        else
+            qWarning() << "SFW cannot listen on" << service->path << qt_error_string(errno);
+        delete service;
+        return false;
+    }
+
+    service->notifier = new QSocketNotifier(service->listenfd, QSocketNotifier::Read, this);
+    service->notifier->setEnabled(false);
+    connect(service->notifier, SIGNAL(activated(int)), this, SLOT(incomingConnection()));
+#endif
+
+    service->restartTimer = new QTimer(this);
+    service->restartTimer->setSingleShot(true);
+    connect(service->restartTimer, SIGNAL(timeout()), this, SLOT(restartTimeout()));
+
+    services.append(service);
+
+    qServiceLog() << "class" << "supervisor"
+                  << "event" << "add"
+                  << "name" << address
+                  << "fd" << service->listenfd;
+
+    if (policy == StartOnDemand && service->notifier)
+        service->notifier->setEnabled(true);
+    else
+        start(service);
+    return true;
+}
+
+QStringList QServiceSupervisor::addresses() const
+{
+    QStringList result;
+    foreach (QSupervisedService *service, services)
+        result.append(service->address);
+    return result;
+}
+
+bool QServiceSupervisor::isRunning(const QString &address) const
+{
+    foreach (QSupervisedService *service, services) {
+        if (service->address == address)
+            return service->process != 0;
+    }
+    return false;
+}
+
+QSupervisedService *QServiceSupervisor::serviceFor(QObject *object) const
+{
+    foreach (QSupervisedService *service, services) {
+        if (service->notifier == object || service->process == object
+                || service->restartTimer == object)
+            return service;
+    }
+    return 0;
+}
+
+void QServiceSupervisor::start(QSupervisedService *service)
+{
+    if (service->process)
+        return;
+    if (service->notifier)
+        service->notifier->setEnabled(false);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("SFW_IDLE_TIMEOUT"), QString::number(idleMsecs));
+
+    // a dup without close-on-exec for the child, ours stays private
+    int childfd = -1;
+#ifdef Q_OS_UNIX
+    childfd = ::dup(service->listenfd);
+    if (childfd == -1
+            || !QRemoteServiceRegisterPrivate::passListenSocket(childfd, service->address, &env)) {
+        qWarning() << "SFW cannot pass the socket to" << service->address << qt_error_string(errno);
+        if (childfd != -1)
+            ::close(childfd);
+        scheduleRestart(service);
+        return;
+    }
+#endif
+
+    service->process = new QProcess(this);
+    service->process->setProcessChannelMode(QProcess::ForwardedChannels);
+    service->process->setProcessEnvironment(env);
+    connect(service->process, SIGNAL(finished(int,QProcess::ExitStatus)),
+            this, SLOT(processFinished(int,QProcess::ExitStatus)));
+
+    service->uptime.start();
+    service->process->start(service->program, QStringList());
+    bool started = service->process->waitForStarted();
+
+#ifdef Q_OS_UNIX
+    ::close(childfd);
+#endif
+
+    if (!started) {
+        qWarning() << "SFW cannot start" << service->program << service->process->errorString();
+        service->process->disconnect(this);
+        service->process->deleteLater();
+        service->process = 0;
+        scheduleRestart(service);
+        return;
+    }
+
+    qServiceLog() << "class" << "supervisor"
+                  << "event" << "started"
+                  << "name" << service->address
+                  << "pid" << (qint32)service->process->processId();
+    emit serviceStarted(service->address, service->process->processId());
+}
+
+void QServiceSupervisor::scheduleRestart(QSupervisedService *service)
+{
+    // back off from services that keep failing right after their start
+    if (!service->uptime.isValid() || service->uptime.elapsed() < 1000)
+        service->restartDelay = qBound(500, service->restartDelay * 2, 30000);
+    else
+        service->restartDelay = 0;
+
+    service->restartTimer->start(service->restartDelay);
+}
+
+void QServiceSupervisor::incomingConnection()
+{
+    QSupervisedService *service = serviceFor(sender());
+    if (!service)
+        return;
+
+    qServiceLog() << "class" << "supervisor"
+                  << "event" << "activate"
+                  << "name" << service->address;
+    start(service);
+}
+
+void QServiceSupervisor::processFinished(int exitCode, QProcess::ExitStatus status)
+{
+    QSupervisedService *service = serviceFor(sender());
+    if (!service)
+        return;
+
+    qServiceLog() << "class" << "supervisor"
+                  << "event" << "finished"
+                  << "name" << service->address
+                  << "exitcode" << exitCode
+                  << "crashed" << (status == QProcess::CrashExit)
+                  << "uptime" << (qint32)service->uptime.elapsed();
+
+    service->process->deleteLater();
+    service->process = 0;
+    emit serviceFinished(service->address, exitCode);
+
+    scheduleRestart(service);
+}
+
+void QServiceSupervisor::restartTimeout()
+{
+    QSupervisedService *service = serviceFor(sender());
+    if (!service)
+        return;
+
+    // on demand services wait for the next client, which may already be queued
+    if (policy == StartOnDemand && service->notifier)
+        service->notifier->setEnabled(true);
+    else
+        start(service);
+}
+
+#include "moc_qservicesupervisor_p.cpp"
+QT_END_NAMESPACE
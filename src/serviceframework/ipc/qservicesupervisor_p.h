@@ -0,0 +1,121 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSERVICESUPERVISOR_P_H
+#define QSERVICESUPERVISOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserviceframeworkglobal.h"
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+class QTimer;
+struct QSupervisedService;
+
+/*
+    Starts inter-process services ahead of their clients and keeps them
+    available. The supervisor listens on the address of every service it
+    is given and passes the socket on to the service process, see
+    QRemoteServiceRegisterPrivate::createListenSocket(). It keeps its own
+    copy of the socket, so the address stays reachable when the service
+    quits and a client connecting meanwhile is served by the next process.
+
+    StartImmediately keeps a warm process running for each service and
+    starts a new one whenever it exits. StartOnDemand only starts the
+    process once a client connects, like inetd. Services exiting right
+    after their start are restarted with an increasing delay.
+*/
+class Q_SERVICEFW_EXPORT QServiceSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    enum StartPolicy {
+        StartImmediately,
+        StartOnDemand
+    };
+
+    explicit QServiceSupervisor(QObject *parent = 0);
+    ~QServiceSupervisor();
+
+    // set before adding services
+    void setStartPolicy(StartPolicy policy);
+    StartPolicy startPolicy() const;
+    void setIdleTimeout(int msecs);
+    int idleTimeout() const;
+
+    bool addService(const QString &address, const QString &program = QString());
+    QStringList addresses() const;
+    bool isRunning(const QString &address) const;
+
+Q_SIGNALS:
+    void serviceStarted(const QString &address, qint64 pid);
+    void serviceFinished(const QString &address, int exitCode);
+
+private Q_SLOTS:
+    void incomingConnection();
+    void processFinished(int exitCode, QProcess::ExitStatus status);
+    void restartTimeout();
+
+private:
+    QSupervisedService *serviceFor(QObject *object) const;
+    void start(QSupervisedService *service);
+    void scheduleRestart(QSupervisedService *service);
+
+    QList<QSupervisedService *> services;
+    StartPolicy policy;
+    int idleMsecs;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERVICESUPERVISOR_P_H
@@ -58,7 +58,9 @@
     be implemented in a generic fashion.
 
     The activated() method is called whenever the signal is emitted,
-    with the arguments in a typed list.
+    with the arguments in a typed list.  Subclasses which can marshal
+    the raw argument array themselves reimplement rawActivated() instead,
+    which avoids copying every argument into a QVariant.
 
     \sa QSlotInvoker
 
@@ -183,6 +185,23 @@ bool QSignalIntercepter::isValid() const
     return ( d->signalIndex != -1 );
 }
 
+/*!
+    Returns the parameter types of the intercepted signal.  QVariant
+    parameters are reported as QVariantId.
+*/
+int *QSignalIntercepter::parameterTypes() const
+{
+    return d->types;
+}
+
+/*!
+    Returns the number of parameter types of the intercepted signal.
+*/
+int QSignalIntercepter::parameterTypesCount() const
+{
+    return d->numArgs;
+}
+
 /*!
     \internal
 */
@@ -195,18 +214,8 @@ int QSignalIntercepter::qt_metacall(QMetaObject::Call c, int id, void **a)
         switch (id) {
             case 0: {
                 // The signal we are interested in has been activated.
-                if ( d->types ) {
-                    QList<QVariant> args;
-                    for ( int i = 0; i < d->numArgs; ++i ) {
-                        if ( d->types[i] != QVariantId ) {
-                            QVariant arg( d->types[i], a[i + 1] );
-                            args.append( arg );
-                        } else {
-                            args.append( *((const QVariant *)( a[i + 1] )) );
-                        }
-                    }
-                    activated( args );
-                }
+                if ( d->types )
+                    rawActivated( a );
             }
             break;
 
@@ -231,6 +240,28 @@ int QSignalIntercepter::qt_metacall(QMetaObject::Call c, int id, void **a)
     The arguments to the signal are passed in the list \a args.
 */
 
+/*!
+    Called when the signal that is being intercepted is activated, with
+    the raw argument array \a a of the signal.  The types of the arguments
+    are given by parameterTypes().
+
+    The default implementation copies the arguments into a list
+    and calls activated().
+*/
+void QSignalIntercepter::rawActivated( void **a )
+{
+    QList<QVariant> args;
+    for ( int i = 0; i < d->numArgs; ++i ) {
+        if ( d->types[i] != QVariantId ) {
+            QVariant arg( d->types[i], a[i + 1] );
+            args.append( arg );
+        } else {
+            args.append( *((const QVariant *)( a[i + 1] )) );
+        }
+    }
+    activated( args );
+}
+
 // Get the QVariant type number for a type name.
 int QSignalIntercepter::typeFromName( const QByteArray& type )
 {
@@ -73,6 +73,9 @@ public:
 
     bool isValid() const;
 
+    int *parameterTypes() const;
+    int parameterTypesCount() const;
+
     static const int QVariantId = -243;
 
     static int *connectionTypes( const QByteArray& member, int& nargs );
@@ -80,6 +83,7 @@ public:
 protected:
     int qt_metacall( QMetaObject::Call c, int id, void **a );
     virtual void activated( const QList<QVariant>& args ) = 0;
+    virtual void rawActivated( void **a );
 
 private:
     QSignalIntercepterPrivate *d;
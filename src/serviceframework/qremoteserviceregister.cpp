@@ -185,6 +185,27 @@ QRemoteServiceRegister::InstanceType QRemoteServiceRegister::Entry::instantiatio
     return d->instanceType;
 }
 
+/*!
+    Sets the QRemoteServiceRegister::ExecutionPolicy of the registration entry to \a policy.
+
+    If this is not explicitly called, the default policy for the registration entry
+    is QRemoteServiceRegister::SharedThreadExecution. The policy only applies to
+    QRemoteServiceRegister::PrivateInstance entries; global instances are always
+    executed on the thread of the service register.
+*/
+void QRemoteServiceRegister::Entry::setExecutionPolicy(QRemoteServiceRegister::ExecutionPolicy policy)
+{
+    d->executionPolicy = policy;
+}
+
+/*!
+    Returns the QRemoteServiceRegister::ExecutionPolicy of the registration entry.
+*/
+QRemoteServiceRegister::ExecutionPolicy QRemoteServiceRegister::Entry::executionPolicy() const
+{
+    return d->executionPolicy;
+}
+
 /*!
     \class QRemoteServiceRegister
     \inmodule QtServiceFramework
@@ -244,6 +265,11 @@ QRemoteServiceRegister::InstanceType QRemoteServiceRegister::Entry::instantiatio
     on the entry. Once the service register has been published the associated service entries
     can no longer be changed.
 
+    Requests of all clients are executed on the thread of the service register. Private
+    instances which should not stall each other can be given a thread of their own by calling
+    QRemoteServiceRegister::Entry::setExecutionPolicy() with
+    QRemoteServiceRegister::InstanceThreadExecution.
+
     \sa QRemoteServiceRegister::Entry
 */
 
@@ -254,6 +280,15 @@ QRemoteServiceRegister::InstanceType QRemoteServiceRegister::Entry::instantiatio
     \value PrivateInstance    New requests for a service gets a new service instance
 */
 
+/*!
+    \enum QRemoteServiceRegister::ExecutionPolicy
+    Defines on which thread the requests for a service instance are executed
+    \value SharedThreadExecution     Requests of all clients are executed on the thread of the service register
+    \value InstanceThreadExecution   Each service instance and its client connection get a thread of their own,
+                                     so a slow request does not stall other clients. The service object is moved
+                                     to that thread and must not rely on living in the main thread.
+*/
+
 /*!
     \fn void QRemoteServiceRegister::instanceClosed(const QRemoteServiceRegister::Entry& entry)
 
@@ -316,6 +351,11 @@ QRemoteServiceRegister::~QRemoteServiceRegister()
     the service will not be discoverable. In some cases this may also cause the IPC
     rendezvous feature to fail.
 
+    When the service process was started by a client, the client has already
+    created the listening socket for \a ident and the process inherits it.
+    This function adopts that socket, so connections made while the service
+    was starting up are served rather than refused.
+
     \sa createEntry()
 */
 void QRemoteServiceRegister::publishEntries(const QString& ident)
@@ -341,6 +381,31 @@ void QRemoteServiceRegister::setQuitOnLastInstanceClosed(bool quit)
     d->setQuitOnLastInstanceClosed(quit);
 }
 
+/*!
+    \property QRemoteServiceRegister::idleTimeout
+
+    \brief How long the service stays up after the last instance was closed, in milliseconds.
+
+    Only has an effect if \l quitOnLastInstanceClosed is true. With the default
+    of 0 the service quits as soon as all clients have closed all objects. A
+    positive value keeps the service running for that long, so a client that
+    comes back soon does not have to wait for the service to start again. A
+    negative value keeps the service running.
+
+    The default can be changed with the \c SFW_IDLE_TIMEOUT environment variable.
+*/
+int QRemoteServiceRegister::idleTimeout() const
+{
+    if (!d) const_cast<QRemoteServiceRegister*>(this)->init();
+    return d->idleTimeout();
+}
+
+void QRemoteServiceRegister::setIdleTimeout(int msecs)
+{
+    if (!d) init();
+    d->setIdleTimeout(msecs);
+}
+
 /*!
   \since 5.0
 
@@ -61,6 +61,7 @@ class Q_SERVICEFW_EXPORT QRemoteServiceRegister : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool quitOnLastInstanceClosed READ quitOnLastInstanceClosed WRITE setQuitOnLastInstanceClosed)
+    Q_PROPERTY(int idleTimeout READ idleTimeout WRITE setIdleTimeout)
     Q_FLAGS(SocketAccessOption SecurityAccessOptions)
 public:
 
@@ -69,6 +70,11 @@ public:
         PrivateInstance
     };
 
+    enum ExecutionPolicy {
+        SharedThreadExecution = 0,
+        InstanceThreadExecution
+    };
+
     enum SecurityAccessOption {
         NoOptions = 0x0,
         UserAccessOption  =   0x01,
@@ -100,6 +106,9 @@ public:
         void setInstantiationType(QRemoteServiceRegister::InstanceType type);
         QRemoteServiceRegister::InstanceType instantiationType() const;
 
+        void setExecutionPolicy(QRemoteServiceRegister::ExecutionPolicy policy);
+        QRemoteServiceRegister::ExecutionPolicy executionPolicy() const;
+
     private:
         QExplicitlySharedDataPointer<QRemoteServiceRegisterEntryPrivate> d;
 
@@ -127,6 +136,9 @@ public:
     bool quitOnLastInstanceClosed() const;
     void setQuitOnLastInstanceClosed(const bool quit);
 
+    int idleTimeout() const;
+    void setIdleTimeout(int msecs);
+
     typedef void (*SecurityFilter)(QServiceClientCredentials *creds);
     SecurityFilter setSecurityFilter(SecurityFilter filter);
 
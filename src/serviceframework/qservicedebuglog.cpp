@@ -39,71 +39,339 @@
 
 #include "qservicedebuglog_p.h"
 #include <QDebug>
-#include <QTime>
 
-#include <QMutex>
-#include <QMutexLocker>
 #include <QCoreApplication>
 #include <QFileInfo>
 
 #ifdef QT_SFW_IPC_DEBUG
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVector>
+#include <QDir>
 #ifdef Q_OS_UNIX
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
 #endif
+#ifdef QT_SFW_TRACE_MULTICAST
 #include <QNetworkInterface>
 #include <QUdpSocket>
+#include <QHostAddress>
+#endif
 #endif
 
 QT_BEGIN_NAMESPACE
 
-QServiceDebugMessage::QServiceDebugMessage()
-{
 #ifdef QT_SFW_IPC_DEBUG
-    buffer = new QBuffer();
-    buffer->open(QIODevice::WriteOnly);
-    ds.setDevice(buffer);
-    QTime t = QTime::currentTime();
-    ds << (quint8)t.hour();
-    ds << (quint8)t.minute();
-    ds << (quint8)t.second();
-    ds << (quint16)t.msec();
-    ds << (quint32)(QCoreApplication::applicationPid());
-    QFileInfo fi(QCoreApplication::applicationFilePath());
-    QByteArray ba = fi.fileName().toLatin1();
-    ds.writeBytes(ba.constData(), ba.size());
+
+/* keep these in sync with qtsystems/src/tools/sfwlisten/main.cpp */
+#define SFW_TRACE_MAGIC 0x54574653u // "SFWT"
+#define SFW_TRACE_VERSION 1
+#define SFW_TRACE_RING_SIZE 512
+#define SFW_TRACE_DRAIN_INTERVAL 20
+#define SFW_TRACE_DATAGRAM_RECORDS 16
+
+#ifdef QT_SFW_TRACE_MULTICAST
+const static QHostAddress _group_addr(QLatin1String("224.0.105.201"));
 #endif
-}
 
-QServiceDebugMessage::~QServiceDebugMessage()
+/*
+    Single producer, single consumer ring of trace records. Only the owning
+    thread writes records and only the writer thread reads them, so the
+    head and tail indices are all the synchronization needed.
+*/
+class QServiceTraceRing
 {
-#ifdef QT_SFW_IPC_DEBUG
-    /* when we're destructed, we're ready to send! */
-    buffer->close();
-    QServiceDebugLog::instance()->logMessage(this);
+public:
+    QServiceTraceRing(quint32 thread)
+        : thread(thread), head(0), tail(0), dropped(0), finished(0)
+    {
+    }
+
+    bool push(const QServiceTraceRecord &record)
+    {
+        const quint32 h = head.load();
+        if (h - tail.loadAcquire() == SFW_TRACE_RING_SIZE) {
+            dropped.ref();
+            return false;
+        }
+        records[h % SFW_TRACE_RING_SIZE] = record;
+        head.storeRelease(h + 1);
+        return true;
+    }
+
+    QServiceTraceRecord records[SFW_TRACE_RING_SIZE];
+    const quint32 thread;
+    QAtomicInteger<quint32> head;
+    QAtomicInteger<quint32> tail;
+    QAtomicInteger<quint32> dropped;
+    QAtomicInt finished;
+};
+
+/*
+    Owned by the thread local storage, tells the writer the thread is gone
+    so the ring can be released once it has been drained. Also holds the
+    thread's message, so building one never allocates.
+*/
+class QServiceTraceRingHandle
+{
+public:
+    QServiceTraceRingHandle(QServiceTraceRing *ring)
+        : ring(ring)
+    {
+        message.refs = 0;
+    }
+
+    ~QServiceTraceRingHandle()
+    {
+        ring->finished.storeRelease(1);
+    }
+
+    QServiceTraceRing *ring;
+    QServiceDebugMessage message;
+};
+
+/*
+    Drains the rings of all threads in the background and writes the
+    records to the file named by SFW_TRACE_FILE, suffixed with the pid, or
+    multicasts them in datagrams of up to SFW_TRACE_DATAGRAM_RECORDS
+    records otherwise. Without the multicast sink the file defaults to
+    sfw-trace in the temporary directory.
+*/
+class QServiceTraceWriter : public QThread
+{
+public:
+    QServiceTraceWriter();
+
+    QServiceTraceRing *addRing();
+    void stop();
+
+protected:
+    void run();
+
+private:
+    bool drain();
+    void appendRecord(const QServiceTraceRecord &record);
+    void flush();
+#ifdef QT_SFW_TRACE_MULTICAST
+    void makeSockets();
 #endif
-}
+    QByteArray header() const;
 
-#ifdef QT_SFW_IPC_DEBUG
-#include <QHostAddress>
-const static QHostAddress _group_addr(QLatin1String("224.0.105.201"));
+    QMutex ringLock;
+    QList<QServiceTraceRing *> rings;
+    QAtomicInteger<quint32> lastThread;
+    QAtomicInt stopRequested;
+
+    QFile *file;
+#ifdef QT_SFW_TRACE_MULTICAST
+    QVector<QUdpSocket *> sockets;
 #endif
+    QByteArray pending;
+    int pendingRecords;
+};
 
-QServiceDebugLog::QServiceDebugLog()
+Q_GLOBAL_STATIC(QThreadStorage<QServiceTraceRingHandle *>, _q_traceRings)
+
+static quint64 qt_sfw_trace_timestamp()
 {
-    makeSockets();
+#ifdef Q_OS_UNIX
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+    return quint64(QDateTime::currentMSecsSinceEpoch()) * 1000;
+#endif
 }
 
-#ifdef QT_SFW_IPC_DEBUG
-#include <fcntl.h>
+static QServiceTraceWriter *qt_sfw_trace_writer = 0;
+Q_GLOBAL_STATIC(QMutex, _q_traceWriterLock)
+
+static void qt_sfw_trace_shutdown()
+{
+    if (qt_sfw_trace_writer)
+        qt_sfw_trace_writer->stop();
+}
+
+QServiceTraceWriter::QServiceTraceWriter()
+    : lastThread(0), stopRequested(0), file(0), pendingRecords(0)
+{
+    setObjectName(QStringLiteral("sfw trace writer"));
+}
+
+QServiceTraceRing *QServiceTraceWriter::addRing()
+{
+    QServiceTraceRing *ring = new QServiceTraceRing(lastThread.fetchAndAddRelaxed(1) + 1);
+    QMutexLocker locker(&ringLock);
+    rings.append(ring);
+    return ring;
+}
+
+void QServiceTraceWriter::stop()
+{
+    if (!isRunning())
+        return;
+    stopRequested.storeRelease(1);
+    wait();
+}
+
+void QServiceTraceWriter::run()
+{
+    QString path = QString::fromLocal8Bit(qgetenv("SFW_TRACE_FILE"));
+#ifndef QT_SFW_TRACE_MULTICAST
+    if (path.isEmpty())
+        path = QDir::tempPath() + QLatin1String("/sfw-trace");
+#endif
+    if (!path.isEmpty()) {
+        file = new QFile(path + QLatin1Char('.')
+                         + QString::number(QCoreApplication::applicationPid()));
+        if (file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file->write(header());
+        } else {
+            qWarning("SFW cannot open trace file %s", qPrintable(file->fileName()));
+            delete file;
+            file = 0;
+        }
+    }
+
+#ifdef QT_SFW_TRACE_MULTICAST
+    int idle = 0;
+#endif
+    while (!stopRequested.loadAcquire()) {
+        if (drain())
+            continue;
+        flush();
+#ifdef QT_SFW_TRACE_MULTICAST
+        // retry the sockets every few seconds until an interface shows up
+        if (!file && sockets.isEmpty() && (idle++ % 100) == 0)
+            makeSockets();
+#endif
+        msleep(SFW_TRACE_DRAIN_INTERVAL);
+    }
+
+    drain();
+    flush();
+
+    delete file;
+    file = 0;
+#ifdef QT_SFW_TRACE_MULTICAST
+    qDeleteAll(sockets);
+    sockets.clear();
 #endif
+}
 
-void QServiceDebugLog::makeSockets()
+/*
+    Moves the records of all rings to the pending output, returns true if
+    there were any.
+*/
+bool QServiceTraceWriter::drain()
 {
-#ifdef QT_SFW_IPC_DEBUG
-    if (sockets.size() > 0)
+    ringLock.lock();
+    QList<QServiceTraceRing *> current = rings;
+    ringLock.unlock();
+
+    bool any = false;
+    foreach (QServiceTraceRing *ring, current) {
+        const bool finished = ring->finished.loadAcquire();
+
+        quint32 t = ring->tail.load();
+        const quint32 h = ring->head.loadAcquire();
+        for (; t != h; ++t) {
+            appendRecord(ring->records[t % SFW_TRACE_RING_SIZE]);
+            any = true;
+        }
+        ring->tail.storeRelease(t);
+
+        const quint32 dropped = ring->dropped.fetchAndStoreRelaxed(0);
+        if (dropped) {
+            QServiceTraceRecord record;
+            record.timestamp = qt_sfw_trace_timestamp();
+            record.thread = ring->thread;
+            record.flags = QServiceTraceRecord::Dropped;
+            record.size = 4;
+            qToLittleEndian(dropped, record.data);
+            appendRecord(record);
+            any = true;
+        }
+
+        if (finished) {
+            ringLock.lock();
+            rings.removeAll(ring);
+            ringLock.unlock();
+            delete ring;
+        }
+    }
+    return any;
+}
+
+void QServiceTraceWriter::appendRecord(const QServiceTraceRecord &record)
+{
+    if (!file && pending.isEmpty())
+        pending = header();
+
+    uchar out[QServiceTraceRecord::Size];
+    ::memset(out, 0, sizeof(out));
+    qToLittleEndian(record.timestamp, out);
+    qToLittleEndian(record.thread, out + 8);
+    qToLittleEndian(record.size, out + 12);
+    qToLittleEndian(record.flags, out + 14);
+    ::memcpy(out + QServiceTraceRecord::HeaderSize, record.data, record.size);
+    pending.append(reinterpret_cast<const char *>(out), sizeof(out));
+
+    if (++pendingRecords == SFW_TRACE_DATAGRAM_RECORDS)
+        flush();
+}
+
+void QServiceTraceWriter::flush()
+{
+    if (pendingRecords == 0)
         return;
 
+    if (file) {
+        file->write(pending);
+        file->flush();
+    }
+#ifdef QT_SFW_TRACE_MULTICAST
+    // the sockets are only made while there is no trace file
+    foreach (QUdpSocket *socket, sockets)
+        socket->writeDatagram(pending, _group_addr, 10520);
+#endif
+
+    pending.clear();
+    pendingRecords = 0;
+}
+
+/*
+    Identifies the process the following records belong to, it starts the
+    trace file and every datagram.
+*/
+QByteArray QServiceTraceWriter::header() const
+{
+    QByteArray name = QFileInfo(QCoreApplication::applicationFilePath()).fileName().toLatin1();
+    name.truncate(255);
+
+    uchar out[13];
+    qToLittleEndian(quint32(SFW_TRACE_MAGIC), out);
+    qToLittleEndian(quint16(SFW_TRACE_VERSION), out + 4);
+    qToLittleEndian(quint16(QServiceTraceRecord::Size), out + 6);
+    qToLittleEndian(quint32(QCoreApplication::applicationPid()), out + 8);
+    out[12] = uchar(name.size());
+
+    QByteArray data(reinterpret_cast<const char *>(out), sizeof(out));
+    data.append(name);
+    return data;
+}
+
+#ifdef QT_SFW_TRACE_MULTICAST
+void QServiceTraceWriter::makeSockets()
+{
     QList<QNetworkInterface> ifs = QNetworkInterface::allInterfaces();
     foreach (const QNetworkInterface &inf, ifs) {
         /* avoid the loopback or any wireless interfaces
@@ -139,57 +407,93 @@ void QServiceDebugLog::makeSockets()
         qDebug("SFW udp debug on interface %s", qPrintable(inf.name()));
         sockets << socket;
     }
-#endif
 }
+#endif
+#endif
 
-void QServiceDebugLog::logMessage(QServiceDebugMessage *msg)
+QServiceDebugLog::QServiceDebugLog()
 {
-#ifdef QT_SFW_IPC_DEBUG
-    QMutexLocker m(&socketLock);
+}
 
-    if (sockets.size() == 0) {
-        makeSockets();
+#ifdef QT_SFW_IPC_DEBUG
+QBasicAtomicInt QServiceDebugLog::traceEnabled = Q_BASIC_ATOMIC_INITIALIZER(-1);
 
-        if (sockets.size() == 0) {
-            queue << msg->buffer;
-            return;
-        }
-    }
+bool QServiceDebugLog::initEnabled()
+{
+    const QByteArray value = qgetenv("SFW_TRACE");
+    setEnabled(!value.isEmpty() && value != "0");
+    return traceEnabled.loadAcquire() > 0;
+}
+#endif
 
-    if (sockets.size() > 0) {
-        while (!queue.isEmpty()) {
-            foreach (QUdpSocket *socket, sockets) {
-                int ret = socket->writeDatagram(queue.front()->data(), _group_addr, 10520);
-                if (ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
-                    queue << msg->buffer;
-                    return;
-                }
-            }
-            delete queue.front();
-            queue.pop_front();
-        }
-        foreach (QUdpSocket *socket, sockets) {
-            int ret = socket->writeDatagram(msg->buffer->data(), _group_addr, 10520);
-            if (ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
-                queue << msg->buffer;
-                return;
-            }
+/*
+    Switches tracing on or off at runtime, the writer thread is started the
+    first time it is switched on and then idles while tracing is off.
+*/
+void QServiceDebugLog::setEnabled(bool enabled)
+{
+#ifdef QT_SFW_IPC_DEBUG
+    if (enabled) {
+        QMutexLocker locker(_q_traceWriterLock());
+        if (!qt_sfw_trace_writer) {
+            qt_sfw_trace_writer = new QServiceTraceWriter;
+            qt_sfw_trace_writer->start(QThread::LowPriority);
+            qAddPostRoutine(qt_sfw_trace_shutdown);
         }
-        delete msg->buffer;
     }
+    traceEnabled.storeRelease(enabled ? 1 : 0);
 #else
-    Q_UNUSED(msg)
+    Q_UNUSED(enabled)
 #endif
 }
 
-QServiceDebugLog *QServiceDebugLog::instance()
+#ifdef QT_SFW_IPC_DEBUG
+/*
+    Returns the calling thread's message, emptied and stamped, or 0 while
+    that message is still being built, a qServiceLog() expression nested
+    in the arguments of another one is dropped.
+*/
+QServiceDebugMessage *QServiceDebugLog::beginMessage()
 {
-    static QServiceDebugLog *dbg = 0;
-    static QMutex m;
-    QMutexLocker l(&m);
+    QThreadStorage<QServiceTraceRingHandle *> *storage = _q_traceRings();
+    if (!storage || !qt_sfw_trace_writer)
+        return 0;
+
+    QServiceTraceRingHandle *handle = storage->localData();
+    if (!handle) {
+        handle = new QServiceTraceRingHandle(qt_sfw_trace_writer->addRing());
+        storage->setLocalData(handle);
+    }
 
-    if (!dbg)
-        dbg = new QServiceDebugLog();
+    QServiceDebugMessage *msg = &handle->message;
+    if (msg->refs) {
+        handle->ring->dropped.ref();
+        return 0;
+    }
+    msg->reset();
+    msg->record.timestamp = qt_sfw_trace_timestamp();
+    msg->record.thread = handle->ring->thread;
+    return msg;
+}
+
+/*
+    Queues the message in the calling thread's ring buffer, the writer
+    thread picks it up from there. Messages are dropped, and the drop
+    counted, while the ring is full.
+*/
+void QServiceDebugLog::logMessage(QServiceDebugMessage *msg)
+{
+    QThreadStorage<QServiceTraceRingHandle *> *storage = _q_traceRings();
+    if (!storage || !storage->hasLocalData())
+        return;
+    storage->localData()->ring->push(msg->record);
+}
+#endif
+
+QServiceDebugLog *QServiceDebugLog::instance()
+{
+    // never destroyed, end points still log while they're torn down at exit
+    static QServiceDebugLog *dbg = new QServiceDebugLog();
     return dbg;
 }
 
@@ -52,14 +52,47 @@
 
 #include <QString>
 #include <QStringList>
-#include <QBuffer>
-#include <QDataStream>
-#include <QSharedPointer>
-#include <QMutex>
-#include <QVector>
+#include <QAtomicInt>
+#include <QtEndian>
+
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Fixed size trace record. The header is kept in host byte order while
+    the record sits in a ring buffer and converted to little endian when it
+    is drained, the key/value data is little endian from the start.
+
+    data holds key/value pairs, a key is a length byte and the key, a value
+    is a type byte followed by a little endian qint32, a float, or a length
+    byte and latin1 characters.
+*/
+struct QServiceTraceRecord
+{
+    enum {
+        Size = 256,
+        HeaderSize = 16,
+        DataSize = Size - HeaderSize
+    };
+
+    enum Flag {
+        Truncated = 0x1,
+        Dropped = 0x2
+    };
+
+    quint64 timestamp; // microseconds since the epoch
+    quint32 thread;
+    quint16 size;
+    quint16 flags;
+    uchar data[DataSize];
+};
+
+/*
+    Scratch space for the message being built. Every thread has one, the
+    keys and values of a qServiceLog() expression count references to it
+    and the last one to go queues the record.
+*/
 class QServiceDebugMessage
 {
 public:
@@ -69,18 +102,59 @@ public:
         StringType = 3
     };
 
-    QServiceDebugMessage();
-    ~QServiceDebugMessage();
-
 #ifdef QT_SFW_IPC_DEBUG
-    QBuffer *buffer;
-    QDataStream ds;
+    inline void reset()
+    {
+        record.thread = 0;
+        record.size = 0;
+        record.flags = 0;
+        full = false;
+    }
+
+    inline void append(const char *data, int len)
+    {
+        len = qMin(len, 255);
+        if (record.size + 1 + len > QServiceTraceRecord::DataSize) {
+            record.flags |= QServiceTraceRecord::Truncated;
+            full = true;
+            return;
+        }
+        record.data[record.size++] = uchar(len);
+        ::memcpy(record.data + record.size, data, len);
+        record.size += len;
+    }
+
+    inline void appendValue(DataType type, quint32 value)
+    {
+        if (record.size + 5 > QServiceTraceRecord::DataSize) {
+            record.flags |= QServiceTraceRecord::Truncated;
+            full = true;
+            return;
+        }
+        record.data[record.size++] = uchar(type);
+        qToLittleEndian(value, record.data + record.size);
+        record.size += 4;
+    }
+
+    inline void appendString(const char *data, int len)
+    {
+        if (record.size + 2 > QServiceTraceRecord::DataSize) {
+            record.flags |= QServiceTraceRecord::Truncated;
+            full = true;
+            return;
+        }
+        record.data[record.size++] = uchar(StringType);
+        append(data, len);
+    }
+
+    QServiceTraceRecord record;
+    bool full;
+    int refs;
 #endif
 };
 
 class QServiceDebugValue;
 class QServiceDebugKey;
-class QUdpSocket;
 
 class QServiceDebugLog
 {
@@ -89,14 +163,44 @@ public:
 
     static QServiceDebugLog* instance();
 
+    /*
+        Tracing is off until SFW_TRACE is set to something other than 0 in
+        the environment, or until it is switched on here. While it is off a
+        qServiceLog() expression does not touch the message or the ring.
+    */
+    static inline bool isEnabled()
+    {
+#ifdef QT_SFW_IPC_DEBUG
+        const int enabled = traceEnabled.loadAcquire();
+        return enabled > 0 || (enabled < 0 && initEnabled());
+#else
+        return false;
+#endif
+    }
+    static void setEnabled(bool enabled);
+
     QServiceDebugValue operator<<(const char *key);
-    void logMessage(QServiceDebugMessage *msg);
+
+#ifdef QT_SFW_IPC_DEBUG
+    static QServiceDebugMessage *beginMessage();
+    static void logMessage(QServiceDebugMessage *msg);
+
+    static inline void ref(QServiceDebugMessage *msg)
+    {
+        if (msg)
+            ++msg->refs;
+    }
+
+    static inline void deref(QServiceDebugMessage *msg)
+    {
+        if (msg && --msg->refs == 0)
+            logMessage(msg);
+    }
 
 private:
-    QList<QBuffer *> queue;
-    QVector<QUdpSocket *> sockets;
-    void makeSockets();
-    QMutex socketLock;
+    static bool initEnabled();
+    static QBasicAtomicInt traceEnabled;
+#endif
 };
 
 inline QServiceDebugLog &qServiceLog()
@@ -108,16 +212,19 @@ class QServiceDebugKey
 {
 public:
 #ifdef QT_SFW_IPC_DEBUG
-    inline QServiceDebugKey(const QSharedPointer<QServiceDebugMessage> &ptr)
-        : ptr(ptr) {}
-
+    inline explicit QServiceDebugKey(QServiceDebugMessage *msg)
+        : msg(msg) { QServiceDebugLog::ref(msg); }
+    inline QServiceDebugKey(const QServiceDebugKey &other)
+        : msg(other.msg) { QServiceDebugLog::ref(msg); }
+    inline ~QServiceDebugKey() { QServiceDebugLog::deref(msg); }
 #else
     inline QServiceDebugKey() {}
 #endif
     QServiceDebugValue operator<<(const char *key);
 private:
 #ifdef QT_SFW_IPC_DEBUG
-    QSharedPointer<QServiceDebugMessage> ptr;
+    QServiceDebugKey &operator=(const QServiceDebugKey &);
+    QServiceDebugMessage *msg;
 #endif
 };
 
@@ -125,8 +232,11 @@ class QServiceDebugValue
 {
 public:
 #ifdef QT_SFW_IPC_DEBUG
-    inline QServiceDebugValue(const QSharedPointer<QServiceDebugMessage> &ptr)
-        : ptr(ptr) {}
+    inline explicit QServiceDebugValue(QServiceDebugMessage *msg)
+        : msg(msg) { QServiceDebugLog::ref(msg); }
+    inline QServiceDebugValue(const QServiceDebugValue &other)
+        : msg(other.msg) { QServiceDebugLog::ref(msg); }
+    inline ~QServiceDebugValue() { QServiceDebugLog::deref(msg); }
 #else
     inline QServiceDebugValue() {}
 #endif
@@ -136,15 +246,17 @@ public:
     QServiceDebugKey operator<<(const char *val);
 private:
 #ifdef QT_SFW_IPC_DEBUG
-    QSharedPointer<QServiceDebugMessage> ptr;
+    QServiceDebugValue &operator=(const QServiceDebugValue &);
+    QServiceDebugMessage *msg;
 #endif
 };
 
 inline QServiceDebugValue QServiceDebugKey::operator<<(const char *key)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    ptr->ds.writeBytes(key, ::strlen(key));
-    return QServiceDebugValue(ptr);
+    if (msg && !msg->full)
+        msg->append(key, ::strlen(key));
+    return QServiceDebugValue(msg);
 #else
     Q_UNUSED(key)
     return QServiceDebugValue();
@@ -154,9 +266,9 @@ inline QServiceDebugValue QServiceDebugKey::operator<<(const char *key)
 inline QServiceDebugKey QServiceDebugValue::operator<<(const qint32 &val)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    ptr->ds << (qint8)QServiceDebugMessage::Int32Type;
-    ptr->ds << val;
-    return QServiceDebugKey(ptr);
+    if (msg && !msg->full)
+        msg->appendValue(QServiceDebugMessage::Int32Type, quint32(val));
+    return QServiceDebugKey(msg);
 #else
     Q_UNUSED(val)
     return QServiceDebugKey();
@@ -166,9 +278,12 @@ inline QServiceDebugKey QServiceDebugValue::operator<<(const qint32 &val)
 inline QServiceDebugKey QServiceDebugValue::operator<<(const float &val)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    ptr->ds << (qint8)QServiceDebugMessage::FloatType;
-    ptr->ds << val;
-    return QServiceDebugKey(ptr);
+    if (msg && !msg->full) {
+        quint32 bits;
+        ::memcpy(&bits, &val, sizeof(bits));
+        msg->appendValue(QServiceDebugMessage::FloatType, bits);
+    }
+    return QServiceDebugKey(msg);
 #else
     Q_UNUSED(val)
     return QServiceDebugKey();
@@ -178,10 +293,11 @@ inline QServiceDebugKey QServiceDebugValue::operator<<(const float &val)
 inline QServiceDebugKey QServiceDebugValue::operator<<(const QString &val)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    ptr->ds << (qint8)QServiceDebugMessage::StringType;
-    QByteArray ba = val.toLatin1();
-    ptr->ds.writeBytes(ba.constData(), ba.size());
-    return QServiceDebugKey(ptr);
+    if (msg && !msg->full) {
+        QByteArray ba = val.toLatin1();
+        msg->appendString(ba.constData(), ba.size());
+    }
+    return QServiceDebugKey(msg);
 #else
     Q_UNUSED(val)
     return QServiceDebugKey();
@@ -191,9 +307,9 @@ inline QServiceDebugKey QServiceDebugValue::operator<<(const QString &val)
 inline QServiceDebugKey QServiceDebugValue::operator<<(const char *val)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    ptr->ds << (qint8)QServiceDebugMessage::StringType;
-    ptr->ds.writeBytes(val, ::strlen(val));
-    return QServiceDebugKey(ptr);
+    if (msg && !msg->full)
+        msg->appendString(val, ::strlen(val));
+    return QServiceDebugKey(msg);
 #else
     Q_UNUSED(val)
     return QServiceDebugKey();
@@ -203,8 +319,9 @@ inline QServiceDebugKey QServiceDebugValue::operator<<(const char *val)
 inline QServiceDebugValue QServiceDebugLog::operator<<(const char *key)
 {
 #ifdef QT_SFW_IPC_DEBUG
-    QSharedPointer<QServiceDebugMessage> msg(new QServiceDebugMessage());
-    return (QServiceDebugKey(msg) << key);
+    if (!isEnabled())
+        return QServiceDebugValue(0);
+    return (QServiceDebugKey(beginMessage()) << key);
 #else
     Q_UNUSED(key)
     return QServiceDebugValue();
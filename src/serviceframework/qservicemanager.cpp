@@ -46,6 +46,9 @@
 #include "qservicereply.h"
 #include "qservicerequest_p.h"
 #include "qservicedebuglog_p.h"
+#ifndef SFW_USE_DBUS_BACKEND
+#include "objectendpoint_p.h"
+#endif
 
 #include "databasemanager_p.h"
 
@@ -56,10 +59,51 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QSystemSemaphore>
-#include <QScopedPointer>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Process wide cache of resolved plugin paths and plugin loaders, shared
+    by all QServiceManager instances.
+
+    Service plugins are never unloaded once loaded, so keeping one loader
+    per plugin for the lifetime of the process does not change which
+    libraries stay in memory; it only avoids probing the library paths and
+    creating a new loader on every loadInterface() call.
+
+    QPluginLoader is not thread-safe, and loaders are shared between the
+    preloader, the operation workers and the calling threads, so every
+    loader is only used with its own mutex held.
+*/
+struct QServicePlugin
+{
+    QServicePlugin(const QString &libPath)
+        : loader(libPath)
+    {
+    }
+
+    QMutex mutex;
+    QPluginLoader loader;
+};
+
+class QServicePluginCache
+{
+public:
+    ~QServicePluginCache()
+    {
+        qDeleteAll(plugins);
+    }
+
+    QMutex mutex;
+    QHash<QString, QString> libraryPaths;
+    QHash<QString, QServicePlugin *> plugins;
+};
+
+Q_GLOBAL_STATIC(QServicePluginCache, pluginCache)
+
 QString QServiceManager::resolveLibraryPath(const QString &libNameOrPath)
 {
     if (QFile::exists(libNameOrPath))
@@ -82,25 +126,110 @@ QString QServiceManager::resolveLibraryPath(const QString &libNameOrPath)
     return QString();
 }
 
-class QServicePluginCleanup : public QObject
+/*
+    Returns the resolved path of the plugin \a libNameOrPath.  The path is
+    only probed when it is first resolved; installing or removing a service
+    drops the cached path through forgetLibraryPath().
+*/
+static QString cachedLibraryPath(const QString &libNameOrPath)
+{
+    QServicePluginCache *cache = pluginCache();
+    {
+        QMutexLocker locker(&cache->mutex);
+        const QString libPath = cache->libraryPaths.value(libNameOrPath);
+        if (!libPath.isEmpty())
+            return libPath;
+    }
+
+    //failures are not cached as the plugin may still be installed later
+    const QString libPath = QServiceManager::resolveLibraryPath(libNameOrPath);
+    if (!libPath.isEmpty()) {
+        QMutexLocker locker(&cache->mutex);
+        cache->libraryPaths.insert(libNameOrPath, libPath);
+    }
+    return libPath;
+}
+
+static void forgetLibraryPath(const QString &libNameOrPath)
+{
+    QServicePluginCache *cache = pluginCache();
+    QMutexLocker locker(&cache->mutex);
+    cache->libraryPaths.remove(libNameOrPath);
+}
+
+/*
+    Returns the shared plugin entry for \a libPath.  The entry is created on
+    first use; loading the library is left to the caller so that the cache
+    is not locked while dlopen() runs.
+*/
+static QServicePlugin *cachedPlugin(const QString &libPath)
+{
+    QServicePluginCache *cache = pluginCache();
+    QMutexLocker locker(&cache->mutex);
+    QServicePlugin *&plugin = cache->plugins[libPath];
+    if (!plugin)
+        plugin = new QServicePlugin(libPath);
+    return plugin;
+}
+
+/*
+    Loads the plugin at \a libPath without instantiating it.  Returns false
+    and sets \a errorString if the library cannot be loaded.
+*/
+static bool loadPlugin(const QString &libPath, QString *errorString)
+{
+    QServicePlugin *plugin = cachedPlugin(libPath);
+    QMutexLocker locker(&plugin->mutex);
+    if (plugin->loader.load())
+        return true;
+    *errorString = plugin->loader.errorString();
+    return false;
+}
+
+/*
+    Returns the plugin interface of the plugin at \a libPath, loading the
+    library if needed.  Returns 0 and sets \a errorString on failure.
+*/
+static QServicePluginInterface *pluginInterface(const QString &libPath, QString *errorString)
+{
+    QServicePlugin *plugin = cachedPlugin(libPath);
+    QMutexLocker locker(&plugin->mutex);
+    QServicePluginInterface *pluginIFace = qobject_cast<QServicePluginInterface *>(plugin->loader.instance());
+    if (!pluginIFace)
+        *errorString = plugin->loader.errorString();
+    return pluginIFace;
+}
+
+/*
+    Resolves and loads the plugins at \a locations in a thread pool thread,
+    without instantiating them, so that a later loadInterface() neither
+    probes the library paths nor waits for the dynamic linker.
+*/
+class QServicePluginPreloader : public QRunnable
 {
-    Q_OBJECT
 public:
-    QServicePluginCleanup(QPluginLoader *loader, QObject *parent = 0)
-        : QObject(parent),
-          m_loader(loader)
+    QServicePluginPreloader(const QStringList &locations)
+        : m_locations(locations)
     {
     }
 
-    ~QServicePluginCleanup()
+    void run()
     {
-        if (m_loader) {
-            //m_loader->unload();
-            delete m_loader;
+        foreach (const QString &location, m_locations) {
+            const QString libPath = cachedLibraryPath(location);
+            if (libPath.isEmpty()) {
+                qWarning() << "QServiceManager::preloadInterfaces(): cannot find plugin" << location;
+                continue;
+            }
+
+            QString errorString;
+            if (!loadPlugin(libPath, &errorString))
+                qWarning() << "QServiceManager::preloadInterfaces():" << libPath << errorString;
         }
     }
 
-    QPluginLoader *m_loader;
+private:
+    QStringList m_locations;
 };
 
 class QServiceManagerPrivate : public QObject
@@ -177,6 +306,35 @@ public:
             manager->errorChanged();
     }
 
+    /*
+        Calls QServicePluginInterface::installService() on a newly
+        registered plugin \a service.  If the plugin cannot be loaded
+        the service is unregistered from \a dbScope again.
+    */
+    bool installService(const ServiceMetaDataResults &service, DatabaseManager::DbScope dbScope)
+    {
+        if (service.type == QService::InterProcess)
+            return true;
+
+        bool result = true;
+        //the plugin may have been (re)installed at a different path
+        forgetLibraryPath(service.location);
+        const QString libPath = cachedLibraryPath(service.location);
+        QString errorString;
+        QServicePluginInterface *pluginIFace = pluginInterface(libPath, &errorString);
+        if (pluginIFace) {
+            pluginIFace->installService();
+        } else {
+            setError(QServiceManager::PluginLoadingFailed);
+            result = false;
+            qWarning() << "QServiceManager::addService()"  << service.location << "->"
+                << libPath << ":"
+                << errorString << " - Aborting registration";
+            dbManager->unregisterService(service.name, dbScope);
+        }
+        return result;
+    }
+
 private Q_SLOTS:
     void serviceAdded(const QString &service, DatabaseManager::DbScope dbScope)
     {
@@ -398,13 +556,12 @@ QObject *QServiceManager::loadInterProcessService(const QServiceInterfaceDescrip
 QObject *QServiceManager::loadInProcessService(const QServiceInterfaceDescriptor& descriptor,
                                                const QString &serviceFilePath) const
 {
-    QScopedPointer<QPluginLoader> loader(new QPluginLoader(serviceFilePath));
     QObject *obj = 0;
 
     // pluginIFace is same for all service instances of the same plugin
-    // calling loader->unload deletes pluginIFace automatically if no other
-    // service instance is around
-    QServicePluginInterface *pluginIFace = qobject_cast<QServicePluginInterface *>(loader->instance());
+    // and the loader is shared, so it is only created once per process
+    QString errorString;
+    QServicePluginInterface *pluginIFace = pluginInterface(serviceFilePath, &errorString);
     if (pluginIFace) {
         //check initialization first as the service may be a pre-registered one
         bool doLoading = true;
@@ -430,17 +587,14 @@ QObject *QServiceManager::loadInProcessService(const QServiceInterfaceDescriptor
         }
         if (doLoading) {
             obj = pluginIFace->createInstance(descriptor);
-            if (obj) {
-                QServicePluginCleanup *cleanup = new QServicePluginCleanup(loader.take());
-                QObject::connect(obj, SIGNAL(destroyed()), cleanup, SLOT(deleteLater()));
-            } else {
+            if (!obj) {
                 qWarning() << "Cannot create object instance for "
                      << descriptor.interfaceName() << ":"
                      << serviceFilePath;
             }
         }
     } else {
-        qWarning() << "QServiceManager::loadInterface():" << serviceFilePath << loader->errorString();
+        qWarning() << "QServiceManager::loadInterface():" << serviceFilePath << errorString;
     }
     return obj;
 }
@@ -477,7 +631,7 @@ QObject* QServiceManager::loadInterface(const QServiceInterfaceDescriptor& descr
     }
     else
     {
-        QString serviceFilePath = resolveLibraryPath(location);
+        QString serviceFilePath = cachedLibraryPath(location);
         if (serviceFilePath.isEmpty())
         {
             d->setError(QServiceManager::InvalidServiceLocation);
@@ -491,6 +645,41 @@ QObject* QServiceManager::loadInterface(const QServiceInterfaceDescriptor& descr
     return obj;
 }
 
+/*!
+    Loads the plugins providing the default implementations of
+    \a interfaceNames in a background thread and returns immediately.
+
+    The first loadInterface() call for a plugin-based service otherwise has
+    to locate the plugin in the library paths and load the library. An
+    application that knows which services it is going to use can call this
+    function at startup, so that later loadInterface() calls only need to
+    create the service objects. The plugins are not instantiated and no
+    service objects are created by this function.
+
+    Interfaces without a default implementation and inter-process services
+    are ignored.
+
+    \sa loadInterface()
+*/
+void QServiceManager::preloadInterfaces(const QStringList& interfaceNames)
+{
+    QStringList locations;
+    foreach (const QString &interfaceName, interfaceNames) {
+        const QServiceInterfaceDescriptor descriptor = interfaceDefault(interfaceName);
+        if (!descriptor.isValid()
+                || descriptor.attribute(QServiceInterfaceDescriptor::ServiceType).toInt() != QService::Plugin)
+            continue;
+
+        const QString location = descriptor.attribute(QServiceInterfaceDescriptor::Location).toString();
+        if (!locations.contains(location))
+            locations.append(location);
+    }
+    d->setError(QServiceManager::NoError);
+
+    if (!locations.isEmpty())
+        QThreadPool::globalInstance()->start(new QServicePluginPreloader(locations));
+}
+
 /*!
     \fn QServiceReply *loadInterfaceRequest(const QString &interfaceName)
     Initiate a background request to load the interface specified by \a interfaceName, and
@@ -739,37 +928,63 @@ bool QServiceManager::addService(QIODevice *device)
         d->setError(QServiceManager::InvalidServiceXml);
         return false;
     }
-    const ServiceMetaDataResults data = parser.parseResults();
-
     DatabaseManager::DbScope scope = d->scope == QService::UserScope ?
             DatabaseManager::UserOnlyScope : DatabaseManager::SystemScope;
     ServiceMetaDataResults results = parser.parseResults();
 
-    bool result = d->dbManager->registerService(results, scope);
+    if (!d->dbManager->registerService(results, scope)) {
+        d->setError();
+        return false;
+    }
 
-    if (results.type == QService::InterProcess)
-        return result;
+    return d->installService(results, scope);
+}
 
-    //test the new plug-in
-    if (result) {
-        QPluginLoader *loader = new QPluginLoader(resolveLibraryPath(data.location));
-        QServicePluginInterface *pluginIFace = qobject_cast<QServicePluginInterface *>(loader->instance());
-        if (pluginIFace) {
-            pluginIFace->installService();
-        } else {
-            d->setError(QServiceManager::PluginLoadingFailed);
-            result = false;
-            qWarning() << "QServiceManager::addService()"  << data.location << "->"
-                << resolveLibraryPath(data.location) << ":"
-                << loader->errorString() << " - Aborting registration";
-            d->dbManager->unregisterService(data.name, scope);
-        }
-        //loader->unload();
-        delete loader;
-    } else {
+/*!
+    Registers the services defined by the XML files in \a xmlFilePaths.
+    Returns true if all of the services were registered, and false otherwise.
+
+    The XML files are parsed concurrently and all services are stored using
+    a single database transaction, so that registering a large number of
+    services only results in one database update and one change notification
+    for other service managers. If any of the files is invalid or any of
+    the services cannot be registered, none of the services are registered.
+
+    As with addService(), QServicePluginInterface::installService() is called
+    on each plugin-based service once the services have been stored. Services
+    whose plugin cannot be loaded are unregistered again, and this method
+    returns false with error() set to PluginLoadingFailed.
+
+    Services are always added based on the \l scope() of the current
+    service manager instance.
+
+    \since 5.4
+    \sa addService(), removeService()
+*/
+bool QServiceManager::addServices(const QStringList &xmlFilePaths)
+{
+    d->setError(QServiceManager::NoError);
+    QList<ServiceMetaDataResults> services;
+    QStringList invalidFilePaths;
+    if (!ServiceMetaData::extractMetadata(xmlFilePaths, &services, &invalidFilePaths)) {
+        foreach (const QString &xmlFilePath, invalidFilePaths)
+            qWarning() << "QServiceManager::addServices(): invalid service xml" << xmlFilePath;
+        d->setError(QServiceManager::InvalidServiceXml);
+        return false;
+    }
+
+    DatabaseManager::DbScope scope = d->scope == QService::UserScope ?
+            DatabaseManager::UserOnlyScope : DatabaseManager::SystemScope;
+    if (!d->dbManager->registerServices(services, scope)) {
         d->setError();
+        return false;
     }
 
+    bool result = true;
+    foreach (const ServiceMetaDataResults &service, services) {
+        if (!d->installService(service, scope))
+            result = false;
+    }
     return result;
 }
 
@@ -814,14 +1029,13 @@ bool QServiceManager::removeService(const QString& serviceName)
 
     QList<QString> pluginPaths = pluginPathsSet.toList();
     for (int i=0; i<pluginPaths.count(); i++) {
-        QPluginLoader *loader = new QPluginLoader(resolveLibraryPath(pluginPaths[i]));
-        QServicePluginInterface *pluginIFace = qobject_cast<QServicePluginInterface *>(loader->instance());
+        QString errorString;
+        QServicePluginInterface *pluginIFace = pluginInterface(cachedLibraryPath(pluginPaths[i]), &errorString);
         if (pluginIFace)
             pluginIFace->uninstallService();
         else
             qWarning() << "QServiceManager: unable to invoke uninstallService() on removed service";
-        //loader->unload();
-        delete loader;
+        forgetLibraryPath(pluginPaths[i]);
     }
 
     if (!d->dbManager->unregisterService(serviceName, d->scope == QService::UserScope ?
@@ -912,6 +1126,69 @@ QServiceManager::Error QServiceManager::error() const
     return d->error;
 }
 
+/*!
+    Sets the time blocking calls on the inter-process \a service object wait
+    for the service to reply to \a msecs milliseconds. A call that gets no
+    reply in time fails and returns a default constructed value. A negative
+    \a msecs makes calls wait until the service replies or the connection
+    is closed.
+
+    The timeout applies to the calls started after it was set, so it can be
+    changed for a single call. It defaults to 15 seconds, or the value of the
+    \c SFW_CALL_TIMEOUT environment variable.
+
+    Returns false if \a service is not an inter-process service object
+    loaded by loadInterface(). The D-Bus backend does not support timeouts.
+
+    \sa interProcessCallTimeout(), cancelInterProcessCalls()
+*/
+bool QServiceManager::setInterProcessCallTimeout(QObject *service, int msecs)
+{
+#ifndef SFW_USE_DBUS_BACKEND
+    return ObjectEndPoint::setCallTimeout(service, msecs);
+#else
+    Q_UNUSED(service);
+    Q_UNUSED(msecs);
+    return false;
+#endif
+}
+
+/*!
+    Returns the time blocking calls on the inter-process \a service object
+    wait for a reply, in milliseconds. Returns 0 if \a service is not an
+    inter-process service object.
+
+    \sa setInterProcessCallTimeout()
+*/
+int QServiceManager::interProcessCallTimeout(QObject *service)
+{
+#ifndef SFW_USE_DBUS_BACKEND
+    return ObjectEndPoint::callTimeout(service);
+#else
+    Q_UNUSED(service);
+    return 0;
+#endif
+}
+
+/*!
+    Makes the blocking calls on the inter-process \a service object that
+    are waiting for a reply fail immediately. Later calls are not affected.
+
+    This function may be called from any thread while \a service exists,
+    for instance by a watchdog which finds the thread using \a service
+    blocked.
+
+    \sa setInterProcessCallTimeout()
+*/
+void QServiceManager::cancelInterProcessCalls(QObject *service)
+{
+#ifndef SFW_USE_DBUS_BACKEND
+    ObjectEndPoint::cancelPendingCalls(service);
+#else
+    Q_UNUSED(service);
+#endif
+}
+
 /*!
     \internal
 */
@@ -102,8 +102,11 @@ public:
     QServiceReply *loadInterfaceRequest(const QString& interfaceName);
     QServiceReply *loadInterfaceRequest(const QServiceInterfaceDescriptor& descriptor);
 
+    void preloadInterfaces(const QStringList& interfaceNames);
+
     bool addService(const QString& xmlFilePath);
     bool addService(QIODevice* xmlDevice);
+    bool addServices(const QStringList& xmlFilePaths);
     bool removeService(const QString& serviceName);
 
     bool setInterfaceDefault(const QString &service, const QString &interfaceName);
@@ -113,6 +116,10 @@ public:
 
     QServiceManager::Error error() const;
 
+    static bool setInterProcessCallTimeout(QObject *service, int msecs);
+    static int interProcessCallTimeout(QObject *service);
+    static void cancelInterProcessCalls(QObject *service);
+
     bool event(QEvent *);
 
 protected:
@@ -60,6 +60,36 @@ Q_GLOBAL_STATIC(QServiceOperations, q_service_operations_object)
 //// is that no locking is needed in QServiceOperationProcessor since it can
 //// only be accessed within its own thread, by calls that are serialised into
 //// its slots by the signal-slot event queue.
+////
+//// When requests arrive while the processors are busy further worker threads,
+//// each with a processor of its own, are started up to a limit of
+//// SFW_OPERATION_THREADS (by default the number of cores, at most 4).  The
+//// workers run an event loop like the facade thread does, since IPC
+//// connections opened while loading a service live in the loading thread.
+//// A request identical to one in flight is not dispatched at all, it is
+//// queued behind that one and handed to its processor when it is done.  The
+//// processor completes it with what it found out for the first request, see
+//// QServiceLoadResult.  The dispatch bookkeeping is the only state shared
+//// between threads and is guarded by m_lock.
+
+static void qt_sfw_stop_thread(QThread *thread)
+{
+    thread->quit();
+    int triesLeft = 3;
+    bool exitedCleanly = false;
+    while (triesLeft) {
+        exitedCleanly = thread->wait(500);
+        if (exitedCleanly)
+            break;
+        qWarning() << "Waiting for QServiceOperations background thread to exit...";
+        triesLeft--;
+    }
+    if (!exitedCleanly) {
+        qWarning() << "...forcing termination of QServiceOperations thread!";
+        thread->terminate();
+        thread->wait();
+    }
+}
 
 QServiceOperations::QServiceOperations(QObject *parent)
     : QThread(parent)
@@ -72,22 +102,27 @@ QServiceOperations::QServiceOperations(QObject *parent)
     qRegisterMetaType<QServiceRequest>("QServiceRequest");
     qRegisterMetaType<QServiceManager::Error>("QServiceManager::Error");
 
+    m_maxWorkers = qEnvironmentVariableIsSet("SFW_OPERATION_THREADS")
+            ? qEnvironmentVariableIntValue("SFW_OPERATION_THREADS")
+            : qMin(QThread::idealThreadCount(), 4);
+    m_maxWorkers = qMax(m_maxWorkers, 1);
+
     // created in the constructor otherwise we can signals/slots
-    QServiceOperationProcessor *processor = new QServiceOperationProcessor();
+    QServiceOperationProcessor *processor = new QServiceOperationProcessor(this);
     processor->moveToThread(this);
+    m_processors.append(processor);
 
-    // This call creates a queued connection
-    connect(this, SIGNAL(newRequest(QServiceRequest)),
-            processor, SLOT(handleRequest(QServiceRequest)), Qt::QueuedConnection);
     connect(this, SIGNAL(destroyed()),
             processor, SLOT(deleteLater()));
 
     qServiceLog() << "event" << "new"
-                  << "class" << "QServiceOperations";
+                  << "class" << "QServiceOperations"
+                  << "workers" << m_maxWorkers;
 }
 
 QServiceOperations::~QServiceOperations()
 {
+    stopWorkers();
     qServiceLog() << "event" << "delete"
                   << "class" << "QServiceOperations";
 }
@@ -132,7 +167,8 @@ void QServiceOperations::engage()
     will try 3 times to quit the thread (with a 500ms window each time) for a
     total worst-case of 1500ms; before calling terminate on the thread.  After
     that the termination will still take a short period of time before its
-    safe to clean up the thread object.
+    safe to clean up the thread object.  Extra worker threads are shut down
+    the same way.
 */
 void QServiceOperations::disengage()
 {
@@ -143,30 +179,128 @@ void QServiceOperations::disengage()
     if (!m_engageCount.deref()) {
         qServiceLog() << "event" << "shutdown"
                       << "class" << "QServiceOperations";
-        quit();
-        int triesLeft = 3;
-        bool exitedCleanly = false;
-        while (triesLeft) {
-            exitedCleanly = wait(500);
-            if (exitedCleanly)
-                break;
-            qWarning() << "Waiting for QServiceOperations background thread to exit...";
-            triesLeft--;
+        stopWorkers();
+        qt_sfw_stop_thread(this);
+    }
+}
+
+void QServiceOperations::stopWorkers()
+{
+    QList<QThread *> workers;
+    {
+        QMutexLocker locker(&m_lock);
+        workers.swap(m_workers);
+        while (m_processors.count() > 1)
+            m_processors.removeLast();
+        m_load.clear();
+        m_inFlight.clear();
+    }
+
+    // the processors are deleted as their threads finish
+    foreach (QThread *worker, workers) {
+        qt_sfw_stop_thread(worker);
+        delete worker;
+    }
+}
+
+int QServiceOperations::workerCount()
+{
+    QMutexLocker locker(&m_lock);
+    return m_processors.count();
+}
+
+/*
+    Requests with the same key are for the same interface and are coalesced.
+*/
+QString QServiceOperations::requestKey(const QServiceRequest &req)
+{
+    QString key = QString::number(req.scope()) + QLatin1Char('/');
+    if (req.requestType() == QServiceRequest::DefaultInterfaceRequest)
+        return key + req.interfaceName();
+
+    const QServiceInterfaceDescriptor descriptor = req.descriptor();
+    return key + descriptor.interfaceName() + QLatin1Char('/') + descriptor.serviceName()
+            + QLatin1Char('/') + QString::number(descriptor.majorVersion())
+            + QLatin1Char('.') + QString::number(descriptor.minorVersion());
+}
+
+/*
+    Chooses the processor for a request, starting another worker if all of
+    them are busy.  Returns 0 if the request was queued behind an identical
+    one.  Must be called with m_lock held.
+*/
+QServiceOperationProcessor *QServiceOperations::pickProcessor(const QString &key, const QServiceRequest &req)
+{
+    QHash<QString, InFlight>::iterator it = m_inFlight.find(key);
+    if (it != m_inFlight.end()) {
+        it->followers.append(req);
+        return 0;
+    }
+
+    QServiceOperationProcessor *processor = 0;
+    int load = 0;
+    foreach (QServiceOperationProcessor *candidate, m_processors) {
+        const int candidateLoad = m_load.value(candidate);
+        if (!processor || candidateLoad < load) {
+            processor = candidate;
+            load = candidateLoad;
         }
-        if (!exitedCleanly) {
-            qWarning() << "...forcing termination of QServiceOperations thread!";
-            terminate();
-            wait();
+    }
+
+    if (load > 0 && m_processors.count() < m_maxWorkers) {
+        QThread *worker = new QThread;
+        worker->setObjectName(QStringLiteral("QServiceOperations worker %1").arg(m_processors.count()));
+        processor = new QServiceOperationProcessor(this);
+        processor->moveToThread(worker);
+        connect(worker, SIGNAL(finished()), processor, SLOT(deleteLater()));
+        worker->start();
+
+        m_workers.append(worker);
+        m_processors.append(processor);
+
+        qServiceLog() << "event" << "new worker"
+                      << "class" << "QServiceOperations"
+                      << "workers" << m_processors.count();
+    }
+
+    InFlight inFlight;
+    inFlight.processor = processor;
+    m_inFlight.insert(key, inFlight);
+    m_load[processor]++;
+    return processor;
+}
+
+/*
+    Called by the processors from their threads when they are done with a
+    request.  Returns the identical requests that came in meanwhile, which
+    the processor completes before calling this again.
+*/
+QList<QServiceRequest> QServiceOperations::requestFinished(QServiceOperationProcessor *processor, const QString &key)
+{
+    QMutexLocker locker(&m_lock);
+    QList<QServiceRequest> followers;
+
+    QHash<QString, InFlight>::iterator it = m_inFlight.find(key);
+    if (it != m_inFlight.end() && it->processor == processor) {
+        if (!it->followers.isEmpty()) {
+            followers.swap(it->followers);
+            return followers;
         }
+        m_inFlight.erase(it);
     }
+
+    QHash<QServiceOperationProcessor *, int>::iterator load = m_load.find(processor);
+    if (load != m_load.end() && --load.value() <= 0)
+        m_load.erase(load);
+    return followers;
 }
 
 /*
     Make a new request.  This slot will be called synchronously from the client
     code, since the client and the facade are in the same thread.  However this
-    slot then forwards the request on via a queued connection to the internal
-    operations object.  The queue automatically gives thread safety to the
-    processor meaning no locking is required.
+    slot then forwards the request on via a queued connection to one of the
+    processors.  The queue automatically gives thread safety to the processor
+    meaning no locking is required.
 */
 void QServiceOperations::initiateRequest(const QServiceRequest &req)
 {
@@ -174,7 +308,21 @@ void QServiceOperations::initiateRequest(const QServiceRequest &req)
                   << "class" << "QServiceOperations"
                   << "iface" << req.descriptor().interfaceName();
 
-    emit newRequest(req);
+    QServiceOperationProcessor *processor;
+    {
+        QMutexLocker locker(&m_lock);
+        processor = pickProcessor(requestKey(req), req);
+    }
+
+    if (!processor) {
+        qServiceLog() << "event" << "coalesced"
+                      << "class" << "QServiceOperations"
+                      << "iface" << req.descriptor().interfaceName();
+        return;
+    }
+
+    QMetaObject::invokeMethod(processor, "handleRequest", Qt::QueuedConnection,
+                              Q_ARG(QServiceRequest, req));
 }
 
 /*
@@ -197,18 +345,41 @@ void QServiceOperations::run()
 ////    QServiceOperationProcessor implementation
 
 /*
-    Constructor - stateless object at present.
+    What was found out while loading the first of a group of identical
+    requests.  The others are completed with the same descriptor, library
+    path or error, so the default lookup and the path resolution run once
+    per group.  Each reply still gets an object of its own, since every
+    client owns and deletes what it receives; IPC proxies to one service
+    share a single connection though.
 */
-QServiceOperationProcessor::QServiceOperationProcessor(QObject *parent)
-    : QObject(parent), inRequest(false)
+struct QServiceLoadResult
+{
+    QServiceLoadResult()
+        : resolved(false), interProcess(false),
+          error(QServiceManager::NoError) {}
+
+    bool resolved;
+    bool interProcess;
+    QServiceManager::Error error;
+    QServiceInterfaceDescriptor descriptor;
+    // the IPC address, or the resolved library path of a plugin
+    QString location;
+};
+
+/*
+    Constructor - the service managers are created on first use, in the
+    processor's thread.
+*/
+QServiceOperationProcessor::QServiceOperationProcessor(QServiceOperations *operations)
+    : QObject(0), operations(operations), inRequest(false)
 {
     qServiceLog() << "event" << "new"
                   << "class" << "QServiceOperationProc";
 }
 
 /*
-    Destructor - no resources.  Should destruct when the main event
-    loop of the facade exits.
+    Destructor - the service managers are children.  Should destruct when the
+    event loop of the processor's thread exits.
 */
 QServiceOperationProcessor::~QServiceOperationProcessor()
 {
@@ -216,6 +387,21 @@ QServiceOperationProcessor::~QServiceOperationProcessor()
                   << "class" << "QServiceOperationProc";
 }
 
+/*
+    The service managers are kept for the lifetime of the processor, so a
+    worker reuses its database connections instead of opening them for every
+    request.
+*/
+QServiceManager *QServiceOperationProcessor::manager(QService::Scope scope)
+{
+    QServiceManager *mgr = managers.value(scope);
+    if (!mgr) {
+        mgr = new QServiceManager(scope, this);
+        managers.insert(scope, mgr);
+    }
+    return mgr;
+}
+
 /*
     Do the actual work.  Note that all calls to this function are serialised by
     the queued signal-slot connection from the facade.  But since SFW could
@@ -234,73 +420,93 @@ void QServiceOperationProcessor::handleRequest(const QServiceRequest &inrequest)
 
     inRequest = true;
 
-    QServiceRequest req;
-
     while (!pendingList.isEmpty()) {
-        req = pendingList.takeFirst();
+        const QServiceRequest req = pendingList.takeFirst();
+        const QString key = QServiceOperations::requestKey(req);
 
-        qServiceLog() << "event" << "handle req start"
-                      << "class" << "QServiceOperationProc"
-                      << "iface" << inrequest.descriptor().interfaceName();
+        QServiceLoadResult result;
+        processRequest(req, &result);
+
+        QList<QServiceRequest> followers;
+        while (!(followers = operations->requestFinished(this, key)).isEmpty()) {
+            foreach (const QServiceRequest &follower, followers)
+                processRequest(follower, &result);
+        }
+    }
+
+    inRequest = false;
+}
 
-        QServiceInterfaceDescriptor descriptor = req.descriptor();
-        QServiceReply *reply = req.reply();
+void QServiceOperationProcessor::processRequest(const QServiceRequest &req, QServiceLoadResult *result)
+{
+    qServiceLog() << "event" << "handle req start"
+                  << "class" << "QServiceOperationProc"
+                  << "iface" << req.descriptor().interfaceName()
+                  << "coalesced" << result->resolved;
+
+    QServiceReply *reply = req.reply();
+
+    QServiceManager &mgr = *manager(req.scope());
 
-        QServiceManager mgr(req.scope());
+    QMetaObject::invokeMethod(reply, "start", Qt::QueuedConnection);
 
-        QMetaObject::invokeMethod(reply, "start", Qt::QueuedConnection);
+    if (!result->resolved) {
+        result->resolved = true;
+        result->descriptor = req.descriptor();
 
         if (req.requestType() == QServiceRequest::DefaultInterfaceRequest) {
             // OK, this was a request based on the interface name rather than a
             // fully specified descriptor
-            qDebug() << "Asking for the default interface for" << mgr.interfaceDefault(req.interfaceName());
-            descriptor = mgr.interfaceDefault(req.interfaceName());
+            result->descriptor = mgr.interfaceDefault(req.interfaceName());
+            qDebug() << "Asking for the default interface for" << result->descriptor;
         } else {
             qDebug() << "NOT asking for default";
         }
 
-        if (!descriptor.isValid()) {
+        if (!result->descriptor.isValid()) {
             qDebug() << "Failed to fetch default";
-            QMetaObject::invokeMethod(reply, "setError", Qt::QueuedConnection, Q_ARG(QServiceManager::Error, QServiceManager::InvalidServiceInterfaceDescriptor));
-            QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
-            continue;
-        }
-
-        QObject *obj = 0;
-        int serviceType = descriptor.attribute(QServiceInterfaceDescriptor::ServiceType).toInt();
-        const QString location = descriptor.attribute(QServiceInterfaceDescriptor::Location).toString();
-
-        if (serviceType == QService::InterProcess) {
-            obj = mgr.loadInterProcessService(descriptor, location);
+            result->error = QServiceManager::InvalidServiceInterfaceDescriptor;
         } else {
-
-            const QString serviceFilePath = mgr.resolveLibraryPath(location);
-            if (serviceFilePath.isEmpty()) {
-                QMetaObject::invokeMethod(reply, "setError", Qt::QueuedConnection, Q_ARG(QServiceManager::Error, QServiceManager::InvalidServiceLocation));
-                QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
-                continue;
-            }
-
-            obj = mgr.loadInProcessService(descriptor, serviceFilePath);
-            if (!obj) {
-                QMetaObject::invokeMethod(reply, "setError", Qt::QueuedConnection, Q_ARG(QServiceManager::Error, QServiceManager::PluginLoadingFailed));
-                QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
-                continue;
+            int serviceType = result->descriptor.attribute(QServiceInterfaceDescriptor::ServiceType).toInt();
+            result->location = result->descriptor.attribute(QServiceInterfaceDescriptor::Location).toString();
+            result->interProcess = (serviceType == QService::InterProcess);
+
+            if (!result->interProcess) {
+                result->location = mgr.resolveLibraryPath(result->location);
+                if (result->location.isEmpty())
+                    result->error = QServiceManager::InvalidServiceLocation;
             }
         }
+    }
 
-        // loadInterface() can return null
-        if (obj) {
-            obj->moveToThread(reply->thread());
-        }
-
-        QMetaObject::invokeMethod(reply, "setProxyObject", Qt::QueuedConnection, Q_ARG(QObject*, obj));
+    if (result->error != QServiceManager::NoError) {
+        QMetaObject::invokeMethod(reply, "setError", Qt::QueuedConnection, Q_ARG(QServiceManager::Error, result->error));
         QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+        return;
+    }
 
-        qServiceLog() << "event" << "handle req done"
-                      << "class" << "QServiceOperationProc"
-                      << "iface" << inrequest.descriptor().interfaceName();
+    QObject *obj = 0;
+    if (result->interProcess)
+        obj = mgr.loadInterProcessService(result->descriptor, result->location);
+    else
+        obj = mgr.loadInProcessService(result->descriptor, result->location);
+
+    // the rest of the group fails the same way, without waiting for a
+    // service that just failed to start again
+    if (!obj) {
+        result->error = result->interProcess ? QServiceManager::InvalidServiceLocation
+                                             : QServiceManager::PluginLoadingFailed;
+        QMetaObject::invokeMethod(reply, "setError", Qt::QueuedConnection, Q_ARG(QServiceManager::Error, result->error));
+        QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+        return;
     }
 
-    inRequest = false;
+    obj->moveToThread(reply->thread());
+
+    QMetaObject::invokeMethod(reply, "setProxyObject", Qt::QueuedConnection, Q_ARG(QObject*, obj));
+    QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+
+    qServiceLog() << "event" << "handle req done"
+                  << "class" << "QServiceOperationProc"
+                  << "iface" << req.descriptor().interfaceName();
 }
@@ -55,10 +55,14 @@
 
 #include <QThread>
 #include <QAtomicInt>
+#include <QMutex>
+#include <QHash>
+#include <QList>
 
 QT_BEGIN_NAMESPACE
 
 class QServiceManager;
+class QServiceOperationProcessor;
 class Q_AUTOTEST_EXPORT QServiceOperations : public QThread
 {
     Q_OBJECT
@@ -71,6 +75,10 @@ public:
     void engage();
     void disengage();
     int clientCount() { return m_engageCount.fetchAndAddRelaxed(0); }
+    int workerCount();
+
+    static QString requestKey(const QServiceRequest &req);
+    QList<QServiceRequest> requestFinished(QServiceOperationProcessor *processor, const QString &key);
 
 public Q_SLOTS:
     void initiateRequest(const QServiceRequest &req);
@@ -78,11 +86,24 @@ public Q_SLOTS:
 protected:
     virtual void run();
 
-Q_SIGNALS:
-    void newRequest(QServiceRequest);
-
 private:
+    QServiceOperationProcessor *pickProcessor(const QString &key, const QServiceRequest &req);
+    void stopWorkers();
+
+    // identical requests arriving while one is being processed
+    struct InFlight {
+        QServiceOperationProcessor *processor;
+        QList<QServiceRequest> followers;
+    };
+
     QAtomicInt m_engageCount;
+    int m_maxWorkers;
+
+    QMutex m_lock;
+    QList<QServiceOperationProcessor *> m_processors;
+    QList<QThread *> m_workers;
+    QHash<QServiceOperationProcessor *, int> m_load;
+    QHash<QString, InFlight> m_inFlight;
 };
 
 QT_END_NAMESPACE
@@ -60,6 +60,7 @@
 #include <QAtomicPointer>
 #include <QObject>
 #include <QList>
+#include <QHash>
 #include <QPair>
 
 QT_BEGIN_NAMESPACE
@@ -92,19 +93,26 @@ public:
 };
 
 class QServiceRequest;
+class QServiceOperations;
+struct QServiceLoadResult;
 class QServiceOperationProcessor : public QObject
 {
     Q_OBJECT
 public:
-    explicit QServiceOperationProcessor(QObject *parent = 0);
+    explicit QServiceOperationProcessor(QServiceOperations *operations);
     ~QServiceOperationProcessor();
 
 public Q_SLOTS:
     void handleRequest(const QServiceRequest &inrequest);
 
 private:
+    void processRequest(const QServiceRequest &req, QServiceLoadResult *result);
+    QServiceManager *manager(QService::Scope scope);
+
+    QServiceOperations *operations;
     bool inRequest;
     QList<QServiceRequest> pendingList;
+    QHash<int, QServiceManager *> managers;
 };
 
 QT_END_NAMESPACE
@@ -56,6 +56,11 @@
 #define DEFAULTS_TABLE "Defaults"
 #define SERVICE_PROPERTY_TABLE "ServiceProperty"
 #define INTERFACE_PROPERTY_TABLE "InterfaceProperty"
+#define CHANGELOG_TABLE "ChangeLog"
+#define CHANGELOG_EPOCH_TABLE "ChangeLogEpoch"
+
+//number of change log entries kept for incremental change notifications
+#define CHANGELOG_MAX_ENTRIES 256
 
 //separator
 #define RESOLVERDATABASE_PATH_SEPARATOR "//"
@@ -105,7 +110,7 @@ enum TBindIndexes
     Constructor
 */
 ServiceDatabase::ServiceDatabase(void)
-:m_isDatabaseOpen(false),m_inTransaction(false)
+:m_isDatabaseOpen(false),m_inTransaction(false),m_hasChangeLog(false)
 {
 }
 
@@ -205,6 +210,9 @@ bool ServiceDatabase::open()
             return false;
         }
     }
+
+    //The change log is optional, older or read-only databases may lack it
+    checkChangeLog();
     return true;
 }
 
@@ -221,23 +229,37 @@ bool ServiceDatabase::open()
    DBError::NoWritePermissions
    DBError::InvalidDatabaseFile
 */
-//bool ServiceDatabase::registerService(ServiceMetaData &service)
 bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, const QString &securityToken)
 {
-    // Derive the location name with the service type prefix to be stored
-    QString locationPrefix = service.location;
-    int type = service.interfaces[0].d->attributes[QServiceInterfaceDescriptor::ServiceType].toInt();
-    if (type == QService::InterProcess)
-        locationPrefix = QLatin1String(SERVICE_IPC_PREFIX) + service.location;
+    return registerServices(QList<ServiceMetaDataResults>() << service, securityToken);
+}
+
+/*
+   Adds all \a services into the database within a single transaction.
+   Either all of the services are registered or, if any of them fails,
+   none of them are.
 
+   May set the following error codes
+   DBError::NoError
+   DBError::LocationAlreadyRegistered
+   DBError::IfaceImplAlreadyRegistered
+   DBError::SqlError
+   DBError::DatabaseNotOpen
+   DBError::InvalidDatabaseConnection
+   DBError::NoWritePermissions
+   DBError::InvalidDatabaseFile
+*/
+bool ServiceDatabase::registerServices(const QList<ServiceMetaDataResults> &services, const QString &securityToken)
+{
 #ifndef QT_SFW_SERVICEDATABASE_USE_SECURITY_TOKEN
     Q_UNUSED(securityToken);
 #else
     if (securityToken.isEmpty()) {
         QString errorText("Access denied, no security token provided (for registering service: \"%1\")");
-        m_lastError.setError(DBError::NoWritePermissions, errorText.arg(service.name));
+        m_lastError.setError(DBError::NoWritePermissions,
+                errorText.arg(services.isEmpty() ? QString() : services.first().name));
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::registerServices():-"
                 << "Problem: Unable to register service,"
                 << "reason:" << qPrintable(m_lastError.text());
 #endif
@@ -247,7 +269,7 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
 
     if (!checkConnection()) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::registerServices():-"
                     << "Problem:" << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -258,27 +280,75 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
 
     if (!beginTransaction(&query, Write)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::registerServices():-"
                     << "Unable to begin transaction,"
                     << "reason:" << qPrintable(m_lastError.text());
 #endif
         return false;
     }
+
+    foreach (const ServiceMetaDataResults &service, services) {
+        if (!insertService(&query, service, securityToken)
+                || !logServiceChange(&query, service.name, ServiceAddedChange)) {
+            rollbackTransaction(&query);
+            return false;
+        }
+    }
+
+    if (!trimChangeLog(&query)) {
+        rollbackTransaction(&query);
+        return false;
+    }
+
+    if (!commitTransaction(&query)) {
+        rollbackTransaction(&query);
+        return false;
+    }
+    m_lastError.setError(DBError::NoError);
+    return true;
+}
+
+/*
+   Helper function that inserts the rows describing \a service into the
+   Service, ServiceProperty, Interface, InterfaceProperty and Defaults tables.
+
+   May set the following error codes
+   DBError::NoError
+   DBError::LocationAlreadyRegistered
+   DBError::IfaceImplAlreadyRegistered
+   DBError::SqlError
+   DBError::NoWritePermissions
+
+   Aside: It is already assumed that a write transaction has been started by the
+   time this function is called; and this function will not rollback/commit
+   the transaction.
+*/
+bool ServiceDatabase::insertService(QSqlQuery *query, const ServiceMetaDataResults &service, const QString &securityToken)
+{
+#ifndef QT_SFW_SERVICEDATABASE_USE_SECURITY_TOKEN
+    Q_UNUSED(securityToken);
+#endif
+
+    // Derive the location name with the service type prefix to be stored
+    QString locationPrefix = service.location;
+    int type = service.interfaces[0].d->attributes[QServiceInterfaceDescriptor::ServiceType].toInt();
+    if (type == QService::InterProcess)
+        locationPrefix = QLatin1String(SERVICE_IPC_PREFIX) + service.location;
+
     //See if the service's location has already been previously registered
     QString statement(QLatin1String("SELECT Name from Service WHERE Location=? COLLATE NOCASE"));
     QList<QVariant> bindValues;
     bindValues.append(locationPrefix);
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                     << qPrintable(m_lastError.text());
 #endif
         return false;
     }
 
-    if (query.next()) {
-        QString alreadyRegisteredService = query.value(EBindIndex).toString();
+    if (query->next()) {
+        QString alreadyRegisteredService = query->value(EBindIndex).toString();
         const QString errorText = QLatin1String("Cannot register service \"%1\". Service location \"%2\" is already "
                     "registered to service \"%3\".  \"%3\" must first be deregistered "
                     "for new registration to take place.");
@@ -288,9 +358,8 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
                         .arg(service.location)
                         .arg(alreadyRegisteredService));
 
-        rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                     << "Problem:" << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -309,24 +378,22 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     bindValues.clear();
     bindValues.append(SECURITY_TOKEN_KEY);
     bindValues.append(service.name);
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                    << qPrintable(m_lastError.text());
 #endif
         return false;
     }
     QString existingSecurityToken;
-    if (query.next()) {
-        existingSecurityToken = query.value(EBindIndex).toString();
+    if (query->next()) {
+        existingSecurityToken = query->value(EBindIndex).toString();
     }
     if (!existingSecurityToken.isEmpty() && (existingSecurityToken != securityToken)) {
         QString errorText("Access denied: \"%1\"");
         m_lastError.setError(DBError::NoWritePermissions, errorText.arg(service.name));
-        rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                 << "Problem: Unable to register service,"
                 << "reason:" << qPrintable(m_lastError.text());
 #endif
@@ -345,10 +412,9 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     bindValues.append(service.name);
     bindValues.append(locationPrefix);
 
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                     << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -363,10 +429,9 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     else
         bindValues.append(service.description);
 
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                     << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -378,10 +443,9 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     bindValues.append(serviceID);
     bindValues.append(SERVICE_INITIALIZED_KEY);
     bindValues.append(QString("NO"));
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                     << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -396,10 +460,9 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     bindValues.append(SECURITY_TOKEN_KEY);
     bindValues.append(securityToken);
 
-    if (!executeQuery(&query, statement, bindValues)) {
-        rollbackTransaction(&query);
+    if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-        qWarning() << "ServiceDatabase::registerService():-"
+        qWarning() << "ServiceDatabase::insertService():-"
                 << qPrintable(m_lastError.text());
 #endif
         return false;
@@ -409,7 +472,7 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
     QList <QServiceInterfaceDescriptor> interfaces = service.interfaces;
     QString interfaceID;;
     foreach (const QServiceInterfaceDescriptor &serviceInterface, interfaces) {
-        interfaceID = getInterfaceID(&query, serviceInterface);
+        interfaceID = getInterfaceID(query, serviceInterface);
         if (m_lastError.code() == DBError::NoError) {
             QString errorText;
             errorText = QLatin1String("Cannot register service \"%1\". \"%1\" is already registered "
@@ -421,25 +484,22 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
                                             .arg(serviceInterface.majorVersion())
                                             .arg(serviceInterface.minorVersion()));
 
-            rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-            qWarning() << "ServiceDatabase::registerService():-"
+            qWarning() << "ServiceDatabase::insertService():-"
                         << "Problem:" << qPrintable(m_lastError.text());
 #endif
             return false;
         } else if (m_lastError.code() == DBError::NotFound){
             //No interface implementation already exists for the service
             //so add it
-            if (!insertInterfaceData(&query, serviceInterface, serviceID)) {
-                rollbackTransaction(&query);
+            if (!insertInterfaceData(query, serviceInterface, serviceID)) {
                 return false;
             } else {
                 continue;
             }
         } else {
-            rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-            qWarning() << "ServiceDatabase::registerService():-"
+            qWarning() << "ServiceDatabase::insertService():-"
                         << "Unable to confirm if implementation version"
                         << (QString::number(serviceInterface.majorVersion()) + "."
                            + QString::number(serviceInterface.minorVersion())).toLatin1()
@@ -461,11 +521,10 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
             continue; //default already exists so don't do anything
         } else if (m_lastError.code() == DBError::NotFound) {
             //default does not already exist so create one
-            interfaceID = getInterfaceID(&query, serviceInterface);
+            interfaceID = getInterfaceID(query, serviceInterface);
             if (m_lastError.code() != DBError::NoError) {
-                rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-                qWarning() << "ServiceDatabase::registerService():-"
+                qWarning() << "ServiceDatabase::insertService():-"
                            << "Unable to retrieve interfaceID for "
                               "interface" << serviceInterface.interfaceName()
                            << "\n" << m_lastError.text();
@@ -477,18 +536,16 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
             bindValues.clear();
             bindValues.append(serviceInterface.interfaceName());
             bindValues.append(interfaceID);
-            if (!executeQuery(&query, statement, bindValues)) {
-                rollbackTransaction(&query);
+            if (!executeQuery(query, statement, bindValues)) {
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-                qWarning() << "ServiceDatabase::registerService():-"
+                qWarning() << "ServiceDatabase::insertService():-"
                     << qPrintable(m_lastError.text());
 #endif
                 return false;
             }
         } else {
-            rollbackTransaction(&query);
 #ifdef QT_SFW_SERVICEDATABASE_DEBUG
-            qWarning() << "ServiceDatabase::registerService()"
+            qWarning() << "ServiceDatabase::insertService()"
                         << "Problem: Unable to confirm if interface"
                         << serviceInterface.interfaceName()
                         << "already has a default implementation";
@@ -497,10 +554,6 @@ bool ServiceDatabase::registerService(const ServiceMetaDataResults &service, con
         }
     }
 
-    if (!commitTransaction(&query)) {
-        rollbackTransaction(&query);
-        return false;
-    }
     m_lastError.setError(DBError::NoError);
     return true;
 }
@@ -733,6 +786,81 @@ bool ServiceDatabase::insertInterfaceData(QSqlQuery *query,const QServiceInterfa
     return true;
 }
 
+/*
+    Helper function that records in the ChangeLog table that the service
+    \a serviceName was added or removed, depending on \a type.
+
+    If the database has no change log this function does nothing.
+
+    May set the last error to one of the following error codes:
+    DBError::NoError
+    DBError::SqlError
+
+    Aside: It is already assumed that a write transaction has been started by the
+    time this function is called; and this function will not rollback/commit
+    the transaction.
+*/
+bool ServiceDatabase::logServiceChange(QSqlQuery *query, const QString &serviceName, ChangeType type)
+{
+    if (!m_hasChangeLog) {
+        m_lastError.setError(DBError::NoError);
+        return true;
+    }
+
+    QString statement(QLatin1String("INSERT INTO ChangeLog(ServiceName, Action) VALUES(?,?)"));
+    QList<QVariant> bindValues;
+    bindValues.append(serviceName);
+    bindValues.append(static_cast<int>(type));
+    if (!executeQuery(query, statement, bindValues)) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::logServiceChange():-"
+                    << qPrintable(m_lastError.text());
+#endif
+        return false;
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return true;
+}
+
+/*
+    Helper function that drops all but the most recent CHANGELOG_MAX_ENTRIES
+    entries of the ChangeLog table.  It is called once per write transaction,
+    after all of its changes have been logged.
+
+    If the database has no change log this function does nothing.
+
+    May set the last error to one of the following error codes:
+    DBError::NoError
+    DBError::SqlError
+
+    Aside: It is already assumed that a write transaction has been started by the
+    time this function is called; and this function will not rollback/commit
+    the transaction.
+*/
+bool ServiceDatabase::trimChangeLog(QSqlQuery *query)
+{
+    if (!m_hasChangeLog) {
+        m_lastError.setError(DBError::NoError);
+        return true;
+    }
+
+    QString statement(QLatin1String("DELETE FROM ChangeLog WHERE Version <= "
+                    "(SELECT MAX(Version) FROM ChangeLog) - ?"));
+    QList<QVariant> bindValues;
+    bindValues.append(CHANGELOG_MAX_ENTRIES);
+    if (!executeQuery(query, statement, bindValues)) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::trimChangeLog():-"
+                    << qPrintable(m_lastError.text());
+#endif
+        return false;
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return true;
+}
+
 /*
     Helper function that executes the sql query specified in \a statement.
     It is assumed that the \a statement uses positional placeholders and
@@ -1126,6 +1254,185 @@ QStringList ServiceDatabase::getServiceNames(const QString &interfaceName)
     return services;
 }
 
+/*
+    Returns the version of the most recent entry in the change log, which
+    increases monotonically with every registration and unregistration.
+    Returns 0 if no change has been logged yet and -1 if the database
+    does not keep a change log.
+
+    If \a epoch is not null it is set to the identity of the change log,
+    which is read in the same transaction as the version.  A recreated
+    database gets a new epoch, so a version is only meaningful together
+    with the epoch it was read with.
+
+    May set last error to one of the following error codes:
+    DBError::NoError
+    DBError::SqlError
+    DBError::DatabaseNotOpen
+    DBError::InvalidDatabaseConnection
+
+    Aside:  There is only one query which implicitly gets
+    wrapped in it's own transaction.
+*/
+qint64 ServiceDatabase::changeVersion(QString *epoch)
+{
+    if (!checkConnection()) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::changeVersion():-"
+                    << "Problem:" << qPrintable(m_lastError.text());
+#endif
+        return -1;
+    }
+
+    if (!m_hasChangeLog) {
+        m_lastError.setError(DBError::NoError);
+        return -1;
+    }
+
+    QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+    QSqlQuery query(database);
+    if (!beginTransaction(&query, Read)) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::changeVersion():-"
+                    << "Unable to begin transaction. "
+                    << "Reason:" << qPrintable(m_lastError.text());
+#endif
+        return -1;
+    }
+
+    if (epoch && !changeLogEpoch(&query, epoch)) {
+        rollbackTransaction(&query);
+        return -1;
+    }
+
+    if (!executeQuery(&query, QLatin1String("SELECT MAX(Version) FROM ChangeLog"))) {
+        rollbackTransaction(&query);
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::changeVersion():-"
+                    << qPrintable(m_lastError.text());
+#endif
+        return -1;
+    }
+
+    qint64 version = 0;
+    if (query.next())
+        version = query.value(EBindIndex).toLongLong();
+    rollbackTransaction(&query);//read-only operation so just rollback
+    m_lastError.setError(DBError::NoError);
+    return version;
+}
+
+/*
+    Returns the services added and removed after the change log
+    \a version of the change log identified by \a epoch, in the order in
+    which they happened, and updates \a version to the latest logged
+    version.
+
+    If the changes since \a version can no longer be reconstructed,
+    because the database has no change log, the log has been trimmed
+    past \a version or the database has been recreated since \a epoch
+    was read, the last error is set to DBError::NotFound and the caller
+    must fall back to comparing the complete list of service names.
+
+    May set last error to one of the following error codes:
+    DBError::NoError
+    DBError::NotFound
+    DBError::SqlError
+    DBError::DatabaseNotOpen
+    DBError::InvalidDatabaseConnection
+*/
+QList<QPair<QString, ServiceDatabase::ChangeType> > ServiceDatabase::serviceChanges(qint64 *version, const QString &epoch)
+{
+    Q_ASSERT(version != NULL);
+
+    QList<QPair<QString, ChangeType> > changes;
+    if (!checkConnection()) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::serviceChanges():-"
+                    << "Problem:" << qPrintable(m_lastError.text());
+#endif
+        return changes;
+    }
+
+    if (!m_hasChangeLog || *version < 0 || epoch.isEmpty()) {
+        m_lastError.setError(DBError::NotFound, QLatin1String("No change log available"));
+        return changes;
+    }
+
+    QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+    QSqlQuery query(database);
+
+    //bounds and entries must be read from the same snapshot
+    if (!beginTransaction(&query, Read)) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::serviceChanges():-"
+                    << "Unable to begin transaction. "
+                    << "Reason:" << qPrintable(m_lastError.text());
+#endif
+        return changes;
+    }
+
+    //the versions of a recreated database say nothing about the old one
+    QString currentEpoch;
+    if (!changeLogEpoch(&query, &currentEpoch)) {
+        rollbackTransaction(&query);
+        return changes;
+    }
+    if (currentEpoch != epoch) {
+        rollbackTransaction(&query);
+        m_lastError.setError(DBError::NotFound, QLatin1String("Change log has been recreated"));
+        return changes;
+    }
+
+    if (!executeQuery(&query, QLatin1String("SELECT MIN(Version), MAX(Version) FROM ChangeLog"))) {
+        rollbackTransaction(&query);
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::serviceChanges():-"
+                    << qPrintable(m_lastError.text());
+#endif
+        return changes;
+    }
+
+    qint64 minVersion = 0;
+    qint64 maxVersion = 0;
+    if (query.next()) {
+        minVersion = query.value(EBindIndex).toLongLong();
+        maxVersion = query.value(EBindIndex1).toLongLong();
+    }
+
+    if (maxVersion < *version || (maxVersion > *version && minVersion > *version + 1)) {
+        rollbackTransaction(&query);
+        QString errorText(QLatin1String("Change log does not contain changes since version %1"));
+        m_lastError.setError(DBError::NotFound, errorText.arg(*version));
+        return changes;
+    }
+
+    if (maxVersion > *version) {
+        QString statement(QLatin1String("SELECT ServiceName, Action FROM ChangeLog "
+                            "WHERE Version > ? ORDER BY Version"));
+        QList<QVariant> bindValues;
+        bindValues.append(*version);
+        if (!executeQuery(&query, statement, bindValues)) {
+            rollbackTransaction(&query);
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+            qWarning() << "ServiceDatabase::serviceChanges():-"
+                        << qPrintable(m_lastError.text());
+#endif
+            return changes;
+        }
+
+        while (query.next()) {
+            changes.append(qMakePair(query.value(EBindIndex).toString(),
+                        static_cast<ChangeType>(query.value(EBindIndex1).toInt())));
+        }
+    }
+
+    rollbackTransaction(&query);//read-only operation so just rollback
+    *version = maxVersion;
+    m_lastError.setError(DBError::NoError);
+    return changes;
+}
+
 /*
     Returns a descriptor for the default interface implementation of
     \a interfaceName.
@@ -1668,6 +1975,12 @@ bool ServiceDatabase::unregisterService(const QString &serviceName, const QStrin
         }
     }
 
+    if (!logServiceChange(&query, serviceName, ServiceRemovedChange)
+            || !trimChangeLog(&query)) {
+        rollbackTransaction(&query);
+        return false;
+    }
+
     //databaseCommit
     if (!commitTransaction(&query)) {
         rollbackTransaction(&query);
@@ -1959,6 +2272,64 @@ bool ServiceDatabase::checkTables()
     return bTables;
 }
 
+/*
+    Helper method that makes sure the ChangeLog table and the epoch that
+    identifies it exist, creating them if needed.  The change log is only
+    used to speed up change notifications, so failing to create it, e.g. for
+    a read-only system database, is not an error; the database is then
+    simply treated as having no change log.
+*/
+bool ServiceDatabase::checkChangeLog()
+{
+    QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+    const QStringList tables = database.tables();
+    m_hasChangeLog = tables.contains(QLatin1String(CHANGELOG_TABLE))
+                        && tables.contains(QLatin1String(CHANGELOG_EPOCH_TABLE));
+    if (!m_hasChangeLog) {
+        QSqlQuery query(database);
+        m_hasChangeLog = query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS ChangeLog("
+                            "Version INTEGER PRIMARY KEY AUTOINCREMENT, "
+                            "ServiceName TEXT NOT NULL, "
+                            "Action INTEGER NOT NULL)"))
+                && query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS ChangeLogEpoch("
+                            "Epoch TEXT NOT NULL)"));
+
+        //another process may have created the epoch in the meantime
+        if (m_hasChangeLog) {
+            m_hasChangeLog = query.prepare(QLatin1String("INSERT INTO ChangeLogEpoch(Epoch) "
+                                "SELECT ? WHERE NOT EXISTS (SELECT 1 FROM ChangeLogEpoch)"));
+            query.addBindValue(QUuid::createUuid().toString());
+            m_hasChangeLog = m_hasChangeLog && query.exec();
+        }
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        if (!m_hasChangeLog)
+            qWarning() << "ServiceDatabase::checkChangeLog():-"
+                        << "Unable to create change log:" << qPrintable(query.lastError().text());
+#endif
+    }
+    return m_hasChangeLog;
+}
+
+/*
+    Helper method that reads the epoch of the change log into \a epoch
+    using \a query, which should be part of the caller's transaction.
+*/
+bool ServiceDatabase::changeLogEpoch(QSqlQuery *query, QString *epoch)
+{
+    if (!executeQuery(query, QLatin1String("SELECT Epoch FROM ChangeLogEpoch"))) {
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceDatabase::changeLogEpoch():-"
+                    << qPrintable(m_lastError.text());
+#endif
+        return false;
+    }
+
+    epoch->clear();
+    if (query->next())
+        *epoch = query->value(EBindIndex).toString();
+    return true;
+}
+
 /*
    This function should only ever be used on a user scope database
    It removes an entry from the Defaults table where the default
@@ -2051,7 +2422,9 @@ bool ServiceDatabase::dropTables()
                 << QLatin1String(INTERFACE_TABLE)
                 << QLatin1String(DEFAULTS_TABLE)
                 << QLatin1String(SERVICE_PROPERTY_TABLE)
-                << QLatin1String(INTERFACE_PROPERTY_TABLE);
+                << QLatin1String(INTERFACE_PROPERTY_TABLE)
+                << QLatin1String(CHANGELOG_TABLE)
+                << QLatin1String(CHANGELOG_EPOCH_TABLE);
 
     if (database.tables().count() > 0) {
         if (!beginTransaction(&query, Write)) {
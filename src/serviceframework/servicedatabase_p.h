@@ -62,7 +62,7 @@ QT_BEGIN_NAMESPACE
 
 class QServiceInterfaceDescriptor;
 
-class Q_AUTOTEST_EXPORT ServiceDatabase : public QObject
+class SERVICEDATABASE_EXPORT ServiceDatabase : public QObject
 {
     Q_OBJECT
 
@@ -79,6 +79,7 @@ class Q_AUTOTEST_EXPORT ServiceDatabase : public QObject
         QString databasePath() const;
 
         bool registerService(const ServiceMetaDataResults &service, const QString &securityToken = QString());
+        bool registerServices(const QList<ServiceMetaDataResults> &services, const QString &securityToken = QString());
         bool unregisterService(const QString &serviceName, const QString &securityToken = QString());
         bool serviceInitialized(const QString &serviceName, const QString &securityToken = QString());
 
@@ -94,6 +95,10 @@ class Q_AUTOTEST_EXPORT ServiceDatabase : public QObject
         QList<QPair<QString,QString> > externalDefaultsInfo();
         bool removeExternalDefaultServiceInterface(const QString &interfaceID);
 
+        enum ChangeType{ServiceAddedChange = 1, ServiceRemovedChange};
+        qint64 changeVersion(QString *epoch = 0);
+        QList<QPair<QString, ChangeType> > serviceChanges(qint64 *version, const QString &epoch);
+
         DBError lastError() const { return m_lastError; }
 
 Q_SIGNALS:
@@ -110,12 +115,17 @@ Q_SIGNALS:
         bool createTables();
         bool dropTables();
         bool checkTables();
+        bool checkChangeLog();
+        bool changeLogEpoch(QSqlQuery *query, QString *epoch);
 
         bool checkConnection();
 
         bool executeQuery(QSqlQuery *query, const QString &statement, const QList<QVariant> &bindValues = QList<QVariant>());
         QString getInterfaceID(QSqlQuery *query, const QServiceInterfaceDescriptor &serviceInterface);
+        bool insertService(QSqlQuery *query, const ServiceMetaDataResults &service, const QString &securityToken);
         bool insertInterfaceData(QSqlQuery *query, const QServiceInterfaceDescriptor &anInterface, const QString &serviceID);
+        bool logServiceChange(QSqlQuery *query, const QString &serviceName, ChangeType type);
+        bool trimChangeLog(QSqlQuery *query);
 
         bool beginTransaction(QSqlQuery *query, TransactionType);
         bool commitTransaction(QSqlQuery *query);
@@ -128,6 +138,7 @@ Q_SIGNALS:
         QString m_connectionName;
         bool m_isDatabaseOpen;
         bool m_inTransaction;
+        bool m_hasChangeLog;
         DBError m_lastError;
 };
 
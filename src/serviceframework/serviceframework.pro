@@ -1,9 +1,14 @@
 TARGET = QtServiceFramework
 QT = core
 
-sfwdebug {
+# IPC tracing is off until SFW_TRACE is set at runtime, no_sfwdebug leaves it out.
+# Traces are written to SFW_TRACE_FILE, sfwdebug adds the multicast sink for sfwlisten
+!no_sfwdebug {
     DEFINES += QT_SFW_IPC_DEBUG
-    QT_PRIVATE += network
+    sfwdebug {
+        DEFINES += QT_SFW_TRACE_MULTICAST
+        QT_PRIVATE += network
+    }
 }
 
 include(ipc/ipc.pri)
@@ -36,9 +41,11 @@ SOURCES += servicemetadata.cpp \
 
 QT_FOR_PRIVATE += sql
 SOURCES += servicedatabase.cpp \
-    databasemanager.cpp
+    databasemanager.cpp \
+    serviceregistryindex.cpp
 PRIVATE_HEADERS += servicedatabase_p.h \
     databasemanager_p.h \
+    serviceregistryindex_p.h \
 
 HEADERS += $$PUBLIC_HEADERS $$PRIVATE_HEADERS \
     qserviceoperations_p.h \
@@ -41,7 +41,9 @@
 #include <QFile>
 #include <QDataStream>
 #include <QDebug>
-#include <QRegularExpression>
+#include <QRunnable>
+#include <QThreadPool>
+#include <limits.h>
 #include "qserviceinterfacedescriptor_p.h"
 
 //XML tags and attributes
@@ -49,7 +51,8 @@
 #define NAME_TAG  "name"
 #define DESCRIPTION_TAG "description"
 #define SERVICEFW_TAG "SFW"
-#define XML_MAX "1.1"
+#define XML_MAX_MAJOR 1
+#define XML_MAX_MINOR 1
 
 //Service related
 #define SERVICE_TAG "service"
@@ -67,6 +70,67 @@
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Atoms for the XML tags of a service description.  Each element name is
+    looked up once and the parser only compares atoms.
+*/
+enum XmlTag {
+    UnknownTag,
+    ServiceFwTag,
+    ServiceTag,
+    NameTag,
+    DescriptionTag,
+    FilePathTag,
+    IpcAddressTag,
+    InterfaceTag,
+    VersionTag,
+    CapabilitiesTag,
+    CustomPropertyTag
+};
+
+static inline bool isTag(const QStringRef &name, const char *tag)
+{
+    return name == QLatin1String(tag);
+}
+
+/*
+    Returns the atom of the current start or end element of \a reader, or
+    UnknownTag for any other token or element.  The tag names differ in
+    length except for "service" and "version", so the length and the first
+    character select the only candidate and at most one comparison is made.
+*/
+static XmlTag elementTag(const QXmlStreamReader &reader)
+{
+    if (!reader.isStartElement() && !reader.isEndElement())
+        return UnknownTag;
+
+    Q_STATIC_ASSERT(sizeof(SERVICE_TAG) == sizeof(INTERFACE_VERSION));
+    const QStringRef name = reader.name();
+    switch (name.size()) {
+    case sizeof(SERVICEFW_TAG) - 1:
+        return isTag(name, SERVICEFW_TAG) ? ServiceFwTag : UnknownTag;
+    case sizeof(NAME_TAG) - 1:
+        return isTag(name, NAME_TAG) ? NameTag : UnknownTag;
+    case sizeof(SERVICE_TAG) - 1: // and INTERFACE_VERSION
+        if (name.at(0) == QLatin1Char('s'))
+            return isTag(name, SERVICE_TAG) ? ServiceTag : UnknownTag;
+        return isTag(name, INTERFACE_VERSION) ? VersionTag : UnknownTag;
+    case sizeof(SERVICE_FILEPATH) - 1:
+        return isTag(name, SERVICE_FILEPATH) ? FilePathTag : UnknownTag;
+    case sizeof(INTERFACE_TAG) - 1:
+        return isTag(name, INTERFACE_TAG) ? InterfaceTag : UnknownTag;
+    case sizeof(SERVICE_IPCADDRESS) - 1:
+        return isTag(name, SERVICE_IPCADDRESS) ? IpcAddressTag : UnknownTag;
+    case sizeof(DESCRIPTION_TAG) - 1:
+        return isTag(name, DESCRIPTION_TAG) ? DescriptionTag : UnknownTag;
+    case sizeof(INTERFACE_CAPABILITY) - 1:
+        return isTag(name, INTERFACE_CAPABILITY) ? CapabilitiesTag : UnknownTag;
+    case sizeof(INTERFACE_CUSTOM_PROPERTY) - 1:
+        return isTag(name, INTERFACE_CUSTOM_PROPERTY) ? CustomPropertyTag : UnknownTag;
+    }
+    return UnknownTag;
+}
+
 #ifndef QT_NO_DATASTREAM
 SERVICEMETADATA_EXPORT QDataStream &operator<<(QDataStream &out, const ServiceMetaDataResults &r)
 {
@@ -217,8 +281,6 @@ ServiceMetaDataResults ServiceMetaData::parseResults() const
  */
 bool ServiceMetaData::extractMetadata()
 {
-    Q_ASSERT(checkVersion(QLatin1String(XML_MAX)));
-
     latestError = 0;
     clearMetadata();
     QXmlStreamReader xmlReader;
@@ -234,21 +296,21 @@ bool ServiceMetaData::extractMetadata()
         // Read XML doc
         while (!xmlReader.atEnd() && !parseError) {
             xmlReader.readNext();
+            const XmlTag tag = elementTag(xmlReader);
             //Found <SFW> xml versioning tag introduced in 1.1
             //If this tag is not found the XML parser version will be 1.0
-            if (xmlReader.isStartElement() && xmlReader.name() == QLatin1String(SERVICEFW_TAG)) {
+            if (xmlReader.isStartElement() && tag == ServiceFwTag) {
                 if (!processVersionElement(xmlReader)) {
                     parseError = true;
                 }
             }
             //Found a <service> node, read service related metadata
-            else if (xmlReader.isStartElement() && xmlReader.name() == QLatin1String(SERVICE_TAG)) {
+            else if (xmlReader.isStartElement() && tag == ServiceTag) {
                 if (!processServiceElement(xmlReader)) {
                     parseError = true;
                 }
             }
-            else if (xmlReader.isStartElement() && xmlReader.name() != QLatin1String(SERVICE_TAG)
-                                                && xmlReader.name() != QLatin1String(SERVICEFW_TAG)) {
+            else if (xmlReader.isStartElement()) {
                 latestError = ServiceMetaData::SFW_ERROR_NO_SERVICE;
                 parseError = true;
             }
@@ -271,7 +333,7 @@ bool ServiceMetaData::extractMetadata()
                 qDebug() << "Missing or empty <name> tag within <service>";
                 break;
             case SFW_ERROR_NO_SERVICE_PATH:                          /* Can not find service filepath or ipcaddress in XML file */
-                if (greaterThan(xmlVersion, QLatin1String("1.0")))
+                if (xmlVersionGreaterThan(1, 0))
                     qDebug() << "Missing or empty <filepath> or <ipcaddress> tag within <service>";
                 else
                     qDebug() << "Missing or empty <filepath> tag within <service>";
@@ -328,7 +390,7 @@ bool ServiceMetaData::extractMetadata()
                 break;
             case SFW_ERROR_UNSUPPORTED_XML_VERSION:                  /* Unsupported servicefw version supplied */
                 qDebug().nospace() << "Service framework version(" << xmlVersion
-                                   << ") is higher than available support(" << QLatin1String(XML_MAX) << ")";
+                                   << ") is higher than available support(" << XML_MAX_MAJOR << '.' << XML_MAX_MINOR << ")";
                 break;
         }
         clearMetadata();
@@ -336,6 +398,63 @@ bool ServiceMetaData::extractMetadata()
     return !parseError;
 }
 
+class ServiceMetaDataParseTask : public QRunnable
+{
+public:
+    ServiceMetaDataParseTask(const QString &xmlFilePath)
+        : parser(xmlFilePath), success(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        success = parser.extractMetadata();
+        if (success)
+            results = parser.parseResults();
+    }
+
+    ServiceMetaData parser;
+    ServiceMetaDataResults results;
+    bool success;
+};
+
+/*
+    Parses all files in \a xmlFilePaths concurrently using a thread pool and
+    appends the results to \a results, in the same order as the files were
+    given.  The paths of files that could not be parsed are appended to
+    \a failedFilePaths if it is not null.
+
+    @return true if all files were parsed successfully, false otherwise
+ */
+bool ServiceMetaData::extractMetadata(const QStringList &xmlFilePaths, QList<ServiceMetaDataResults> *results,
+                                      QStringList *failedFilePaths)
+{
+    Q_ASSERT(results != NULL);
+
+    QList<ServiceMetaDataParseTask *> tasks;
+    QThreadPool pool;
+    for (int i = 0; i < xmlFilePaths.count(); ++i) {
+        ServiceMetaDataParseTask *task = new ServiceMetaDataParseTask(xmlFilePaths[i]);
+        tasks.append(task);
+        pool.start(task);
+    }
+    pool.waitForDone();
+
+    bool success = true;
+    for (int i = 0; i < tasks.count(); ++i) {
+        if (tasks[i]->success) {
+            results->append(tasks[i]->results);
+        } else {
+            success = false;
+            if (failedFilePaths)
+                failedFilePaths->append(xmlFilePaths[i]);
+        }
+    }
+    qDeleteAll(tasks);
+    return success;
+}
+
 /*
     Gets the latest parsing error \n
     @return parsing error(negative value) or 0 in case there is none
@@ -350,18 +469,18 @@ int ServiceMetaData::getLatestError() const
 */
 bool ServiceMetaData::processVersionElement(QXmlStreamReader &aXMLReader)
 {
-    Q_ASSERT(aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(SERVICEFW_TAG));
+    Q_ASSERT(aXMLReader.isStartElement() && elementTag(aXMLReader) == ServiceFwTag);
     bool parseError = false;
 
     if (aXMLReader.attributes().hasAttribute(QLatin1String("version"))) {
         xmlVersion = aXMLReader.attributes().value(QLatin1String("version")).toString();
-        bool success = checkVersion(xmlVersion);
+        bool success = parseVersion(xmlVersion, &xmlMajorVersion, &xmlMinorVersion);
 
         if (xmlVersion.isEmpty() || !success) {
             latestError = ServiceMetaData::SFW_ERROR_INVALID_XML_VERSION;
             parseError = true;
         } else {
-            if (greaterThan(xmlVersion, QLatin1String(XML_MAX))) {
+            if (xmlVersionGreaterThan(XML_MAX_MAJOR, XML_MAX_MINOR)) {
                 latestError = ServiceMetaData::SFW_ERROR_UNSUPPORTED_XML_VERSION;
                 parseError = true;
             }
@@ -373,17 +492,18 @@ bool ServiceMetaData::processVersionElement(QXmlStreamReader &aXMLReader)
 
     while (!parseError && !aXMLReader.atEnd()) {
         aXMLReader.readNext();
+        const XmlTag tag = elementTag(aXMLReader);
         //Found a <service> node, read service related metadata
-        if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(SERVICE_TAG)) {
+        if (aXMLReader.isStartElement() && tag == ServiceTag) {
             if (!processServiceElement(aXMLReader)) {
                 parseError = true;
             }
         }
-        else if (aXMLReader.isEndElement() && aXMLReader.name() == QLatin1String(SERVICEFW_TAG)) {
+        else if (aXMLReader.isEndElement() && tag == ServiceFwTag) {
             //Found </SFW>, leave the loop
             break;
         }
-        else if (aXMLReader.isStartElement() && aXMLReader.name() != QLatin1String(SERVICE_TAG)) {
+        else if (aXMLReader.isStartElement()) {
             latestError = ServiceMetaData::SFW_ERROR_NO_SERVICE;
             parseError = true;
         }
@@ -401,7 +521,7 @@ bool ServiceMetaData::processVersionElement(QXmlStreamReader &aXMLReader)
  */
 bool ServiceMetaData::processServiceElement(QXmlStreamReader &aXMLReader)
 {
-    Q_ASSERT(aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(SERVICE_TAG));
+    Q_ASSERT(aXMLReader.isStartElement() && elementTag(aXMLReader) == ServiceTag);
     bool parseError = false;
 
     int dupSTags[4] = {0 //->tag name
@@ -411,15 +531,16 @@ bool ServiceMetaData::processServiceElement(QXmlStreamReader &aXMLReader)
     };
     while (!parseError && !aXMLReader.atEnd()) {
         aXMLReader.readNext();
-        if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(NAME_TAG)) {
+        const XmlTag tag = elementTag(aXMLReader);
+        if (aXMLReader.isStartElement() && tag == NameTag) {
             //Found <name> tag
             serviceName = aXMLReader.readElementText();
             dupSTags[0]++;
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(DESCRIPTION_TAG)) {
+        } else if (aXMLReader.isStartElement() && tag == DescriptionTag) {
             //Found <description> tag
             serviceDescription = aXMLReader.readElementText();
             dupSTags[1]++;
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(SERVICE_FILEPATH) ) {
+        } else if (aXMLReader.isStartElement() && tag == FilePathTag) {
             //Found <filepath> tag for plugin service
             dupSTags[2]++;
             serviceLocation = aXMLReader.readElementText();
@@ -428,10 +549,10 @@ bool ServiceMetaData::processServiceElement(QXmlStreamReader &aXMLReader)
                 latestError = ServiceMetaData::SFW_ERROR_INVALID_FILEPATH;
                 parseError = true;
             }
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(SERVICE_IPCADDRESS) ) {
+        } else if (aXMLReader.isStartElement() && tag == IpcAddressTag) {
             //Found <ipcaddress> tag for IPC service
             //Check if servicefw XML version supports IPC
-            if (greaterThan(xmlVersion, QLatin1String("1.0"))) {
+            if (xmlVersionGreaterThan(1, 0)) {
                 dupSTags[3]++;
                 serviceLocation = aXMLReader.readElementText();
                 //Check if IPC prefix was used incorrectly here
@@ -443,14 +564,14 @@ bool ServiceMetaData::processServiceElement(QXmlStreamReader &aXMLReader)
                 latestError = ServiceMetaData::SFW_ERROR_UNSUPPORTED_IPC;
                 parseError = true;
             }
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(INTERFACE_TAG)) {
+        } else if (aXMLReader.isStartElement() && tag == InterfaceTag) {
             //Found interface> node, read module related metadata
             if (!processInterfaceElement(aXMLReader))
                 parseError = true;
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String("version")) {
+        } else if (aXMLReader.isStartElement() && tag == VersionTag) {
             //Found <version> tag on service level. We ignore this for now
             aXMLReader.readElementText();
-        } else if (aXMLReader.isEndElement() && aXMLReader.name() == QLatin1String(SERVICE_TAG)) {
+        } else if (aXMLReader.isEndElement() && tag == ServiceTag) {
             //Found </service>, leave the loop
             break;
         } else if (aXMLReader.isEndElement() || aXMLReader.isStartElement()) {
@@ -509,7 +630,7 @@ bool ServiceMetaData::processServiceElement(QXmlStreamReader &aXMLReader)
 */
 bool ServiceMetaData::processInterfaceElement(QXmlStreamReader &aXMLReader)
 {
-    Q_ASSERT(aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(INTERFACE_TAG));
+    Q_ASSERT(aXMLReader.isStartElement() && elementTag(aXMLReader) == InterfaceTag);
     bool parseError = false;
 
     //Read interface parameter
@@ -525,26 +646,25 @@ bool ServiceMetaData::processInterfaceElement(QXmlStreamReader &aXMLReader)
 
     while (!parseError && !aXMLReader.atEnd()) {
         aXMLReader.readNext();
+        const XmlTag tag = elementTag(aXMLReader);
         //Read interface description
-        if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(NAME_TAG)) {
+        if (aXMLReader.isStartElement() && tag == NameTag) {
             aInterface.d->interfaceName = aXMLReader.readElementText();
             dupITags[0]++;
             //Found <name> tag for interface
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(DESCRIPTION_TAG)) {
+        } else if (aXMLReader.isStartElement() && tag == DescriptionTag) {
             //Found <description> tag
             aInterface.d->attributes[QServiceInterfaceDescriptor::InterfaceDescription] = aXMLReader.readElementText();
             dupITags[3]++;
         //Found </interface>, leave the loop
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(INTERFACE_VERSION)) {
+        } else if (aXMLReader.isStartElement() && tag == VersionTag) {
             tmp.clear();
             tmp = aXMLReader.readElementText();
             if (tmp.isEmpty())
                 continue;  //creates NO_INTERFACE_VERSION error further below
-            bool success = checkVersion(tmp);
-            if ( success ) {
-                int majorVer = -1;
-                int minorVer = -1;
-                transformVersion(tmp, &majorVer, &minorVer);
+            int majorVer = -1;
+            int minorVer = -1;
+            if (parseVersion(tmp, &majorVer, &minorVer)) {
                 aInterface.d->major = majorVer;
                 aInterface.d->minor = minorVer;
                 dupITags[1]++;
@@ -552,12 +672,12 @@ bool ServiceMetaData::processInterfaceElement(QXmlStreamReader &aXMLReader)
                 latestError = ServiceMetaData::SFW_ERROR_INVALID_VERSION;
                 parseError = true;
             }
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(INTERFACE_CAPABILITY)) {
+        } else if (aXMLReader.isStartElement() && tag == CapabilitiesTag) {
             tmp.clear();
             tmp= aXMLReader.readElementText();
             aInterface.d->attributes[QServiceInterfaceDescriptor::Capabilities] = tmp.split(QLatin1String(","), QString::SkipEmptyParts);
             dupITags[2]++;
-        } else if (aXMLReader.isStartElement() && aXMLReader.name() == QLatin1String(INTERFACE_CUSTOM_PROPERTY)) {
+        } else if (aXMLReader.isStartElement() && tag == CustomPropertyTag) {
             parseError = true;
             if (aXMLReader.attributes().hasAttribute(QLatin1String("key"))) {
                 const QString ref = aXMLReader.attributes().value(QLatin1String("key")).toString();
@@ -576,7 +696,7 @@ bool ServiceMetaData::processInterfaceElement(QXmlStreamReader &aXMLReader)
             }
             if (parseError)
                 latestError = SFW_ERROR_INVALID_CUSTOM_TAG;
-        } else if (aXMLReader.isEndElement() && aXMLReader.name() == QLatin1String(INTERFACE_TAG)) {
+        } else if (aXMLReader.isEndElement() && tag == InterfaceTag) {
             break;
         } else if (aXMLReader.isStartElement() || aXMLReader.isEndElement()) {
             latestError = ServiceMetaData::SFW_ERROR_PARSE_INTERFACE;
@@ -657,53 +777,78 @@ bool ServiceMetaData::lessThan(const QServiceInterfaceDescriptor &d1,
 
 }
 
-bool ServiceMetaData::greaterThan(const QString &v1, const QString &v2) const
+/*
+    Returns true if the servicefw XML version of the parsed document is
+    greater than \a major.\a minor.
+*/
+bool ServiceMetaData::xmlVersionGreaterThan(int major, int minor) const
+{
+    return xmlMajorVersion > major
+            || (xmlMajorVersion == major && xmlMinorVersion > minor);
+}
+
+/*
+    Parses a version string of the form x.y, where x is a positive number
+    without leading zeros and y is either a number without leading zeros or
+    a sequence of zeros, in a single pass.
+
+    Returns true and sets \a major and \a minor if \a version is valid;
+    otherwise returns false and leaves them untouched.
+*/
+bool ServiceMetaData::parseVersion(const QString &version, int *major, int *minor)
 {
-    int majorV1 = -1;
-    int minorV1 = -1;
-    transformVersion(v1, &majorV1, &minorV1);
+    Q_ASSERT(major != NULL);
+    Q_ASSERT(minor != NULL);
 
-    int majorV2 = -1;
-    int minorV2 = -1;
-    transformVersion(v2, &majorV2, &minorV2);
+    const int dot = version.indexOf(QLatin1Char('.'));
+    if (dot <= 0 || dot == version.length() - 1)
+        return false;
+
+    const QChar *data = version.constData();
+    //major must not start with 0; minor may only do so if it is all zeros
+    if (data[0] == QLatin1Char('0'))
+        return false;
+    if (data[dot + 1] == QLatin1Char('0')) {
+        for (int i = dot + 2; i < version.length(); ++i) {
+            if (data[i] != QLatin1Char('0'))
+                return false;
+        }
+    }
 
-    return  (majorV1 > majorV2
-             || (majorV1 == majorV2 && minorV1 > minorV2));
+    qint64 values[2] = {0, 0};
+    int part = 0;
+    for (int i = 0; i < version.length(); ++i) {
+        if (i == dot) {
+            part = 1;
+            continue;
+        }
+        const ushort c = data[i].unicode();
+        if (c < '0' || c > '9')
+            return false;
+        values[part] = values[part] * 10 + (c - '0');
+        if (values[part] > INT_MAX)
+            return false;
+    }
+
+    *major = int(values[0]);
+    *minor = int(values[1]);
+    return true;
 }
 
 bool ServiceMetaData::checkVersion(const QString &version) const
 {
-    //match x.y as version format
-    QRegularExpression rx(QLatin1String("^([1-9][0-9]*)\\.(0+|[1-9][0-9]*)$"));
-    QRegularExpressionMatch match = rx.match(version);
-    int pos = match.capturedStart();
-    QStringList list = match.capturedTexts();
-    bool success = false;
-    if (pos == 0 && list.count() == 3
-            && match.capturedLength() == version.length() )
-    {
-        list[1].toInt(&success);
-        if ( success ) {
-            list[2].toInt(&success);
-        }
-    }
-    return success;
+    int major;
+    int minor;
+    return parseVersion(version, &major, &minor);
 }
 
 void ServiceMetaData::transformVersion(const QString &version, int *major, int *minor) const
 {
     Q_ASSERT(major != NULL);
     Q_ASSERT(minor != NULL);
-    if (!checkVersion(version)) {
+    if (!parseVersion(version, major, minor)) {
         *major = -1;
         *minor = -1;
-    } else {
-        QRegularExpression rx(QLatin1String("^([1-9][0-9]*)\\.(0+|[1-9][0-9]*)$"));
-        QRegularExpressionMatch match = rx.match(version);
-        QStringList list = match.capturedTexts();
-        Q_ASSERT(list.count() == 3);
-        *major = list[1].toInt();
-        *minor = list[2].toInt();
     }
 }
 
@@ -714,6 +859,8 @@ void ServiceMetaData::transformVersion(const QString &version, int *major, int *
 void ServiceMetaData::clearMetadata()
 {
     xmlVersion = QLatin1String("1.0");
+    xmlMajorVersion = 1;
+    xmlMinorVersion = 0;
     serviceName.clear();
     serviceLocation.clear();
     serviceDescription.clear();
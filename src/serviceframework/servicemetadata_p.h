@@ -147,6 +147,9 @@ public:
 
     ServiceMetaDataResults parseResults() const;
 
+    static bool extractMetadata(const QStringList &xmlFilePaths, QList<ServiceMetaDataResults> *results,
+                                QStringList *failedFilePaths = 0);
+
 private:
     QList<QServiceInterfaceDescriptor> latestInterfaces() const;
     QServiceInterfaceDescriptor latestInterfaceVersion(const QString &interfaceName);
@@ -160,13 +163,16 @@ private:
 private:
     bool lessThan(const QServiceInterfaceDescriptor &d1,
                     const QServiceInterfaceDescriptor &d2) const;
-    bool greaterThan(const QString &v1, const QString &v2) const;
+    bool xmlVersionGreaterThan(int major, int minor) const;
+    static bool parseVersion(const QString &version, int *major, int *minor);
     bool checkVersion(const QString &version) const;
     void transformVersion(const QString &version, int *major, int *minor) const;
 
     QIODevice *xmlDevice;
     bool ownsXmlDevice;
     QString xmlVersion;
+    int xmlMajorVersion;
+    int xmlMinorVersion;
     QString serviceName;
     QString serviceLocation;
     QString serviceDescription;
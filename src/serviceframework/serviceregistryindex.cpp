@@ -0,0 +1,826 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "serviceregistryindex_p.h"
+#include "servicedatabase_p.h"
+#include "qserviceinterfacedescriptor_p.h"
+#include <QFileInfo>
+#include <QMap>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+#include <QDebug>
+#endif
+
+//"QSFI" in host byte order; an index written on a host with a different
+//byte order is rejected rather than converted
+#define INDEX_MAGIC 0x49465351
+#define INDEX_VERSION 1
+#define INDEX_NO_STRING 0xffffffff
+#define INDEX_SUFFIX ".idx"
+
+QT_BEGIN_NAMESPACE
+
+/*
+    \class ServiceRegistryIndex
+    The ServiceRegistryIndex is a read-only, precompiled form of a service
+    database.  It is intended for system images where the set of system
+    services is fixed at build time: the index is memory mapped and queried
+    in place, so no SQLite connection has to be opened at runtime.
+
+    The file consists of a header followed by fixed size tables and a string
+    table.  All integers are stored in host byte order and every table starts
+    at a 4 byte boundary:
+    - Entry: one record per interface implementation, sorted by lowercased
+      interface name, lowercased service name and version
+    - interfaces: lowercased interface name -> range of entries
+    - services: lowercased service name -> service name
+    - defaults: lowercased interface name -> default entry
+    - interface ids: interface ID -> entry, for defaults of the user
+      database that refer to system interface implementations
+    - attributes: custom attribute key/value pairs of the entries
+    - strings: length prefixed UTF-16 strings, shared by all tables
+*/
+
+struct ServiceRegistryIndex::Header
+{
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    quint32 entryOffset;
+    quint32 interfaceCount;
+    quint32 interfaceOffset;
+    quint32 serviceCount;
+    quint32 serviceOffset;
+    quint32 defaultCount;
+    quint32 defaultOffset;
+    quint32 interfaceIdCount;
+    quint32 interfaceIdOffset;
+    quint32 attributeCount;
+    quint32 attributeOffset;
+    quint32 stringOffset;
+    quint32 stringSize;
+};
+
+struct ServiceRegistryIndex::Entry
+{
+    quint32 interfaceName;
+    quint32 serviceName;
+    quint32 serviceKey;
+    quint32 interfaceId;
+    qint32 major;
+    qint32 minor;
+    quint32 serviceType;
+    quint32 location;
+    quint32 serviceDescription;
+    quint32 interfaceDescription;
+    quint32 capabilities;
+    quint32 firstAttribute;
+    quint32 attributeCount;
+};
+
+struct ServiceRegistryIndex::NameEntry
+{
+    quint32 key;
+    quint32 value;
+    quint32 count;
+};
+
+struct ServiceRegistryIndex::Attribute
+{
+    quint32 key;
+    quint32 value;
+};
+
+/*
+    Accumulates the string table of an index while it is being compiled.
+    Identical strings are stored once.
+*/
+class IndexStringTable
+{
+public:
+    quint32 add(const QString &string)
+    {
+        QHash<QString, quint32>::const_iterator it = m_offsets.constFind(string);
+        if (it != m_offsets.constEnd())
+            return it.value();
+
+        quint32 offset = m_data.size();
+        quint32 length = string.length();
+        m_data.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        m_data.append(reinterpret_cast<const char *>(string.constData()), length * sizeof(QChar));
+        while (m_data.size() % 4)
+            m_data.append('\0');
+
+        m_offsets.insert(string, offset);
+        return offset;
+    }
+
+    quint32 addOptional(const QVariant &value)
+    {
+        return value.isValid() ? add(value.toString()) : INDEX_NO_STRING;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QHash<QString, quint32> m_offsets;
+    QByteArray m_data;
+};
+
+struct IndexRecord
+{
+    QServiceInterfaceDescriptor descriptor;
+    QString interfaceKey;
+    QString serviceKey;
+    QString interfaceId;
+};
+
+static bool indexRecordLessThan(const IndexRecord &r1, const IndexRecord &r2)
+{
+    if (r1.interfaceKey != r2.interfaceKey)
+        return r1.interfaceKey < r2.interfaceKey;
+    if (r1.serviceKey != r2.serviceKey)
+        return r1.serviceKey < r2.serviceKey;
+    if (r1.descriptor.majorVersion() != r2.descriptor.majorVersion())
+        return r1.descriptor.majorVersion() < r2.descriptor.majorVersion();
+    return r1.descriptor.minorVersion() < r2.descriptor.minorVersion();
+}
+
+template <typename T>
+static void appendTable(QByteArray *data, const QVector<T> &table)
+{
+    data->append(reinterpret_cast<const char *>(table.constData()), table.count() * sizeof(T));
+}
+
+/*
+    Constructor
+*/
+ServiceRegistryIndex::ServiceRegistryIndex()
+    : m_data(0), m_size(0), m_header(0), m_entries(0), m_interfaces(0),
+      m_services(0), m_defaults(0), m_interfaceIds(0), m_attributes(0), m_strings(0)
+{
+}
+
+/*
+    Destructor
+*/
+ServiceRegistryIndex::~ServiceRegistryIndex()
+{
+    close();
+}
+
+/*
+    Returns the path of the index that accompanies the service database
+    at \a databasePath.
+*/
+QString ServiceRegistryIndex::indexPath(const QString &databasePath)
+{
+    QFileInfo info(databasePath);
+    return info.path() + QLatin1Char('/') + info.completeBaseName() + QLatin1String(INDEX_SUFFIX);
+}
+
+/*
+    Maps the index file at \a indexPath into memory and validates its
+    tables.  Returns true if the operation was successful, false if not.
+
+    May set the last error to one of the following error codes:
+    DBError::NoError
+    DBError::CannotOpenServiceDb
+    DBError::InvalidDatabaseFile
+*/
+bool ServiceRegistryIndex::open(const QString &indexPath)
+{
+    close();
+
+    m_file.setFileName(indexPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        QString errorText(QLatin1String("Unable to open service registry index: %1"));
+        m_lastError.setError(DBError::CannotOpenServiceDb, errorText.arg(indexPath));
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size > 0)
+        m_data = m_file.map(0, m_size);
+
+    if (!m_data || !validate()) {
+        QString errorText(QLatin1String("Service registry index is corrupt or invalid: %1"));
+        m_lastError.setError(DBError::InvalidDatabaseFile, errorText.arg(indexPath));
+#ifdef QT_SFW_SERVICEDATABASE_DEBUG
+        qWarning() << "ServiceRegistryIndex::open():-"
+                    << "Problem:" << qPrintable(m_lastError.text());
+#endif
+        close();
+        return false;
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return true;
+}
+
+/*
+    Unmaps and closes the index
+*/
+void ServiceRegistryIndex::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+    m_file.close();
+
+    m_data = 0;
+    m_size = 0;
+    m_header = 0;
+    m_entries = 0;
+    m_interfaces = 0;
+    m_services = 0;
+    m_defaults = 0;
+    m_interfaceIds = 0;
+    m_attributes = 0;
+    m_strings = 0;
+}
+
+bool ServiceRegistryIndex::isOpen() const
+{
+    return m_header != 0;
+}
+
+QString ServiceRegistryIndex::indexPath() const
+{
+    return m_file.fileName();
+}
+
+/*
+    Checks that all tables of the mapped file lie within its bounds and that
+    every reference between them is valid, so that queries need not do any
+    further checking.
+*/
+bool ServiceRegistryIndex::validate()
+{
+    if (m_size < qint64(sizeof(Header)))
+        return false;
+
+    const Header *header = reinterpret_cast<const Header *>(m_data);
+    if (header->magic != INDEX_MAGIC || header->version != INDEX_VERSION)
+        return false;
+
+    struct { quint32 offset; quint32 count; quint32 size; } tables[] = {
+        { header->entryOffset, header->entryCount, sizeof(Entry) },
+        { header->interfaceOffset, header->interfaceCount, sizeof(NameEntry) },
+        { header->serviceOffset, header->serviceCount, sizeof(NameEntry) },
+        { header->defaultOffset, header->defaultCount, sizeof(NameEntry) },
+        { header->interfaceIdOffset, header->interfaceIdCount, sizeof(NameEntry) },
+        { header->attributeOffset, header->attributeCount, sizeof(Attribute) },
+        { header->stringOffset, header->stringSize, 1 }
+    };
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i) {
+        if (tables[i].offset % 4
+                || quint64(tables[i].offset) + quint64(tables[i].count) * tables[i].size > quint64(m_size))
+            return false;
+    }
+
+    m_header = header;
+    m_entries = reinterpret_cast<const Entry *>(m_data + header->entryOffset);
+    m_interfaces = reinterpret_cast<const NameEntry *>(m_data + header->interfaceOffset);
+    m_services = reinterpret_cast<const NameEntry *>(m_data + header->serviceOffset);
+    m_defaults = reinterpret_cast<const NameEntry *>(m_data + header->defaultOffset);
+    m_interfaceIds = reinterpret_cast<const NameEntry *>(m_data + header->interfaceIdOffset);
+    m_attributes = reinterpret_cast<const Attribute *>(m_data + header->attributeOffset);
+    m_strings = m_data + header->stringOffset;
+
+    for (quint32 i = 0; i < header->entryCount; ++i) {
+        const Entry &entry = m_entries[i];
+        if (!validString(entry.interfaceName) || !validString(entry.serviceName)
+                || !validString(entry.serviceKey) || !validString(entry.interfaceId)
+                || !validString(entry.location)
+                || (entry.serviceDescription != INDEX_NO_STRING && !validString(entry.serviceDescription))
+                || (entry.interfaceDescription != INDEX_NO_STRING && !validString(entry.interfaceDescription))
+                || (entry.capabilities != INDEX_NO_STRING && !validString(entry.capabilities))
+                || quint64(entry.firstAttribute) + entry.attributeCount > header->attributeCount)
+            return false;
+    }
+
+    for (quint32 i = 0; i < header->interfaceCount; ++i) {
+        if (!validString(m_interfaces[i].key)
+                || quint64(m_interfaces[i].value) + m_interfaces[i].count > header->entryCount)
+            return false;
+    }
+
+    for (quint32 i = 0; i < header->serviceCount; ++i) {
+        if (!validString(m_services[i].key) || !validString(m_services[i].value))
+            return false;
+    }
+
+    for (quint32 i = 0; i < header->defaultCount; ++i) {
+        if (!validString(m_defaults[i].key) || m_defaults[i].value >= header->entryCount)
+            return false;
+    }
+
+    for (quint32 i = 0; i < header->interfaceIdCount; ++i) {
+        if (!validString(m_interfaceIds[i].key) || m_interfaceIds[i].value >= header->entryCount)
+            return false;
+    }
+
+    for (quint32 i = 0; i < header->attributeCount; ++i) {
+        if (!validString(m_attributes[i].key) || !validString(m_attributes[i].value))
+            return false;
+    }
+
+    return true;
+}
+
+bool ServiceRegistryIndex::validString(quint32 offset) const
+{
+    if (offset % 4 || quint64(offset) + sizeof(quint32) > m_header->stringSize)
+        return false;
+
+    quint32 length = *reinterpret_cast<const quint32 *>(m_strings + offset);
+    return quint64(offset) + sizeof(quint32) + quint64(length) * sizeof(QChar) <= m_header->stringSize;
+}
+
+/*
+    Returns a deep copy of the string at \a offset, which remains valid
+    after the index has been closed.
+*/
+QString ServiceRegistryIndex::string(quint32 offset) const
+{
+    if (offset == INDEX_NO_STRING)
+        return QString();
+
+    quint32 length = *reinterpret_cast<const quint32 *>(m_strings + offset);
+    return QString(reinterpret_cast<const QChar *>(m_strings + offset + sizeof(quint32)), length);
+}
+
+/*
+    Returns the string at \a offset without copying it out of the mapped
+    file.  Only to be used for temporary comparisons.
+*/
+QString ServiceRegistryIndex::rawString(quint32 offset) const
+{
+    quint32 length = *reinterpret_cast<const quint32 *>(m_strings + offset);
+    return QString::fromRawData(reinterpret_cast<const QChar *>(m_strings + offset + sizeof(quint32)), length);
+}
+
+/*
+    Returns the position of the first element of the sorted \a table whose
+    key is not less than \a key.
+*/
+int ServiceRegistryIndex::lowerBound(const NameEntry *table, int count, const QString &key) const
+{
+    int first = 0;
+    while (count > 0) {
+        int half = count / 2;
+        if (rawString(table[first + half].key) < key) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+/*
+    Sets \a first and \a last to the range of entries implementing
+    \a interfaceName.  The range is empty if there is no such interface.
+*/
+void ServiceRegistryIndex::interfaceRange(const QString &interfaceName, int *first, int *last) const
+{
+    const QString key = interfaceName.toLower();
+    int i = lowerBound(m_interfaces, m_header->interfaceCount, key);
+    if (i < int(m_header->interfaceCount) && rawString(m_interfaces[i].key) == key) {
+        *first = m_interfaces[i].value;
+        *last = *first + m_interfaces[i].count;
+    } else {
+        *first = *last = 0;
+    }
+}
+
+QServiceInterfaceDescriptor ServiceRegistryIndex::descriptor(int entryIndex) const
+{
+    const Entry &entry = m_entries[entryIndex];
+
+    QServiceInterfaceDescriptorPrivate *priv = new QServiceInterfaceDescriptorPrivate;
+    priv->interfaceName = string(entry.interfaceName);
+    priv->serviceName = string(entry.serviceName);
+    priv->major = entry.major;
+    priv->minor = entry.minor;
+    priv->attributes[QServiceInterfaceDescriptor::ServiceType] = int(entry.serviceType);
+    priv->attributes[QServiceInterfaceDescriptor::Location] = string(entry.location);
+    if (entry.serviceDescription != INDEX_NO_STRING)
+        priv->attributes[QServiceInterfaceDescriptor::ServiceDescription] = string(entry.serviceDescription);
+    if (entry.interfaceDescription != INDEX_NO_STRING)
+        priv->attributes[QServiceInterfaceDescriptor::InterfaceDescription] = string(entry.interfaceDescription);
+    if (entry.capabilities != INDEX_NO_STRING) {
+        const QString capabilities = rawString(entry.capabilities);
+        priv->attributes[QServiceInterfaceDescriptor::Capabilities]
+            = capabilities.isEmpty() ? QStringList() : capabilities.split(QLatin1Char(','));
+    }
+    for (quint32 i = entry.firstAttribute; i < entry.firstAttribute + entry.attributeCount; ++i)
+        priv->customAttributes[string(m_attributes[i].key)] = string(m_attributes[i].value);
+
+    QServiceInterfaceDescriptor descriptor;
+    QServiceInterfaceDescriptorPrivate::setPrivate(&descriptor, priv);
+    return descriptor;
+}
+
+/*
+   Obtains a list of QServiceInterfaceDescriptors that match the constraints supplied
+   by \a filter.  The matching rules are the same as for
+   ServiceDatabase::getInterfaces().
+
+   May set last error to one of the following error codes:
+   DBError::NoError
+   DBError::DatabaseNotOpen
+*/
+QList<QServiceInterfaceDescriptor> ServiceRegistryIndex::getInterfaces(const QServiceFilter &filter)
+{
+    QList<QServiceInterfaceDescriptor> interfaces;
+    if (!isOpen()) {
+        m_lastError.setError(DBError::DatabaseNotOpen);
+        return interfaces;
+    }
+
+    int first = 0;
+    int last = m_header->entryCount;
+    bool matchVersion = false;
+    if (!filter.interfaceName().isEmpty()) {
+        interfaceRange(filter.interfaceName(), &first, &last);
+        matchVersion = filter.majorVersion() >= 0 && filter.minorVersion() >= 0;
+    }
+
+    const QString serviceKey = filter.serviceName().toLower();
+    const QSet<QString> filterCaps = filter.capabilities().toSet();
+    const QStringList filterKeys = filter.customAttributes();
+
+    for (int i = first; i < last; ++i) {
+        const Entry &entry = m_entries[i];
+        if (!serviceKey.isEmpty() && rawString(entry.serviceKey) != serviceKey)
+            continue;
+
+        if (matchVersion) {
+            if (filter.versionMatchRule() == QServiceFilter::ExactVersionMatch) {
+                if (entry.major != filter.majorVersion() || entry.minor != filter.minorVersion())
+                    continue;
+            } else if (filter.versionMatchRule() == QServiceFilter::MinimumVersionMatch) {
+                if (entry.major < filter.majorVersion()
+                        || (entry.major == filter.majorVersion() && entry.minor < filter.minorVersion()))
+                    continue;
+            }
+        }
+
+        const QServiceInterfaceDescriptor serviceInterface = descriptor(i);
+        const QServiceInterfaceDescriptorPrivate *priv = QServiceInterfaceDescriptorPrivate::getPrivate(&serviceInterface);
+
+        const QSet<QString> ifaceCaps = priv->attributes.value(QServiceInterfaceDescriptor::Capabilities).toStringList().toSet();
+        const QSet<QString> difference = (filter.capabilityMatchRule() == QServiceFilter::MatchMinimum)
+                ? (filterCaps - ifaceCaps) : (ifaceCaps - filterCaps);
+        if (!difference.isEmpty())
+            continue;
+
+        bool isMatch = true;
+        for (int k = 0; k < filterKeys.count(); ++k) {
+            QHash<QString, QString>::const_iterator it = priv->customAttributes.constFind(filterKeys[k]);
+            if (it == priv->customAttributes.constEnd() || it.value() != filter.customAttribute(filterKeys[k])) {
+                isMatch = false;
+                break;
+            }
+        }
+        if (isMatch)
+            interfaces.append(serviceInterface);
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return interfaces;
+}
+
+/*
+   Obtains a QServiceInterfaceDescriptor that
+   corresponds to a given \a interfaceID
+
+   May set last error to one of the following error codes:
+   DBError::NoError
+   DBError::NotFound
+   DBError::DatabaseNotOpen
+*/
+QServiceInterfaceDescriptor ServiceRegistryIndex::getInterface(const QString &interfaceID)
+{
+    if (!isOpen()) {
+        m_lastError.setError(DBError::DatabaseNotOpen);
+        return QServiceInterfaceDescriptor();
+    }
+
+    int i = lowerBound(m_interfaceIds, m_header->interfaceIdCount, interfaceID);
+    if (i == int(m_header->interfaceIdCount) || rawString(m_interfaceIds[i].key) != interfaceID) {
+        QString errorText(QLatin1String("Interface implementation not found for Interface ID: %1"));
+        m_lastError.setError(DBError::NotFound, errorText.arg(interfaceID));
+        return QServiceInterfaceDescriptor();
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return descriptor(m_interfaceIds[i].value);
+}
+
+/*
+    Obtains an interface ID corresponding to a given interface \a descriptor
+
+    May set the following error codes:
+    DBError::NoError
+    DBError::NotFound
+    DBError::DatabaseNotOpen
+*/
+QString ServiceRegistryIndex::getInterfaceID(const QServiceInterfaceDescriptor &serviceInterface)
+{
+    if (!isOpen()) {
+        m_lastError.setError(DBError::DatabaseNotOpen);
+        return QString();
+    }
+
+    int first;
+    int last;
+    interfaceRange(serviceInterface.interfaceName(), &first, &last);
+    const QString serviceKey = serviceInterface.serviceName().toLower();
+    for (int i = first; i < last; ++i) {
+        const Entry &entry = m_entries[i];
+        if (entry.major == serviceInterface.majorVersion()
+                && entry.minor == serviceInterface.minorVersion()
+                && rawString(entry.serviceKey) == serviceKey) {
+            m_lastError.setError(DBError::NoError);
+            return string(entry.interfaceId);
+        }
+    }
+
+    QString errorText(QLatin1String("No Interface Descriptor found with "
+                        "Service name: %1 "
+                        "Interface name: %2 "
+                        "Version: %3.%4"));
+    m_lastError.setError(DBError::NotFound, errorText.arg(serviceInterface.serviceName())
+                                                    .arg(serviceInterface.interfaceName())
+                                                    .arg(serviceInterface.majorVersion())
+                                                    .arg(serviceInterface.minorVersion()));
+    return QString();
+}
+
+/*
+    Obtains a list of services names.  If \a interfaceName is empty,
+    then all service names are returned.  If \a interfaceName specifies
+    an interface then the names of all services implementing that interface
+    are returned
+
+    May set last error to one of the following error codes:
+    DBError::NoError
+    DBError::DatabaseNotOpen
+*/
+QStringList ServiceRegistryIndex::getServiceNames(const QString &interfaceName)
+{
+    QStringList services;
+    if (!isOpen()) {
+        m_lastError.setError(DBError::DatabaseNotOpen);
+        return services;
+    }
+
+    if (interfaceName.isEmpty()) {
+        for (quint32 i = 0; i < m_header->serviceCount; ++i)
+            services.append(string(m_services[i].value));
+    } else {
+        //entries of an interface are sorted by service, so duplicates are adjacent
+        int first;
+        int last;
+        interfaceRange(interfaceName, &first, &last);
+        for (int i = first; i < last; ++i) {
+            if (i == first || rawString(m_entries[i].serviceKey) != rawString(m_entries[i - 1].serviceKey))
+                services.append(string(m_entries[i].serviceName));
+        }
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return services;
+}
+
+/*
+    Retrieves the default interface implementation for \a interfaceName.
+
+    May set the last error to one of the following error codes:
+    DBError::NoError
+    DBError::NotFound
+    DBError::DatabaseNotOpen
+*/
+QServiceInterfaceDescriptor ServiceRegistryIndex::interfaceDefault(const QString &interfaceName)
+{
+    if (!isOpen()) {
+        m_lastError.setError(DBError::DatabaseNotOpen);
+        return QServiceInterfaceDescriptor();
+    }
+
+    const QString key = interfaceName.toLower();
+    int i = lowerBound(m_defaults, m_header->defaultCount, key);
+    if (i == int(m_header->defaultCount) || rawString(m_defaults[i].key) != key) {
+        QString errorText(QLatin1String("No default service found for interface: \"%1\""));
+        m_lastError.setError(DBError::NotFound, errorText.arg(interfaceName));
+        return QServiceInterfaceDescriptor();
+    }
+
+    m_lastError.setError(DBError::NoError);
+    return descriptor(m_defaults[i].value);
+}
+
+/*
+    Compiles the contents of the service \a database, which must already be
+    open, into an index file at \a indexPath.  An existing index at that
+    path is replaced atomically, so processes that have the old index mapped
+    keep a consistent view.
+
+    Returns true if the operation was successful, false if not, in which
+    case \a error describes the failure.
+*/
+bool ServiceRegistryIndex::compile(ServiceDatabase *database, const QString &indexPath, DBError *error)
+{
+    const QList<QServiceInterfaceDescriptor> descriptors = database->getInterfaces(QServiceFilter());
+    if (database->lastError().code() != DBError::NoError) {
+        *error = database->lastError();
+        return false;
+    }
+
+    QList<IndexRecord> records;
+    foreach (const QServiceInterfaceDescriptor &descriptor, descriptors) {
+        IndexRecord record;
+        record.descriptor = descriptor;
+        record.interfaceKey = descriptor.interfaceName().toLower();
+        record.serviceKey = descriptor.serviceName().toLower();
+        record.interfaceId = database->getInterfaceID(descriptor);
+        if (database->lastError().code() != DBError::NoError) {
+            *error = database->lastError();
+            return false;
+        }
+        records.append(record);
+    }
+    std::sort(records.begin(), records.end(), indexRecordLessThan);
+
+    IndexStringTable strings;
+    QVector<Entry> entries;
+    QVector<NameEntry> interfaces;
+    QVector<NameEntry> defaults;
+    QVector<Attribute> attributes;
+    QMap<QString, quint32> services;
+    QMap<QString, quint32> interfaceIds;
+
+    for (int i = 0; i < records.count(); ++i) {
+        const IndexRecord &record = records.at(i);
+        const QServiceInterfaceDescriptor &descriptor = record.descriptor;
+
+        Entry entry;
+        entry.interfaceName = strings.add(descriptor.interfaceName());
+        entry.serviceName = strings.add(descriptor.serviceName());
+        entry.serviceKey = strings.add(record.serviceKey);
+        entry.interfaceId = strings.add(record.interfaceId);
+        entry.major = descriptor.majorVersion();
+        entry.minor = descriptor.minorVersion();
+        entry.serviceType = descriptor.attribute(QServiceInterfaceDescriptor::ServiceType).toInt();
+        entry.location = strings.add(descriptor.attribute(QServiceInterfaceDescriptor::Location).toString());
+        entry.serviceDescription = strings.addOptional(descriptor.attribute(QServiceInterfaceDescriptor::ServiceDescription));
+        entry.interfaceDescription = strings.addOptional(descriptor.attribute(QServiceInterfaceDescriptor::InterfaceDescription));
+        const QVariant capabilities = descriptor.attribute(QServiceInterfaceDescriptor::Capabilities);
+        entry.capabilities = capabilities.isValid()
+                ? strings.add(capabilities.toStringList().join(QLatin1String(","))) : INDEX_NO_STRING;
+        entry.firstAttribute = attributes.count();
+        foreach (const QString &key, descriptor.customAttributes()) {
+            Attribute attribute;
+            attribute.key = strings.add(key);
+            attribute.value = strings.add(descriptor.customAttribute(key));
+            attributes.append(attribute);
+        }
+        entry.attributeCount = attributes.count() - entry.firstAttribute;
+        entries.append(entry);
+
+        if (!services.contains(record.serviceKey))
+            services.insert(record.serviceKey, entry.serviceName);
+        interfaceIds.insert(record.interfaceId, i);
+
+        if (i == 0 || record.interfaceKey != records.at(i - 1).interfaceKey) {
+            NameEntry interfaceEntry;
+            interfaceEntry.key = strings.add(record.interfaceKey);
+            interfaceEntry.value = i;
+            interfaceEntry.count = 0;
+            interfaces.append(interfaceEntry);
+        }
+        ++interfaces.last().count;
+    }
+
+    //records are sorted by interface, so the defaults come out sorted as well
+    for (int i = 0; i < interfaces.count(); ++i) {
+        const QServiceInterfaceDescriptor &first = records.at(interfaces.at(i).value).descriptor;
+        const QServiceInterfaceDescriptor defaultInterface = database->interfaceDefault(first.interfaceName());
+        if (database->lastError().code() == DBError::NotFound)
+            continue;
+        QString defaultId;
+        if (database->lastError().code() == DBError::NoError)
+            defaultId = database->getInterfaceID(defaultInterface);
+        if (database->lastError().code() != DBError::NoError) {
+            *error = database->lastError();
+            return false;
+        }
+
+        NameEntry defaultEntry;
+        defaultEntry.key = interfaces.at(i).key;
+        defaultEntry.value = interfaceIds.value(defaultId);
+        defaultEntry.count = 0;
+        defaults.append(defaultEntry);
+    }
+
+    QVector<NameEntry> serviceTable;
+    for (QMap<QString, quint32>::const_iterator it = services.constBegin(); it != services.constEnd(); ++it) {
+        NameEntry service;
+        service.key = strings.add(it.key());
+        service.value = it.value();
+        service.count = 0;
+        serviceTable.append(service);
+    }
+
+    QVector<NameEntry> interfaceIdTable;
+    for (QMap<QString, quint32>::const_iterator it = interfaceIds.constBegin(); it != interfaceIds.constEnd(); ++it) {
+        NameEntry interfaceId;
+        interfaceId.key = strings.add(it.key());
+        interfaceId.value = it.value();
+        interfaceId.count = 0;
+        interfaceIdTable.append(interfaceId);
+    }
+
+    Header header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.entryCount = entries.count();
+    header.entryOffset = sizeof(Header);
+    header.interfaceCount = interfaces.count();
+    header.interfaceOffset = header.entryOffset + entries.count() * sizeof(Entry);
+    header.serviceCount = serviceTable.count();
+    header.serviceOffset = header.interfaceOffset + interfaces.count() * sizeof(NameEntry);
+    header.defaultCount = defaults.count();
+    header.defaultOffset = header.serviceOffset + serviceTable.count() * sizeof(NameEntry);
+    header.interfaceIdCount = interfaceIdTable.count();
+    header.interfaceIdOffset = header.defaultOffset + defaults.count() * sizeof(NameEntry);
+    header.attributeCount = attributes.count();
+    header.attributeOffset = header.interfaceIdOffset + interfaceIdTable.count() * sizeof(NameEntry);
+    header.stringOffset = header.attributeOffset + attributes.count() * sizeof(Attribute);
+    header.stringSize = strings.data().size();
+
+    QByteArray data(reinterpret_cast<const char *>(&header), sizeof(Header));
+    appendTable(&data, entries);
+    appendTable(&data, interfaces);
+    appendTable(&data, serviceTable);
+    appendTable(&data, defaults);
+    appendTable(&data, interfaceIdTable);
+    appendTable(&data, attributes);
+    data.append(strings.data());
+
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        QString errorText(QLatin1String("Unable to write service registry index %1: %2"));
+        error->setError(DBError::NoWritePermissions, errorText.arg(indexPath).arg(file.errorString()));
+        return false;
+    }
+
+    error->setError(DBError::NoError);
+    return true;
+}
+
+QT_END_NAMESPACE
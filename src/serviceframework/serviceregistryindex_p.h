@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SERVICEREGISTRYINDEX_P_H
+#define SERVICEREGISTRYINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserviceframeworkglobal.h"
+#include "qserviceinterfacedescriptor.h"
+#include "qservicefilter.h"
+#include "dberror_p.h"
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+
+class ServiceDatabase;
+
+class SERVICEDATABASE_EXPORT ServiceRegistryIndex
+{
+    public:
+        ServiceRegistryIndex();
+        ~ServiceRegistryIndex();
+
+        bool open(const QString &indexPath);
+        void close();
+        bool isOpen() const;
+        QString indexPath() const;
+
+        static QString indexPath(const QString &databasePath);
+        static bool compile(ServiceDatabase *database, const QString &indexPath, DBError *error);
+
+        QList<QServiceInterfaceDescriptor> getInterfaces(const QServiceFilter &filter);
+        QServiceInterfaceDescriptor getInterface(const QString &interfaceID);
+        QString getInterfaceID(const QServiceInterfaceDescriptor &serviceInterface);
+        QStringList getServiceNames(const QString &interfaceName);
+        QServiceInterfaceDescriptor interfaceDefault(const QString &interfaceName);
+
+        DBError lastError() const { return m_lastError; }
+
+    private:
+        struct Header;
+        struct Entry;
+        struct NameEntry;
+        struct Attribute;
+
+        bool validate();
+        bool validString(quint32 offset) const;
+        QString string(quint32 offset) const;
+        QString rawString(quint32 offset) const;
+        int lowerBound(const NameEntry *table, int count, const QString &key) const;
+        void interfaceRange(const QString &interfaceName, int *first, int *last) const;
+        QServiceInterfaceDescriptor descriptor(int entryIndex) const;
+
+        QFile m_file;
+        const uchar *m_data;
+        qint64 m_size;
+        const Header *m_header;
+        const Entry *m_entries;
+        const NameEntry *m_interfaces;
+        const NameEntry *m_services;
+        const NameEntry *m_defaults;
+        const NameEntry *m_interfaceIds;
+        const Attribute *m_attributes;
+        const uchar *m_strings;
+        DBError m_lastError;
+};
+
+QT_END_NAMESPACE
+
+#endif //SERVICEREGISTRYINDEX_P_H
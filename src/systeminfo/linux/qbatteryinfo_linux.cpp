@@ -50,6 +50,13 @@
 #include "qudevwrapper_p.h"
 #endif // QT_NO_UDEV
 
+#if !defined(QT_NO_VALUESPACE)
+#include <QtPublishSubscribe/qvaluespacesubscriber.h>
+
+#include <errno.h>
+#include <signal.h>
+#endif // QT_NO_VALUESPACE
+
 QT_BEGIN_NAMESPACE
 
 Q_GLOBAL_STATIC_WITH_ARGS(const QString, AC_ONLINE_SYSFS_PATH, (QLatin1String("/sys/class/power_supply/AC/online")))
@@ -60,6 +67,16 @@ Q_GLOBAL_STATIC_WITH_ARGS(const QString, USB_TYPE_SYSFS_PATH, (QLatin1String("/s
 Q_GLOBAL_STATIC_WITH_ARGS(const QString, USB0_PRESENT_SYSFS_PATH, (QLatin1String("/sys/class/power_supply/USB0/present")))
 Q_GLOBAL_STATIC_WITH_ARGS(const QString, USB0_TYPE_SYSFS_PATH, (QLatin1String("/sys/class/power_supply/USB0/type")))
 
+#if !defined(QT_NO_VALUESPACE)
+/* keep these in sync with qtsystems/src/tools/sysinfod/main.cpp */
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, BATTERY_VALUESPACE_PATH, (QLatin1String("/SystemInfo/Battery")))
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, BATTERY_VALUESPACE_KEY, (QLatin1String("battery%1/%2")))
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, BATTERY_VALUESPACE_PID, (QLatin1String("pid")))
+
+/* how often a client following sysinfod makes sure it has not died silently */
+#define SYSINFOD_CHECK_INTERVAL 5000
+#endif // QT_NO_VALUESPACE
+
 QBatteryInfoPrivate::QBatteryInfoPrivate(QBatteryInfo *parent)
     : QObject(parent)
     , q_ptr(parent)
@@ -81,7 +98,11 @@ QBatteryInfoPrivate::QBatteryInfoPrivate(QBatteryInfo *parent)
 #else
     , timer(0)
 #endif // QT_NO_UDEV
+    , subscriber(0)
+    , daemonCheckTimer(0)
+    , daemonRunning(false)
 {
+    connectValueSpace();
 }
 
 QBatteryInfoPrivate::QBatteryInfoPrivate(int batteryIndex, QBatteryInfo *parent)
@@ -105,7 +126,11 @@ QBatteryInfoPrivate::QBatteryInfoPrivate(int batteryIndex, QBatteryInfo *parent)
 #else
     , timer(0)
 #endif // QT_NO_UDEV
+    , subscriber(0)
+    , daemonCheckTimer(0)
+    , daemonRunning(false)
 {
+    connectValueSpace();
 }
 
 QBatteryInfoPrivate::~QBatteryInfoPrivate()
@@ -115,6 +140,125 @@ QBatteryInfoPrivate::~QBatteryInfoPrivate()
 #endif // QT_NO_UDEV
 }
 
+/*
+    When sysinfod publishes the battery state in the value space, read it from
+    there instead of having every process watch sysfs on its own. sysinfod sets
+    QT_SYSTEMINFO_NO_VALUESPACE for itself, it is the one sampling the hardware.
+*/
+void QBatteryInfoPrivate::connectValueSpace()
+{
+#if !defined(QT_NO_VALUESPACE)
+    if (!qEnvironmentVariableIsEmpty("QT_SYSTEMINFO_NO_VALUESPACE"))
+        return;
+
+    // kept even while sysinfod is not running, so that we notice it start and stop
+    subscriber = new QValueSpaceSubscriber(*BATTERY_VALUESPACE_PATH(), this);
+    if (!subscriber->isConnected()) {
+        delete subscriber;
+        subscriber = 0;
+        return;
+    }
+    daemonRunning = isDaemonRunning();
+#endif // QT_NO_VALUESPACE
+}
+
+/*
+    The value space backend may outlive sysinfod and keep its last values,
+    so only the published pid of a process that still exists counts.
+*/
+bool QBatteryInfoPrivate::isDaemonRunning() const
+{
+#if !defined(QT_NO_VALUESPACE)
+    if (!subscriber)
+        return false;
+
+    bool ok = false;
+    const qint64 pid = subscriber->value(*BATTERY_VALUESPACE_PID()).toLongLong(&ok);
+    return ok && pid > 0 && (::kill(pid_t(pid), 0) == 0 || errno == EPERM);
+#else
+    return false;
+#endif // QT_NO_VALUESPACE
+}
+
+/*
+    Switches between the values of sysinfod and sysfs when sysinfod started or
+    went away, moving any watches over. Returns true if the source changed.
+*/
+bool QBatteryInfoPrivate::updateSource()
+{
+    const bool running = isDaemonRunning();
+    if (running == daemonRunning)
+        return false;
+
+    daemonRunning = running;
+    if (isWatching()) {
+        if (daemonRunning) {
+            stopSysfsWatch();
+            daemonCheckTimer->start();
+        } else {
+            daemonCheckTimer->stop();
+            startSysfsWatch();
+        }
+    }
+    return true;
+}
+
+/*
+    While values are watched, the pid key and the periodic check keep the
+    source up to date. Otherwise every read checks it.
+*/
+bool QBatteryInfoPrivate::useValueSpace()
+{
+    if (!subscriber)
+        return false;
+    if (!isWatching())
+        updateSource();
+    return daemonRunning;
+}
+
+bool QBatteryInfoPrivate::isWatching() const
+{
+    return watchBatteryCount || watchChargerType || watchChargingState
+            || watchCurrentFlow || watchRemainingCapacity
+            || watchRemainingChargingTime || watchVoltage || watchLevelStatus;
+}
+
+void QBatteryInfoPrivate::startSysfsWatch()
+{
+#if !defined(QT_NO_UDEV)
+    if (!uDevWrapper)
+        uDevWrapper = new QUDevWrapper(this);
+    if (watchChargerType)
+        connect(uDevWrapper, SIGNAL(chargerTypeChanged(QByteArray,bool)), this, SLOT(onChargerTypeChanged(QByteArray,bool)), Qt::UniqueConnection);
+    if (watchIsValid || watchCurrentFlow || watchVoltage || watchChargingState || watchRemainingCapacity
+            || watchRemainingChargingTime || watchBatteryCount || watchLevelStatus) {
+        connect(uDevWrapper, SIGNAL(batteryDataChanged(int,QByteArray,QByteArray)), this, SLOT(onBatteryDataChanged(int,QByteArray,QByteArray)), Qt::UniqueConnection);
+    }
+#else
+    if (timer == 0) {
+       timer = new QTimer;
+       timer->setInterval(2000);
+       connect(timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+    }
+
+    if (!timer->isActive())
+       timer->start();
+#endif // QT_NO_UDEV
+}
+
+void QBatteryInfoPrivate::stopSysfsWatch()
+{
+#if !defined(QT_NO_UDEV)
+    if (uDevWrapper) {
+        delete uDevWrapper;
+        uDevWrapper = 0;
+    }
+#else
+    if (timer)
+        timer->stop();
+#endif // QT_NO_UDEV
+}
+
 int QBatteryInfoPrivate::batteryCount()
 {
     if (!watchBatteryCount)
@@ -256,6 +400,11 @@ int QBatteryInfoPrivate::cycleCount()
 
 int QBatteryInfoPrivate::maximumCapacity(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("maximumCapacity")), -1).toInt();
+#endif // QT_NO_VALUESPACE
+
     if (maximumCapacities[battery] == 0) {
         QFile maximum(BATTERY_SYSFS_PATH()->arg(battery) + QStringLiteral("charge_full"));
         if (maximum.open(QIODevice::ReadOnly)) {
@@ -387,25 +536,42 @@ void QBatteryInfoPrivate::connectNotify(const QMetaMethod &signal)
     static const QMetaMethod voltageChangedSignal = QMetaMethod::fromSignal(&QBatteryInfoPrivate::voltageChanged);
     static const QMetaMethod levelStatusChangedSignal = QMetaMethod::fromSignal(&QBatteryInfoPrivate::levelStatusChanged);
 
-#if !defined(QT_NO_UDEV)
-    if (!uDevWrapper)
-        uDevWrapper = new QUDevWrapper(this);
-    if (!watchChargerType && signal == chargerTypeChangedSignal) {
-        connect(uDevWrapper, SIGNAL(chargerTypeChanged(QByteArray,bool)), this, SLOT(onChargerTypeChanged(QByteArray,bool)));
-    } else if (!watchIsValid && !watchCurrentFlow && !watchVoltage && !watchChargingState && !watchRemainingCapacity
-               && !watchRemainingChargingTime && !watchBatteryCount && !watchLevelStatus) {
-        connect(uDevWrapper, SIGNAL(batteryDataChanged(int,QByteArray,QByteArray)), this, SLOT(onBatteryDataChanged(int,QByteArray,QByteArray)));
+#if !defined(QT_NO_VALUESPACE)
+    // sysinfod does the watching, we only follow what it publishes and whether it runs
+    if (subscriber) {
+        if (!isWatching())
+            updateSource();
+        connect(subscriber, SIGNAL(contentsChanged()), this, SLOT(onValueSpaceChanged()), Qt::UniqueConnection);
+        if (!daemonCheckTimer) {
+            daemonCheckTimer = new QTimer(this);
+            daemonCheckTimer->setInterval(SYSINFOD_CHECK_INTERVAL);
+            connect(daemonCheckTimer, SIGNAL(timeout()), this, SLOT(onDaemonCheck()));
+        }
+        if (daemonRunning)
+            daemonCheckTimer->start();
     }
+#endif // QT_NO_VALUESPACE
+    if (!daemonRunning) {
+#if !defined(QT_NO_UDEV)
+        if (!uDevWrapper)
+            uDevWrapper = new QUDevWrapper(this);
+        if (!watchChargerType && signal == chargerTypeChangedSignal) {
+            connect(uDevWrapper, SIGNAL(chargerTypeChanged(QByteArray,bool)), this, SLOT(onChargerTypeChanged(QByteArray,bool)));
+        } else if (!watchIsValid && !watchCurrentFlow && !watchVoltage && !watchChargingState && !watchRemainingCapacity
+                   && !watchRemainingChargingTime && !watchBatteryCount && !watchLevelStatus) {
+            connect(uDevWrapper, SIGNAL(batteryDataChanged(int,QByteArray,QByteArray)), this, SLOT(onBatteryDataChanged(int,QByteArray,QByteArray)));
+        }
 #else
-    if (timer == 0) {
-       timer = new QTimer;
-       timer->setInterval(2000);
-       connect(timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
-    }
+        if (timer == 0) {
+           timer = new QTimer;
+           timer->setInterval(2000);
+           connect(timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+        }
 
-    if (!timer->isActive())
-       timer->start();
+        if (!timer->isActive())
+           timer->start();
 #endif // QT_NO_UDEV
+    }
 
     if (signal == validChangedSignal) {
         if (!watchIsValid && !watchBatteryCount)
@@ -515,16 +681,21 @@ void QBatteryInfoPrivate::disconnectNotify(const QMetaMethod &signal)
     }
 #endif
 
-    if (!watchBatteryCount && !watchChargerType && !watchChargingState
-            && !watchCurrentFlow && !watchRemainingCapacity
-            && !watchRemainingChargingTime && !watchVoltage && !watchLevelStatus) {
+    if (!isWatching()) {
+#if !defined(QT_NO_VALUESPACE)
+        if (subscriber)
+            disconnect(subscriber, SIGNAL(contentsChanged()), this, SLOT(onValueSpaceChanged()));
+        if (daemonCheckTimer)
+            daemonCheckTimer->stop();
+#endif // QT_NO_VALUESPACE
 #if !defined(QT_NO_UDEV)
         if (uDevWrapper) {
             delete uDevWrapper;
             uDevWrapper = 0;
         }
 #else
-        timer->stop();
+        if (timer)
+            timer->stop();
 #endif // QT_NO_UDEV
     }
 }
@@ -654,6 +825,31 @@ void QBatteryInfoPrivate::onChargerTypeChanged(const QByteArray &value, bool ena
 #else
 
 void QBatteryInfoPrivate::onTimeout()
+{
+    updateWatchedValues();
+}
+
+#endif // QT_NO_UDEV
+
+void QBatteryInfoPrivate::onValueSpaceChanged()
+{
+    updateSource();
+    updateWatchedValues();
+}
+
+/*
+    A killed sysinfod cannot clear its pid, nothing in the value space changes.
+*/
+void QBatteryInfoPrivate::onDaemonCheck()
+{
+    if (updateSource())
+        updateWatchedValues();
+}
+
+/*
+    Samples every watched value again and emits the changes.
+*/
+void QBatteryInfoPrivate::updateWatchedValues()
 {
     int count = getBatteryCount();
     int value;
@@ -739,15 +935,23 @@ void QBatteryInfoPrivate::onTimeout()
     }
 }
 
-#endif // QT_NO_UDEV
-
 int QBatteryInfoPrivate::getBatteryCount()
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(QStringLiteral("count"), 0).toInt();
+#endif // QT_NO_VALUESPACE
+
     return QDir(*POWER_SUPPLY_SYSFS_PATH()).entryList(QStringList() << QStringLiteral("BAT*")).size();
 }
 
 int QBatteryInfoPrivate::getCurrentFlow(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("currentFlow")), 0).toInt();
+#endif // QT_NO_VALUESPACE
+
     QBatteryInfo::ChargingState state = chargingState(battery);
     if (state == QBatteryInfo::UnknownChargingState)
         return 0;
@@ -774,6 +978,11 @@ int QBatteryInfoPrivate::getCurrentFlow(int battery)
 
 int QBatteryInfoPrivate::getRemainingCapacity(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("remainingCapacity")), -1).toInt();
+#endif // QT_NO_VALUESPACE
+
     QFile remaining(BATTERY_SYSFS_PATH()->arg(battery) + QStringLiteral("charge_now"));
     if (!remaining.open(QIODevice::ReadOnly))
         return -1;
@@ -787,6 +996,11 @@ int QBatteryInfoPrivate::getRemainingCapacity(int battery)
 
 int QBatteryInfoPrivate::getRemainingChargingTime(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("remainingChargingTime")), -1).toInt();
+#endif // QT_NO_VALUESPACE
+
     QBatteryInfo::ChargingState state = chargingState(battery);
     if (state == QBatteryInfo::UnknownChargingState)
         return -1;
@@ -815,6 +1029,11 @@ int QBatteryInfoPrivate::getRemainingChargingTime(int battery)
 
 int QBatteryInfoPrivate::getVoltage(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("voltage")), -1).toInt();
+#endif // QT_NO_VALUESPACE
+
     QFile current(BATTERY_SYSFS_PATH()->arg(battery) + QStringLiteral("voltage_now"));
     if (!current.open(QIODevice::ReadOnly))
         return -1;
@@ -828,6 +1047,11 @@ int QBatteryInfoPrivate::getVoltage(int battery)
 
 QBatteryInfo::ChargerType QBatteryInfoPrivate::getChargerType()
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return static_cast<QBatteryInfo::ChargerType>(subscriber->value(QStringLiteral("chargerType"), QBatteryInfo::UnknownCharger).toInt());
+#endif // QT_NO_VALUESPACE
+
     QFile charger(*AC_ONLINE_SYSFS_PATH());
     if (charger.open(QIODevice::ReadOnly)) {
         char online;
@@ -864,6 +1088,11 @@ QBatteryInfo::ChargerType QBatteryInfoPrivate::getChargerType()
 
 QBatteryInfo::ChargingState QBatteryInfoPrivate::getChargingState(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return static_cast<QBatteryInfo::ChargingState>(subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("chargingState")), QBatteryInfo::UnknownChargingState).toInt());
+#endif // QT_NO_VALUESPACE
+
     QFile state(BATTERY_SYSFS_PATH()->arg(battery) + QStringLiteral("status"));
     if (!state.open(QIODevice::ReadOnly))
         return QBatteryInfo::UnknownChargingState;
@@ -883,6 +1112,11 @@ QBatteryInfo::ChargingState QBatteryInfoPrivate::getChargingState(int battery)
 
 QBatteryInfo::LevelStatus QBatteryInfoPrivate::getLevelStatus(int battery)
 {
+#if !defined(QT_NO_VALUESPACE)
+    if (useValueSpace())
+        return static_cast<QBatteryInfo::LevelStatus>(subscriber->value(BATTERY_VALUESPACE_KEY()->arg(battery).arg(QStringLiteral("levelStatus")), QBatteryInfo::LevelUnknown).toInt());
+#endif // QT_NO_VALUESPACE
+
     QFile levelStatusFile(BATTERY_SYSFS_PATH()->arg(battery) + QStringLiteral("capacity_level"));
     if (!levelStatusFile.open(QIODevice::ReadOnly))
         return QBatteryInfo::LevelUnknown;
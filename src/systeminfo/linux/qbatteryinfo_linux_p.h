@@ -60,9 +60,9 @@ QT_BEGIN_NAMESPACE
 
 #if !defined(QT_NO_UDEV)
 class QUDevWrapper;
-#else
-class QTimer;
 #endif // QT_NO_UDEV
+class QTimer;
+class QValueSpaceSubscriber;
 
 class QBatteryInfoPrivate : public QObject
 {
@@ -129,6 +129,8 @@ private Q_SLOTS:
 #else
     void onTimeout();
 #endif // QT_NO_UDEV
+    void onValueSpaceChanged();
+    void onDaemonCheck();
 
 private:
     QBatteryInfo * const q_ptr;
@@ -159,7 +161,19 @@ private:
 #else
     QTimer *timer;
 #endif // QT_NO_UDEV
-
+    QValueSpaceSubscriber *subscriber; // follows what sysinfod publishes
+    QTimer *daemonCheckTimer;
+    bool daemonRunning;
+
+    void connectValueSpace();
+    bool isDaemonRunning() const;
+    bool updateSource();
+    bool useValueSpace();
+    bool isWatching() const;
+    void startSysfsWatch();
+    void stopSysfsWatch();
+
+    void updateWatchedValues();
     int getBatteryCount();
     int getCurrentFlow(int battery);
     int getRemainingCapacity(int battery);
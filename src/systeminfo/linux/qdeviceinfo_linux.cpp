@@ -51,7 +51,9 @@
 #include <QNetworkInfo>
 
 #include <QtCore/qdir.h>
+#include <QtCore/qhash.h>
 #include <QtCore/qmetaobject.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qprocess.h>
 #include <QtCore/qregularexpression.h>
 #include <QtCore/qtextstream.h>
@@ -66,6 +68,11 @@
 #include <QUuid>
 #include <QCryptographicHash>
 
+#if !defined(QT_NO_UDEV)
+#include <libudev.h>
+#include <poll.h>
+#endif // QT_NO_UDEV
+
 #if !defined(QT_NO_DBUS)
 #include <QtDBus/QDBusInterface>
 #include <QtDBus/QDBusReply>
@@ -77,6 +84,155 @@
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Device facts that cannot change while the process runs are looked up once
+    and shared by all QDeviceInfo objects, so that only the first query pays for
+    scanning sysfs and /etc or for running lsb_release. Empty results are kept
+    as well. Features backed by hotpluggable hardware are only cached while a
+    udev monitor can tell when their subsystems change.
+*/
+class QDeviceInfoFactCache
+{
+public:
+    enum Fact {
+        Manufacturer,
+        Model,
+        ProductName,
+        UniqueDeviceID,
+        OsVersion,
+        FirmwareVersion,
+        OperatingSystemName,
+        BoardName,
+        FactCount
+    };
+
+    QDeviceInfoFactCache();
+    ~QDeviceInfoFactCache();
+
+    bool isCacheable(QDeviceInfo::Feature feature) const;
+    void dropHotpluggedFeatures();
+
+    QMutex mutex;
+    QString facts[FactCount];
+    bool knownFacts[FactCount];
+    QHash<int, bool> features;
+
+private:
+    static bool isHotpluggable(QDeviceInfo::Feature feature);
+
+#if !defined(QT_NO_UDEV)
+    struct udev *udev;
+    struct udev_monitor *monitor;
+#endif // QT_NO_UDEV
+};
+
+Q_GLOBAL_STATIC(QDeviceInfoFactCache, deviceFactCache)
+
+QDeviceInfoFactCache::QDeviceInfoFactCache()
+#if !defined(QT_NO_UDEV)
+    : udev(0)
+    , monitor(0)
+#endif // QT_NO_UDEV
+{
+    for (int i = 0; i < FactCount; ++i)
+        knownFacts[i] = false;
+
+#if !defined(QT_NO_UDEV)
+    udev = udev_new();
+    if (udev)
+        monitor = udev_monitor_new_from_netlink(udev, "udev");
+    if (monitor) {
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "usb", NULL);
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "mmc_host", NULL);
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "video4linux", NULL);
+        // Bluetooth and WLAN often come as USB dongles
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "bluetooth", NULL);
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "net", NULL);
+        udev_monitor_filter_add_match_subsystem_devtype(monitor, "ieee80211", NULL);
+        if (udev_monitor_enable_receiving(monitor) < 0) {
+            udev_monitor_unref(monitor);
+            monitor = 0;
+        }
+    }
+#endif // QT_NO_UDEV
+}
+
+QDeviceInfoFactCache::~QDeviceInfoFactCache()
+{
+#if !defined(QT_NO_UDEV)
+    if (monitor)
+        udev_monitor_unref(monitor);
+    if (udev)
+        udev_unref(udev);
+#endif // QT_NO_UDEV
+}
+
+bool QDeviceInfoFactCache::isHotpluggable(QDeviceInfo::Feature feature)
+{
+    switch (feature) {
+    case QDeviceInfo::BluetoothFeature:
+    case QDeviceInfo::UsbFeature:
+    case QDeviceInfo::MemoryCardFeature:
+    case QDeviceInfo::CameraFeature:
+    case QDeviceInfo::FmRadioFeature:
+    case QDeviceInfo::FmTransmitterFeature:
+    case QDeviceInfo::VideoOutFeature:
+    case QDeviceInfo::WlanFeature:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool QDeviceInfoFactCache::isCacheable(QDeviceInfo::Feature feature) const
+{
+    // SIM availability follows the modems oFono reports
+    if (feature == QDeviceInfo::SimFeature)
+        return false;
+
+    if (!isHotpluggable(feature))
+        return true;
+
+#if !defined(QT_NO_UDEV)
+    return monitor != 0;
+#else
+    return false;
+#endif // QT_NO_UDEV
+}
+
+void QDeviceInfoFactCache::dropHotpluggedFeatures()
+{
+#if !defined(QT_NO_UDEV)
+    if (!monitor)
+        return;
+
+    // Anything pending on the monitor, including an overrun, means that a
+    // device came or went since the features were last looked up.
+    bool changed = false;
+    struct pollfd fds;
+    fds.fd = udev_monitor_get_fd(monitor);
+    fds.events = POLLIN;
+    while (poll(&fds, 1, 0) > 0) {
+        changed = true;
+        struct udev_device *device = udev_monitor_receive_device(monitor);
+        if (!device)
+            break;
+        udev_device_unref(device);
+    }
+
+    if (!changed)
+        return;
+
+    QHash<int, bool>::iterator it = features.begin();
+    while (it != features.end()) {
+        if (isHotpluggable(static_cast<QDeviceInfo::Feature>(it.key())))
+            it = features.erase(it);
+        else
+            ++it;
+    }
+#endif // QT_NO_UDEV
+}
+
 QDeviceInfoPrivate::QDeviceInfoPrivate(QDeviceInfo *parent)
     : QObject(parent)
 #if !defined(QT_SIMULATOR)
@@ -84,10 +240,7 @@ QDeviceInfoPrivate::QDeviceInfoPrivate(QDeviceInfo *parent)
 #endif // QT_SIMULATOR
     , watchThermalState(false)
     , imeiBuffer(QStringList())
-    , uniqueDeviceIDBuffer(QString())
     , timer(0)
-    , boardNameString(QString())
-    , osName(QString())
 #if !defined(QT_NO_OFONO)
         , ofonoWrapper(0)
 #endif // QT_NO_OFONO
@@ -97,6 +250,29 @@ QDeviceInfoPrivate::QDeviceInfoPrivate(QDeviceInfo *parent)
 }
 
 bool QDeviceInfoPrivate::hasFeature(QDeviceInfo::Feature feature)
+{
+    QDeviceInfoFactCache *cache = deviceFactCache();
+    if (!cache->isCacheable(feature))
+        return probeFeature(feature);
+
+    QMutexLocker locker(&cache->mutex);
+    cache->dropHotpluggedFeatures();
+    QHash<int, bool>::const_iterator it = cache->features.constFind(feature);
+    if (it != cache->features.constEnd())
+        return it.value();
+
+    // probe without the lock, another thread may find the same value meanwhile
+    locker.unlock();
+    const bool available = probeFeature(feature);
+    locker.relock();
+    it = cache->features.constFind(feature);
+    if (it != cache->features.constEnd())
+        return it.value();
+    cache->features.insert(feature, available);
+    return available;
+}
+
+bool QDeviceInfoPrivate::probeFeature(QDeviceInfo::Feature feature)
 {
     switch (feature) {
     case QDeviceInfo::BluetoothFeature:
@@ -277,21 +453,107 @@ QString QDeviceInfoPrivate::imei(int interfaceNumber)
 
 QString QDeviceInfoPrivate::manufacturer()
 {
-#if defined(QT_USE_SSU)
-    if (manufacturerBuffer.isEmpty()) {
-        manufacturerBuffer = SsuDeviceInfo().displayName(Ssu::DeviceManufacturer);
+    return cachedFact(QDeviceInfoFactCache::Manufacturer);
+}
+
+QString QDeviceInfoPrivate::model()
+{
+    return cachedFact(QDeviceInfoFactCache::Model);
+}
+
+QString QDeviceInfoPrivate::productName()
+{
+    return cachedFact(QDeviceInfoFactCache::ProductName);
+}
+
+QString QDeviceInfoPrivate::uniqueDeviceID()
+{
+    return cachedFact(QDeviceInfoFactCache::UniqueDeviceID);
+}
+
+QString QDeviceInfoPrivate::version(QDeviceInfo::Version type)
+{
+    switch (type) {
+    case QDeviceInfo::Os:
+        return cachedFact(QDeviceInfoFactCache::OsVersion);
+    case QDeviceInfo::Firmware:
+        return cachedFact(QDeviceInfoFactCache::FirmwareVersion);
     }
+
+    return QString();
+}
+
+QString QDeviceInfoPrivate::operatingSystemName()
+{
+    return cachedFact(QDeviceInfoFactCache::OperatingSystemName);
+}
+
+QString QDeviceInfoPrivate::boardName()
+{
+    return cachedFact(QDeviceInfoFactCache::BoardName);
+}
+
+QString QDeviceInfoPrivate::cachedFact(int fact)
+{
+    QDeviceInfoFactCache *cache = deviceFactCache();
+    QMutexLocker locker(&cache->mutex);
+    if (cache->knownFacts[fact])
+        return cache->facts[fact];
+
+    // reading a fact may run lsb_release, other QDeviceInfo users must not wait on that
+    locker.unlock();
+    QString value;
+    switch (fact) {
+    case QDeviceInfoFactCache::Manufacturer:
+        value = readManufacturer();
+        break;
+    case QDeviceInfoFactCache::Model:
+        value = readModel();
+        break;
+    case QDeviceInfoFactCache::ProductName:
+        value = readProductName();
+        break;
+    case QDeviceInfoFactCache::UniqueDeviceID:
+        value = readUniqueDeviceID();
+        break;
+    case QDeviceInfoFactCache::OsVersion:
+        value = readVersion(QDeviceInfo::Os);
+        break;
+    case QDeviceInfoFactCache::FirmwareVersion:
+        value = readVersion(QDeviceInfo::Firmware);
+        break;
+    case QDeviceInfoFactCache::OperatingSystemName:
+        value = readOperatingSystemName();
+        break;
+    case QDeviceInfoFactCache::BoardName:
+        value = readBoardName();
+        break;
+    }
+
+    locker.relock();
+    if (cache->knownFacts[fact])
+        return cache->facts[fact];
+    cache->facts[fact] = value;
+    cache->knownFacts[fact] = true;
+    return value;
+}
+
+QString QDeviceInfoPrivate::readManufacturer()
+{
+    QString value;
+#if defined(QT_USE_SSU)
+    value = SsuDeviceInfo().displayName(Ssu::DeviceManufacturer);
 #endif
-    if (manufacturerBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         // for dmi enabled kernels
         QFile file(QStringLiteral("/sys/devices/virtual/dmi/id/sys_vendor"));
         if (file.open(QIODevice::ReadOnly))
-            manufacturerBuffer = QString::fromLocal8Bit(file.readAll().simplified().data());
+            value = QString::fromLocal8Bit(file.readAll().simplified().data());
     }
-    if (manufacturerBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QStringList releaseFies = QDir(QStringLiteral("/etc/")).entryList(QStringList() << QStringLiteral("*-release"));
         foreach (const QString &file, releaseFies) {
-            if (!manufacturerBuffer.isEmpty())
+            if (!value.isEmpty())
                 continue;
             QFile release(QStringLiteral("/etc/") + file);
             if (release.open(QIODevice::ReadOnly))  {
@@ -301,7 +563,7 @@ QString QDeviceInfoPrivate::manufacturer()
                     line = stream.readLine();
                     //                 this seems to be mer specific
                     if (line.startsWith(QStringLiteral("BUILD"))) {
-                      manufacturerBuffer = line.split(QStringLiteral(":")).at(1).simplified().split(QStringLiteral("-")).at(0);
+                      value = line.split(QStringLiteral(":")).at(1).simplified().split(QStringLiteral("-")).at(0);
                       break;
                     }
                 } while (!line.isNull());
@@ -309,32 +571,31 @@ QString QDeviceInfoPrivate::manufacturer()
             }
         }
     }
-    if (manufacturerBuffer.isEmpty()) {
-        manufacturerBuffer = findInRelease(QStringLiteral("BUILD"));
+    if (value.isEmpty()) {
+        value = findInRelease(QStringLiteral("BUILD"));
     }
-    return manufacturerBuffer;
+    return value;
 }
 
-QString QDeviceInfoPrivate::model()
+QString QDeviceInfoPrivate::readModel()
 {
+    QString value;
 #if defined(QT_USE_SSU)
-    if (modelBuffer.isEmpty()) {
-        modelBuffer = SsuDeviceInfo().displayName(Ssu::DeviceModel);
-    }
+    value = SsuDeviceInfo().displayName(Ssu::DeviceModel);
 #endif
-    if (modelBuffer.isEmpty()) {
-        modelBuffer = findInRelease(QStringLiteral("NAME"),QStringLiteral("hw-release"));
+    if (value.isEmpty()) {
+        value = findInRelease(QStringLiteral("NAME"),QStringLiteral("hw-release"));
     }
     // for dmi enabled kernels
-    if (modelBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QFile file(QStringLiteral("/sys/devices/virtual/dmi/id/product_name"));
         if (file.open(QIODevice::ReadOnly))
-            modelBuffer = QString::fromLocal8Bit(file.readAll().simplified().data());
+            value = QString::fromLocal8Bit(file.readAll().simplified().data());
     }
-    if (modelBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QStringList releaseFies = QDir(QStringLiteral("/etc/")).entryList(QStringList() << QStringLiteral("*-release"));
         foreach (const QString &file, releaseFies) {
-            if (!modelBuffer.isEmpty())
+            if (!value.isEmpty())
                 continue;
             QFile release(QStringLiteral("/etc/") + file);
             if (release.open(QIODevice::ReadOnly))  {
@@ -344,7 +605,7 @@ QString QDeviceInfoPrivate::model()
                     line = stream.readLine();
                     //                 this seems to be mer specific
                     if (line.startsWith(QStringLiteral("BUILD"))) {
-                        modelBuffer = line.split(QStringLiteral(":")).at(1).split(QStringLiteral("-")).at(3);
+                        value = line.split(QStringLiteral(":")).at(1).split(QStringLiteral("-")).at(3);
                         break;
                     }
                 } while (!line.isNull());
@@ -352,64 +613,60 @@ QString QDeviceInfoPrivate::model()
             }
         }
     }
-    return modelBuffer;
+    return value;
 }
 
-QString QDeviceInfoPrivate::productName()
+QString QDeviceInfoPrivate::readProductName()
 {
+    QString value;
 #if defined(QT_USE_SSU)
-    if (productNameBuffer.isEmpty()) {
-        productNameBuffer = SsuDeviceInfo().displayName(Ssu::DeviceDesignation);
-    }
+    value = SsuDeviceInfo().displayName(Ssu::DeviceDesignation);
 #endif
 
-    if (productNameBuffer.isEmpty()) {
-        productNameBuffer = findInRelease(QStringLiteral("PRETTY_NAME")).remove(QStringLiteral("\""));
+    if (value.isEmpty()) {
+        value = findInRelease(QStringLiteral("PRETTY_NAME")).remove(QStringLiteral("\""));
     }
 
-    if (productNameBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QProcess lsbRelease;
         lsbRelease.start(QStringLiteral("/usr/bin/lsb_release"),
                          QStringList() << QStringLiteral("-c"));
         if (lsbRelease.waitForFinished()) {
             QString buffer(QString::fromLocal8Bit(lsbRelease.readAllStandardOutput().constData()));
-            productNameBuffer = buffer.section(QChar::fromLatin1('\t'), 1, 1).simplified();
+            value = buffer.section(QChar::fromLatin1('\t'), 1, 1).simplified();
         }
     }
 
-    return productNameBuffer;
+    return value;
 }
 
-QString QDeviceInfoPrivate::uniqueDeviceID()
+QString QDeviceInfoPrivate::readUniqueDeviceID()
 {
-    if (uniqueDeviceIDBuffer.isEmpty()) {
-        // for dmi enabled kernels
-        QFile file(QStringLiteral("/sys/devices/virtual/dmi/id/product_uuid"));
-        if (file.open(QIODevice::ReadOnly)) {
-            QString id = QString::fromLocal8Bit(file.readAll().simplified().data());
-            if (id.length() == 36) {
-                if (isUuid(id)) {
-                    uniqueDeviceIDBuffer = id;
-                }
-            }
-        }
+    QString value;
+
+    // for dmi enabled kernels
+    QFile dmiFile(QStringLiteral("/sys/devices/virtual/dmi/id/product_uuid"));
+    if (dmiFile.open(QIODevice::ReadOnly)) {
+        QString id = QString::fromLocal8Bit(dmiFile.readAll().simplified().data());
+        if (id.length() == 36 && isUuid(id))
+            value = id;
     }
 
-    if (uniqueDeviceIDBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QFile file(QStringLiteral("/etc/unique-id"));
         if (file.open(QIODevice::ReadOnly)) {
             QString id = QString::fromLocal8Bit(file.readAll().simplified().data());
             if (id.length() == 32) {
                 id = id.insert(8,'-').insert(13,'-').insert(18,'-').insert(23,'-');
                 if (isUuid(id)) {
-                    uniqueDeviceIDBuffer = id;
+                    value = id;
                 }
                 file.close();
             }
         }
     }
 
-    if (uniqueDeviceIDBuffer.isEmpty()) { //try wifi mac address
+    if (value.isEmpty()) { //try wifi mac address
         QNetworkInfo netinfo;
         QString macaddy;
         macaddy = netinfo.macAddress(QNetworkInfo::WlanMode,0);
@@ -421,17 +678,17 @@ QString QDeviceInfoPrivate::uniqueDeviceID()
 
             QUuid id = QUuid::fromRfc4122(hash2.result().left(16));
             if (!id.isNull())
-                uniqueDeviceIDBuffer = id.toString();
+                value = id.toString();
         }
     }
-    if (uniqueDeviceIDBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QFile file(QStringLiteral("/etc/machine-id"));
         if (file.open(QIODevice::ReadOnly)) {
             QString id = QString::fromLocal8Bit(file.readAll().simplified().data());
             if (id.length() == 32) {
                 id = id.insert(8,'-').insert(13,'-').insert(18,'-').insert(23,'-');
                 if (isUuid(id)) {
-                    uniqueDeviceIDBuffer = id;
+                    value = id;
                 }
             }
             file.close();
@@ -439,7 +696,7 @@ QString QDeviceInfoPrivate::uniqueDeviceID()
     }
 
 //last ditch effort
-    if (uniqueDeviceIDBuffer.isEmpty()) {
+    if (value.isEmpty()) {
         QFile file(QStringLiteral("/var/lib/dbus/machine-id"));
 
         if (file.open(QIODevice::ReadOnly)) {
@@ -447,7 +704,7 @@ QString QDeviceInfoPrivate::uniqueDeviceID()
             if (id.length() == 32) {
                 id = id.insert(8,'-').insert(13,'-').insert(18,'-').insert(23,'-');
                 if (isUuid(id)) {
-                    uniqueDeviceIDBuffer = id;
+                    value = id;
                 }
             }
             file.close();
@@ -455,7 +712,7 @@ QString QDeviceInfoPrivate::uniqueDeviceID()
     }
 
 
-    return uniqueDeviceIDBuffer;
+    return value;
 }
 
 bool QDeviceInfoPrivate::isUuid(const QString &id)
@@ -464,79 +721,73 @@ bool QDeviceInfoPrivate::isUuid(const QString &id)
     return !uid.isNull();
 }
 
-QString QDeviceInfoPrivate::version(QDeviceInfo::Version type)
+QString QDeviceInfoPrivate::readVersion(QDeviceInfo::Version type)
 {
+    QString value;
+
     switch (type) {
     case QDeviceInfo::Os:
+        value = findInRelease(QStringLiteral("VERSION_ID"),
+                              QStringLiteral("os-release"));
 
-        if (versionBuffer[0].isEmpty()) {
-            versionBuffer[0] = findInRelease(QStringLiteral("VERSION_ID"),
-                                             QStringLiteral("os-release"));
+        if (value.isEmpty()) {
+            value = findInRelease(QStringLiteral("VERSION_ID"));
         }
 
-        if (versionBuffer[0].isEmpty()) {
-            versionBuffer[0] = findInRelease(QStringLiteral("VERSION_ID"));
-        }
-
-        if (versionBuffer[0].isEmpty() && QFile::exists(QStringLiteral("/usr/bin/lsb_release"))) {
+        if (value.isEmpty() && QFile::exists(QStringLiteral("/usr/bin/lsb_release"))) {
             QProcess lsbRelease;
             lsbRelease.start(QStringLiteral("/usr/bin/lsb_release"),
                              QStringList() << QStringLiteral("-r"));
             if (lsbRelease.waitForFinished()) {
                 QString buffer(QString::fromLocal8Bit(lsbRelease.readAllStandardOutput().constData()));
-                versionBuffer[0] = buffer.section(QChar::fromLatin1('\t'), 1, 1).simplified();
+                value = buffer.section(QChar::fromLatin1('\t'), 1, 1).simplified();
             }
         }
 
-        return versionBuffer[0];
+        return value;
 
     case QDeviceInfo::Firmware:
         // Try to read hardware adaptation version first.
-        if (versionBuffer[1].isEmpty()) {
-            versionBuffer[1] = findInRelease(QStringLiteral("VERSION_ID"),
-                                             QStringLiteral("hw-release"));
-        }
+        value = findInRelease(QStringLiteral("VERSION_ID"),
+                              QStringLiteral("hw-release"));
 
-        if (versionBuffer[1].isEmpty()) {
+        if (value.isEmpty()) {
             QFile file(QStringLiteral("/proc/sys/kernel/osrelease"));
             if (file.open(QIODevice::ReadOnly)) {
-                versionBuffer[1] = QString::fromLocal8Bit(file.readAll().simplified().data());
+                value = QString::fromLocal8Bit(file.readAll().simplified().data());
                 file.close();
             }
         }
-        return versionBuffer[1];
+        return value;
     }
 
     return QString();
 }
 
-QString QDeviceInfoPrivate::operatingSystemName()
+QString QDeviceInfoPrivate::readOperatingSystemName()
 {
-    if (osName.isEmpty()) {
-        osName = findInRelease(QStringLiteral("NAME="), QStringLiteral("os-release"));
-    }
-    if (osName.isEmpty()) {
-        osName = findInRelease(QStringLiteral("NAME="));
-    }
+    QString value = findInRelease(QStringLiteral("NAME="), QStringLiteral("os-release"));
+    if (value.isEmpty())
+        value = findInRelease(QStringLiteral("NAME="));
 
-    return osName;
+    return value;
 }
 
-QString QDeviceInfoPrivate::boardName()
+QString QDeviceInfoPrivate::readBoardName()
 {
-    if (boardNameString.isEmpty()) {
-        QFile boardfile(QStringLiteral("/etc/boardname"));
-        if (boardfile.open(QIODevice::ReadOnly))
-            boardNameString = QString::fromLocal8Bit(boardfile.readAll().simplified().data());
-    }
+    QString value;
+
+    QFile boardfile(QStringLiteral("/etc/boardname"));
+    if (boardfile.open(QIODevice::ReadOnly))
+        value = QString::fromLocal8Bit(boardfile.readAll().simplified().data());
 
-    if (boardNameString.isEmpty()) {
+    if (value.isEmpty()) {
         // for dmi enabled kernels
         QFile file(QStringLiteral("/sys/devices/virtual/dmi/id/board_name"));
         if (file.open(QIODevice::ReadOnly))
-            boardNameString = QString::fromLocal8Bit(file.readAll().simplified().data());
+            value = QString::fromLocal8Bit(file.readAll().simplified().data());
     }
-    return boardNameString;
+    return value;
 }
 
 QString QDeviceInfoPrivate::findInRelease(const QString &searchTerm, const QString &file)
@@ -111,18 +111,21 @@ private:
 
     bool watchThermalState;
     QDeviceInfo::ThermalState currentThermalState;
-    QString manufacturerBuffer;
-    QString modelBuffer;
     QStringList imeiBuffer;
-    QString productNameBuffer;
-    QString uniqueDeviceIDBuffer;
-    QString versionBuffer[2];
     QTimer *timer;
-    QString boardNameString;
-    QString osName;
 
     QDeviceInfo::ThermalState getThermalState();
 
+    bool probeFeature(QDeviceInfo::Feature feature);
+    QString cachedFact(int fact);
+    QString readManufacturer();
+    QString readModel();
+    QString readProductName();
+    QString readUniqueDeviceID();
+    QString readVersion(QDeviceInfo::Version type);
+    QString readOperatingSystemName();
+    QString readBoardName();
+
 #if !defined(QT_NO_OFONO)
     QOfonoWrapper *ofonoWrapper;
 #endif // QT_NO_OFONO
@@ -41,15 +41,136 @@
 #include "qinputinfomanagerudev_p.h"
 
 #include <libudev.h>
-#ifndef QT_NO_EVDEV
-#include <libevdev/libevdev.h>
-#endif
+#include <linux/input.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include <QDebug>
 #include <QDir>
 #include <QSocketNotifier>
 #include <QTimer>
 
+#define QT_EVDEV_BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define QT_EVDEV_NLONGS(x) (((x) + QT_EVDEV_BITS_PER_LONG - 1) / QT_EVDEV_BITS_PER_LONG)
+
+struct QEvdevCapabilities
+{
+    QBitArray events;
+    QBitArray keys;
+    QBitArray relativeAxes;
+    QBitArray absoluteAxes;
+    QBitArray switches;
+};
+
+static inline bool hasCode(const QBitArray &bits, int code)
+{
+    return code < bits.size() && bits.testBit(code);
+}
+
+static bool hasAnyCode(const QBitArray &bits, int first, int last)
+{
+    for (int code = first; code <= last && code < bits.size(); code++) {
+        if (bits.testBit(code))
+            return true;
+    }
+    return false;
+}
+
+/*
+    Returns the EVIOCGBIT bitmap of the codes of event \a type that the
+    device open on \a fd can report.
+ */
+static QBitArray readEventBits(int fd, int type, int maxCode)
+{
+    unsigned long words[QT_EVDEV_NLONGS(KEY_CNT)];
+    memset(words, 0, sizeof(words));
+
+    QBitArray bits;
+    int bytes = ioctl(fd, EVIOCGBIT(type, sizeof(words)), words);
+    if (bytes <= 0)
+        return bits;
+
+    bits.resize(qMin(maxCode + 1, bytes * 8));
+    for (int code = 0; code < bits.size(); code++) {
+        if (words[code / QT_EVDEV_BITS_PER_LONG] & (1UL << (code % QT_EVDEV_BITS_PER_LONG)))
+            bits.setBit(code);
+    }
+
+    // the device keeps these, so drop the unused tail of the KEY_MAX sized map
+    int size = bits.size();
+    while (size > 0 && !bits.testBit(size - 1))
+        size--;
+    bits.truncate(size);
+    return bits;
+}
+
+/*
+    Reads all capability bitmaps of the event node \a path, opening it once.
+ */
+static bool readCapabilities(const QString &path, QEvdevCapabilities *caps)
+{
+    int fd = open(path.toLatin1(), O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    caps->events = readEventBits(fd, 0, EV_MAX);
+    if (hasCode(caps->events, EV_KEY))
+        caps->keys = readEventBits(fd, EV_KEY, KEY_MAX);
+    if (hasCode(caps->events, EV_REL))
+        caps->relativeAxes = readEventBits(fd, EV_REL, REL_MAX);
+    if (hasCode(caps->events, EV_ABS))
+        caps->absoluteAxes = readEventBits(fd, EV_ABS, ABS_MAX);
+    if (hasCode(caps->events, EV_SW))
+        caps->switches = readEventBits(fd, EV_SW, SW_MAX);
+
+    close(fd);
+    return !caps->events.isEmpty();
+}
+
+/*
+    Classifies a device from its capability bitmaps, along the lines of the
+    udev input_id builtin that sets the ID_INPUT_* properties.
+ */
+static QInputDevice::InputTypeFlags typesFromCapabilities(const QEvdevCapabilities &caps)
+{
+    QInputDevice::InputTypeFlags flags = QInputDevice::UnknownType;
+
+    // any keyboard key or any key past the button ranges
+    if (hasAnyCode(caps.keys, KEY_ESC, BTN_MISC - 1) || hasAnyCode(caps.keys, KEY_OK, KEY_MAX))
+        flags |= QInputDevice::Button;
+
+    // like udev, all of the first 31 codes (KEY_ESC up to KEY_S, the digits
+    // and the top letter row) tell a keyboard from a few media keys
+    bool keyboard = true;
+    for (int code = KEY_ESC; code <= KEY_S && keyboard; code++)
+        keyboard = hasCode(caps.keys, code);
+    if (keyboard)
+        flags |= QInputDevice::Keyboard;
+
+    if (hasCode(caps.relativeAxes, REL_X) && hasCode(caps.relativeAxes, REL_Y)
+            && hasCode(caps.keys, BTN_MOUSE)) {
+        flags |= QInputDevice::Mouse;
+    }
+
+    if ((hasCode(caps.absoluteAxes, ABS_X) && hasCode(caps.absoluteAxes, ABS_Y))
+            || (hasCode(caps.absoluteAxes, ABS_MT_POSITION_X) && hasCode(caps.absoluteAxes, ABS_MT_POSITION_Y))) {
+        if (hasCode(caps.keys, BTN_TOOL_PEN) || hasCode(caps.keys, BTN_STYLUS))
+            flags |= QInputDevice::TouchScreen; // tablet
+        else if (hasCode(caps.keys, BTN_TOOL_FINGER))
+            flags |= QInputDevice::TouchPad;
+        else if (hasCode(caps.keys, BTN_TOUCH))
+            flags |= QInputDevice::TouchScreen;
+        else if (hasCode(caps.keys, BTN_MOUSE))
+            flags |= QInputDevice::Mouse; // absolute pointer, e.g. in a virtual machine
+    }
+
+    if (caps.switches.count(true) > 0)
+        flags |= QInputDevice::Switch;
+
+    return flags;
+}
+
 QInputInfoManagerUdev::QInputInfoManagerUdev(QObject *parent) :
     QInputInfoManagerPrivate(parent),
     udevice(0)
@@ -151,51 +272,7 @@ QInputDevice *QInputInfoManagerUdev::addDevice(struct udev_device *udev)
     if (deviceMap.contains(eventPath)) {
         return Q_NULLPTR;
     }
-    QInputDevice *inputDevice;
-    inputDevice = addUdevDevice(udev);
-    if (!inputDevice) {
-        return Q_NULLPTR;
-    }
-    eventPath = inputDevice->identifier();
-
-    int fd = open(eventPath.toLatin1(), O_RDONLY|O_NONBLOCK);
-    if (fd == -1) {
-        return inputDevice;
-    }
-#ifndef QT_NO_EVDEV
-    struct libevdev *dev = NULL;
-    int rc = 1;
-    rc = libevdev_new_from_fd(fd, &dev);
-    if (rc < 0) {
-        qWarning() << "Failed to init libevdev ("<< strerror(-rc) << ")";
-        return Q_NULLPTR;
-    }
-
-    for (int i = 0; i < EV_MAX; i++) {
-        if (i == EV_KEY || i == EV_SW || i == EV_REL
-                || i == EV_REL || i == EV_ABS) {
-            for (int j = 0; j <  libevdev_event_type_get_max(i); j++) {
-                if (libevdev_has_event_code(dev, i, j)) {
-                    switch (i) {
-                    case EV_KEY:
-                        inputDevice->addButton(j);
-                        break;
-                    case EV_SW:
-                        inputDevice->addSwitch(j);
-                        break;
-                    case EV_REL:
-                        inputDevice->addRelativeAxis(j);
-                        break;
-                    case EV_ABS:
-                        inputDevice->addAbsoluteAxis(j);
-                        break;
-                    };
-                }
-            }
-        }
-    }
-#endif
-    return inputDevice;
+    return addUdevDevice(udev);
 }
 
 void QInputInfoManagerUdev::addDetails(struct udev_device *)
@@ -245,7 +322,19 @@ QInputDevice *QInputInfoManagerUdev::addUdevDevice(struct udev_device *udev)
             iDevice->setName(value.remove(QStringLiteral("\"")));
         }
     }
-    iDevice->setTypes(getInputTypeFlags(udev));
+
+    // the bitmaps give both the type and the capabilities, the udev properties
+    // are only a fallback for event nodes we are not allowed to open
+    QEvdevCapabilities caps;
+    if (readCapabilities(iDevice->identifier(), &caps)) {
+        iDevice->d_ptr->buttons = caps.keys;
+        iDevice->d_ptr->switches = caps.switches;
+        iDevice->d_ptr->relativeAxes = caps.relativeAxes;
+        iDevice->d_ptr->absoluteAxes = caps.absoluteAxes;
+        iDevice->setTypes(typesFromCapabilities(caps));
+    } else {
+        iDevice->setTypes(getInputTypeFlags(udev));
+    }
     return iDevice;
 }
 
@@ -276,7 +365,6 @@ void QInputInfoManagerUdev::onUDevChanges()
                     delete iDevice;
                     return;
                 }
-                iDevice->setTypes(getInputTypeFlags(dev));
                 udev_device_unref(dev);
                 deviceMap.insert(eventPath,iDevice);
                 Q_EMIT deviceAdded(deviceMap.value(eventPath));
@@ -97,6 +97,11 @@ QT_BEGIN_NAMESPACE
     you are strongly suggested to disconnect the signals when no longer needed in your application.
 
     Battery index starts at \c 0, which indicates the first battery.
+
+    On Linux, when Qt System Info is configured with \c valuespace and the
+    \c sysinfod daemon is running, the battery state is read from the values
+    the daemon publishes under \c /SystemInfo/Battery instead of being sampled
+    by every application.
 */
 
 /*!
@@ -109,12 +109,55 @@ QInputInfoManagerPrivate * QInputInfoManagerPrivate::instance()
 */
 QInputDevicePrivate::QInputDevicePrivate(QObject *parent) :
     QObject(parent),
+    codeListsValid(false),
     type(QInputDevice::UnknownType)
 {
     qRegisterMetaType<QInputDevice::InputType>();
     qRegisterMetaType<QInputDevice::InputTypeFlags>();
 }
 
+/*!
+    \internal
+*/
+void QInputDevicePrivate::setCode(QBitArray *bits, int code)
+{
+    if (code < 0)
+        return;
+    if (code >= bits->size())
+        bits->resize(code + 1);
+    bits->setBit(code);
+}
+
+/*!
+    \internal
+*/
+QList <int> QInputDevicePrivate::codes(const QBitArray &bits)
+{
+    QList <int> list;
+    for (int i = 0; i < bits.size(); i++) {
+        if (bits.testBit(i))
+            list.append(i);
+    }
+    return list;
+}
+
+/*!
+    \internal
+
+    Devices are enumerated far more often than their capabilities are looked
+    at, so the code lists are only built on first access.
+*/
+void QInputDevicePrivate::ensureCodeLists()
+{
+    if (codeListsValid)
+        return;
+    buttonCodes = codes(buttons);
+    switchCodes = codes(switches);
+    relativeAxisCodes = codes(relativeAxes);
+    absoluteAxisCodes = codes(absoluteAxes);
+    codeListsValid = true;
+}
+
 
 /*!
     \class QInputDevice
@@ -157,7 +200,19 @@ QInputDevice::QInputDevice(QObject *parent) :
 */
 QVariantMap QInputDevice::properties()
 {
-    return deviceProperties;
+    QVariantMap map = deviceProperties;
+
+    d_ptr->ensureCodeLists();
+    if (!d_ptr->buttonCodes.isEmpty())
+        map.insert(QStringLiteral("buttons"),QVariant::fromValue(d_ptr->buttonCodes));
+    if (!d_ptr->switchCodes.isEmpty())
+        map.insert(QStringLiteral("switches"),QVariant::fromValue(d_ptr->switchCodes));
+    if (!d_ptr->relativeAxisCodes.isEmpty())
+        map.insert(QStringLiteral("rAxis"),QVariant::fromValue(d_ptr->relativeAxisCodes));
+    if (!d_ptr->absoluteAxisCodes.isEmpty())
+        map.insert(QStringLiteral("aAxis"),QVariant::fromValue(d_ptr->absoluteAxisCodes));
+
+    return map;
 }
 
 /*
@@ -199,7 +254,8 @@ void QInputDevice::setIdentifier(const QString &id)
  */
 QList <int> QInputDevice::buttons() const
 {
-    return d_ptr->buttons;
+    d_ptr->ensureCodeLists();
+    return d_ptr->buttonCodes;
 }
 
 /*
@@ -207,8 +263,8 @@ QList <int> QInputDevice::buttons() const
  */
 void QInputDevice::addButton(int buttonCode)
 {
-    d_ptr->buttons.append(buttonCode);
-    deviceProperties.insert(QStringLiteral("buttons"),QVariant::fromValue(d_ptr->buttons));
+    QInputDevicePrivate::setCode(&d_ptr->buttons, buttonCode);
+    d_ptr->codeListsValid = false;
 }
 
 /*
@@ -216,7 +272,8 @@ void QInputDevice::addButton(int buttonCode)
  */
 QList <int> QInputDevice::switches() const
 {
-    return d_ptr->switches;
+    d_ptr->ensureCodeLists();
+    return d_ptr->switchCodes;
 }
 
 /*
@@ -224,8 +281,8 @@ QList <int> QInputDevice::switches() const
  */
 void QInputDevice::addSwitch(int switchCode)
 {
-    d_ptr->switches.append(switchCode);
-    deviceProperties.insert(QStringLiteral("switches"),QVariant::fromValue(d_ptr->switches));
+    QInputDevicePrivate::setCode(&d_ptr->switches, switchCode);
+    d_ptr->codeListsValid = false;
 }
 
 /*
@@ -233,7 +290,8 @@ void QInputDevice::addSwitch(int switchCode)
  */
 QList <int> QInputDevice::relativeAxes() const
 {
-    return d_ptr->relativeAxes;
+    d_ptr->ensureCodeLists();
+    return d_ptr->relativeAxisCodes;
 }
 
 /*
@@ -241,8 +299,8 @@ QList <int> QInputDevice::relativeAxes() const
  */
 void QInputDevice::addRelativeAxis(int axisCode)
 {
-    d_ptr->relativeAxes.append(axisCode);
-    deviceProperties.insert(QStringLiteral("rAxis"),QVariant::fromValue(d_ptr->relativeAxes));
+    QInputDevicePrivate::setCode(&d_ptr->relativeAxes, axisCode);
+    d_ptr->codeListsValid = false;
 }
 
 /*
@@ -250,7 +308,8 @@ void QInputDevice::addRelativeAxis(int axisCode)
  */
 QList <int> QInputDevice::absoluteAxes() const
 {
-    return d_ptr->absoluteAxes;
+    d_ptr->ensureCodeLists();
+    return d_ptr->absoluteAxisCodes;
 }
 
 /*
@@ -258,8 +317,8 @@ QList <int> QInputDevice::absoluteAxes() const
  */
 void QInputDevice::addAbsoluteAxis(int axisCode)
 {
-    d_ptr->absoluteAxes.append(axisCode);
-    deviceProperties.insert(QStringLiteral("aAxis"),QVariant::fromValue(d_ptr->absoluteAxes));
+    QInputDevicePrivate::setCode(&d_ptr->absoluteAxes, axisCode);
+    d_ptr->codeListsValid = false;
 }
 
 /*
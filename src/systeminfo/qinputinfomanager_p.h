@@ -41,6 +41,7 @@
 #define QINPUTDEVICEINFO_LINUX_P_H
 
 #include <QObject>
+#include <QBitArray>
 #include "qinputinfo.h"
 
 QT_BEGIN_NAMESPACE
@@ -51,12 +52,23 @@ class QInputDevicePrivate : public QObject
 public:
     explicit QInputDevicePrivate(QObject *parent = 0);
 
+    static void setCode(QBitArray *bits, int code);
+    static QList <int> codes(const QBitArray &bits);
+    void ensureCodeLists();
+
     QString name;
     QString identifier;
-    QList <int> buttons; //keys
-    QList <int> switches;
-    QList <int> relativeAxes;
-    QList <int> absoluteAxes;
+    // one bit per event code, as evdev reports them
+    QBitArray buttons; //keys
+    QBitArray switches;
+    QBitArray relativeAxes;
+    QBitArray absoluteAxes;
+    // built from the bits the first time they are asked for
+    QList <int> buttonCodes;
+    QList <int> switchCodes;
+    QList <int> relativeAxisCodes;
+    QList <int> absoluteAxisCodes;
+    bool codeListsValid;
     QInputDevice::InputTypeFlags type;
 };
 
@@ -146,12 +146,6 @@ linux-*: !simulator: {
         PKGCONFIG += udev
         LIBS += -ludev
 
-        config_evdev {
-            PKGCONFIG += libevdev
-            LIBS +=  -levdev
-        } else {
-            DEFINES += QT_NO_EVDEV
-        }
         PRIVATE_HEADERS += linux/qudevwrapper_p.h \
             linux/qinputinfomanagerudev_p.h
         SOURCES += linux/qudevwrapper.cpp \
@@ -159,6 +153,13 @@ linux-*: !simulator: {
     } else {
         DEFINES += QT_NO_UDEV
     }
+
+    # read the state published by sysinfod instead of polling in every process
+    contains(CONFIG,valuespace):!without-publishsubscribe {
+        QT_PRIVATE += publishsubscribe
+    } else {
+        DEFINES += QT_NO_VALUESPACE
+    }
 }
 
 macx:!simulator {
@@ -263,12 +264,6 @@ simulator {
             PKGCONFIG += udev
             LIBS += -ludev
 
-            config_evdev {
-                PKGCONFIG += libevdev
-                LIBS +=  -levdev
-            } else {
-                DEFINES += QT_NO_EVDEV
-            }
             PRIVATE_HEADERS += linux/qudevwrapper_p.h \
                 linux/qinputinfomanagerudev_p.h
             SOURCES += linux/qudevwrapper.cpp \
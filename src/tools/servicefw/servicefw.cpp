@@ -43,9 +43,19 @@
 #include <QTextStream>
 #include <qservicemanager.h>
 #include <servicemetadata_p.h>
+#include <servicedatabase_p.h>
+#include <serviceregistryindex_p.h>
+#include <qserviceipcstatistics_p.h>
+#include <qservicesupervisor_p.h>
 #include <QString>
 #include <QDir>
 
+#ifdef Q_OS_UNIX
+#include <private/qcore_unix_p.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
 static const char * const errorTable[] = {
     "No error", //0
     "Storage read error",
@@ -80,25 +90,35 @@ public slots:
     void remove(const QStringList &args);
     void dbusservice(const QStringList &args);
     void setdefault(const QStringList &args);
+    void compile(const QStringList &args);
+    void stats(const QStringList &args);
+    void supervise(const QStringList &args);
 
 private:
+    void addMultiple(const QStringList &args);
     bool setOptions(const QStringList &options);
     void setErrorCode(int error);
     void showAllEntries();
     void showInterfaceInfo(const QServiceFilter &filter);
     void showInterfaceInfo(QList<QServiceInterfaceDescriptor> descriptors);
     void showServiceInfo(const QString &service);
+    void showStatistics(const QString &location);
+    QStringList ipcLocations(const QString &name);
 
     QServiceManager *serviceManager;
     QTextStream *stdoutStream;
     int m_error;
+    bool m_onDemand;
+    int m_idleTimeout;
 };
 
 CommandProcessor::CommandProcessor(QObject *parent)
     : QObject(parent),
       serviceManager(0),
       stdoutStream(new QTextStream(stdout)),
-      m_error(0)
+      m_error(0),
+      m_onDemand(false),
+      m_idleTimeout(-1)
 {
 }
 
@@ -140,15 +160,21 @@ void CommandProcessor::showUsage(QTextStream *stream)
             "Commands:\n"
             "\tbrowse         List all registered services\n"
             "\tsearch         Search for a service or interface\n"
-            "\tadd            Register a service\n"
+            "\tadd            Register a service, or several services at once\n"
             "\tremove         Unregister a service\n"
             "\tdbusservice    Generates a .service file for D-Bus service autostart\n"
+            "\tcompile        Compile a services database into a read-only registry index\n"
+            "\tstats          Show the IPC call statistics of a running service\n"
+            "\tsupervise      Keep IPC services started ahead of their clients\n"
             "\n"
             "Options:\n"
             "\t--system       Use the system-wide services database instead of the\n"
             "\t               user-specific database\n"
             "\t--user         Use the user-specific services database for add/remove.\n"
             "\t               This is the default\n"
+            "\t--on-demand    supervise: start services when the first client connects\n"
+            "\t--idle-timeout=<ms>\n"
+            "\t               supervise: let services quit after being idle for <ms>\n"
             "\n";
 }
 
@@ -215,7 +241,12 @@ void CommandProcessor::search(const QStringList &args)
 void CommandProcessor::add(const QStringList &args)
 {
     if (args.isEmpty()) {
-        *stdoutStream << "Usage:\n\tadd <service-xml-file>\n";
+        *stdoutStream << "Usage:\n\tadd <service-xml-file|directory> [service-xml-file|directory...]\n";
+        return;
+    }
+
+    if (args.count() > 1 || QFileInfo(args[0]).isDir()) {
+        addMultiple(args);
         return;
     }
 
@@ -239,6 +270,44 @@ void CommandProcessor::add(const QStringList &args)
     }
 }
 
+void CommandProcessor::addMultiple(const QStringList &args)
+{
+    QStringList xmlPaths;
+    foreach (const QString &path, args) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            QDir dir(path);
+            foreach (const QString &file, dir.entryList(QStringList() << "*.xml", QDir::Files, QDir::Name))
+                xmlPaths << dir.filePath(file);
+        } else if (info.exists()) {
+            xmlPaths << path;
+        } else {
+            *stdoutStream << "Error: cannot find file " << path << '\n';
+            setErrorCode(11);
+            return;
+        }
+    }
+
+    if (xmlPaths.isEmpty()) {
+        *stdoutStream << "Error: no service xml files found in " << args.join(QLatin1Char(' ')) << '\n';
+        setErrorCode(11);
+        return;
+    }
+
+    if (serviceManager->addServices(xmlPaths)) {
+        foreach (const QString &xmlPath, xmlPaths)
+            *stdoutStream << "Registered service at " << xmlPath << '\n';
+    } else {
+        int error = serviceManager->error();
+        if (error > 10) //map anything larger than 10 to 10
+            error = 10;
+        *stdoutStream << "Error: cannot register services at " << args.join(QLatin1Char(' '))
+                << " (" << errorTable[error] << ")" << '\n';
+
+        setErrorCode(error);
+    }
+}
+
 void CommandProcessor::remove(const QStringList &args)
 {
     if (args.isEmpty()) {
@@ -333,6 +402,134 @@ void CommandProcessor::dbusservice(const QStringList &args)
     }
 }
 
+void CommandProcessor::compile(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        *stdoutStream << "Usage:\n\tcompile <database-file> [index-file]\n\n"
+                "The index is written next to the database unless an index file is given.\n"
+                "An index next to the system database replaces it for all system scope\n"
+                "lookups; the system database cannot be modified while the index exists.\n";
+        return;
+    }
+
+    const QString &dbPath = args[0];
+    if (!QFile::exists(dbPath)) {
+        *stdoutStream << "Error: cannot find database " << dbPath << '\n';
+        setErrorCode(11);
+        return;
+    }
+
+    const QString indexPath = args.count() > 1 ? args[1] : ServiceRegistryIndex::indexPath(dbPath);
+
+    ServiceDatabase database;
+    database.setDatabasePath(dbPath);
+    DBError error;
+    if (!database.open())
+        error = database.lastError();
+    else
+        ServiceRegistryIndex::compile(&database, indexPath, &error);
+
+    if (error.code() != DBError::NoError) {
+        *stdoutStream << "Error: cannot compile " << dbPath << " into " << indexPath
+                << " (" << error.text() << ")" << '\n';
+        setErrorCode(10);
+        return;
+    }
+
+    *stdoutStream << "Compiled " << dbPath << " into " << indexPath << '\n';
+}
+
+void CommandProcessor::stats(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        *stdoutStream << "Usage:\n\tstats <service|ipc-address>\n\n"
+                "Shows the call counters and latencies of a running IPC service. The\n"
+                "service is not started if it isn't running.\n";
+        return;
+    }
+
+    foreach (const QString &location, ipcLocations(args[0]))
+        showStatistics(location);
+}
+
+#ifdef Q_OS_UNIX
+static int qt_sfw_signal_pipe[2] = { -1, -1 };
+
+static void qt_sfw_quit_signal(int)
+{
+    // nothing to do if the pipe is full, a quit is pending already
+    qt_safe_write(qt_sfw_signal_pipe[1], "", 1);
+}
+#endif
+
+void CommandProcessor::supervise(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        *stdoutStream << "Usage:\n\tsupervise [--on-demand] [--idle-timeout=<ms>] <service|ipc-address>...\n\n"
+                "Listens on the addresses of the given IPC services and keeps a started\n"
+                "process ready for each of them, so clients do not have to wait for the\n"
+                "service to start. With --on-demand a service is only started once a\n"
+                "client connects. Services that quit are started again. Runs until it\n"
+                "is interrupted.\n";
+        return;
+    }
+
+#ifdef SFW_USE_DBUS_BACKEND
+    *stdoutStream << "Error: supervise needs the unix or local socket IPC backend, "
+                     "D-Bus services are started by D-Bus activation\n";
+    setErrorCode(13);
+    return;
+#endif
+
+    QServiceSupervisor supervisor;
+    supervisor.setStartPolicy(m_onDemand ? QServiceSupervisor::StartOnDemand
+                                         : QServiceSupervisor::StartImmediately);
+    supervisor.setIdleTimeout(m_idleTimeout);
+
+    foreach (const QString &name, args) {
+        foreach (const QString &location, ipcLocations(name)) {
+            if (supervisor.addService(location))
+                *stdoutStream << "Supervising " << location << '\n';
+            else
+                setErrorCode(13);
+        }
+    }
+    stdoutStream->flush();
+    if (supervisor.addresses().isEmpty())
+        return;
+
+#ifdef Q_OS_UNIX
+    // quit cleanly on SIGINT and SIGTERM so the services are stopped too
+    if (qt_safe_pipe(qt_sfw_signal_pipe, O_NONBLOCK) == 0) {
+        QSocketNotifier *notifier = new QSocketNotifier(qt_sfw_signal_pipe[0], QSocketNotifier::Read, &supervisor);
+        connect(notifier, SIGNAL(activated(int)), QCoreApplication::instance(), SLOT(quit()));
+        ::signal(SIGINT, qt_sfw_quit_signal);
+        ::signal(SIGTERM, qt_sfw_quit_signal);
+    }
+#endif
+
+    QCoreApplication::exec();
+}
+
+/*
+    The IPC addresses of the inter-process services called \a name, or
+    \a name itself if it is not a registered service.
+*/
+QStringList CommandProcessor::ipcLocations(const QString &name)
+{
+    QStringList locations;
+    foreach (const QServiceInterfaceDescriptor &desc, serviceManager->findInterfaces(name)) {
+        if (desc.attribute(QServiceInterfaceDescriptor::ServiceType).toInt() == QService::Plugin)
+            continue;
+        const QString location = desc.attribute(QServiceInterfaceDescriptor::Location).toString();
+        if (!locations.contains(location))
+            locations.append(location);
+    }
+    if (locations.isEmpty())
+        locations.append(name);
+    return locations;
+}
+
 bool CommandProcessor::setOptions(const QStringList &options)
 {
     if (serviceManager)
@@ -350,6 +547,14 @@ bool CommandProcessor::setOptions(const QStringList &options)
         } else if (option == "--user") {
             scope = QService::UserScope;
             i.remove();
+        } else if (option == "--on-demand") {
+            m_onDemand = true;
+            i.remove();
+        } else if (option.startsWith("--idle-timeout=")) {
+            bool ok = false;
+            m_idleTimeout = option.mid(15).toInt(&ok);
+            if (ok)
+                i.remove();
         }
     }
 
@@ -364,6 +569,49 @@ bool CommandProcessor::setOptions(const QStringList &options)
     return true;
 }
 
+void CommandProcessor::showStatistics(const QString &location)
+{
+    const QJsonObject snapshot = QServiceIpcStatistics::query(location);
+    if (snapshot.isEmpty()) {
+        *stdoutStream << "Error: no statistics received from " << location << '\n';
+        setErrorCode(12);
+        return;
+    }
+
+    const QJsonObject transport = snapshot.value("transport").toObject();
+    *stdoutStream << location << " (pid " << qint64(snapshot.value("pid").toDouble()) << "):\n"
+                  << "\tRead " << qint64(transport.value("bytesRead").toDouble()) << " bytes in "
+                  << qint64(transport.value("packagesRead").toDouble()) << " packages, wrote "
+                  << qint64(transport.value("bytesWritten").toDouble()) << " bytes in "
+                  << qint64(transport.value("packagesWritten").toDouble()) << " packages\n"
+                  << "\tPending writes " << qint64(transport.value("pendingWrite").toDouble())
+                  << " bytes, at most " << qint64(transport.value("pendingWriteMax").toDouble())
+                  << " bytes\n";
+
+    const QJsonArray methods = snapshot.value("methods").toArray();
+    if (methods.isEmpty())
+        return;
+
+    *stdoutStream << '\n' << qSetFieldWidth(10) << right
+                  << "calls" << "bytes in" << "bytes out" << "p50 us" << "p99 us" << "max us"
+                  << qSetFieldWidth(0) << left << "  method\n";
+    foreach (const QJsonValue &value, methods) {
+        const QJsonObject method = value.toObject();
+        const QJsonObject latency = method.value("latency").toObject();
+        *stdoutStream << qSetFieldWidth(10) << right
+                      << qint64(method.value("calls").toDouble())
+                      << qint64(method.value("bytesIn").toDouble())
+                      << qint64(method.value("bytesOut").toDouble())
+                      << qint64(latency.value("p50").toDouble())
+                      << qint64(latency.value("p99").toDouble())
+                      << qint64(latency.value("max").toDouble())
+                      << qSetFieldWidth(0) << left
+                      << "  " << method.value("interface").toString()
+                      << "::" << method.value("method").toString()
+                      << (method.value("side").toString() == "client" ? " (as client)" : "") << '\n';
+    }
+}
+
 void CommandProcessor::showAllEntries()
 {
     QStringList services = serviceManager->findServices();
@@ -2,10 +2,12 @@ TEMPLATE = app
 TARGET = servicefw
 DESTDIR = $$QT.serviceframework.bins
 
-QT += serviceframework
+QT += core-private serviceframework sql
+contains(QT.serviceframework.module_config, sfw_dbus_backend): DEFINES += SFW_USE_DBUS_BACKEND
 QT -= gui
 DEFINES += IGNORE_SERVICEMETADATA_EXPORT
-INCLUDEPATH += ../../serviceframework
+INCLUDEPATH += ../../serviceframework \
+               ../../serviceframework/ipc
 
 SOURCES = servicefw.cpp \
           ../../serviceframework/servicemetadata.cpp
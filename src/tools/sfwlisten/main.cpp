@@ -40,12 +40,13 @@
 #include <QUdpSocket>
 #include <QHostAddress>
 #include <QCoreApplication>
-#include <QBuffer>
-#include <QDataStream>
-#include <QTime>
+#include <QDateTime>
+#include <QFile>
 #include <QTimer>
 #include <QNetworkInterface>
+#include <QtEndian>
 #include <cstdio>
+#include <cstring>
 
 /* keep this in sync with qtsystems/src/serviceframework/qservicedebuglog_p.h */
 enum DataType {
@@ -54,6 +55,123 @@ enum DataType {
     StringType = 3
 };
 
+enum RecordFlag {
+    Truncated = 0x1,
+    Dropped = 0x2
+};
+
+/* and these with qtsystems/src/serviceframework/qservicedebuglog.cpp */
+#define SFW_TRACE_MAGIC 0x54574653u
+#define SFW_TRACE_VERSION 1
+#define SFW_TRACE_HEADER_SIZE 13
+#define SFW_TRACE_RECORD_HEADER_SIZE 16
+
+static QByteArray readLatin1(const uchar *&p, const uchar *end)
+{
+    if (p >= end)
+        return QByteArray();
+    int len = qMin<int>(*p++, end - p);
+    QByteArray ba(reinterpret_cast<const char *>(p), len);
+    p += len;
+    return ba;
+}
+
+static void printRecord(const QString &source, quint32 pid, const QByteArray &appName,
+                        const uchar *record)
+{
+    const quint64 timestamp = qFromLittleEndian<quint64>(record);
+    const quint32 thread = qFromLittleEndian<quint32>(record + 8);
+    const quint16 size = qFromLittleEndian<quint16>(record + 12);
+    const quint16 flags = qFromLittleEndian<quint16>(record + 14);
+
+    const QDateTime time = QDateTime::fromMSecsSinceEpoch(timestamp / 1000);
+    printf("{%4s} %s.%03d ", qPrintable(source),
+           qPrintable(time.time().toString(QStringLiteral("hh:mm:ss.zzz"))),
+           int(timestamp % 1000));
+    printf("[%5d/%10s/%2d] ", pid, appName.constData(), thread);
+
+    const uchar *p = record + SFW_TRACE_RECORD_HEADER_SIZE;
+    const uchar *end = p + size;
+
+    if (flags & Dropped) {
+        printf("{dropped, %d}\n", size >= 4 ? qFromLittleEndian<qint32>(p) : 0);
+        return;
+    }
+
+    while (p < end) {
+        QByteArray termName = readLatin1(p, end);
+        if (p >= end)
+            break;
+        printf("{%s, ", termName.constData());
+
+        DataType dt = static_cast<DataType>(*p++);
+        switch (dt) {
+        case Int32Type:
+            if (end - p < 4)
+                break;
+            printf("%d} ", qFromLittleEndian<qint32>(p));
+            p += 4;
+            break;
+        case FloatType:
+        {
+            if (end - p < 4)
+                break;
+            quint32 bits = qFromLittleEndian<quint32>(p);
+            float data;
+            memcpy(&data, &bits, sizeof(data));
+            printf("%.4f} ", data);
+            p += 4;
+        }
+            break;
+        case StringType:
+        {
+            QByteArray ba = readLatin1(p, end);
+            ba.truncate(35);
+            printf("'%s'} ", ba.constData());
+        }
+            break;
+        default:
+            p = end;
+            break;
+        }
+    }
+
+    if (flags & Truncated)
+        printf("...");
+    printf("\n");
+}
+
+/*
+    Decodes a trace, the process header followed by fixed size records, as
+    found in a datagram or a trace file. Returns false if it isn't one.
+*/
+static bool decodeTrace(const QString &source, const QByteArray &data)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    const uchar *end = p + data.size();
+
+    if (data.size() < SFW_TRACE_HEADER_SIZE
+            || qFromLittleEndian<quint32>(p) != SFW_TRACE_MAGIC
+            || qFromLittleEndian<quint16>(p + 4) != SFW_TRACE_VERSION)
+        return false;
+
+    const int recordSize = qFromLittleEndian<quint16>(p + 6);
+    const quint32 pid = qFromLittleEndian<quint32>(p + 8);
+    p += SFW_TRACE_HEADER_SIZE - 1;
+    const QByteArray appName = readLatin1(p, end);
+
+    if (recordSize <= SFW_TRACE_RECORD_HEADER_SIZE)
+        return false;
+
+    for (; end - p >= recordSize; p += recordSize) {
+        const quint16 size = qFromLittleEndian<quint16>(p + 12);
+        if (size > recordSize - SFW_TRACE_RECORD_HEADER_SIZE)
+            return false;
+        printRecord(source, pid, appName, p);
+    }
+    return true;
+}
+
 class SFWReceiver : public QObject
 {
     Q_OBJECT
@@ -162,67 +280,8 @@ void SFWReceiver::socketReadyRead()
             if (dgram == last)
                 continue;
 
-            QBuffer buff(&dgram);
-            buff.open(QIODevice::ReadOnly);
-            QDataStream ds(&buff);
-
-            quint8 hour,minute,second;
-            quint16 msec;
-            ds >> hour;
-            ds >> minute;
-            ds >> second;
-            ds >> msec;
-
-            qint32 pid;
-            ds >> pid;
-
-            char *str;
-            uint len;
-
-            ds.readBytes(str, len);
-            QByteArray appName(str, len);
-            delete[] str;
-
-            printf("{%4s} %2d:%02d:%02d.%03d ", qPrintable(intf), hour, minute,
-                   second, msec);
-            printf("[%5d/%10s] ", pid, appName.constData());
-            while (!ds.atEnd()) {
-                ds.readBytes(str, len);
-                QByteArray termName(str, len);
-                delete[] str;
-
-                printf("{%s, ", termName.constData());
-
-                qint8 type;
-                ds >> type;
-                DataType dt = static_cast<DataType>(type);
-                switch (dt) {
-                case Int32Type:
-                {
-                    qint32 data;
-                    ds >> data;
-                    printf("%d} ", data);
-                }
-                    break;
-                case FloatType:
-                {
-                    float data;
-                    ds >> data;
-                    printf("%.4f} ", data);
-                }
-                    break;
-                case StringType:
-                {
-                    ds.readBytes(str, len);
-                    QByteArray ba(str, len);
-                    ba.truncate(35);
-                    printf("'%s'} ", ba.constData());
-                }
-                    break;
-                }
-            }
-
-            printf("\n");
+            if (!decodeTrace(intf, dgram))
+                printf("{%4s} malformed trace datagram of %d bytes\n", qPrintable(intf), dgram.size());
             last = dgram;
         }
     }
@@ -231,6 +290,25 @@ void SFWReceiver::socketReadyRead()
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
+
+    // sfwlisten -f <file>... decodes the files written with SFW_TRACE_FILE
+    if (argc > 2 && qstrcmp(argv[1], "-f") == 0) {
+        int ret = 0;
+        for (int i = 2; i < argc; i++) {
+            QFile file(QString::fromLocal8Bit(argv[i]));
+            if (!file.open(QIODevice::ReadOnly)) {
+                fprintf(stderr, "Couldn't open %s: %s\n", argv[i], qPrintable(file.errorString()));
+                ret = 1;
+                continue;
+            }
+            if (!decodeTrace(QStringLiteral("file"), file.readAll())) {
+                fprintf(stderr, "%s is not an sfw trace\n", argv[i]);
+                ret = 1;
+            }
+        }
+        return ret;
+    }
+
     QString filter;
     if (argc > 1)
         filter = QString::fromLatin1(argv[1]);
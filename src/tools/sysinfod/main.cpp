@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QtSystemInfo/qbatteryinfo.h>
+#include <QtPublishSubscribe/qvaluespacepublisher.h>
+#include <private/qcore_unix_p.h>
+#include <cstdio>
+#include <signal.h>
+#include <unistd.h>
+
+/* keep these in sync with qtsystems/src/systeminfo/linux/qbatteryinfo_linux.cpp */
+#define BATTERY_VALUESPACE_PATH "/SystemInfo/Battery"
+#define BATTERY_VALUESPACE_KEY "battery%1/%2"
+#define BATTERY_VALUESPACE_PID "pid"
+
+/*
+    Samples the battery state once for the whole session and publishes it in
+    the value space. QBatteryInfo in other processes reads it from there
+    instead of watching sysfs itself.
+*/
+class BatteryPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatteryPublisher(QObject *parent = 0);
+    ~BatteryPublisher();
+
+    bool isConnected() const;
+
+public slots:
+    void publish();
+
+private:
+    void watch(QBatteryInfo *battery);
+    void setBatteryValue(int battery, const char *attribute, int value);
+    void removeBatteries(int from);
+
+    QValueSpacePublisher *publisher;
+    QList<QBatteryInfo *> batteries;
+    int publishedCount;
+};
+
+BatteryPublisher::BatteryPublisher(QObject *parent)
+    : QObject(parent),
+      publisher(new QValueSpacePublisher(QStringLiteral(BATTERY_VALUESPACE_PATH), this)),
+      publishedCount(0)
+{
+    // the first one also follows the battery count and the charger
+    QBatteryInfo *first = new QBatteryInfo(0, this);
+    connect(first, SIGNAL(batteryCountChanged(int)), this, SLOT(publish()));
+    connect(first, SIGNAL(chargerTypeChanged(QBatteryInfo::ChargerType)), this, SLOT(publish()));
+    watch(first);
+}
+
+BatteryPublisher::~BatteryPublisher()
+{
+    if (!isConnected())
+        return;
+
+    // the value space may keep values after we are gone, clients must not
+    // mistake stale values for a running daemon
+    publisher->resetValue(QStringLiteral(BATTERY_VALUESPACE_PID));
+    removeBatteries(0);
+    publisher->resetValue(QStringLiteral("chargerType"));
+    publisher->resetValue(QStringLiteral("count"));
+    publisher->sync();
+}
+
+bool BatteryPublisher::isConnected() const
+{
+    return publisher->isConnected();
+}
+
+void BatteryPublisher::watch(QBatteryInfo *battery)
+{
+    // connecting is what makes the backend watch a value
+    connect(battery, SIGNAL(chargingStateChanged(QBatteryInfo::ChargingState)), this, SLOT(publish()));
+    connect(battery, SIGNAL(currentFlowChanged(int)), this, SLOT(publish()));
+    connect(battery, SIGNAL(remainingCapacityChanged(int)), this, SLOT(publish()));
+    connect(battery, SIGNAL(remainingChargingTimeChanged(int)), this, SLOT(publish()));
+    connect(battery, SIGNAL(voltageChanged(int)), this, SLOT(publish()));
+    connect(battery, SIGNAL(levelStatusChanged(QBatteryInfo::LevelStatus)), this, SLOT(publish()));
+    batteries.append(battery);
+}
+
+void BatteryPublisher::setBatteryValue(int battery, const char *attribute, int value)
+{
+    publisher->setValue(QStringLiteral(BATTERY_VALUESPACE_KEY).arg(battery).arg(QLatin1String(attribute)), value);
+}
+
+void BatteryPublisher::removeBatteries(int from)
+{
+    for (int i = from; i < publishedCount; ++i)
+        publisher->resetValue(QStringLiteral("battery%1").arg(i));
+}
+
+void BatteryPublisher::publish()
+{
+    const int count = batteries.first()->batteryCount();
+
+    while (batteries.count() < count)
+        watch(new QBatteryInfo(batteries.count(), this));
+    while (batteries.count() > qMax(count, 1))
+        batteries.takeLast()->deleteLater();
+
+    for (int i = 0; i < count; ++i) {
+        QBatteryInfo *battery = batteries.at(i);
+        setBatteryValue(i, "chargingState", battery->chargingState());
+        setBatteryValue(i, "currentFlow", battery->currentFlow());
+        setBatteryValue(i, "maximumCapacity", battery->maximumCapacity());
+        setBatteryValue(i, "remainingCapacity", battery->remainingCapacity());
+        setBatteryValue(i, "remainingChargingTime", battery->remainingChargingTime());
+        setBatteryValue(i, "voltage", battery->voltage());
+        setBatteryValue(i, "levelStatus", battery->levelStatus());
+    }
+    removeBatteries(count);
+    publishedCount = count;
+
+    publisher->setValue(QStringLiteral("chargerType"), batteries.first()->chargerType());
+    publisher->setValue(QStringLiteral("count"), count);
+    // written last, clients read the values only while this process exists
+    publisher->setValue(QStringLiteral(BATTERY_VALUESPACE_PID), QCoreApplication::applicationPid());
+    publisher->sync();
+}
+
+static int sysinfod_signal_pipe[2] = { -1, -1 };
+
+static void sysinfod_quit_signal(int)
+{
+    // nothing to do if the pipe is full, a quit is pending already
+    qt_safe_write(sysinfod_signal_pipe[1], "", 1);
+}
+
+int main(int argc, char **argv)
+{
+    // this process samples the hardware, it must not read back its own values
+    qputenv("QT_SYSTEMINFO_NO_VALUESPACE", "1");
+
+    QCoreApplication app(argc, argv);
+
+    if (app.arguments().count() > 1) {
+        fprintf(stderr, "Usage: %s\n\n"
+                "Publishes the battery state under " BATTERY_VALUESPACE_PATH " in the value space,\n"
+                "so that applications using QtSystemInfo read it from there instead of\n"
+                "each polling the system themselves. Runs until it is interrupted.\n",
+                argv[0]);
+        return 1;
+    }
+
+    BatteryPublisher battery;
+    if (!battery.isConnected()) {
+        fprintf(stderr, "%s: no value space layer available\n", argv[0]);
+        return 2;
+    }
+    battery.publish();
+
+    // quit cleanly on SIGINT and SIGTERM so the published values are removed
+    if (qt_safe_pipe(sysinfod_signal_pipe, O_NONBLOCK) == 0) {
+        QSocketNotifier *notifier = new QSocketNotifier(sysinfod_signal_pipe[0], QSocketNotifier::Read, &app);
+        QObject::connect(notifier, SIGNAL(activated(int)), &app, SLOT(quit()));
+        ::signal(SIGINT, sysinfod_quit_signal);
+        ::signal(SIGTERM, sysinfod_quit_signal);
+    }
+
+    return app.exec();
+}
+
+#include "main.moc"
@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = sysinfod
+
+CONFIG -= app_bundle
+
+DESTDIR = $$QT.systeminfo.bins
+
+QT = core-private systeminfo publishsubscribe
+
+SOURCES = main.cpp
+
+target.path = $$[QT_INSTALL_BINS]
+INSTALLS += target
+
+CONFIG += console
+load(qt_targets)
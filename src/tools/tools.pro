@@ -1,2 +1,3 @@
 TEMPLATE = subdirs
 !macx:!boot2qt:!without-serviceframework: SUBDIRS = servicefw sfwlisten
+linux-*:!boot2qt:!without-publishsubscribe:!without-systeminfo: SUBDIRS += sysinfod
@@ -0,0 +1,8 @@
+TARGET = tst_qdeclarativeservicefilter
+CONFIG += testcase
+
+QT = core qml serviceframework testlib
+
+SOURCES += tst_qdeclarativeservicefilter.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
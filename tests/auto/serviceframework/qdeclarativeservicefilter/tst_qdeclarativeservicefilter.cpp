@@ -0,0 +1,229 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/imports/serviceframework
+
+#include <QtTest/QtTest>
+#include <QAbstractItemModel>
+#include <QBuffer>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQmlListReference>
+#include <qservicemanager.h>
+
+QT_USE_NAMESPACE
+
+static const char filterInterfaceC[] = "com.nokia.qt.tests.servicefilter";
+
+static const char firstServiceXmlC[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<SFW version=\"1.1\">"
+        "<service>"
+            "<name>ServiceFilterTest</name>"
+            "<ipcaddress>com.nokia.qt.tests.servicefilter</ipcaddress>"
+            "<interface>"
+                "<name>com.nokia.qt.tests.servicefilter</name>"
+                "<version>1.0</version>"
+            "</interface>"
+            "<interface>"
+                "<name>com.nokia.qt.tests.servicefilter</name>"
+                "<version>1.1</version>"
+            "</interface>"
+        "</service>"
+        "</SFW>";
+
+static const char secondServiceXmlC[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<SFW version=\"1.1\">"
+        "<service>"
+            "<name>ServiceFilterTest2</name>"
+            "<ipcaddress>com.nokia.qt.tests.servicefilter2</ipcaddress>"
+            "<interface>"
+                "<name>com.nokia.qt.tests.servicefilter</name>"
+                "<version>2.0</version>"
+            "</interface>"
+        "</service>"
+        "</SFW>";
+
+class tst_QDeclarativeServiceFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void roles();
+    void rowsFollowRegistrations();
+
+private:
+    QObject *createFilter(QQmlEngine *engine);
+    static bool addService(const char *xml);
+    static QObject *descriptorAt(QAbstractItemModel *model, int row);
+};
+
+bool tst_QDeclarativeServiceFilter::addService(const char *xml)
+{
+    QByteArray data(xml);
+    QBuffer buffer(&data);
+    QServiceManager manager;
+    return manager.addService(&buffer);
+}
+
+void tst_QDeclarativeServiceFilter::initTestCase()
+{
+    cleanupTestCase();
+    QVERIFY(addService(firstServiceXmlC));
+}
+
+void tst_QDeclarativeServiceFilter::cleanupTestCase()
+{
+    QServiceManager manager;
+    manager.removeService(QStringLiteral("ServiceFilterTest"));
+    manager.removeService(QStringLiteral("ServiceFilterTest2"));
+}
+
+QObject *tst_QDeclarativeServiceFilter::createFilter(QQmlEngine *engine)
+{
+    QQmlComponent component(engine);
+    component.setData("import QtServiceFramework 5.0\n"
+                      "ServiceFilter {\n"
+                      "    interfaceName: \"" + QByteArray(filterInterfaceC) + "\"\n"
+                      "    monitorServiceRegistrations: true\n"
+                      "}\n", QUrl());
+    QObject *filter = component.create();
+    if (!filter)
+        qWarning() << component.errors();
+    return filter;
+}
+
+QObject *tst_QDeclarativeServiceFilter::descriptorAt(QAbstractItemModel *model, int row)
+{
+    const QByteArray role("serviceDescriptor");
+    return model->data(model->index(row, 0), model->roleNames().key(role)).value<QObject *>();
+}
+
+void tst_QDeclarativeServiceFilter::roles()
+{
+    QQmlEngine engine;
+    QScopedPointer<QObject> filter(createFilter(&engine));
+    QVERIFY(filter);
+    QAbstractItemModel *model = qobject_cast<QAbstractItemModel *>(filter.data());
+    QVERIFY(model);
+
+    const QHash<int, QByteArray> roles = model->roleNames();
+    QVERIFY(roles.values().contains("serviceDescriptor"));
+    QVERIFY(roles.values().contains("serviceName"));
+    QVERIFY(roles.values().contains("interfaceName"));
+    QVERIFY(roles.values().contains("majorVersion"));
+    QVERIFY(roles.values().contains("minorVersion"));
+
+    QCOMPARE(model->rowCount(), 2);
+    QSet<int> minorVersions;
+    for (int row = 0; row < model->rowCount(); ++row) {
+        const QModelIndex index = model->index(row, 0);
+        QCOMPARE(model->data(index, roles.key("serviceName")).toString(),
+                 QStringLiteral("ServiceFilterTest"));
+        QCOMPARE(model->data(index, roles.key("interfaceName")).toString(),
+                 QLatin1String(filterInterfaceC));
+        QCOMPARE(model->data(index, roles.key("majorVersion")).toInt(), 1);
+        minorVersions.insert(model->data(index, roles.key("minorVersion")).toInt());
+
+        //the descriptor object agrees with the plain roles
+        QObject *descriptor = descriptorAt(model, row);
+        QVERIFY(descriptor);
+        QCOMPARE(descriptor->property("serviceName").toString(), QStringLiteral("ServiceFilterTest"));
+        QCOMPARE(descriptor->property("minorVersion").toInt(),
+                 model->data(index, roles.key("minorVersion")).toInt());
+    }
+    QCOMPARE(minorVersions, QSet<int>() << 0 << 1);
+
+    //the list property serves the same objects
+    QQmlListReference list(filter.data(), "serviceDescriptions");
+    QCOMPARE(list.count(), model->rowCount());
+    QCOMPARE(list.at(0), descriptorAt(model, 0));
+}
+
+void tst_QDeclarativeServiceFilter::rowsFollowRegistrations()
+{
+    QQmlEngine engine;
+    QScopedPointer<QObject> filter(createFilter(&engine));
+    QVERIFY(filter);
+    QAbstractItemModel *model = qobject_cast<QAbstractItemModel *>(filter.data());
+    QVERIFY(model);
+    QCOMPARE(model->rowCount(), 2);
+
+    QSignalSpy inserted(model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removed(model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy reset(model, SIGNAL(modelReset()));
+    QSignalSpy changed(filter.data(), SIGNAL(serviceDescriptionsChanged()));
+
+    QObject *first = descriptorAt(model, 0);
+    QObject *second = descriptorAt(model, 1);
+
+    //a new service only appends its own row
+    QVERIFY(addService(secondServiceXmlC));
+    QTRY_COMPARE(model->rowCount(), 3);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.at(0).at(1).toInt(), 2);
+    QCOMPARE(inserted.at(0).at(2).toInt(), 2);
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(descriptorAt(model, 0), first);
+    QCOMPARE(descriptorAt(model, 1), second);
+    QCOMPARE(descriptorAt(model, 2)->property("serviceName").toString(),
+             QStringLiteral("ServiceFilterTest2"));
+    QCOMPARE(descriptorAt(model, 2)->property("majorVersion").toInt(), 2);
+
+    //removing it only removes that row
+    QServiceManager manager;
+    QVERIFY(manager.removeService(QStringLiteral("ServiceFilterTest2")));
+    QTRY_COMPARE(model->rowCount(), 2);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 2);
+    QCOMPARE(removed.at(0).at(2).toInt(), 2);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(changed.count(), 2);
+    QCOMPARE(descriptorAt(model, 0), first);
+    QCOMPARE(descriptorAt(model, 1), second);
+
+    //removing a service with several rows removes them together
+    QVERIFY(manager.removeService(QStringLiteral("ServiceFilterTest")));
+    QTRY_COMPARE(model->rowCount(), 0);
+    QCOMPARE(removed.count(), 2);
+    QCOMPARE(removed.at(1).at(1).toInt(), 0);
+    QCOMPARE(removed.at(1).at(2).toInt(), 1);
+    QCOMPARE(reset.count(), 0);
+
+    QVERIFY(addService(firstServiceXmlC));
+    QTRY_COMPARE(model->rowCount(), 2);
+}
+
+QTEST_MAIN(tst_QDeclarativeServiceFilter)
+#include "tst_qdeclarativeservicefilter.moc"
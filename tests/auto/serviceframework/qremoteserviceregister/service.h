@@ -26,6 +26,7 @@
 **
 ****************************************************************************/
 #include <QObject>
+#include <QThread>
 
 class QRemoteServiceRegisterService : public QObject
 {
@@ -41,6 +42,11 @@ public:
     {
     }
 
+    Q_INVOKABLE qulonglong threadId() const
+    {
+        return qulonglong(quintptr(QThread::currentThread()));
+    }
+
 Q_SIGNALS:
     void valueChanged();
 
@@ -58,15 +58,17 @@ private slots:
     void cleanupTestCase();
     void checkCreateEntryWithEmptyServiceName();
     void checkOperators();
+    void checkExecutionPolicy();
     void checkPublish();
     void tst_instanceClosed();
+    void checkInstanceThreads();
 
 private:
     QRemoteServiceRegister* serviceRegister;
     QRemoteServiceRegister::Entry uniqueEntry;
     QRemoteServiceRegister::Entry uniqueEntry2;
 
-    QObject *connectToService(const QString &serviceName);
+    QObject *connectToService(const QString &serviceName, const QString &interfaceName = QString());
     bool servicePublished;
 };
 
@@ -100,6 +102,12 @@ void tst_QRemoteServiceRegister::initTestCase()
     serviceRegister->setQuitOnLastInstanceClosed(true);
     QVERIFY(serviceRegister->quitOnLastInstanceClosed() == true);
 
+    //Check setting of the idle timeout
+    QCOMPARE(serviceRegister->idleTimeout(), 0);
+    serviceRegister->setIdleTimeout(500);
+    QCOMPARE(serviceRegister->idleTimeout(), 500);
+    serviceRegister->setIdleTimeout(0);
+
     //check setting a security filter
     serviceRegister->setSecurityFilter(mySecurityFilterFunction);
 
@@ -194,6 +202,21 @@ void tst_QRemoteServiceRegister::checkOperators()
 #endif
 }
 
+void tst_QRemoteServiceRegister::checkExecutionPolicy()
+{
+    QRemoteServiceRegister::Entry threadedEntry =
+                serviceRegister->createEntry<QRemoteServiceRegisterService>(
+                "RSRExampleService", "com.nokia.qt.sfw.ThreadedTest", "1.0");
+    QCOMPARE(threadedEntry.executionPolicy(), QRemoteServiceRegister::SharedThreadExecution);
+
+    threadedEntry.setExecutionPolicy(QRemoteServiceRegister::InstanceThreadExecution);
+    QCOMPARE(threadedEntry.executionPolicy(), QRemoteServiceRegister::InstanceThreadExecution);
+
+    QRemoteServiceRegister::Entry copy(threadedEntry);
+    QCOMPARE(copy.executionPolicy(), QRemoteServiceRegister::InstanceThreadExecution);
+    QCOMPARE(copy.instantiationType(), QRemoteServiceRegister::PrivateInstance);
+}
+
 void tst_QRemoteServiceRegister::checkPublish()
 {
     //publish the registered services
@@ -224,7 +247,7 @@ void tst_QRemoteServiceRegister::tst_instanceClosed()
     QSignalSpy spy(serviceRegister,SIGNAL(instanceClosed(QRemoteServiceRegister::Entry)));
     QSignalSpy spyAll(serviceRegister,SIGNAL(allInstancesClosed()));
 
-    QObject *o = connectToService("RSRExampleService");
+    QObject *o = connectToService("RSRExampleService", "com.nokia.qt.rsrunittest");
     QVERIFY(o);
 
     delete o;
@@ -234,11 +257,40 @@ void tst_QRemoteServiceRegister::tst_instanceClosed()
 
 }
 
-QObject *tst_QRemoteServiceRegister::connectToService(const QString &serviceName)
+void tst_QRemoteServiceRegister::checkInstanceThreads()
+{
+    //checkExecutionPolicy() registered the interface with its own threads
+    const QString threadedInterface(QStringLiteral("com.nokia.qt.sfw.ThreadedTest"));
+    QObject *first = connectToService("RSRExampleService", threadedInterface);
+    QVERIFY(first);
+    QObject *second = connectToService("RSRExampleService", threadedInterface);
+    QVERIFY(second);
+
+    qulonglong firstThread = 0;
+    qulonglong secondThread = 0;
+    QVERIFY(QMetaObject::invokeMethod(first, "threadId", Q_RETURN_ARG(qulonglong, firstThread)));
+    QVERIFY(QMetaObject::invokeMethod(second, "threadId", Q_RETURN_ARG(qulonglong, secondThread)));
+
+    const qulonglong registerThread = qulonglong(quintptr(QThread::currentThread()));
+    QVERIFY(firstThread != 0);
+    QVERIFY(secondThread != 0);
+    QVERIFY(firstThread != registerThread);
+    QVERIFY(secondThread != registerThread);
+    QVERIFY(firstThread != secondThread);
+
+    //the register joins the instance threads when it is deleted in cleanupTestCase()
+    delete first;
+    delete second;
+}
+
+QObject *tst_QRemoteServiceRegister::connectToService(const QString &serviceName,
+                                                      const QString &interfaceName)
 {
     QServiceManager manager;
 
-    QList<QServiceInterfaceDescriptor> list = manager.findInterfaces(serviceName);
+    QServiceFilter filter(interfaceName);
+    filter.setServiceName(serviceName);
+    QList<QServiceInterfaceDescriptor> list = manager.findInterfaces(filter);
     if (list.isEmpty()) {
         qWarning() << "Couldn't find service" << serviceName << manager.findServices("qt_sfw_example_rsr_unittest");
         return 0;
@@ -212,6 +212,8 @@ private slots:
 
     void loadInterface_testLoadedObjectAttributes();
 
+    void loadInterface_preloaded();
+
     void loadLocalTypedInterface();
 
     void addService();
@@ -221,6 +223,7 @@ private slots:
     void addService_testPluginLoading();
     void addService_testPluginLoading_data();
     void addService_testInstallService();
+    void addServices();
 
     void removeService();
 
@@ -772,6 +775,35 @@ void tst_QServiceManager::loadInterface_string()
     QCoreApplication::processEvents();
 }
 
+void tst_QServiceManager::loadInterface_preloaded()
+{
+    QServiceManager mgr;
+    QString commonInterface = "com.nokia.qt.TestInterfaceA";
+    QVERIFY2(mgr.addService(xmlTestDataPath("sampleservice.xml")), PRINT_ERR(mgr));
+
+    //unknown interfaces are ignored
+    mgr.preloadInterfaces(QStringList() << commonInterface << "com.nokia.qt.DoesNotExist");
+    QCOMPARE(mgr.error(), QServiceManager::NoError);
+
+    //loading while the preload may still run shares the loader safely
+    QObject *early = mgr.loadInterface(commonInterface);
+    QVERIFY(early != 0);
+    delete early;
+    QThreadPool::globalInstance()->waitForDone();
+
+    //the plugin is shared, but every call still creates a new instance
+    QObject *obj = mgr.loadInterface(commonInterface);
+    QVERIFY(obj != 0);
+    QCOMPARE(QString(obj->metaObject()->className()), QString("SampleServicePluginClass"));
+    QObject *obj2 = mgr.loadInterface(commonInterface);
+    QVERIFY(obj2 != 0);
+    QVERIFY(obj2 != obj);
+    delete obj;
+    delete obj2;
+    QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    QCoreApplication::processEvents();
+}
+
 void tst_QServiceManager::loadInterface_descriptor()
 {
     QFETCH(QServiceInterfaceDescriptor, descriptor);
@@ -1064,6 +1096,42 @@ void tst_QServiceManager::addService_testInstallService()
     QCOMPARE(settings.value("installed").toBool(), true);
 }
 
+void tst_QServiceManager::addServices()
+{
+    QServiceManager mgr;
+
+    QVERIFY2(mgr.addServices(QStringList() << xmlTestDataPath("sampleservice.xml")
+                                           << xmlTestDataPath("sampleservice2.xml")), PRINT_ERR(mgr));
+    QCOMPARE(mgr.error(), QServiceManager::NoError);
+    QStringList result = mgr.findServices();
+    QCOMPARE(result.count(), 2);
+    QVERIFY(result.contains("SampleService"));
+    QVERIFY(result.contains("SampleService2"));
+    QVERIFY(mgr.removeService("SampleService"));
+    QVERIFY(mgr.removeService("SampleService2"));
+
+    // one invalid file prevents all of the services from being registered
+    QTemporaryFile invalidFile;
+    QVERIFY2(invalidFile.open(), "Can't open temp file");
+    invalidFile.write("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<service><name>Broken</name>\n");
+    invalidFile.close();
+    QVERIFY(!mgr.addServices(QStringList() << xmlTestDataPath("sampleservice.xml")
+                                           << invalidFile.fileName()));
+    QCOMPARE(mgr.error(), QServiceManager::InvalidServiceXml);
+    QVERIFY(mgr.findServices().isEmpty());
+
+    // a service whose plugin cannot be loaded is unregistered again
+    QTemporaryFile missingPluginFile;
+    QVERIFY2(missingPluginFile.open(), "Can't open temp file");
+    missingPluginFile.write(createServiceXml("MissingPluginService",
+            createInterfaceXml("com.qt.serviceframework.Interface"), "no_such_plugin"));
+    missingPluginFile.close();
+    QVERIFY(!mgr.addServices(QStringList() << xmlTestDataPath("sampleservice.xml")
+                                           << missingPluginFile.fileName()));
+    QCOMPARE(mgr.error(), QServiceManager::PluginLoadingFailed);
+    QCOMPARE(mgr.findServices(), QStringList("SampleService"));
+}
+
 void tst_QServiceManager::removeService()
 {
     QServiceManager mgr;
@@ -2,7 +2,7 @@ TARGET = tst_qservicemanager_ipc
 CONFIG += testcase
 testcase.timeout = 600 # this test is slow
 
-QT += serviceframework testlib
+QT += serviceframework serviceframework-private testlib
 QT -= gui
 
 # Increase the stack size on MSVC to 4M to avoid a stack overflow
@@ -10,6 +10,8 @@ win32-msvc*:QMAKE_LFLAGS += /STACK:4194304
 
 CONFIG -= app_bundle
 
+contains(QT.serviceframework.module_config, sfw_unix_backend): DEFINES += SFW_USE_UNIX_BACKEND
+
 qtHaveModule(dbus): {
     QT += dbus
     DEFINES+=SFW_USE_DBUS_BACKEND
@@ -40,6 +40,10 @@
 #include <qservice.h>
 #include <qremoteserviceregister.h>
 #include <qservicereply.h>
+#include <private/qserviceipcstatistics_p.h>
+#ifdef QT_BUILD_INTERNAL
+#include <private/qserviceoperations_p.h>
+#endif
 
 #include <signal.h>
 
@@ -68,6 +72,28 @@ inline QDBusArgument &operator<<(QDBusArgument &arg, const QVariantHash &map)
 #include <sys/resource.h>
 #endif
 
+#ifdef SFW_USE_UNIX_BACKEND
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+#endif
+
 QT_USE_NAMESPACE
 Q_DECLARE_METATYPE(QServiceFilter);
 Q_DECLARE_METATYPE(QVariant);
@@ -205,18 +231,23 @@ private slots:
 
     void verifyLargeDataTransfer();
     void verifyLargeDataTransfer_data();
+    void verifyPayloadSegments();
 
     void verifyRemoteBlockingFunctions();
+    void verifyCallTimeout();
 
     void verifyThreadSafety();
     void verifyThreadSafety_data();
 
     void sharedTestService();
     void uniqueTestService();
+    void verifyConnectionSharing();
+    void verifyCallStatistics();
 
     void testInvokableFunctions();
     void testSlotInvokation();
     void testSignalling();
+    void testSignalSubscription();
 
     void testSignalSlotOrdering();
 
@@ -225,6 +256,9 @@ private slots:
 
     void verifyAsyncLoading();
     void verifyAsyncLoading_data();
+    void verifyConcurrentAsyncLoading();
+    void verifyCoalescedAsyncFailures();
+    void verifyCoalescedAsyncFailures_data();
 
     void testServiceSecurity();
 
@@ -268,8 +302,13 @@ static const char serviceBinaryC[] = "qt_sfw_example_ipc_unittest.exe";
 static const char serviceBinaryC[] = "qt_sfw_example_ipc_unittest";
 #endif
 
+// asynchronous loads may use the background thread and one more worker
+static const int operationThreadsC = 2;
+
 void tst_QServiceManager_IPC::initTestCase()
 {
+    qputenv("SFW_OPERATION_THREADS", QByteArray::number(operationThreadsC));
+
     const QString serviceBinary = QFINDTESTDATA(serviceBinaryC);
     QVERIFY(!serviceBinary.isEmpty());
     const QFileInfo serviceBinaryInfo(serviceBinary);
@@ -571,6 +610,101 @@ void tst_QServiceManager_IPC::uniqueTestService()
     QCOMPARE(hashOther, (uint)0);
 }
 
+void tst_QServiceManager_IPC::verifyConnectionSharing()
+{
+#if defined(Q_OS_LINUX) && !defined(SFW_USE_DBUS_BACKEND)
+    QServiceInterfaceDescriptor d;
+    foreach (const QServiceInterfaceDescriptor &descriptor, manager->findInterfaces("IPCExampleService")) {
+        if (descriptor.majorVersion() == 3 && descriptor.minorVersion() == 5)
+            d = descriptor;
+    }
+    QVERIFY(d.isValid());
+
+    // the service is running already, new proxies share its connection
+    QDir fds(QStringLiteral("/proc/self/fd"));
+    const int openFds = int(fds.count());
+    QList<QObject *> proxies;
+    for (int i = 0; i < 5; i++) {
+        QObject *o = manager->loadInterface(d);
+        QVERIFY(o);
+        proxies.append(o);
+    }
+    fds.refresh();
+    // descriptors closing meanwhile only lower the count
+    QVERIFY(int(fds.count()) - openFds < proxies.count());
+
+    // every proxy still has an instance of its own
+    uint hash = 0;
+    QMetaObject::invokeMethod(proxies.at(0), "setConfirmationHash", Q_ARG(uint, 7));
+    QMetaObject::invokeMethod(proxies.at(1), "setConfirmationHash", Q_ARG(uint, 3));
+    QMetaObject::invokeMethod(proxies.at(0), "slotConfirmation", Q_RETURN_ARG(uint, hash));
+    QCOMPARE(hash, (uint)7);
+
+    // and dropping one leaves the others on the connection working
+    delete proxies.takeFirst();
+    QMetaObject::invokeMethod(proxies.at(0), "slotConfirmation", Q_RETURN_ARG(uint, hash));
+    QCOMPARE(hash, (uint)3);
+
+    qDeleteAll(proxies);
+    QVERIFY(serviceUnique->property("value").isValid());
+
+    // a blocking call on one proxy dispatches the packages of the other
+    // proxies on the connection while it waits, so the other proxy of the
+    // shared instance has its signal once the read after the write returns
+    QSignalSpy otherSpy(serviceSharedOther, SIGNAL(valueChanged()));
+    const QString sharedValue = serviceShared->property("value").toString();
+    serviceShared->setProperty("value", sharedValue + QLatin1String("-shared"));
+    QCOMPARE(serviceShared->property("value").toString(), sharedValue + QLatin1String("-shared"));
+    QCOMPARE(otherSpy.count(), 1);
+    serviceShared->setProperty("value", sharedValue);
+    QTRY_COMPARE(otherSpy.count(), 2);
+#else
+    QSKIP("Connections are only shared by the unix socket backend");
+#endif
+}
+
+void tst_QServiceManager_IPC::verifyCallStatistics()
+{
+#ifndef SFW_USE_DBUS_BACKEND
+    QServiceLatencyHistogram histogram;
+    for (quint64 usec = 1; usec <= 1000; ++usec)
+        histogram.record(usec);
+    QCOMPARE(histogram.count(), quint64(1000));
+    QCOMPARE(histogram.maximum(), quint64(1000));
+    QVERIFY(qAbs(qint64(histogram.percentile(50)) - 500) <= 500 / 8);
+    QVERIFY(qAbs(qint64(histogram.percentile(99)) - 990) <= 990 / 8);
+
+    QServiceIpcStatistics::reset();
+    uint hash = 0;
+    for (int i = 0; i < 10; i++)
+        QMetaObject::invokeMethod(serviceUnique, "slotConfirmation", Q_RETURN_ARG(uint, hash));
+
+    QServiceMethodStatistics *stats = QServiceIpcStatistics::method(QServiceIpcStatistics::Client,
+            QStringLiteral("com.nokia.qt.ipcunittest"), "slotConfirmation()");
+    QCOMPARE(stats->calls.load(), quint64(10));
+    QCOMPARE(stats->latency.count(), quint64(10));
+    QVERIFY(stats->bytesOut.load() > 0);
+    QVERIFY(stats->bytesIn.load() > 0);
+    QVERIFY(QServiceIpcStatistics::transport()->packagesWritten.load() >= 10);
+
+    // the service reports the calls it executed
+    const QJsonObject snapshot = QServiceIpcStatistics::query(QStringLiteral("qt_sfw_example_ipc_unittest"));
+    QVERIFY(!snapshot.isEmpty());
+    bool found = false;
+    foreach (const QJsonValue &value, snapshot.value(QStringLiteral("methods")).toArray()) {
+        const QJsonObject method = value.toObject();
+        if (method.value(QStringLiteral("side")).toString() == QLatin1String("service")
+                && method.value(QStringLiteral("method")).toString() == QLatin1String("slotConfirmation()")) {
+            QVERIFY(method.value(QStringLiteral("calls")).toDouble() >= 10);
+            found = true;
+        }
+    }
+    QVERIFY(found);
+#else
+    QSKIP("Call statistics are not collected by the D-Bus backend");
+#endif
+}
+
 void tst_QServiceManager_IPC::verifySharedServiceObject()
 {
     QVERIFY(serviceShared != 0);
@@ -772,8 +906,8 @@ void tst_QServiceManager_IPC::verifyUniqueServiceObject()
     QVERIFY(mo->superClass());
     QCOMPARE(mo->superClass()->className(), "QServiceProxyBase");
     // TODO adding the ipc failure signal seems to break these
-    QCOMPARE(mo->methodCount()-mo-> methodOffset(), 27); // 28+1 added signal for error signal added by library
-    QCOMPARE(mo->methodCount(), 33); //33 meta functions available + 1 signal
+    QCOMPARE(mo->methodCount()-mo-> methodOffset(), 30); // 31+1 added signal for error signal added by library
+    QCOMPARE(mo->methodCount(), 36); //36 meta functions available + 1 signal
     //actual function presence will be tested later
 
 //    for (int i = 0; i < mo->methodCount(); i++) {
@@ -870,6 +1004,8 @@ void tst_QServiceManager_IPC::verifyUniqueMethods_data()
         << QByteArray("testSlotWithArgs(QByteArray,int,QVariant)") <<  (int)( QMetaMethod::Slot) << QByteArray("void");
     QTest::newRow("testSlotWithCustomArg(QServiceFilter)")
         << QByteArray("testSlotWithCustomArg(QServiceFilter)") <<  (int)( QMetaMethod::Slot) << QByteArray("void");
+    QTest::newRow("testSlotWithManyArgs(int,...)")
+        << QByteArray("testSlotWithManyArgs(int,int,int,int,int,int,int,int,int,int,int)") <<  (int)( QMetaMethod::Slot) << QByteArray("void");
 
     //QServiceInterfaceDescriptor has not been declared as meta type
     QTest::newRow("testSlotWithUnknownArg(QServiceInterfaceDescriptor)")
@@ -1169,6 +1305,55 @@ void tst_QServiceManager_IPC::testSignalling()
     QCOMPARE(variousSpy.at(0).at(3).value<QVariant>(), QVariant(5));
 }
 
+void tst_QServiceManager_IPC::testSignalSubscription()
+{
+    // The service only forwards signals the client is connected to,
+    // make sure forwarding resumes after the last connection is dropped
+    QCOMPARE(QString("FFF"), serviceUnique->property("value").toString());
+    QSignalSpy firstSpy(serviceUnique, SIGNAL(valueChanged()));
+    serviceUnique->setProperty("value", QString("GGG"));
+    QTRY_COMPARE(firstSpy.count(), 1);
+
+    QVERIFY(QObject::disconnect(serviceUnique, SIGNAL(valueChanged()), &firstSpy, 0));
+    serviceUnique->setProperty("value", QString("HHH"));
+    QCOMPARE(QString("HHH"), serviceUnique->property("value").toString());
+
+#ifndef SFW_USE_DBUS_BACKEND
+    // Without a connection the service must not send the signal at all.
+    // slotConfirmation() is answered after any signal emitted before it,
+    // so the packages read up to its reply include a forwarded signal.
+    uint hash = 0;
+    QServiceIpcStatistics::reset();
+    serviceUnique->setProperty("value", QString("III"));
+    QMetaObject::invokeMethod(serviceUnique, "slotConfirmation", Q_RETURN_ARG(uint, hash));
+    QCoreApplication::processEvents();
+    const quint64 unsubscribedPackages = QServiceIpcStatistics::transport()->packagesRead.load();
+
+    QSignalSpy countingSpy(serviceUnique, SIGNAL(valueChanged()));
+    QServiceIpcStatistics::reset();
+    serviceUnique->setProperty("value", QString("HHH"));
+    QMetaObject::invokeMethod(serviceUnique, "slotConfirmation", Q_RETURN_ARG(uint, hash));
+    QTRY_COMPARE(countingSpy.count(), 1);
+    const quint64 subscribedPackages = QServiceIpcStatistics::transport()->packagesRead.load();
+    QCOMPARE(subscribedPackages, unsubscribedPackages + 1);
+    QVERIFY(QObject::disconnect(serviceUnique, SIGNAL(valueChanged()), &countingSpy, 0));
+
+    // once the last connection is gone, forwarding stops again
+    QServiceIpcStatistics::reset();
+    serviceUnique->setProperty("value", QString("III"));
+    QMetaObject::invokeMethod(serviceUnique, "slotConfirmation", Q_RETURN_ARG(uint, hash));
+    QCoreApplication::processEvents();
+    QCOMPARE(QServiceIpcStatistics::transport()->packagesRead.load(), unsubscribedPackages);
+    QCOMPARE(countingSpy.count(), 1);
+#endif
+
+    QSignalSpy secondSpy(serviceUnique, SIGNAL(valueChanged()));
+    serviceUnique->setProperty("value", QString("FFF"));
+    QTRY_COMPARE(secondSpy.count(), 1);
+    QCOMPARE(firstSpy.count(), 1);
+    QCOMPARE(QString("FFF"), serviceUnique->property("value").toString());
+}
+
 void tst_QServiceManager_IPC::testSlotInvokation()
 {
     QObject *service = serviceUnique;
@@ -1211,6 +1396,22 @@ void tst_QServiceManager_IPC::testSlotInvokation()
                               Q_RETURN_ARG(uint, hash));
     QVERIFY(hash != 1);
 
+    // Test slot with more arguments than QMetaObject::invokeMethod() can pass
+    const int manyArgsIndex = service->metaObject()->indexOfMethod(
+                "testSlotWithManyArgs(int,int,int,int,int,int,int,int,int,int,int)");
+    QVERIFY(manyArgsIndex >= 0);
+    int values[11];
+    void *argv[12];
+    argv[0] = 0;
+    for (int i = 0; i < 11; ++i) {
+        values[i] = i + 1;
+        argv[i + 1] = &values[i];
+    }
+    QMetaObject::metacall(service, QMetaObject::InvokeMetaMethod, manyArgsIndex, argv);
+    QMetaObject::invokeMethod(service, "slotConfirmation",
+                              Q_RETURN_ARG(uint, hash));
+    QCOMPARE(hash, (uint)66);
+
     // Test slot function with custom argument
     QServiceFilter f("com.myInterface" , "4.5");
     f.setServiceName("MyService");
@@ -1307,10 +1508,123 @@ void tst_QServiceManager_IPC::verifyLargeDataTransfer_data()
     QTest::newRow("32k") << QByteArray(32768, 'A');
     QTest::newRow("64k") << QByteArray(65536, 'A');
     QTest::newRow("128k") << QByteArray(131072, 'A');
+    QTest::newRow("256k") << QByteArray(262144, 'A');
     QTest::newRow("1 megabyte") << QByteArray(1048576, 'A');
+    QTest::newRow("8 megabytes") << QByteArray(8388608, 'A');
     QTest::newRow("Free mem") << QByteArray("");
 }
 
+#if defined(SFW_USE_UNIX_BACKEND) && defined(SYS_memfd_create)
+/*
+    Connects to the test service directly and sends it a payload segment
+    frame which claims \a frameSize bytes, passing a memfd segment of
+    \a segmentSize bytes along. Returns true if the service drops the
+    connection on it.
+*/
+static bool serviceRejectsSegment(int segmentSize, quint32 frameSize, bool sealed)
+{
+    const QByteArray path = QFile::encodeName(QDir::cleanPath(QDir::tempPath())
+                                              + QLatin1String("/qt_sfw_example_ipc_unittest"));
+    struct sockaddr_un name;
+    memset(&name, 0, sizeof(name));
+    name.sun_family = AF_UNIX;
+    qstrncpy(name.sun_path, path.constData(), sizeof(name.sun_path));
+
+    const int sock = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1)
+        return false;
+    if (::connect(sock, (struct sockaddr *)&name, sizeof(name)) == -1) {
+        ::close(sock);
+        return false;
+    }
+
+    int segment = ::syscall(SYS_memfd_create, "tst-payload", MFD_ALLOW_SEALING);
+    if (segment == -1 || ::ftruncate(segment, segmentSize) == -1
+            || (sealed && ::fcntl(segment, F_ADD_SEALS,
+                                  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)) {
+        if (segment != -1)
+            ::close(segment);
+        ::close(sock);
+        return false;
+    }
+
+    QByteArray frame;
+    QDataStream out(&frame, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << quint32(0xffffffffu) << frameSize;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov;
+    iov.iov_base = frame.data();
+    iov.iov_len = frame.size();
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &segment, sizeof(int));
+    const bool sent = ::sendmsg(sock, &msg, 0) == frame.size();
+    ::close(segment);
+
+    bool closed = false;
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (sent && ::poll(&pfd, 1, 5000) == 1) {
+        char c;
+        closed = ::recv(sock, &c, 1, 0) <= 0;
+    }
+    ::close(sock);
+    return closed;
+}
+#endif
+
+void tst_QServiceManager_IPC::verifyPayloadSegments()
+{
+#if defined(SFW_USE_UNIX_BACKEND) && defined(SYS_memfd_create)
+    // well above the segment threshold, and patterned so that misplaced
+    // pages are noticed
+    QByteArray data(512 * 1024, '\0');
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = char(i % 251);
+
+    QSignalSpy spy(serviceUnique, SIGNAL(dataReturned(QByteArray)));
+    QServiceIpcStatistics::reset();
+
+    // slot argument, return value and signal argument each take a segment
+    QMetaObject::invokeMethod(serviceUnique, "testSlotWithData", Q_ARG(QByteArray, data));
+    QByteArray returned;
+    QMetaObject::invokeMethod(serviceUnique, "testInvoableWithReturnData", Q_RETURN_ARG(QByteArray, returned));
+    QCOMPARE(returned, data);
+    QMetaObject::invokeMethod(serviceUnique, "emitData");
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toByteArray(), data);
+
+    // only the frames of the segments went through the socket
+    QVERIFY(QServiceIpcStatistics::transport()->bytesWritten.load() < quint64(data.size()));
+    QVERIFY(QServiceIpcStatistics::transport()->bytesRead.load() < quint64(data.size()));
+
+    // the service refuses segments the sender can still modify and ones
+    // smaller than their frame claims
+    QVERIFY(serviceRejectsSegment(4096, 4096, false));
+    QVERIFY(serviceRejectsSegment(4096, 8192, true));
+
+    // and keeps serving the other connections
+    QMetaObject::invokeMethod(serviceUnique, "testInvoableWithReturnData", Q_RETURN_ARG(QByteArray, returned));
+    QCOMPARE(returned, data);
+    QMetaObject::invokeMethod(serviceUnique, "testSlotWithData", Q_ARG(QByteArray, QByteArray()));
+#else
+    QSKIP("Payload segments are only used by the unix socket backend on Linux");
+#endif
+}
+
 class FetchLotsOfProperties : public QThread
 {
     Q_OBJECT
@@ -1551,6 +1865,66 @@ void tst_QServiceManager_IPC::verifyRemoteBlockingFunctions()
 #endif
 }
 
+class CallCanceller : public QThread
+{
+public:
+    CallCanceller(QObject *service) : service(service) {}
+
+protected:
+    void run()
+    {
+        msleep(200);
+        QServiceManager::cancelInterProcessCalls(service);
+    }
+
+private:
+    QObject *service;
+};
+
+void tst_QServiceManager_IPC::verifyCallTimeout()
+{
+#ifdef SFW_USE_DBUS_BACKEND
+    QSKIP("The D-Bus backend does not support call timeouts");
+#else
+    QVERIFY(!QServiceManager::setInterProcessCallTimeout(this, 500));
+    QCOMPARE(QServiceManager::interProcessCallTimeout(this), 0);
+
+    // nothing may release the service while the calls are blocked
+    disconnect(serviceUnique, SIGNAL(blockingValueRead()), this, SLOT(unblockRemote()));
+
+    const int timeout = QServiceManager::interProcessCallTimeout(serviceUnique);
+    QVERIFY(QServiceManager::setInterProcessCallTimeout(serviceUnique, 500));
+    QCOMPARE(QServiceManager::interProcessCallTimeout(serviceUnique), 500);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QCOMPARE(serviceUnique->property("blockingValue").toString(), QString());
+    QVERIFY(elapsed.elapsed() >= 400);
+    QVERIFY(elapsed.elapsed() < 5000);
+
+    // the late reply of the failed call doesn't disturb the next ones
+    QCOMPARE(serviceUnique->property("releaseBlockingRead").toString(),
+             QStringLiteral("releaseBlockingReadReturned"));
+    QString result;
+    QVERIFY(QMetaObject::invokeMethod(serviceUnique, "testFunctionWithReturnValue",
+                                      Q_RETURN_ARG(QString, result), Q_ARG(int, 4)));
+    QCOMPARE(result, QStringLiteral("4 + 3 = 7"));
+
+    // a call without a timeout is cancelled from another thread
+    QVERIFY(QServiceManager::setInterProcessCallTimeout(serviceUnique, -1));
+    CallCanceller canceller(serviceUnique);
+    elapsed.restart();
+    canceller.start();
+    QCOMPARE(serviceUnique->property("blockingValue").toString(), QString());
+    QVERIFY(elapsed.elapsed() < 5000);
+    QVERIFY(canceller.wait(5000));
+
+    QVERIFY(QServiceManager::setInterProcessCallTimeout(serviceUnique, timeout));
+    QCOMPARE(serviceUnique->property("releaseBlockingRead").toString(),
+             QStringLiteral("releaseBlockingReadReturned"));
+#endif
+}
+
 void tst_QServiceManager_IPC::testSignalSlotOrdering()
 {
     QSignalSpy spy(serviceUnique, SIGNAL(count(int)));
@@ -1693,6 +2067,125 @@ void tst_QServiceManager_IPC::verifyAsyncLoading_data()
 
 }
 
+void tst_QServiceManager_IPC::verifyConcurrentAsyncLoading()
+{
+    const int count = 8;
+    QServiceManager mgr;
+
+    //four different requests, more than there are operation threads
+    QServiceInterfaceDescriptor unique;
+    QServiceInterfaceDescriptor shared;
+    QServiceInterfaceDescriptor misc;
+    foreach (const QServiceInterfaceDescriptor &d, mgr.findInterfaces("IPCExampleService")) {
+        if (d.majorVersion() == 3 && d.minorVersion() == 5)
+            unique = d;
+        else if (d.majorVersion() == 3 && d.minorVersion() == 4)
+            shared = d;
+        else if (d.majorVersion() == 3 && d.minorVersion() == 8)
+            misc = d;
+    }
+    QVERIFY(unique.isValid());
+    QVERIFY(shared.isValid());
+    QVERIFY(misc.isValid());
+
+    QList<QServiceReply *> uniqueReplies;
+    QList<QServiceReply *> sharedReplies;
+    QList<QServiceReply *> replies;
+    for (int i = 0; i < count; ++i) {
+        uniqueReplies.append(mgr.loadInterfaceRequest(unique));
+        sharedReplies.append(mgr.loadInterfaceRequest(shared));
+        replies.append(mgr.loadInterfaceRequest(misc));
+        replies.append(mgr.loadInterfaceRequest(QStringLiteral("com.nokia.qt.ipcunittest")));
+    }
+    replies += uniqueReplies;
+    replies += sharedReplies;
+
+#ifdef QT_BUILD_INTERNAL
+    QVERIFY(QServiceOperations::instance()->workerCount() <= operationThreadsC);
+#endif
+
+    //every reply finishes with an object of its own
+    QSet<QObject *> objects;
+    foreach (QServiceReply *reply, replies) {
+        QTRY_VERIFY(reply->isFinished());
+        QCOMPARE(reply->error(), QServiceManager::NoError);
+        QVERIFY(reply->proxyObject());
+        objects.insert(reply->proxyObject());
+    }
+    QCOMPARE(objects.count(), replies.count());
+
+#ifdef QT_BUILD_INTERNAL
+    QVERIFY(QServiceOperations::instance()->workerCount() <= operationThreadsC);
+#endif
+
+    //private instances are separate in the service, the global one is shared
+    QObject *firstUnique = uniqueReplies.first()->proxyObject();
+    firstUnique->setProperty("value", QStringLiteral("concurrent"));
+    QCOMPARE(firstUnique->property("value").toString(), QStringLiteral("concurrent"));
+    for (int i = 1; i < count; ++i)
+        QCOMPARE(uniqueReplies.at(i)->proxyObject()->property("value").toString(), QStringLiteral("FFF"));
+
+    QObject *firstShared = sharedReplies.first()->proxyObject();
+    const QVariant sharedValue = firstShared->property("value");
+    firstShared->setProperty("value", QStringLiteral("concurrent"));
+    QCOMPARE(firstShared->property("value").toString(), QStringLiteral("concurrent"));
+    for (int i = 1; i < count; ++i)
+        QCOMPARE(sharedReplies.at(i)->proxyObject()->property("value").toString(), QStringLiteral("concurrent"));
+    firstShared->setProperty("value", sharedValue);
+    QCOMPARE(firstShared->property("value"), sharedValue);
+
+    qDeleteAll(objects);
+    qDeleteAll(replies);
+}
+
+void tst_QServiceManager_IPC::verifyCoalescedAsyncFailures()
+{
+    QFETCH(QString, serviceInterface);
+    QFETCH(int, descriptor);
+    QFETCH(int, expectedError);
+
+    const int count = 8;
+    QServiceManager mgr;
+
+    QServiceInterfaceDescriptor d;
+    if (descriptor > 0) {
+        foreach (const QServiceInterfaceDescriptor &candidate, mgr.findInterfaces("IPCExampleService")) {
+            if (candidate.majorVersion() == 3 && candidate.minorVersion() == descriptor)
+                d = candidate;
+        }
+        QVERIFY(d.isValid());
+    }
+
+    //the requests after the first wait for it and share its outcome
+    QList<QServiceReply *> replies;
+    for (int i = 0; i < count; ++i) {
+        if (descriptor > 0)
+            replies.append(mgr.loadInterfaceRequest(d));
+        else
+            replies.append(mgr.loadInterfaceRequest(serviceInterface));
+    }
+
+    foreach (QServiceReply *reply, replies) {
+        QTRY_VERIFY(reply->isFinished());
+        QCOMPARE(int(reply->error()), expectedError);
+        QVERIFY(!reply->proxyObject());
+    }
+
+    qDeleteAll(replies);
+}
+
+void tst_QServiceManager_IPC::verifyCoalescedAsyncFailures_data()
+{
+    QTest::addColumn<QString>("serviceInterface");
+    QTest::addColumn<int>("descriptor");
+    QTest::addColumn<int>("expectedError");
+
+    QTest::newRow("no default interface") << QString("com.nokia.qt.ipcunittest.does.not.exist") << 0
+            << int(QServiceManager::InvalidServiceInterfaceDescriptor);
+    QTest::newRow("service object creation fails") << QString() << 6
+            << int(QServiceManager::InvalidServiceLocation);
+}
+
 void tst_QServiceManager_IPC::testIpcFailure()
 {
     // test deleting an object doesn't trigger an IPC fault
@@ -340,6 +340,7 @@ Q_SIGNALS:
     void priorityChanged();
     void count(int value);
     void blockingValueRead();
+    void dataReturned(const QByteArray &data);
 
 public slots:
     void triggerSignalWithIntParam()
@@ -420,11 +421,22 @@ public slots:
         m_data = data;
     }
 
+    void testSlotWithManyArgs(int a0, int a1, int a2, int a3, int a4, int a5,
+                              int a6, int a7, int a8, int a9, int a10)
+    {
+        m_hash = a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9 + a10;
+    }
+
     QByteArray testInvoableWithReturnData()
     {
         return m_data;
     }
 
+    void emitData()
+    {
+        emit dataReturned(m_data);
+    }
+
     int testSignalSlotOrdering() {
         m_count = 0;
         QMetaObject::invokeMethod(this, "generateSignal", Qt::QueuedConnection);
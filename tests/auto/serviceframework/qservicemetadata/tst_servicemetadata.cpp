@@ -309,6 +309,9 @@ void ServiceMetadataTest::checkVersion_data()
     QTest::newRow("checkVersion_data():Invalid 29") << "4,8" << false << -1 << -1;
     QTest::newRow("checkVersion_data():Invalid 30") << "  " << false << -1 << -1;
     QTest::newRow("checkVersion_data():Invalid 31") << "1.9b" << false << -1 << -1;
+    QTest::newRow("checkVersion_data():Invalid 32") << "1.0.0" << false << -1 << -1;
+    QTest::newRow("checkVersion_data():Invalid 33") << "4294967296.0" << false << -1 << -1;
+    QTest::newRow("checkVersion_data():Invalid 34") << "1.4294967296" << false << -1 << -1;
 
     QTest::newRow("checkVersion_data():Valid 1") << "1.0" << true << 1 << 0;
     QTest::newRow("checkVersion_data():Valid 2") << "1.00" << true << 1 << 0;
@@ -317,6 +320,8 @@ void ServiceMetadataTest::checkVersion_data()
     QTest::newRow("checkVersion_data():Valid 5") << "10.3" << true << 10 << 3;
     QTest::newRow("checkVersion_data():Valid 6") << "5.10" << true << 5 << 10;
     QTest::newRow("checkVersion_data():Valid 7") << "10.10" << true << 10 << 10;
+    QTest::newRow("checkVersion_data():Valid 8") << "1.000" << true << 1 << 0;
+    QTest::newRow("checkVersion_data():Valid 9") << "2147483647.1" << true << 2147483647 << 1;
 }
 
 void ServiceMetadataTest::checkVersion()
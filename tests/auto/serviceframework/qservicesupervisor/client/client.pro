@@ -0,0 +1,12 @@
+TARGET = tst_qservicesupervisor
+CONFIG += testcase
+
+QT = core serviceframework serviceframework-private testlib
+
+CONFIG -= app_bundle
+
+contains(QT.serviceframework.module_config, sfw_unix_backend): DEFINES += SFW_USE_UNIX_BACKEND
+
+SOURCES += tst_qservicesupervisor.cpp
+
+TESTDATA += xmldata/*
@@ -0,0 +1,389 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/serviceframework
+
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QThread>
+#include <QtTest/QtTest>
+#include <qservicemanager.h>
+#include <private/qservicesupervisor_p.h>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+QT_USE_NAMESPACE
+
+static const char serviceAddressC[] = "qt_sfw_supervisor_unittest";
+static const char serviceBinaryC[] = "qt_sfw_supervisor_unittest";
+
+/*
+    Runs the supervisor on its own thread. The client side of the test
+    blocks in loadInterface() and in remote calls, which would keep a
+    supervisor on the test thread from accepting the service's clients.
+    The signals are re-emitted on the test thread.
+*/
+class SupervisorThread : public QThread
+{
+    Q_OBJECT
+public:
+    SupervisorThread(QServiceSupervisor::StartPolicy policy, int idleTimeout,
+                     const QString &program)
+        : policy(policy), idleTimeout(idleTimeout), program(program), added(false)
+    {
+    }
+
+    ~SupervisorThread()
+    {
+        quit();
+        wait();
+    }
+
+    bool startSupervisor()
+    {
+        start();
+        ready.acquire();
+        return added;
+    }
+
+Q_SIGNALS:
+    void serviceStarted(const QString &address, qint64 pid);
+    void serviceFinished(const QString &address, int exitCode);
+
+protected:
+    void run()
+    {
+        QServiceSupervisor supervisor;
+        supervisor.setStartPolicy(policy);
+        supervisor.setIdleTimeout(idleTimeout);
+        connect(&supervisor, SIGNAL(serviceStarted(QString,qint64)),
+                this, SIGNAL(serviceStarted(QString,qint64)));
+        connect(&supervisor, SIGNAL(serviceFinished(QString,int)),
+                this, SIGNAL(serviceFinished(QString,int)));
+
+        added = supervisor.addService(QLatin1String(serviceAddressC), program);
+        ready.release();
+        if (added)
+            exec();
+    }
+
+private:
+    QServiceSupervisor::StartPolicy policy;
+    int idleTimeout;
+    QString program;
+    bool added;
+    QSemaphore ready;
+};
+
+static QByteArray serviceSocketPath()
+{
+    return QFile::encodeName(QDir::cleanPath(QDir::tempPath()) + QLatin1Char('/')
+                             + QLatin1String(serviceAddressC));
+}
+
+/*
+    Loads the service in a thread of its own once \a go is released, so
+    that several of them race to start it.
+*/
+class ClientThread : public QThread
+{
+public:
+    ClientThread(QSemaphore *go)
+        : pid(0), go(go)
+    {
+    }
+
+    qint64 pid;
+
+protected:
+    void run()
+    {
+        go->acquire();
+        QServiceManager manager;
+        QObject *service = manager.loadInterface(QStringLiteral("com.nokia.qt.supervisorunittest"));
+        if (!service)
+            return;
+        QMetaObject::invokeMethod(service, "processId", Q_RETURN_ARG(qint64, pid));
+        delete service;
+    }
+
+private:
+    QSemaphore *go;
+};
+
+class tst_QServiceSupervisor: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void idleTimeout();
+    void restartKilledService();
+
+    void adoptListenSocket();
+    void replaceStaleSocket();
+    void concurrentStart();
+
+private:
+    QObject *loadService();
+    static qint64 processId(QObject *service);
+    void stopService(qint64 pid);
+
+    QString serviceBinary;
+    QList<qint64> startedPids;
+};
+
+void tst_QServiceSupervisor::initTestCase()
+{
+#ifndef SFW_USE_UNIX_BACKEND
+    QSKIP("The supervisor needs the unix backend");
+#endif
+    serviceBinary = QFINDTESTDATA(serviceBinaryC);
+    QVERIFY(!serviceBinary.isEmpty());
+    serviceBinary = QFileInfo(serviceBinary).absoluteFilePath();
+
+    // clients start services by their address, which is looked up in PATH
+    const QByteArray searchPath = qgetenv("PATH");
+    qputenv("PATH", QFile::encodeName(QFileInfo(serviceBinary).absolutePath()) + ':' + searchPath);
+
+    const QString path = QFINDTESTDATA("xmldata/supervisedservice.xml");
+    QVERIFY(!path.isEmpty());
+
+    QServiceManager manager;
+    manager.removeService(QStringLiteral("SupervisedService"));
+    QVERIFY(manager.addService(path));
+}
+
+void tst_QServiceSupervisor::cleanupTestCase()
+{
+    foreach (qint64 pid, startedPids)
+        stopService(pid);
+
+    QServiceManager manager;
+    manager.removeService(QStringLiteral("SupervisedService"));
+}
+
+QObject *tst_QServiceSupervisor::loadService()
+{
+    QServiceManager manager;
+    return manager.loadInterface(QStringLiteral("com.nokia.qt.supervisorunittest"));
+}
+
+qint64 tst_QServiceSupervisor::processId(QObject *service)
+{
+    qint64 pid = 0;
+    if (!QMetaObject::invokeMethod(service, "processId", Q_RETURN_ARG(qint64, pid)))
+        return 0;
+    return pid;
+}
+
+/*
+    Kills a service started by a client of the test, which leaves its
+    socket behind.
+*/
+void tst_QServiceSupervisor::stopService(qint64 pid)
+{
+#ifdef Q_OS_UNIX
+    startedPids.removeAll(pid);
+    ::kill(pid_t(pid), SIGKILL);
+    ::waitpid(pid_t(pid), 0, 0);
+#else
+    Q_UNUSED(pid);
+#endif
+    // the pooled connection to it goes away with the last proxy
+    QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+}
+
+void tst_QServiceSupervisor::idleTimeout()
+{
+    const int timeout = 1000;
+    SupervisorThread supervisor(QServiceSupervisor::StartOnDemand, timeout, serviceBinary);
+    QSignalSpy started(&supervisor, SIGNAL(serviceStarted(QString,qint64)));
+    QSignalSpy finished(&supervisor, SIGNAL(serviceFinished(QString,int)));
+    QVERIFY(supervisor.startSupervisor());
+
+    //on demand, nothing runs until a client connects
+    QTest::qWait(200);
+    QCOMPARE(started.count(), 0);
+
+    QObject *service = loadService();
+    QVERIFY(service);
+    QTRY_COMPARE(started.count(), 1);
+    const qint64 pid = started.at(0).at(1).toLongLong();
+    QCOMPARE(processId(service), pid);
+
+    //a connected client keeps the service up past the idle timeout
+    QTest::qWait(timeout + 500);
+    QCOMPARE(finished.count(), 0);
+    QCOMPARE(processId(service), pid);
+
+    //the service waits for the idle timeout after the last client left...
+    delete service;
+    QTest::qWait(timeout / 4);
+    QCOMPARE(finished.count(), 0);
+
+    //...and then quits normally
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5 * timeout);
+    QCOMPARE(finished.at(0).at(1).toInt(), 0);
+    QCOMPARE(started.count(), 1);
+}
+
+void tst_QServiceSupervisor::restartKilledService()
+{
+#ifdef Q_OS_UNIX
+    SupervisorThread supervisor(QServiceSupervisor::StartImmediately, -1, serviceBinary);
+    QSignalSpy started(&supervisor, SIGNAL(serviceStarted(QString,qint64)));
+    QSignalSpy finished(&supervisor, SIGNAL(serviceFinished(QString,int)));
+    QVERIFY(supervisor.startSupervisor());
+
+    //the first process is started without waiting for a client
+    QTRY_COMPARE(started.count(), 1);
+    const qint64 pid = started.at(0).at(1).toLongLong();
+
+    QObject *service = loadService();
+    QVERIFY(service);
+    QCOMPARE(processId(service), pid);
+    delete service;
+
+    QCOMPARE(::kill(pid_t(pid), SIGKILL), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(started.count(), 2, 5000);
+    const qint64 restartedPid = started.at(1).at(1).toLongLong();
+    QVERIFY(restartedPid != pid);
+
+    //clients get the restarted process
+    service = loadService();
+    QVERIFY(service);
+    QCOMPARE(processId(service), restartedPid);
+    delete service;
+#else
+    QSKIP("Needs kill(2)");
+#endif
+}
+
+void tst_QServiceSupervisor::adoptListenSocket()
+{
+#ifdef Q_OS_UNIX
+    const QByteArray socketPath = serviceSocketPath();
+    ::unlink(socketPath.constData());
+
+    // the client listens on the address and hands the socket to the
+    // service it starts
+    QObject *service = loadService();
+    QVERIFY(service);
+    const qint64 pid = processId(service);
+    QVERIFY(pid > 0);
+    startedPids.append(pid);
+    QCOMPARE(::waitpid(pid_t(pid), 0, WNOHANG), pid_t(0));
+
+    bool adopted = false;
+    QVERIFY(QMetaObject::invokeMethod(service, "adoptedListenSocket", Q_RETURN_ARG(bool, adopted)));
+    QVERIFY(adopted);
+    delete service;
+
+    stopService(pid);
+#else
+    QSKIP("Clients only start services on unix");
+#endif
+}
+
+void tst_QServiceSupervisor::replaceStaleSocket()
+{
+#ifdef Q_OS_UNIX
+    const QByteArray socketPath = serviceSocketPath();
+
+    // a socket nobody listens on any more, as a killed service leaves it
+    struct sockaddr_un name;
+    memset(&name, 0, sizeof(name));
+    name.sun_family = AF_UNIX;
+    qstrncpy(name.sun_path, socketPath.constData(), sizeof(name.sun_path));
+    ::unlink(socketPath.constData());
+    const int fd = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    QVERIFY(fd != -1);
+    QCOMPARE(::bind(fd, (struct sockaddr *)&name, sizeof(name)), 0);
+    QCOMPARE(::listen(fd, 1), 0);
+    ::close(fd);
+    QVERIFY(QFile::exists(QFile::decodeName(socketPath)));
+
+    QObject *service = loadService();
+    QVERIFY(service);
+    const qint64 pid = processId(service);
+    QVERIFY(pid > 0);
+    startedPids.append(pid);
+
+    bool adopted = false;
+    QVERIFY(QMetaObject::invokeMethod(service, "adoptedListenSocket", Q_RETURN_ARG(bool, adopted)));
+    QVERIFY(adopted);
+    delete service;
+
+    stopService(pid);
+#else
+    QSKIP("Clients only start services on unix");
+#endif
+}
+
+void tst_QServiceSupervisor::concurrentStart()
+{
+#ifdef Q_OS_UNIX
+    const QByteArray socketPath = serviceSocketPath();
+    ::unlink(socketPath.constData());
+
+    // both clients find no service, only one of them may start it
+    QSemaphore go;
+    ClientThread first(&go);
+    ClientThread second(&go);
+    first.start();
+    second.start();
+    go.release(2);
+    QVERIFY(first.wait(30000));
+    QVERIFY(second.wait(30000));
+
+    QVERIFY(first.pid > 0);
+    startedPids.append(first.pid);
+    if (second.pid != first.pid && second.pid > 0)
+        startedPids.append(second.pid);
+    QCOMPARE(second.pid, first.pid);
+
+    stopService(first.pid);
+#else
+    QSKIP("Clients only start services on unix");
+#endif
+}
+
+QTEST_MAIN(tst_QServiceSupervisor)
+#include "tst_qservicesupervisor.moc"
@@ -0,0 +1,80 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <qremoteserviceregister.h>
+
+QT_USE_NAMESPACE
+
+static bool listenSocketAdopted = false;
+
+class SupervisedService : public QObject
+{
+    Q_OBJECT
+public:
+    SupervisedService(QObject *parent = 0)
+        : QObject(parent)
+    {
+    }
+
+    Q_INVOKABLE qint64 processId() const
+    {
+        return QCoreApplication::applicationPid();
+    }
+
+    Q_INVOKABLE bool adoptedListenSocket() const
+    {
+        return listenSocketAdopted;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // the idle timeout and the listening socket come from the supervisor
+    QRemoteServiceRegister* serviceRegister = new QRemoteServiceRegister();
+
+    QRemoteServiceRegister::Entry entry =
+        serviceRegister->createEntry<SupervisedService>(
+                "SupervisedService", "com.nokia.qt.supervisorunittest", "1.0");
+    entry.setInstantiationType(QRemoteServiceRegister::GlobalInstance);
+
+    // publishEntries() takes over a listening socket passed by whoever
+    // started the service and clears the variable naming it
+    const bool listenSocketPassed = !qgetenv("SFW_LISTEN_FD").isEmpty();
+    serviceRegister->publishEntries("qt_sfw_supervisor_unittest");
+    listenSocketAdopted = listenSocketPassed && qgetenv("SFW_LISTEN_FD").isEmpty();
+    int res = app.exec();
+    delete serviceRegister;
+
+    return res;
+}
+
+#include "main.moc"
@@ -0,0 +1,20 @@
+TARGET = qt_sfw_supervisor_unittest
+TEMPLATE = app
+QT = core serviceframework
+
+mac {
+    CONFIG -= app_bundle
+}
+
+debug_and_release {
+    CONFIG(debug, debug|release): \
+        INFIX = /debug
+    else: \
+        INFIX = /release
+}
+DESTDIR = ../client$$INFIX  #service must be in same dir as client binary
+
+SOURCES += main.cpp
+
+target.path = $$[QT_INSTALL_TESTS]/tst_qservicesupervisor
+INSTALLS += target
@@ -34,12 +34,16 @@
 #include <qserviceinterfacedescriptor.h>
 #include <private/qserviceinterfacedescriptor_p.h>
 #include <private/servicedatabase_p.h>
+#include <private/databasemanager_p.h>
+#include <private/serviceregistryindex_p.h>
 #include <qservicefilter.h>
 
 #define RESOLVERDATABASE "services.db"
 
 QT_USE_NAMESPACE
 
+Q_DECLARE_METATYPE(DatabaseManager::DbScope)
+
 class ServiceDatabaseUnitTest: public QObject
 {
     Q_OBJECT
@@ -59,6 +63,10 @@ private slots:
     void setInterfaceDefault();
     void unregister();
     void securityTokens();
+    void changeLog();
+    void changeNotifications();
+    void registerServices();
+    void registryIndex();
     void cleanupTestCase();
 
 private:
@@ -1550,6 +1558,310 @@ void ServiceDatabaseUnitTest::securityTokens() {
     QVERIFY(unregisterService("DharmaInitiative", securityTokenOwner));
 }
 
+void ServiceDatabaseUnitTest::changeLog()
+{
+    database.close();
+    QFile::remove(database.databasePath());
+    QDir testdir = QDir(QFINDTESTDATA("testdata"));
+
+    qint64 version = database.changeVersion();
+    QCOMPARE(database.lastError().code(), DBError::DatabaseNotOpen);
+    QVERIFY(database.open());
+
+    QString epoch;
+    version = database.changeVersion(&epoch);
+    QCOMPARE(database.lastError().code(), DBError::NoError);
+    QCOMPARE(version, qint64(0));
+    QVERIFY(!epoch.isEmpty());
+
+    QList<QPair<QString, ServiceDatabase::ChangeType> > changes;
+    changes = database.serviceChanges(&version, epoch);
+    QCOMPARE(database.lastError().code(), DBError::NoError);
+    QCOMPARE(changes.count(), 0);
+    QCOMPARE(version, qint64(0));
+
+    ServiceMetaData parser(testdir.absoluteFilePath("ServiceAcme.xml"));
+    QVERIFY(parser.extractMetadata());
+    QVERIFY(registerService(parser.parseResults()));
+    parser.setDevice(new QFile(testdir.absoluteFilePath("ServiceOmni.xml")));
+    QVERIFY(parser.extractMetadata());
+    QVERIFY(registerService(parser.parseResults()));
+    QVERIFY(unregisterService("acme"));
+
+    //failed operations must not be logged
+    QVERIFY(!unregisterService("acme"));
+
+    changes = database.serviceChanges(&version, epoch);
+    QCOMPARE(database.lastError().code(), DBError::NoError);
+    QCOMPARE(version, qint64(3));
+    QCOMPARE(database.changeVersion(), qint64(3));
+    QCOMPARE(changes.count(), 3);
+    QCOMPARE(changes[0].first, QString("acme"));
+    QCOMPARE(changes[0].second, ServiceDatabase::ServiceAddedChange);
+    QCOMPARE(changes[1].first, QString("OMNI"));
+    QCOMPARE(changes[1].second, ServiceDatabase::ServiceAddedChange);
+    QCOMPARE(changes[2].first, QString("acme"));
+    QCOMPARE(changes[2].second, ServiceDatabase::ServiceRemovedChange);
+
+    //nothing changed since the last query
+    changes = database.serviceChanges(&version, epoch);
+    QCOMPARE(database.lastError().code(), DBError::NoError);
+    QCOMPARE(changes.count(), 0);
+    QCOMPARE(version, qint64(3));
+
+    //a version from a recreated database cannot be diffed
+    version = 10;
+    changes = database.serviceChanges(&version, epoch);
+    QCOMPARE(database.lastError().code(), DBError::NotFound);
+    QCOMPARE(changes.count(), 0);
+
+    //neither can one the recreated database has already counted past
+    QVERIFY(database.close());
+    QFile::remove(database.databasePath());
+    QVERIFY(database.open());
+    QString recreatedEpoch;
+    QCOMPARE(database.changeVersion(&recreatedEpoch), qint64(0));
+    QVERIFY(!recreatedEpoch.isEmpty());
+    QVERIFY(recreatedEpoch != epoch);
+
+    parser.setDevice(new QFile(testdir.absoluteFilePath("ServiceAcme.xml")));
+    QVERIFY(parser.extractMetadata());
+    for (int i = 0; i < 2; ++i) {
+        QVERIFY(registerService(parser.parseResults()));
+        QVERIFY(unregisterService("acme"));
+    }
+    QCOMPARE(database.changeVersion(), qint64(4));
+
+    version = 3;
+    changes = database.serviceChanges(&version, epoch);
+    QCOMPARE(database.lastError().code(), DBError::NotFound);
+    QCOMPARE(changes.count(), 0);
+
+    version = 3;
+    changes = database.serviceChanges(&version, recreatedEpoch);
+    QCOMPARE(database.lastError().code(), DBError::NoError);
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(version, qint64(4));
+
+    QVERIFY(database.close());
+}
+
+void ServiceDatabaseUnitTest::changeNotifications()
+{
+    database.close();
+    QFile::remove(database.databasePath());
+    QDir testdir = QDir(QFINDTESTDATA("testdata"));
+    QVERIFY(database.open());
+
+    ServiceMetaData parser(testdir.absoluteFilePath("ServiceAcme.xml"));
+    QVERIFY(parser.extractMetadata());
+    QVERIFY(registerService(parser.parseResults()));
+
+    qRegisterMetaType<DatabaseManager::DbScope>("DatabaseManager::DbScope");
+    DatabaseManager manager;
+    manager.m_userDb->setDatabasePath(database.databasePath());
+    QVERIFY(manager.m_userDb->open());
+    manager.setChangeNotificationsEnabled(DatabaseManager::UserScope, true);
+    QSignalSpy addedSpy(&manager, SIGNAL(serviceAdded(QString,DatabaseManager::DbScope)));
+    QSignalSpy removedSpy(&manager, SIGNAL(serviceRemoved(QString,DatabaseManager::DbScope)));
+
+    //the watcher only runs from the event loop, so it sees both changes at
+    //once; only the logged changes tell that the service came and went
+    parser.setDevice(new QFile(testdir.absoluteFilePath("ServicePrimatech.xml")));
+    QVERIFY(parser.extractMetadata());
+    QVERIFY(registerService(parser.parseResults()));
+    QVERIFY(unregisterService("Primatech"));
+
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.at(0).at(0).toString(), QString("Primatech"));
+    QCOMPARE(removedSpy.at(0).at(0).toString(), QString("Primatech"));
+    QCOMPARE(removedSpy.at(0).at(1).value<DatabaseManager::DbScope>(), DatabaseManager::UserScope);
+    addedSpy.clear();
+    removedSpy.clear();
+
+    //changes that are not in the log of a new epoch are found by comparing
+    //the complete list of services
+    QVERIFY(unregisterService("acme"));
+    parser.setDevice(new QFile(testdir.absoluteFilePath("ServiceOmni.xml")));
+    QVERIFY(parser.extractMetadata());
+    QVERIFY(registerService(parser.parseResults()));
+    QSqlQuery query(QSqlDatabase::database(database.m_connectionName));
+    QVERIFY(query.exec("DELETE FROM ChangeLog"));
+    QVERIFY(query.exec("UPDATE ChangeLogEpoch SET Epoch = 'recreated'"));
+    query.finish();
+
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(addedSpy.at(0).at(0).toString(), QString("OMNI"));
+    QCOMPARE(removedSpy.at(0).at(0).toString(), QString("acme"));
+
+    manager.setChangeNotificationsEnabled(DatabaseManager::UserScope, false);
+    QVERIFY(unregisterService("OMNI"));
+    QVERIFY(database.close());
+}
+
+void ServiceDatabaseUnitTest::registerServices()
+{
+    database.close();
+    QFile::remove(database.databasePath());
+    QDir testdir = QDir(QFINDTESTDATA("testdata"));
+    QVERIFY(database.open());
+
+    QStringList xmlFiles;
+    xmlFiles << testdir.absoluteFilePath("ServiceAcme.xml")
+             << testdir.absoluteFilePath("ServicePrimatech.xml")
+             << testdir.absoluteFilePath("ServiceYamagato.xml");
+    QList<ServiceMetaDataResults> services;
+    QVERIFY(ServiceMetaData::extractMetadata(xmlFiles, &services));
+    QCOMPARE(services.count(), 3);
+    QCOMPARE(services[0].name, QString("acme"));
+    QCOMPARE(services[1].name, QString("Primatech"));
+
+    //Yamagato uses the same location as Primatech so nothing is registered
+#ifdef QT_SFW_SERVICEDATABASE_USE_SECURITY_TOKEN
+    QVERIFY(!database.registerServices(services, securityTokenOwner));
+#else
+    QVERIFY(!database.registerServices(services));
+#endif
+    QCOMPARE(database.lastError().code(), DBError::LocationAlreadyRegistered);
+    QCOMPARE(database.getServiceNames(QString()).count(), 0);
+    QCOMPARE(database.changeVersion(), qint64(0));
+
+    services.removeLast();
+#ifdef QT_SFW_SERVICEDATABASE_USE_SECURITY_TOKEN
+    QVERIFY(database.registerServices(services, securityTokenOwner));
+#else
+    QVERIFY(database.registerServices(services));
+#endif
+    QStringList names = database.getServiceNames(QString());
+    QCOMPARE(names.count(), 2);
+    QVERIFY(names.contains("acme"));
+    QVERIFY(names.contains("Primatech"));
+    QCOMPARE(database.changeVersion(), qint64(2));
+
+    //invalid files are reported
+    QStringList failed;
+    services.clear();
+    xmlFiles.clear();
+    xmlFiles << testdir.absoluteFilePath("ServiceOmni.xml")
+             << testdir.absoluteFilePath("ServiceDoesNotExist.xml");
+    QVERIFY(!ServiceMetaData::extractMetadata(xmlFiles, &services, &failed));
+    QCOMPARE(services.count(), 1);
+    QCOMPARE(failed, QStringList() << testdir.absoluteFilePath("ServiceDoesNotExist.xml"));
+
+    QVERIFY(unregisterService("acme"));
+    QVERIFY(unregisterService("Primatech"));
+    QVERIFY(database.close());
+}
+
+static bool sameDescriptors(const QList<QServiceInterfaceDescriptor> &expected,
+                            const QList<QServiceInterfaceDescriptor> &actual)
+{
+    if (expected.count() != actual.count())
+        return false;
+    foreach (const QServiceInterfaceDescriptor &descriptor, expected) {
+        if (!actual.contains(descriptor))
+            return false;
+    }
+    return true;
+}
+
+void ServiceDatabaseUnitTest::registryIndex()
+{
+    database.close();
+    QFile::remove(database.databasePath());
+    QDir testdir = QDir(QFINDTESTDATA("testdata"));
+    QVERIFY(database.open());
+
+    QStringList xmlFiles;
+    xmlFiles << testdir.absoluteFilePath("ServiceAcme.xml")
+             << testdir.absoluteFilePath("ServiceOmni.xml")
+             << testdir.absoluteFilePath("ServicePrimatech.xml");
+    QList<ServiceMetaDataResults> services;
+    QVERIFY(ServiceMetaData::extractMetadata(xmlFiles, &services));
+#ifdef QT_SFW_SERVICEDATABASE_USE_SECURITY_TOKEN
+    QVERIFY(database.registerServices(services, securityTokenOwner));
+#else
+    QVERIFY(database.registerServices(services));
+#endif
+
+    const QString indexPath = ServiceRegistryIndex::indexPath(database.databasePath());
+    QVERIFY(indexPath.endsWith(".idx"));
+    DBError error;
+    QVERIFY(ServiceRegistryIndex::compile(&database, indexPath, &error));
+    QCOMPARE(error.code(), DBError::NoError);
+
+    ServiceRegistryIndex index;
+    QVERIFY(index.open(indexPath));
+
+    //queries on the index must give the same answers as the database
+    QList<QServiceFilter> filters;
+    filters << QServiceFilter();
+    filters << QServiceFilter("com.acme.device.sysinfo", "2.0", QServiceFilter::MinimumVersionMatch);
+    filters << QServiceFilter("com.acme.device.sysinfo", "2.0", QServiceFilter::ExactVersionMatch);
+    filters << QServiceFilter("COM.OMNI.DEVICE.LIGHTS");
+    QServiceFilter filter;
+    filter.setServiceName("omni");
+    filters << filter;
+    filter = QServiceFilter();
+    filter.setCustomAttribute("coordinate", "global");
+    filters << filter;
+    filter = QServiceFilter();
+    filter.setCapabilities(QServiceFilter::MatchLoadable, QStringList() << "ReadUserData");
+    filters << filter;
+    filter = QServiceFilter();
+    filter.setCapabilities(QServiceFilter::MatchMinimum, QStringList() << "ReadUserData" << "WriteUserData");
+    filters << filter;
+
+    foreach (const QServiceFilter &queryFilter, filters) {
+        QList<QServiceInterfaceDescriptor> expected = database.getInterfaces(queryFilter);
+        QCOMPARE(database.lastError().code(), DBError::NoError);
+        QList<QServiceInterfaceDescriptor> actual = index.getInterfaces(queryFilter);
+        QCOMPARE(index.lastError().code(), DBError::NoError);
+        QVERIFY(sameDescriptors(expected, actual));
+    }
+    QVERIFY(index.getInterfaces(QServiceFilter()).count() > 0);
+    QCOMPARE(index.getInterfaces(QServiceFilter("com.nokia.nonexistent")).count(), 0);
+
+    QStringList names = index.getServiceNames(QString());
+    names.sort();
+    QCOMPARE(names, QStringList() << "OMNI" << "Primatech" << "acme");
+    QCOMPARE(index.getServiceNames("com.acme.device.sysinfo"), database.getServiceNames("com.acme.device.sysinfo"));
+
+    QServiceInterfaceDescriptor descriptor = index.interfaceDefault("com.acme.device.sysinfo");
+    QCOMPARE(index.lastError().code(), DBError::NoError);
+    QVERIFY(descriptor == database.interfaceDefault("com.acme.device.sysinfo"));
+    index.interfaceDefault("com.nokia.nonexistent");
+    QCOMPARE(index.lastError().code(), DBError::NotFound);
+
+    const QString interfaceID = index.getInterfaceID(descriptor);
+    QCOMPARE(index.lastError().code(), DBError::NoError);
+    QCOMPARE(interfaceID, database.getInterfaceID(descriptor));
+    QVERIFY(index.getInterface(interfaceID) == descriptor);
+    index.getInterface("{00000000-0000-0000-0000-000000000000}");
+    QCOMPARE(index.lastError().code(), DBError::NotFound);
+    index.close();
+
+    //truncated or foreign files are rejected
+    QFile file(indexPath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+    QVERIFY(!index.open(indexPath));
+    QCOMPARE(index.lastError().code(), DBError::InvalidDatabaseFile);
+    QVERIFY(!index.open(database.databasePath()));
+    QCOMPARE(index.lastError().code(), DBError::InvalidDatabaseFile);
+    QVERIFY(!index.open(indexPath + ".missing"));
+    QCOMPARE(index.lastError().code(), DBError::CannotOpenServiceDb);
+
+    QFile::remove(indexPath);
+    QVERIFY(unregisterService("acme"));
+    QVERIFY(unregisterService("OMNI"));
+    QVERIFY(unregisterService("Primatech"));
+    QVERIFY(database.close());
+}
+
 void ServiceDatabaseUnitTest::cleanupTestCase()
 {
     database.close();
@@ -7,11 +7,15 @@ SUBDIRS = \
            qservicemanager \
            qservicemanager_ipc \
            qservicemetadata \
+           qservicesupervisor \
            servicedeletion
 #           serviceobject
 #           servicedatabase    #(requires test symbols)
 
+qtHaveModule(qml): SUBDIRS += qdeclarativeservicefilter
+
 win32:SUBDIRS -= \
     qservicemanager_ipc \ # QTBUG-32662
+    qservicesupervisor \
     servicedeletion \ # QTBUG-32667
     qremoteserviceregister # QTBUG-32707
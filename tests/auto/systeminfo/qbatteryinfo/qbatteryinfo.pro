@@ -1,5 +1,11 @@
 
 QT += systeminfo testlib
 
+# the same condition as for reading the state of sysinfod in systeminfo.pro
+linux-*:!simulator:contains(CONFIG,valuespace):!without-publishsubscribe {
+    QT += publishsubscribe
+    DEFINES += TST_BATTERY_VALUESPACE
+}
+
 SOURCES += tst_qbatteryinfo.cpp
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -30,6 +30,13 @@
 #include <QtTest/QtTest>
 #include "qbatteryinfo.h"
 
+#if defined(TST_BATTERY_VALUESPACE)
+#include <QtPublishSubscribe/qvaluespace.h>
+#include <QtPublishSubscribe/qvaluespacepublisher.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 QT_USE_NAMESPACE
 
 class tst_QBatteryInfo : public QObject
@@ -41,8 +48,36 @@ private slots:
     void tst_flow();
     void tst_invalid();
     void tst_setBatteryIndex();
+    void tst_valueSpaceSource();
+    void tst_valueSpaceWatch();
 };
 
+#if defined(TST_BATTERY_VALUESPACE)
+/*
+    Returns the pid of a child that already exited and was reaped, the way
+    sysinfod looks to its clients after it got killed.
+*/
+static qint64 deadPid()
+{
+    pid_t pid = ::fork();
+    if (pid == 0)
+        ::_exit(0);
+    if (pid > 0)
+        ::waitpid(pid, 0, 0);
+    return pid;
+}
+
+/* keep in sync with qtsystems/src/tools/sysinfod/main.cpp */
+static void publishBattery(QValueSpacePublisher *publisher, qint64 pid, int remainingCapacity)
+{
+    publisher->setValue(QStringLiteral("count"), 1);
+    publisher->setValue(QStringLiteral("battery0/maximumCapacity"), 4242);
+    publisher->setValue(QStringLiteral("battery0/remainingCapacity"), remainingCapacity);
+    publisher->setValue(QStringLiteral("pid"), pid);
+    publisher->sync();
+}
+#endif
+
 void tst_QBatteryInfo::tst_capacity()
 {
     QBatteryInfo batteryInfo;
@@ -126,5 +161,73 @@ void tst_QBatteryInfo::tst_setBatteryIndex()
     QCOMPARE(batteryInfo.batteryIndex(), -1);
 }
 
+void tst_QBatteryInfo::tst_valueSpaceSource()
+{
+#if defined(TST_BATTERY_VALUESPACE)
+    if (QValueSpace::availableLayers().isEmpty())
+        QSKIP("No value space layer available.");
+
+    const qint64 dead = deadPid();
+    QVERIFY(dead > 0);
+
+    QValueSpacePublisher publisher(QStringLiteral("/SystemInfo/Battery"));
+    QVERIFY(publisher.isConnected());
+
+    // the values of a sysinfod that is gone must not be used
+    publishBattery(&publisher, dead, 4000);
+    QBatteryInfo batteryInfo;
+    const int sysfsCapacity = batteryInfo.maximumCapacity();
+    QVERIFY(sysfsCapacity != 4242);
+
+    publishBattery(&publisher, QCoreApplication::applicationPid(), 4000);
+    QCOMPARE(batteryInfo.batteryCount(), 1);
+    QCOMPARE(batteryInfo.maximumCapacity(), 4242);
+    QCOMPARE(batteryInfo.remainingCapacity(), 4000);
+
+    publishBattery(&publisher, dead, 4000);
+    QCOMPARE(batteryInfo.maximumCapacity(), sysfsCapacity);
+
+    publisher.resetValue(QStringLiteral("battery0"));
+    publisher.resetValue(QStringLiteral("count"));
+    publisher.resetValue(QStringLiteral("pid"));
+    publisher.sync();
+#else
+    QSKIP("Reading from the value space is not built in.");
+#endif
+}
+
+void tst_QBatteryInfo::tst_valueSpaceWatch()
+{
+#if defined(TST_BATTERY_VALUESPACE)
+    if (QValueSpace::availableLayers().isEmpty())
+        QSKIP("No value space layer available.");
+
+    QValueSpacePublisher publisher(QStringLiteral("/SystemInfo/Battery"));
+    QVERIFY(publisher.isConnected());
+    publishBattery(&publisher, QCoreApplication::applicationPid(), 4000);
+
+    QBatteryInfo batteryInfo;
+    QSignalSpy spy(&batteryInfo, SIGNAL(remainingCapacityChanged(int)));
+    QCOMPARE(batteryInfo.remainingCapacity(), 4000);
+
+    publishBattery(&publisher, QCoreApplication::applicationPid(), 3000);
+    QTRY_VERIFY(!spy.isEmpty());
+    QCOMPARE(spy.last().at(0).toInt(), 3000);
+
+    // a watch falls back to sysfs once the published pid goes away
+    const qint64 dead = deadPid();
+    QVERIFY(dead > 0);
+    publishBattery(&publisher, dead, 3000);
+    QTRY_VERIFY(batteryInfo.remainingCapacity() != 3000);
+
+    publisher.resetValue(QStringLiteral("battery0"));
+    publisher.resetValue(QStringLiteral("count"));
+    publisher.resetValue(QStringLiteral("pid"));
+    publisher.sync();
+#else
+    QSKIP("Reading from the value space is not built in.");
+#endif
+}
+
 QTEST_MAIN(tst_QBatteryInfo)
 #include "tst_qbatteryinfo.moc"
@@ -0,0 +1,8 @@
+QT = core systeminfo testlib
+TARGET = tst_qdeclarativeinputdevicemodel
+CONFIG += testcase
+
+INCLUDEPATH += ../../../../src/imports/systeminfo
+HEADERS += ../../../../src/imports/systeminfo/qdeclarativeinputdevicemodel_p.h
+SOURCES += tst_qdeclarativeinputdevicemodel.cpp \
+           ../../../../src/imports/systeminfo/qdeclarativeinputdevicemodel.cpp
@@ -0,0 +1,180 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/qtest.h>
+#include <QSignalSpy>
+#include <QFile>
+
+#include "qdeclarativeinputdevicemodel_p.h"
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+QT_USE_NAMESPACE
+
+static const char testDeviceName[] = "QtSystems test keyboard";
+
+/*
+    Plugs in a virtual keyboard through uinput for as long as it exists.
+ */
+class VirtualKeyboard
+{
+public:
+    VirtualKeyboard() : fd(-1) {}
+    ~VirtualKeyboard() { unplug(); }
+
+    bool plug()
+    {
+        fd = ::open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+        if (fd == -1)
+            return false;
+
+        struct uinput_user_dev dev;
+        memset(&dev, 0, sizeof(dev));
+        strncpy(dev.name, testDeviceName, UINPUT_MAX_NAME_SIZE - 1);
+        dev.id.bustype = BUS_VIRTUAL;
+        dev.id.vendor = 0x1;
+        dev.id.product = 0x1;
+
+        bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0;
+        for (int code = KEY_ESC; code <= KEY_SPACE && ok; code++)
+            ok = ioctl(fd, UI_SET_KEYBIT, code) == 0;
+        ok = ok && write(fd, &dev, sizeof(dev)) == sizeof(dev)
+                && ioctl(fd, UI_DEV_CREATE) == 0;
+        if (!ok)
+            unplug();
+        return ok;
+    }
+
+    void unplug()
+    {
+        if (fd == -1)
+            return;
+        ioctl(fd, UI_DEV_DESTROY);
+        ::close(fd);
+        fd = -1;
+    }
+
+private:
+    int fd;
+};
+
+class tst_QDeclarativeInputDeviceModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void hotplug();
+
+private:
+    static int rowOf(const QDeclarativeInputDeviceModel &model, const QString &name);
+};
+
+void tst_QDeclarativeInputDeviceModel::initTestCase()
+{
+    qRegisterMetaType<QInputDevice::InputType>();
+    qRegisterMetaType<QInputDevice::InputTypeFlags>();
+    qRegisterMetaType<QInputDevice *>();
+}
+
+int tst_QDeclarativeInputDeviceModel::rowOf(const QDeclarativeInputDeviceModel &model, const QString &name)
+{
+    for (int row = 0; row < model.rowCount(); row++) {
+        if (model.data(model.index(row), QDeclarativeInputDeviceModel::NameRole).toString() == name)
+            return row;
+    }
+    return -1;
+}
+
+void tst_QDeclarativeInputDeviceModel::hotplug()
+{
+    if (!QFile::exists(QStringLiteral("/run/udev/control")))
+        QSKIP("Hotplug events need a running udev daemon");
+
+    QDeclarativeInputDeviceModel model;
+    QSignalSpy countSpy(&model, SIGNAL(countChanged(int)));
+    QSignalSpy addedSpy(&model, SIGNAL(added(QInputDevice*)));
+    QSignalSpy removedSpy(&model, SIGNAL(removed(QString)));
+    QSignalSpy rowsRemovedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // the manager reads the existing devices when it is first used
+    QTest::qWait(1000);
+    const int initialCount = model.rowCount();
+    countSpy.clear();
+    addedSpy.clear();
+
+    VirtualKeyboard keyboard;
+    if (!keyboard.plug())
+        QSKIP("Needs write access to /dev/uinput");
+
+    const QString name = QString::fromLatin1(testDeviceName);
+    QTRY_VERIFY_WITH_TIMEOUT(rowOf(model, name) != -1, 10000);
+    QCOMPARE(model.rowCount(), initialCount + 1);
+    QCOMPARE(model.property("count").toInt(), initialCount + 1);
+    QVERIFY(countSpy.count() >= 1);
+    QCOMPARE(countSpy.last().at(0).toInt(), initialCount + 1);
+    QTRY_COMPARE(addedSpy.count(), 1);
+
+    const int row = rowOf(model, name);
+    const QModelIndex index = model.index(row);
+    const QString identifier = model.data(index, QDeclarativeInputDeviceModel::IdentifierRole).toString();
+    QVERIFY(identifier.startsWith(QStringLiteral("/dev/input/event")));
+    QCOMPARE(model.indexOf(identifier), row);
+    QCOMPARE(model.get(row)->identifier(), identifier);
+
+    const QInputDevice::InputTypeFlags types(model.data(index, QDeclarativeInputDeviceModel::TypesRole).toInt());
+    QVERIFY(types.testFlag(QInputDevice::Keyboard));
+    QVERIFY(types.testFlag(QInputDevice::Button));
+    const QList<int> buttons = model.data(index, QDeclarativeInputDeviceModel::ButtonsRole).value<QList<int> >();
+    QVERIFY(buttons.contains(KEY_ESC));
+    QVERIFY(buttons.contains(KEY_SPACE));
+
+    countSpy.clear();
+    removedSpy.clear();
+    rowsRemovedSpy.clear();
+    keyboard.unplug();
+
+    // the row goes away together with the removed() signal, not on a later update
+    QTRY_VERIFY_WITH_TIMEOUT(removedSpy.count() > 0, 10000);
+    QCOMPARE(removedSpy.last().at(0).toString(), identifier);
+    QCOMPARE(rowsRemovedSpy.count(), 1);
+    QCOMPARE(rowsRemovedSpy.last().at(1).toInt(), row);
+    QCOMPARE(rowOf(model, name), -1);
+    QCOMPARE(model.indexOf(identifier), -1);
+    QCOMPARE(model.rowCount(), initialCount);
+    QCOMPARE(countSpy.count(), 1);
+    QCOMPARE(countSpy.last().at(0).toInt(), initialCount);
+}
+
+QTEST_MAIN(tst_QDeclarativeInputDeviceModel)
+#include "tst_qdeclarativeinputdevicemodel.moc"
@@ -28,10 +28,42 @@
 
 #include <QtCore/qregularexpression.h>
 #include <QtTest/qtest.h>
+#include <QtCore/qthread.h>
 #include "qdeviceinfo.h"
 
 QT_USE_NAMESPACE
 
+/*
+    Reads the facts that are shared by all QDeviceInfo objects with its own one.
+ */
+static QStringList readFacts()
+{
+    QDeviceInfo info;
+    QStringList facts;
+    facts << info.manufacturer()
+          << info.model()
+          << info.productName()
+          << info.uniqueDeviceID()
+          << info.version(QDeviceInfo::Os)
+          << info.version(QDeviceInfo::Firmware)
+          << info.operatingSystemName()
+          << info.boardName()
+          << QString::number(info.hasFeature(QDeviceInfo::InfraredFeature))
+          << QString::number(info.hasFeature(QDeviceInfo::LedFeature))
+          << QString::number(info.hasFeature(QDeviceInfo::VibrationFeature))
+          << QString::number(info.hasFeature(QDeviceInfo::PositioningFeature));
+    return facts;
+}
+
+class FactReader : public QThread
+{
+public:
+    QStringList facts;
+
+protected:
+    void run() { facts = readFacts(); }
+};
+
 class tst_QDeviceInfo : public QObject
 {
     Q_OBJECT
@@ -52,6 +84,7 @@ private slots:
     void tst_uniqueDeviceID();
     void tst_hasFeature();
     void tst_thermalState();
+    void tst_cachedFacts();
 
 private:
     QDeviceInfo *deviceInfo;
@@ -163,5 +196,23 @@ void tst_QDeviceInfo::tst_thermalState()
             state == QDeviceInfo::ErrorThermal);
 }
 
+void tst_QDeviceInfo::tst_cachedFacts()
+{
+    const QStringList facts = readFacts();
+    QCOMPARE(readFacts(), facts);
+
+    // QDeviceInfo objects in other threads share the same entries
+    QList<FactReader *> readers;
+    for (int i = 0; i < 4; ++i)
+        readers.append(new FactReader);
+    foreach (FactReader *reader, readers)
+        reader->start();
+    foreach (FactReader *reader, readers) {
+        QVERIFY(reader->wait(30000));
+        QCOMPARE(reader->facts, facts);
+    }
+    qDeleteAll(readers);
+}
+
 QTEST_APPLESS_MAIN(tst_QDeviceInfo)
 #include "tst_qdeviceinfo.moc"
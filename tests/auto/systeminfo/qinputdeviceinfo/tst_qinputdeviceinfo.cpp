@@ -70,6 +70,12 @@ void tst_QInputDeviceInfo::tst_deviceMap()
         QVERIFY(i.value()->name() == i.value()->properties().value("name"));
         QVERIFY(i.value()->identifier() == i.value()->properties().value("identifier"));
         QVERIFY(!i.value()->types().testFlag(QInputDevice::UnknownType));
+
+        QList <int> buttons = i.value()->buttons();
+        QCOMPARE(i.value()->properties().value("buttons").value<QList <int> >(), buttons);
+        for (int j = 1; j < buttons.count(); j++)
+            QVERIFY(buttons.at(j - 1) < buttons.at(j));
+        QCOMPARE(i.value()->properties().value("aAxis").value<QList <int> >(), i.value()->absoluteAxes());
     }
 }
 
@@ -7,5 +7,6 @@ SUBDIRS = \
 
 linux-*: !simulator: {
     SUBDIRS += \
-    qinputdeviceinfo
+    qinputdeviceinfo \
+    qdeclarativeinputdevicemodel
 }
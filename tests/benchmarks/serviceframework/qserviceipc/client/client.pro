@@ -0,0 +1,16 @@
+TARGET = tst_bench_qserviceipc
+CONFIG += benchmark
+
+QT += serviceframework testlib
+QT -= gui
+
+CONFIG -= app_bundle
+
+contains(QT.serviceframework.module_config, sfw_dbus_backend) {
+    QT += dbus
+    DEFINES+=SFW_USE_DBUS_BACKEND
+}
+
+SOURCES += tst_bench_qserviceipc.cpp
+
+TESTDATA += xmldata/*
@@ -0,0 +1,312 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/serviceframework
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtTest/QtTest>
+#include <qservicemanager.h>
+
+QT_USE_NAMESPACE
+
+#ifdef Q_OS_WIN
+static const char serviceBinaryC[] = "qt_sfw_example_ipc_benchmark.exe";
+#else
+static const char serviceBinaryC[] = "qt_sfw_example_ipc_benchmark";
+#endif
+
+class TickCounter : public QObject
+{
+    Q_OBJECT
+public:
+    TickCounter()
+        : received(0), target(0)
+    {
+        timer.setSingleShot(true);
+        connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    }
+
+    bool waitFor(int count)
+    {
+        target = count;
+        if (received < target) {
+            timer.start(10000);
+            loop.exec();
+            timer.stop();
+        }
+        return received >= target;
+    }
+
+    int received;
+
+public Q_SLOTS:
+    void tick()
+    {
+        if (++received == target)
+            loop.quit();
+    }
+
+private:
+    int target;
+    QEventLoop loop;
+    QTimer timer;
+};
+
+class tst_QServiceIpcBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QServiceIpcBenchmark()
+        : manager(0), service(0)
+    {
+    }
+
+    enum Call {
+        VoidCall,
+        IntCall,
+        PayloadCall
+    };
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void proxyConstruction_data();
+    void proxyConstruction();
+
+    void callLatency_data();
+    void callLatency();
+
+    void signalFanOut_data();
+    void signalFanOut();
+
+    void propertyRead();
+    void propertyWrite();
+
+private:
+    QServiceInterfaceDescriptor descriptor(const QString &version) const;
+
+    QServiceManager *manager;
+    QObject *service;
+};
+
+Q_DECLARE_METATYPE(tst_QServiceIpcBenchmark::Call)
+
+QServiceInterfaceDescriptor tst_QServiceIpcBenchmark::descriptor(const QString &version) const
+{
+    foreach (const QServiceInterfaceDescriptor &d, manager->findInterfaces("IPCBenchmarkService")) {
+        if (QString("%1.%2").arg(d.majorVersion()).arg(d.minorVersion()) == version)
+            return d;
+    }
+    return QServiceInterfaceDescriptor();
+}
+
+void tst_QServiceIpcBenchmark::initTestCase()
+{
+#ifdef SFW_USE_DBUS_BACKEND
+    QSKIP("The benchmarks measure the socket based transports");
+#endif
+    const QString serviceBinary = QFINDTESTDATA(serviceBinaryC);
+    QVERIFY(!serviceBinary.isEmpty());
+
+    const QString path = QFINDTESTDATA("xmldata/ipcbenchmarkservice.xml");
+    QVERIFY(!path.isEmpty());
+
+#ifdef Q_OS_UNIX
+    // the service is started from the client's directory
+    QByteArray newpath = qgetenv("PATH");
+    newpath += ":.";
+    qputenv("PATH", newpath);
+#endif
+    QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath());
+
+    manager = new QServiceManager(this);
+    manager->removeService("IPCBenchmarkService");
+    QVERIFY2(manager->addService(path), "Cannot register IPCBenchmarkService");
+
+    // launches the service, all benchmarks below run against a live process
+    service = manager->loadInterface(descriptor("1.0"));
+    QVERIFY(service);
+}
+
+void tst_QServiceIpcBenchmark::cleanupTestCase()
+{
+    if (service) {
+        QMetaObject::invokeMethod(service, "quit");
+        delete service;
+        service = 0;
+    }
+
+    if (manager)
+        manager->removeService("IPCBenchmarkService");
+}
+
+void tst_QServiceIpcBenchmark::proxyConstruction_data()
+{
+    QTest::addColumn<QString>("version");
+    QTest::addColumn<bool>("keepConnection");
+
+    QTest::newRow("private instance") << QString("1.0") << true;
+    QTest::newRow("shared instance") << QString("1.1") << true;
+    QTest::newRow("private instance, first proxy") << QString("1.0") << false;
+}
+
+void tst_QServiceIpcBenchmark::proxyConstruction()
+{
+    QFETCH(QString, version);
+    QFETCH(bool, keepConnection);
+
+    const QServiceInterfaceDescriptor d = descriptor(version);
+    QVERIFY(d.isValid());
+
+    // without another proxy alive every construction has to connect first
+    if (!keepConnection) {
+        delete service;
+        service = 0;
+    }
+
+    QBENCHMARK {
+        QObject *proxy = manager->loadInterface(d);
+        QVERIFY(proxy);
+        delete proxy;
+    }
+
+    if (!service) {
+        service = manager->loadInterface(descriptor("1.0"));
+        QVERIFY(service);
+    }
+}
+
+void tst_QServiceIpcBenchmark::callLatency_data()
+{
+    QTest::addColumn<Call>("call");
+    QTest::addColumn<int>("size");
+
+    // void calls don't wait for the service, they measure the send path only
+    QTest::newRow("void") << VoidCall << 0;
+    QTest::newRow("int") << IntCall << 0;
+    QTest::newRow("QByteArray 0") << PayloadCall << 0;
+    QTest::newRow("QByteArray 64") << PayloadCall << 64;
+    QTest::newRow("QByteArray 4k") << PayloadCall << 4 * 1024;
+    QTest::newRow("QByteArray 64k") << PayloadCall << 64 * 1024;
+    QTest::newRow("QByteArray 1M") << PayloadCall << 1024 * 1024;
+}
+
+void tst_QServiceIpcBenchmark::callLatency()
+{
+    QFETCH(Call, call);
+    QFETCH(int, size);
+
+    switch (call) {
+    case VoidCall:
+        QBENCHMARK {
+            QMetaObject::invokeMethod(service, "voidCall");
+        }
+        break;
+    case IntCall: {
+        int result = 0;
+        QBENCHMARK {
+            QMetaObject::invokeMethod(service, "intCall",
+                                      Q_RETURN_ARG(int, result), Q_ARG(int, 41));
+        }
+        QCOMPARE(result, 42);
+        break;
+    }
+    case PayloadCall: {
+        QByteArray result;
+        QBENCHMARK {
+            QMetaObject::invokeMethod(service, "payload",
+                                      Q_RETURN_ARG(QByteArray, result), Q_ARG(int, size));
+        }
+        QCOMPARE(result.size(), size);
+        break;
+    }
+    }
+}
+
+void tst_QServiceIpcBenchmark::signalFanOut_data()
+{
+    QTest::addColumn<int>("proxies");
+    QTest::addColumn<int>("ticks");
+
+    QTest::newRow("1 proxy") << 1 << 100;
+    QTest::newRow("4 proxies") << 4 << 100;
+    QTest::newRow("16 proxies") << 16 << 100;
+}
+
+void tst_QServiceIpcBenchmark::signalFanOut()
+{
+    QFETCH(int, proxies);
+    QFETCH(int, ticks);
+
+    // every proxy of the shared instance receives each signal it emits
+    const QServiceInterfaceDescriptor d = descriptor("1.1");
+    QVERIFY(d.isValid());
+
+    TickCounter counter;
+    QList<QObject *> receivers;
+    for (int i = 0; i < proxies; i++) {
+        QObject *proxy = manager->loadInterface(d);
+        QVERIFY(proxy);
+        QVERIFY(connect(proxy, SIGNAL(tick(int)), &counter, SLOT(tick())));
+        receivers.append(proxy);
+    }
+
+    QBENCHMARK {
+        counter.received = 0;
+        QMetaObject::invokeMethod(receivers.first(), "emitTicks", Q_ARG(int, ticks));
+        QVERIFY(counter.waitFor(proxies * ticks));
+    }
+
+    qDeleteAll(receivers);
+}
+
+void tst_QServiceIpcBenchmark::propertyRead()
+{
+    QVariant value;
+    QBENCHMARK {
+        value = service->property("value");
+    }
+    QVERIFY(value.isValid());
+}
+
+void tst_QServiceIpcBenchmark::propertyWrite()
+{
+    int value = 0;
+    QBENCHMARK {
+        service->setProperty("value", ++value);
+    }
+    QCOMPARE(service->property("value").toInt(), value);
+}
+
+QTEST_MAIN(tst_QServiceIpcBenchmark)
+#include "tst_bench_qserviceipc.moc"
@@ -0,0 +1,133 @@
+
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtSystems module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QTimer>
+#include <qremoteserviceregister.h>
+#include <qserviceclientcredentials.h>
+
+QT_USE_NAMESPACE
+
+class BenchmarkService : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged)
+
+public:
+    BenchmarkService(QObject *parent = 0)
+        : QObject(parent), m_value(0)
+    {
+    }
+
+    Q_INVOKABLE BenchmarkService(QServiceClientCredentials *creds)
+        : QObject(0), m_value(0)
+    {
+        creds->setClientAccepted(true);
+    }
+
+    Q_INVOKABLE void verifyNewServiceClientCredentials(QServiceClientCredentials *creds)
+    {
+        creds->setClientAccepted(true);
+    }
+
+    int value() const
+    {
+        return m_value;
+    }
+
+    void setValue(int value)
+    {
+        if (m_value == value)
+            return;
+        m_value = value;
+        emit valueChanged();
+    }
+
+    Q_INVOKABLE void voidCall()
+    {
+    }
+
+    Q_INVOKABLE int intCall(int value)
+    {
+        return value + 1;
+    }
+
+    Q_INVOKABLE QByteArray payload(int size)
+    {
+        if (m_payload.size() != size)
+            m_payload = QByteArray(size, 'x');
+        return m_payload;
+    }
+
+    Q_INVOKABLE void emitTicks(int count)
+    {
+        for (int i = 0; i < count; i++)
+            emit tick(i);
+    }
+
+    Q_INVOKABLE void quit()
+    {
+        QTimer::singleShot(0, QCoreApplication::instance(), SLOT(quit()));
+    }
+
+Q_SIGNALS:
+    void valueChanged();
+    void tick(int sequence);
+
+private:
+    int m_value;
+    QByteArray m_payload;
+};
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QRemoteServiceRegister* serviceRegister = new QRemoteServiceRegister();
+    // keep the process around between iterations, the client quits it
+    serviceRegister->setQuitOnLastInstanceClosed(false);
+
+    QRemoteServiceRegister::Entry privateEntry =
+        serviceRegister->createEntry<BenchmarkService>(
+                "IPCBenchmarkService", "com.nokia.qt.ipcbenchmark", "1.0");
+    privateEntry.setInstantiationType(QRemoteServiceRegister::PrivateInstance);
+
+    QRemoteServiceRegister::Entry globalEntry =
+        serviceRegister->createEntry<BenchmarkService>(
+                "IPCBenchmarkService", "com.nokia.qt.ipcbenchmark", "1.1");
+    globalEntry.setInstantiationType(QRemoteServiceRegister::GlobalInstance);
+
+    serviceRegister->publishEntries("qt_sfw_example_ipc_benchmark");
+    int res = app.exec();
+    delete serviceRegister;
+
+    return res;
+}
+
+#include "main.moc"
@@ -0,0 +1,26 @@
+TARGET = qt_sfw_example_ipc_benchmark
+TEMPLATE = app
+
+mac {
+    CONFIG -= app_bundle
+}
+
+debug_and_release {
+    CONFIG(debug, debug|release): \
+        INFIX = /debug
+    else: \
+        INFIX = /release
+}
+DESTDIR = ../client$$INFIX  #service must be in same dir as client binary
+
+QT = core serviceframework
+
+contains(QT.serviceframework.module_config, sfw_dbus_backend) {
+    QT += dbus
+    DEFINES+=SFW_USE_DBUS_BACKEND
+}
+
+SOURCES += main.cpp
+
+target.path = $$[QT_INSTALL_TESTS]/tst_bench_qserviceipc
+INSTALLS += target
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS = \
+           qserviceipc
+
+win32:SUBDIRS -= \
+    qserviceipc # QTBUG-32662
@@ -1,5 +1,5 @@
 TEMPLATE = subdirs
-SUBDIRS += auto
+SUBDIRS += auto benchmarks
 
 linux-*: !simulator: {
   SUBDIRS += manual/sysinfo-tester